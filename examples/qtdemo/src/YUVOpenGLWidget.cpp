@@ -16,6 +16,10 @@ YUVOpenGLWidget::YUVOpenGLWidget(QWidget* parent) : QOpenGLWidget(parent)
     m_pTextureY = NULL;
     m_pTextureU = NULL;
     m_pTextureV = NULL;
+
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_frameTimer, &QTimer::timeout, this, &YUVOpenGLWidget::pollFrame);
 }
 
 YUVOpenGLWidget::~YUVOpenGLWidget()
@@ -67,6 +71,32 @@ void YUVOpenGLWidget::updateFrame(MediaFrameSharedPointer frame)
 
 }
 
+void YUVOpenGLWidget::setFrameSource(krtc::IMediaHandler* source)
+{
+    m_frameSource = source;
+    m_latestFrame = nullptr;
+    if (m_frameSource) {
+        m_frameTimer->start(16);
+    }
+    else {
+        m_frameTimer->stop();
+    }
+}
+
+void YUVOpenGLWidget::pollFrame()
+{
+    if (!m_frameSource) {
+        return;
+    }
+
+    // 两次刷新之间到达的旧帧已经在SDK里丢掉了
+    std::shared_ptr<krtc::MediaFrame> frame = m_frameSource->AcquireLatestFrame();
+    if (frame && frame->fmt.sub_fmt.video_fmt.type == krtc::SubMediaType::kSubTypeI420) {
+        m_latestFrame = frame;
+        update();
+    }
+}
+
 void YUVOpenGLWidget::initializeGL()
 {
     initializeOpenGLFunctions();
@@ -195,20 +225,24 @@ void YUVOpenGLWidget::resizeGL(int w, int h)
 
 void YUVOpenGLWidget::paintGL()
 {
-    if ( nullptr == m_videoFrame) {
+    const krtc::MediaFrame* videoFrame = m_latestFrame ? m_latestFrame.get() : m_videoFrame.data();
+    if (nullptr == videoFrame) {
         return;
     }
 
-    int width = m_videoFrame->fmt.sub_fmt.video_fmt.width;
-    int height = m_videoFrame->fmt.sub_fmt.video_fmt.height;
+    int width = videoFrame->fmt.sub_fmt.video_fmt.width;
+    int height = videoFrame->fmt.sub_fmt.video_fmt.height;
 
     // 加载y数据纹理
     // 激活纹理单元GL_TEXTURE0
     glActiveTexture(GL_TEXTURE0);
     // 使用来自y数据生成纹理
     glBindTexture(GL_TEXTURE_2D, id_y);
+    // SDK的帧缓冲带行对齐，按stride上传
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, videoFrame->stride[0]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED,
-        GL_UNSIGNED_BYTE, m_videoFrame->data[0]);
+        GL_UNSIGNED_BYTE, videoFrame->data[0]);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -218,8 +252,9 @@ void YUVOpenGLWidget::paintGL()
     // 激活纹理单元GL_TEXTURE1
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, id_u);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, videoFrame->stride[1]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width / 2, height / 2, 0, GL_RED,
-        GL_UNSIGNED_BYTE, m_videoFrame->data[1]);
+        GL_UNSIGNED_BYTE, videoFrame->data[1]);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -229,8 +264,10 @@ void YUVOpenGLWidget::paintGL()
     // 激活纹理单元GL_TEXTURE2
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_2D, id_v);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, videoFrame->stride[2]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width / 2, height / 2, 0, GL_RED,
-        GL_UNSIGNED_BYTE, m_videoFrame->data[2]);
+        GL_UNSIGNED_BYTE, videoFrame->data[2]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -5,7 +5,11 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
 #include <QOpenGLTexture>
+#include <QTimer>
 
+#include <memory>
+
+#include "krtc/krtc.h"
 #include "defs.h"
 
 #define ATTRIB_VERTEX 3
@@ -21,6 +25,8 @@ public:
 
 public:
     void updateFrame(MediaFrameSharedPointer videoFrame);
+    // 按屏幕刷新的节奏从SDK的信箱里取最新一帧，传nullptr停止
+    void setFrameSource(krtc::IMediaHandler* source);
 
 private:
     void initializeGL() Q_DECL_OVERRIDE;
@@ -28,6 +34,7 @@ private:
     void paintGL() Q_DECL_OVERRIDE;
 
     void releaseMemory();
+    void pollFrame();
 
 private:
     /**
@@ -49,6 +56,10 @@ private:
     QOpenGLShaderProgram* m_pShaderProgram; // 着色器程序容器
 
     MediaFrameSharedPointer m_videoFrame;
+
+    krtc::IMediaHandler* m_frameSource = nullptr;
+    QTimer* m_frameTimer = nullptr;
+    std::shared_ptr<krtc::MediaFrame> m_latestFrame; // 直接持有SDK的帧，不拷贝
 };
 
 #endif // YUVOPENGLWIDGET_H
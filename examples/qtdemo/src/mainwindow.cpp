@@ -84,6 +84,7 @@ void MainWindow::initWindow()
 		});
 	connect(this, &MainWindow::previewFailedSignal,
 		[this] {
+			ui->previewOpenGLWidget->setFrameSource(nullptr);
 			stopPreview();
 			ui->startPreviewBtn->setText(QStringLiteral("本地预览"));
 		});
@@ -361,6 +362,8 @@ bool MainWindow::startPreview() {
 #endif
 	
     krtc_preview_ = krtc::KRTCEngine::CreatePreview();
+	krtc_preview_->SetFrameMailbox(true);
+	ui->previewOpenGLWidget->setFrameSource(krtc_preview_);
 	krtc_preview_->Start();
 
 	return true;
@@ -371,6 +374,7 @@ bool MainWindow::stopPreview() {
 		return false;
 	}
 
+	ui->previewOpenGLWidget->setFrameSource(nullptr);
 	krtc_preview_->Stop();
 	krtc_preview_ = nullptr;
 
@@ -419,6 +423,8 @@ bool MainWindow::startPull()
 
 	QString channel = ui->pullStreamNameLineEdit->text();
     krtc_puller_ = krtc::KRTCEngine::CreatePuller(url.toUtf8().constData(), channel.toUtf8().constData());
+	krtc_puller_->SetFrameMailbox(true);
+	ui->pullOpenGLWidget->setFrameSource(krtc_puller_);
 	krtc_puller_->Start();
 
 	return true;
@@ -430,6 +436,7 @@ bool MainWindow::stopPull()
 		return true;
 	}
 
+	ui->pullOpenGLWidget->setFrameSource(nullptr);
 	krtc_puller_->Stop();
 	krtc_puller_->Destroy();
 	krtc_puller_ = nullptr;
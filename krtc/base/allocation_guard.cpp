@@ -0,0 +1,76 @@
+#include "krtc/base/allocation_guard.h"
+
+#include <stdlib.h>
+
+#include <new>
+
+#include <rtc_base/checks.h>
+
+namespace krtc {
+
+namespace {
+
+thread_local int g_no_allocation_depth = 0;
+
+} // namespace
+
+ScopedNoAllocation::ScopedNoAllocation() {
+    ++g_no_allocation_depth;
+}
+
+ScopedNoAllocation::~ScopedNoAllocation() {
+    --g_no_allocation_depth;
+}
+
+bool ScopedNoAllocation::IsActive() {
+    return g_no_allocation_depth > 0;
+}
+
+#if defined(KRTC_CHECK_RT_ALLOCATION)
+
+namespace {
+
+void* CheckedAllocate(size_t size) {
+    if (g_no_allocation_depth > 0) {
+        // 打印日志本身也要分配内存
+        g_no_allocation_depth = 0;
+        RTC_FATAL() << "heap allocation of " << size << " bytes on a real-time thread";
+    }
+    return malloc(size ? size : 1);
+}
+
+} // namespace
+
+#endif // KRTC_CHECK_RT_ALLOCATION
+
+} // namespace krtc
+
+#if defined(KRTC_CHECK_RT_ALLOCATION)
+
+void* operator new(size_t size) {
+    void* ptr = krtc::CheckedAllocate(size);
+    RTC_CHECK(ptr) << "out of memory";
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return krtc::CheckedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return krtc::CheckedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+#endif // KRTC_CHECK_RT_ALLOCATION
@@ -0,0 +1,22 @@
+#ifndef KRTCSDK_KRTC_BASE_ALLOCATION_GUARD_H_
+#define KRTCSDK_KRTC_BASE_ALLOCATION_GUARD_H_
+
+namespace krtc {
+
+// 标记实时线程上不允许堆分配的代码段。
+// 编译时打开KRTC_CHECK_RT_ALLOCATION后SDK替换全局operator new，
+// 在这个范围内分配内存会直接崩溃并打印分配大小；默认不开启，只是一个标记。
+class ScopedNoAllocation {
+public:
+    ScopedNoAllocation();
+    ~ScopedNoAllocation();
+
+    ScopedNoAllocation(const ScopedNoAllocation&) = delete;
+    ScopedNoAllocation& operator=(const ScopedNoAllocation&) = delete;
+
+    static bool IsActive();
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_BASE_ALLOCATION_GUARD_H_
@@ -0,0 +1,119 @@
+#include "krtc/base/field_trials.h"
+
+#include <algorithm>
+
+#include <api/audio_codecs/audio_decoder_factory.h>
+#include <api/audio_codecs/audio_encoder_factory.h>
+#include <api/call/call_factory_interface.h>
+#include <api/rtc_event_log/rtc_event_log_factory.h>
+#include <api/task_queue/default_task_queue_factory.h>
+#include <api/video_codecs/video_decoder_factory.h>
+#include <api/video_codecs/video_encoder_factory.h>
+#include <media/engine/webrtc_media_engine.h>
+#include <modules/audio_device/include/audio_device.h>
+#include <modules/audio_processing/include/audio_processing.h>
+#include <system_wrappers/include/field_trial.h>
+
+namespace krtc {
+
+std::string PushFieldTrials(const KRTCBitrateConfig& config)
+{
+    std::string trials;
+    if (config.aggressive_initial_probe) {
+        // 初始探测为起始码率的p1倍，随后p2倍
+        trials += "WebRTC-Bwe-ProbingConfiguration/p1:4,p2:8/";
+    }
+    return trials;
+}
+
+std::string PullFieldTrials(const KRTCPullLatencyConfig& config)
+{
+    if (config.render_asap) {
+        // min和max都为0时解码完直接渲染
+        return "WebRTC-ForcePlayoutDelay/min_ms:0,max_ms:0/";
+    }
+    if (config.max_playout_delay_ms < 0) {
+        return "";
+    }
+    int32_t min_ms = std::max(config.min_playout_delay_ms, 0);
+    int32_t max_ms = std::max(config.max_playout_delay_ms, min_ms);
+    return "WebRTC-ForcePlayoutDelay/min_ms:" + std::to_string(min_ms) +
+        ",max_ms:" + std::to_string(max_ms) + "/";
+}
+
+KRTCFieldTrials::KRTCFieldTrials(std::function<std::string()> trials) :
+    trials_(std::move(trials))
+{
+}
+
+std::string KRTCFieldTrials::Lookup(absl::string_view key) const
+{
+    std::string value = Find(trials_(), key);
+    if (!value.empty()) {
+        return value;
+    }
+    return webrtc::field_trial::FindFullName(std::string(key));
+}
+
+std::string KRTCFieldTrials::Find(const std::string& trials, absl::string_view key)
+{
+    size_t pos = 0;
+    while (pos < trials.size()) {
+        size_t key_end = trials.find('/', pos);
+        if (key_end == std::string::npos) {
+            break;
+        }
+        size_t value_end = trials.find('/', key_end + 1);
+        if (value_end == std::string::npos) {
+            value_end = trials.size();
+        }
+        if (absl::string_view(trials).substr(pos, key_end - pos) == key) {
+            return trials.substr(key_end + 1, value_end - key_end - 1);
+        }
+        pos = value_end + 1;
+    }
+    return "";
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> CreatePeerConnectionFactoryWithTrials(
+    rtc::Thread* network_thread,
+    rtc::Thread* worker_thread,
+    rtc::Thread* signaling_thread,
+    rtc::scoped_refptr<webrtc::AudioDeviceModule> default_adm,
+    rtc::scoped_refptr<webrtc::AudioEncoderFactory> audio_encoder_factory,
+    rtc::scoped_refptr<webrtc::AudioDecoderFactory> audio_decoder_factory,
+    std::unique_ptr<webrtc::VideoEncoderFactory> video_encoder_factory,
+    std::unique_ptr<webrtc::VideoDecoderFactory> video_decoder_factory,
+    rtc::scoped_refptr<webrtc::AudioProcessing> audio_processing,
+    std::unique_ptr<webrtc::FieldTrialsView> trials)
+{
+    // 和webrtc::CreatePeerConnectionFactory的组装过程相同，只是trials换成我们的
+    webrtc::PeerConnectionFactoryDependencies dependencies;
+    dependencies.network_thread = network_thread;
+    dependencies.worker_thread = worker_thread;
+    dependencies.signaling_thread = signaling_thread;
+    dependencies.task_queue_factory = webrtc::CreateDefaultTaskQueueFactory(trials.get());
+    dependencies.call_factory = webrtc::CreateCallFactory();
+    dependencies.event_log_factory = std::make_unique<webrtc::RtcEventLogFactory>(
+        dependencies.task_queue_factory.get());
+    dependencies.trials = std::move(trials);
+    if (network_thread) {
+        dependencies.socket_factory = network_thread->socketserver();
+    }
+
+    cricket::MediaEngineDependencies media_dependencies;
+    media_dependencies.task_queue_factory = dependencies.task_queue_factory.get();
+    media_dependencies.adm = std::move(default_adm);
+    media_dependencies.audio_encoder_factory = std::move(audio_encoder_factory);
+    media_dependencies.audio_decoder_factory = std::move(audio_decoder_factory);
+    media_dependencies.audio_processing = audio_processing ?
+        std::move(audio_processing) : webrtc::AudioProcessingBuilder().Create();
+    media_dependencies.video_encoder_factory = std::move(video_encoder_factory);
+    media_dependencies.video_decoder_factory = std::move(video_decoder_factory);
+    media_dependencies.trials = dependencies.trials.get();
+    dependencies.media_engine = cricket::CreateMediaEngine(std::move(media_dependencies));
+
+    return webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
+}
+
+} // namespace krtc
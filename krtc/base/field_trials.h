@@ -0,0 +1,50 @@
+#ifndef KRTCSDK_KRTC_BASE_FIELD_TRIALS_H_
+#define KRTCSDK_KRTC_BASE_FIELD_TRIALS_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <api/field_trials_view.h>
+#include <api/peer_connection_interface.h>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 推流的field trial字符串，格式"Key1/Value1/Key2/Value2/"
+std::string PushFieldTrials(const KRTCBitrateConfig& config);
+// 拉流的field trial字符串，播放延迟上限和render_asap
+std::string PullFieldTrials(const KRTCPullLatencyConfig& config);
+
+// 只对一个PeerConnectionFactory生效的field trial，不修改进程全局的字符串。
+// trials在每次查询时调用，返回"Key1/Value1/"格式；没有的键回落到全局field trial
+class KRTCFieldTrials : public webrtc::FieldTrialsView {
+public:
+    explicit KRTCFieldTrials(std::function<std::string()> trials);
+
+    std::string Lookup(absl::string_view key) const override;
+
+    // 在"Key1/Value1/Key2/Value2/"里找key的值，没有时返回空串
+    static std::string Find(const std::string& trials, absl::string_view key);
+
+private:
+    std::function<std::string()> trials_;
+};
+
+// 同webrtc::CreatePeerConnectionFactory，多了每个factory自己的field trial
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> CreatePeerConnectionFactoryWithTrials(
+    rtc::Thread* network_thread,
+    rtc::Thread* worker_thread,
+    rtc::Thread* signaling_thread,
+    rtc::scoped_refptr<webrtc::AudioDeviceModule> default_adm,
+    rtc::scoped_refptr<webrtc::AudioEncoderFactory> audio_encoder_factory,
+    rtc::scoped_refptr<webrtc::AudioDecoderFactory> audio_decoder_factory,
+    std::unique_ptr<webrtc::VideoEncoderFactory> video_encoder_factory,
+    std::unique_ptr<webrtc::VideoDecoderFactory> video_decoder_factory,
+    rtc::scoped_refptr<webrtc::AudioProcessing> audio_processing,
+    std::unique_ptr<webrtc::FieldTrialsView> trials);
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_BASE_FIELD_TRIALS_H_
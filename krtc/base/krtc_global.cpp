@@ -5,10 +5,18 @@
 #include <api/audio_codecs/builtin_audio_encoder_factory.h>
 #include <api/video_codecs/builtin_video_decoder_factory.h>
 #include <api/video_codecs/builtin_video_encoder_factory.h>
+#include <rtc_base/logging.h>
 
 #include "krtc/base/krtc_global.h"
+#include "krtc/base/field_trials.h"
 #include "krtc/base/krtc_http.h"
+#include "krtc/media/peer_connection_pool.h"
+#include "krtc/media/pull_audio_mixer.h"
+#include "krtc/media/audio_send_config.h"
 #include "krtc/device/audio_device_data_observer.h"
+#include "krtc/device/audio_capture_tap.h"
+#include "krtc/device/audio_processing_profiler.h"
+#include "krtc/device/headless_audio_device.h"
 
 #if defined(_WIN32) || defined(_WIN64)
 #include "krtc/codec/external_video_encoder_factory.h"
@@ -16,6 +24,23 @@
 
 namespace krtc {
 
+namespace {
+
+AUDIO_DEVICE_TYPE g_audio_device_type = AUDIO_DEVICE_TYPE::PLATFORM;
+std::string g_capture_wav_file;
+std::atomic<bool> g_instance_created{ false };
+
+} // namespace
+
+void KRTCGlobal::SetAudioDeviceConfig(const KRTCAudioDeviceConfig& config) {
+    if (g_instance_created) {
+        RTC_LOG(LS_WARNING) << "SetAudioDeviceConfig must be called before any other KRTCEngine call";
+        return;
+    }
+    g_audio_device_type = config.type;
+    g_capture_wav_file = config.capture_wav_file ? config.capture_wav_file : "";
+}
+
 KRTCGlobal* KRTCGlobal::Instance() {
     static KRTCGlobal* const instance = new KRTCGlobal();
     return instance;
@@ -26,8 +51,13 @@ KRTCGlobal::KRTCGlobal() :
     worker_thread_(rtc::Thread::Create()),
     network_thread_(rtc::Thread::CreateWithSocketServer()),
     video_device_info_(webrtc::VideoCaptureFactory::CreateDeviceInfo()),
-    task_queue_factory_(webrtc::CreateDefaultTaskQueueFactory())
+    task_queue_factory_(webrtc::CreateDefaultTaskQueueFactory()),
+    audio_capture_tap_(std::make_unique<AudioCaptureTap>()),
+    audio_processing_profiler_(std::make_unique<AudioProcessingProfiler>()),
+    audio_processing_(webrtc::AudioProcessingBuilder().Create())
 {
+    g_instance_created = true;
+
     signaling_thread_->SetName("signaling_thread", nullptr);
     signaling_thread_->Start();
 
@@ -41,14 +71,26 @@ KRTCGlobal::KRTCGlobal() :
     http_manager_->Start();
 
     worker_thread_->BlockingCall([&] { 
-        audio_device_ = webrtc::AudioDeviceModule::Create(
-            webrtc::AudioDeviceModule::kPlatformDefaultAudio,
-            task_queue_factory_.get());
-        audio_device_ = webrtc::CreateAudioDeviceWithDataObserver(audio_device_, std::make_unique<ADMDataObserver>());
+        if (g_audio_device_type == AUDIO_DEVICE_TYPE::HEADLESS) {
+            audio_device_ = rtc::make_ref_counted<HeadlessAudioDevice>(g_capture_wav_file);
+        }
+        else {
+            audio_device_ = webrtc::AudioDeviceModule::Create(
+                webrtc::AudioDeviceModule::kPlatformDefaultAudio,
+                task_queue_factory_.get());
+        }
+        audio_device_ = webrtc::CreateAudioDeviceWithDataObserver(audio_device_,
+            std::make_unique<ADMDataObserver>(audio_capture_tap_.get(), audio_processing_profiler_.get()));
         audio_device_->Init();
     });
 
     push_peer_connection_factory();
+    // 语音引擎初始化时按默认AudioOptions打开了AGC1等，这里覆盖成我们的配置。
+    // 音频源都用空的AudioOptions创建，之后引擎不会再改APM的配置
+    audio_processing_->ApplyConfig(AudioProcessingProfiler::ToApmConfig(audio_processing_config_));
+    peer_connection_pool_ = std::make_unique<PeerConnectionPool>();
+    video_source_registry_ = std::make_unique<VideoSourceRegistry>();
+    pull_audio_mixer_ = std::make_unique<PullAudioMixer>();
 
    // DesktopCapturer::GetScreenSourceList(&screen_source_list_);
 }
@@ -60,127 +102,83 @@ webrtc::PeerConnectionFactoryInterface* KRTCGlobal::push_peer_connection_factory
     if (push_peer_connection_factory_) {
         return push_peer_connection_factory_.get();
     }
-#if defined(_WIN32) || defined(_WIN64)
-    push_peer_connection_factory_ = webrtc::CreatePeerConnectionFactory(
+    // 探测模式每次建Call时按当前的bitrate_config查询，之后新建的PeerConnection生效。
+    // 构造函数里就会查询，这里不能再调Instance()
+    auto trials = std::make_unique<KRTCFieldTrials>([this]() {
+        return PushFieldTrials(bitrate_config());
+    });
+    push_peer_connection_factory_ = CreatePeerConnectionFactoryWithTrials(
         network_thread_.get(), /* network_thread */
         worker_thread_.get(), /* worker_thread */
         signaling_thread_.get(),  /* signaling_thread */
         audio_device_,  /* default_adm */
-        webrtc::CreateBuiltinAudioEncoderFactory(),
+        CreateTunedAudioEncoderFactory(),
         webrtc::CreateBuiltinAudioDecoderFactory(),
-#if USE_EXTERNAL_ENCOER
+#if (defined(_WIN32) || defined(_WIN64)) && USE_EXTERNAL_ENCOER
         krtc::CreateBuiltinExternalVideoEncoderFactory(),
 #else
         webrtc::CreateBuiltinVideoEncoderFactory(),
 #endif
         webrtc::CreateBuiltinVideoDecoderFactory(),
-        nullptr, /* audio_mixer */
-        nullptr, /* audio_processing */
-        nullptr, /*audio_frame_processor*/
-        std::move(task_queue_factory_));
-#else
-    push_peer_connection_factory_ = webrtc::CreatePeerConnectionFactory(
-        network_thread_.get(), /* network_thread */
-        worker_thread_.get(), /* worker_thread */
-        signaling_thread_.get(),  /* signaling_thread */
-        audio_device_,  /* default_adm */
-        webrtc::CreateBuiltinAudioEncoderFactory(),
-        webrtc::CreateBuiltinAudioDecoderFactory(),
-        webrtc::CreateBuiltinVideoEncoderFactory(),
-        webrtc::CreateBuiltinVideoDecoderFactory(),
-        nullptr, /* audio_mixer */
-        nullptr, /* audio_processing */
-        nullptr, /*audio_frame_processor*/
-        std::move(task_queue_factory_));
-#endif
+        audio_processing_, /* audio_processing */
+        std::move(trials));
 
     return push_peer_connection_factory_.get();
 }
 
-void KRTCGlobal::CreateVcmCapturerSource(const char* cam_id)
+rtc::scoped_refptr<webrtc::AudioDeviceModule> KRTCGlobal::CreatePullAudioDevice()
 {
-    signaling_thread_->PostTask([this, cam_id]() {
-        camera_capturer_source_ = VcmCapturerTrackSource::Create(cam_id);
-        if (!camera_capturer_source_) {
-            if (KRTCGlobal::Instance()->engine_observer()) {
-                KRTCGlobal::Instance()->engine_observer()->OnPreviewFailed(KRTCError::kVideoCreateCaptureErr);
-            }
-            return;
-        }
-
-        SetCurrentCaptureType(CAPTURE_TYPE::CAMERA);
-    });
+    if (g_audio_device_type != AUDIO_DEVICE_TYPE::HEADLESS) {
+        return nullptr;
+    }
+    // 拉流只需要播放端驱动解码
+    return rtc::make_ref_counted<HeadlessAudioDevice>("");
 }
 
-void KRTCGlobal::StartVcmCapturerSource()
+void KRTCGlobal::SetFastStart(bool enable, int pool_size)
 {
-    signaling_thread_->PostTask([this]() {
-        if (camera_capturer_source_) {
-            camera_capturer_source_->Start();
-        }
-
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPreviewSuccess();
-        }
+    fast_start_ = enable;
+    signaling_thread_->PostTask([this, enable, pool_size]() {
+        peer_connection_pool_->SetSize(enable ? std::min(std::max(pool_size, 1), 4) : 0);
     });
 }
 
-void KRTCGlobal::StopVcmCapturerSource()
+void KRTCGlobal::SetBitrateConfig(const KRTCBitrateConfig& config)
 {
-    signaling_thread_->PostTask([this]() {
-        if (camera_capturer_source_) {
-            camera_capturer_source_->Stop();
-        }
-    });
+    std::lock_guard<std::mutex> locker(bitrate_config_mutex_);
+    bitrate_config_ = config;
 }
 
-void KRTCGlobal::CreateDesktopCapturerSource(uint16_t screen_index, uint16_t target_fps)
+void KRTCGlobal::SetPullLatencyConfig(const KRTCPullLatencyConfig& config)
 {
-    signaling_thread_->PostTask([this, screen_index, target_fps]() {
-        desktop_capturer_source_ = DesktopCapturerTrackSource::Create(screen_index, target_fps);
-        if (!desktop_capturer_source_) {
-            if (KRTCGlobal::Instance()->engine_observer()) {
-                KRTCGlobal::Instance()->engine_observer()->OnPreviewFailed(KRTCError::kVideoCreateCaptureErr);     
-            }
-            return;
-        }
-
-        SetCurrentCaptureType(CAPTURE_TYPE::SCREEN);
-    });
+    std::lock_guard<std::mutex> locker(pull_latency_config_mutex_);
+    pull_latency_config_ = config;
 }
 
-void KRTCGlobal::StartDesktopCapturerSource()
+void KRTCGlobal::SetAudioProcessingConfig(const KRTCAudioProcessingConfig& config)
 {
-    signaling_thread_->PostTask([this]() {
-        if (desktop_capturer_source_) {
-            desktop_capturer_source_->Start();
-
-            if (KRTCGlobal::Instance()->engine_observer()) {
-                KRTCGlobal::Instance()->engine_observer()->OnPreviewSuccess();
-            }
-        }
-    });
+    {
+        std::lock_guard<std::mutex> locker(audio_processing_config_mutex_);
+        audio_processing_config_ = config;
+    }
+    // ApplyConfig是线程安全的，下一帧生效
+    audio_processing_->ApplyConfig(AudioProcessingProfiler::ToApmConfig(config));
+    audio_processing_profiler_->SetConfig(config);
 }
 
-void KRTCGlobal::StopDesktopCapturerSource()
+void KRTCGlobal::SetVideoSourceConfig(const CAPTURE_TYPE& type, const KRTCVideoSourceConfig& config)
 {
-    signaling_thread_->PostTask([this]() {
-        if (desktop_capturer_source_) {
-            desktop_capturer_source_->Stop();
+    {
+        std::lock_guard<std::mutex> locker(video_source_config_mutex_);
+        if (type == CAPTURE_TYPE::SCREEN) {
+            screen_source_config_ = config;
+        }
+        else {
+            camera_source_config_ = config;
         }
-    });
-}
-
-webrtc::VideoTrackSource* KRTCGlobal::current_video_source()
-{
-    switch (current_capture_type_) {
-    case CAPTURE_TYPE::CAMERA:
-        return camera_capturer_source_.get();
-    case CAPTURE_TYPE::SCREEN:
-        return desktop_capturer_source_.get();
-    default:
-        return nullptr;
     }
+
+    video_source_registry_->SetDegradationPreference(type, config.degradation_preference);
 }
 
 } // namespace krtc
@@ -2,31 +2,38 @@
 #define KRTCSDK_KRTC_BASE_KRTC_GLOBAL_H_
 
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <string>
 
 #include <rtc_base/thread.h>
 #include <modules/video_capture/video_capture.h>
 #include <modules/audio_device/include/audio_device.h>
+#include <modules/audio_processing/include/audio_processing.h>
 #include <api/task_queue/default_task_queue_factory.h>
 #include <api/media_stream_interface.h>
 #include <api/peer_connection_interface.h>
 
 #include "krtc/device/vcm_capturer.h"
 #include "krtc/device/desktop_capturer.h"
+#include "krtc/device/video_source_registry.h"
 
 namespace krtc {
 
 	class KRTCEngineObserver;
 	class HttpManager;
-
-    enum class CAPTURE_TYPE {
-		CAMERA,	// 摄像头采集
-		SCREEN  // 桌面采集
-	};
+	class PeerConnectionPool;
+	class PullAudioMixer;
+	class AudioCaptureTap;
+	class AudioProcessingProfiler;
 
 	// 全局管理类，单例模式
 	class KRTCGlobal {
 	public:
 		static KRTCGlobal* Instance();
+		// 构造时按这个配置创建ADM，要在第一次Instance()之前设置
+		static void SetAudioDeviceConfig(const KRTCAudioDeviceConfig& config);
 
 	private:
 		KRTCGlobal();
@@ -52,6 +59,11 @@ namespace krtc {
 		}
 
 		HttpManager* http_manager() { return http_manager_; }
+
+		// 快速启动：预创建推流PeerConnection，只在api线程访问
+		PeerConnectionPool* peer_connection_pool() { return peer_connection_pool_.get(); }
+		void SetFastStart(bool enable, int pool_size);
+		bool fast_start() const { return fast_start_; }
 	
 		webrtc::AudioDeviceModule* audio_device() {
 			return push_peer_connection_factory()->GetAdmPtr().get();
@@ -59,25 +71,120 @@ namespace krtc {
 
 		webrtc::PeerConnectionFactoryInterface* push_peer_connection_factory();
 
+		// 推外部音频的推流计数，只在api线程访问。推流factory的ADM录音状态是共用的，
+		// 第一个外部音频推流开始时关闭麦克风录音，最后一个停止时再打开，返回值表示是否需要切换
+		bool AddExternalAudioPusher() { return external_audio_pushers_++ == 0; }
+		bool RemoveExternalAudioPusher() { return --external_audio_pushers_ == 0; }
+
+		// 拉流各自的PeerConnectionFactory使用的ADM，系统声卡时返回nullptr用webrtc默认的
+		rtc::scoped_refptr<webrtc::AudioDeviceModule> CreatePullAudioDevice();
+
 		webrtc::TaskQueueFactory* task_queue_factory() { return task_queue_factory_.get(); }
 
-		webrtc::VideoTrackSource* current_video_source();
+		// 摄像头、屏幕采集源，按句柄区分
+		VideoSourceRegistry* video_source_registry() { return video_source_registry_.get(); }
+
+		// 麦克风采集数据的旁路输出
+		AudioCaptureTap* audio_capture_tap() { return audio_capture_tap_.get(); }
+
+		// 推流麦克风的音频处理，运行中立即生效
+		void SetAudioProcessingConfig(const KRTCAudioProcessingConfig& config);
+		KRTCAudioProcessingConfig audio_processing_config() {
+			std::lock_guard<std::mutex> locker(audio_processing_config_mutex_);
+			return audio_processing_config_;
+		}
+
+		// 多路拉流音频混音
+		PullAudioMixer* pull_audio_mixer() { return pull_audio_mixer_.get(); }
+
+		void SetVideoEncodeMode(const VIDEO_ENCODE_MODE& mode, int pipeline_depth) {
+			video_encode_mode_ = mode;
+			video_encode_pipeline_depth_ = std::min(std::max(pipeline_depth, 2), 4);
+		}
+
+		VIDEO_ENCODE_MODE video_encode_mode() const { return video_encode_mode_; }
+		int video_encode_pipeline_depth() const { return video_encode_pipeline_depth_; }
+
+		void SetScreenShareRoi(bool enable, bool detect_text) {
+			screen_share_roi_ = enable;
+			screen_share_detect_text_ = detect_text;
+		}
+		bool screen_share_roi() const { return screen_share_roi_; }
+		bool screen_share_detect_text() const { return screen_share_detect_text_; }
+
+		void SetVideoTemporalLayers(int layers) {
+			video_temporal_layers_ = std::min(std::max(layers, 1), 3);
+		}
+		int video_temporal_layers() const { return video_temporal_layers_; }
+
+		void SetSignalingProtocol(const SIGNALING_PROTOCOL& protocol) { signaling_protocol_ = protocol; }
+		SIGNALING_PROTOCOL signaling_protocol() const { return signaling_protocol_; }
+
+		void SetKeyFrameConfig(const KRTCKeyFrameConfig& config) {
+			std::lock_guard<std::mutex> locker(key_frame_config_mutex_);
+			key_frame_config_ = config;
+		}
+		KRTCKeyFrameConfig key_frame_config() {
+			std::lock_guard<std::mutex> locker(key_frame_config_mutex_);
+			return key_frame_config_;
+		}
+
+		// 已创建的采集源立即更新
+		void SetVideoSourceConfig(const CAPTURE_TYPE& type, const KRTCVideoSourceConfig& config);
+		KRTCVideoSourceConfig video_source_config(const CAPTURE_TYPE& type) {
+			std::lock_guard<std::mutex> locker(video_source_config_mutex_);
+			return type == CAPTURE_TYPE::SCREEN ? screen_source_config_ : camera_source_config_;
+		}
+
+		void SetCameraCaptureConfig(const KRTCCameraCaptureConfig& config) {
+			std::lock_guard<std::mutex> locker(camera_capture_config_mutex_);
+			camera_capture_config_ = config;
+		}
+		KRTCCameraCaptureConfig camera_capture_config() {
+			std::lock_guard<std::mutex> locker(camera_capture_config_mutex_);
+			return camera_capture_config_;
+		}
+
+		void SetReconnectConfig(const KRTCReconnectConfig& config) {
+			std::lock_guard<std::mutex> locker(reconnect_config_mutex_);
+			reconnect_config_ = config;
+		}
+		KRTCReconnectConfig reconnect_config() {
+			std::lock_guard<std::mutex> locker(reconnect_config_mutex_);
+			return reconnect_config_;
+		}
 
-		void SetCurrentCaptureType(const CAPTURE_TYPE& type) {
-			current_capture_type_ = type;
+		// 探测模式通过推流factory自己的field trial生效，之后新建的PeerConnection生效
+		void SetBitrateConfig(const KRTCBitrateConfig& config);
+		KRTCBitrateConfig bitrate_config() {
+			std::lock_guard<std::mutex> locker(bitrate_config_mutex_);
+			return bitrate_config_;
 		}
 
-		CAPTURE_TYPE current_capture_type() const {
-			return current_capture_type_;
+		// 视频播放延迟通过每个拉流factory自己的field trial生效，之后开始的拉流生效
+		void SetPullLatencyConfig(const KRTCPullLatencyConfig& config);
+		KRTCPullLatencyConfig pull_latency_config() {
+			std::lock_guard<std::mutex> locker(pull_latency_config_mutex_);
+			return pull_latency_config_;
 		}
 
-		void CreateVcmCapturerSource(const char* cam_id);
-		void StartVcmCapturerSource();
-		void StopVcmCapturerSource();
+		void SetPullVideoFormats(const KRTCPullVideoFormats& formats) {
+			std::lock_guard<std::mutex> locker(pull_video_formats_mutex_);
+			pull_video_formats_ = formats;
+		}
+		KRTCPullVideoFormats pull_video_formats() {
+			std::lock_guard<std::mutex> locker(pull_video_formats_mutex_);
+			return pull_video_formats_;
+		}
 
-		void CreateDesktopCapturerSource(uint16_t screen_index, uint16_t target_fps);
-		void StartDesktopCapturerSource();
-		void StopDesktopCapturerSource();
+		void SetAudioSendConfig(const KRTCAudioSendConfig& config) {
+			std::lock_guard<std::mutex> locker(audio_send_config_mutex_);
+			audio_send_config_ = config;
+		}
+		KRTCAudioSendConfig audio_send_config() {
+			std::lock_guard<std::mutex> locker(audio_send_config_mutex_);
+			return audio_send_config_;
+		}
 
 	private:
 		std::unique_ptr<rtc::Thread> signaling_thread_;
@@ -85,14 +192,45 @@ namespace krtc {
 		std::unique_ptr<rtc::Thread> network_thread_;
 		std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> video_device_info_;
 		std::unique_ptr<webrtc::TaskQueueFactory> task_queue_factory_;
+		std::unique_ptr<AudioCaptureTap> audio_capture_tap_;
+		std::unique_ptr<AudioProcessingProfiler> audio_processing_profiler_;
+		rtc::scoped_refptr<webrtc::AudioProcessing> audio_processing_;
+		std::mutex audio_processing_config_mutex_;
+		KRTCAudioProcessingConfig audio_processing_config_;
 		rtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_;
 		KRTCEngineObserver* engine_observer_ = nullptr;
 		rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> push_peer_connection_factory_;
-		rtc::scoped_refptr<VcmCapturerTrackSource> camera_capturer_source_;
-		rtc::scoped_refptr<DesktopCapturerTrackSource> desktop_capturer_source_;
+		int external_audio_pushers_ = 0;
+		std::unique_ptr<VideoSourceRegistry> video_source_registry_;
+		std::unique_ptr<PullAudioMixer> pull_audio_mixer_;
 		webrtc::DesktopCapturer::SourceList screen_source_list_;
-		CAPTURE_TYPE current_capture_type_ = CAPTURE_TYPE::CAMERA;
+		std::atomic<VIDEO_ENCODE_MODE> video_encode_mode_{ VIDEO_ENCODE_MODE::LOW_LATENCY };
+		std::atomic<int> video_encode_pipeline_depth_{ 3 };
+		std::atomic<bool> screen_share_roi_{ false };
+		std::atomic<bool> screen_share_detect_text_{ true };
+		std::atomic<int> video_temporal_layers_{ 1 };
+		std::atomic<SIGNALING_PROTOCOL> signaling_protocol_{ SIGNALING_PROTOCOL::SRS };
+		std::mutex key_frame_config_mutex_;
+		KRTCKeyFrameConfig key_frame_config_;
+		std::mutex video_source_config_mutex_;
+		KRTCVideoSourceConfig camera_source_config_;
+		KRTCVideoSourceConfig screen_source_config_{
+			DEGRADATION_PREFERENCE::MAINTAIN_RESOLUTION, VIDEO_CONTENT_HINT::DETAIL };
+		std::mutex camera_capture_config_mutex_;
+		KRTCCameraCaptureConfig camera_capture_config_;
+		std::mutex reconnect_config_mutex_;
+		KRTCReconnectConfig reconnect_config_;
+		std::mutex bitrate_config_mutex_;
+		KRTCBitrateConfig bitrate_config_;
+		std::mutex pull_latency_config_mutex_;
+		KRTCPullLatencyConfig pull_latency_config_;
+		std::mutex pull_video_formats_mutex_;
+		KRTCPullVideoFormats pull_video_formats_;
+		std::mutex audio_send_config_mutex_;
+		KRTCAudioSendConfig audio_send_config_;
 		HttpManager* http_manager_ = nullptr;
+		std::unique_ptr<PeerConnectionPool> peer_connection_pool_;
+		std::atomic<bool> fast_start_{ false };
 		bool is_preview_ = false;
 	};
 
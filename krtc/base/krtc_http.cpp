@@ -1,5 +1,6 @@
 #include "krtc/base/krtc_http.h"
 
+#include <absl/strings/match.h>
 #include <rtc_base/logging.h>
 #include <rtc_base/thread.h>
 #include <rtc_base/time_utils.h>
@@ -8,46 +9,80 @@
 
 namespace krtc {
 
-HttpRequestTask::HttpRequestTask(CURLM* curlm, const HttpRequest& request, std::function<void(HttpReply)> resp_func) :
+HttpRequestTask::HttpRequestTask(CURLM* curlm, CURLSH* share, const HttpRequest& request, std::function<void(HttpReply)> resp_func) :
 	curlm_(curlm),
 	curl_(curl_easy_init()),
 	resp_func_(resp_func),
 	start_time_(rtc::Time32()),
 	request_(request) {
     curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, false);
+	// 完成时由easy handle直接找回任务，不用遍历请求列表
+	curl_easy_setopt(curl_, CURLOPT_PRIVATE, this);
 
-	if (request_.get_method() == HttpRequest::HttpMethod::kPost) {
+	// 连接留在multi handle的连接池里按源复用，https上优先走HTTP/2，
+	// 同一源的并发请求等已有连接协商完成后复用，不再各自握手
+	curl_easy_setopt(curl_, CURLOPT_SHARE, share);
+	curl_easy_setopt(curl_, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(curl_, CURLOPT_PIPEWAIT, 1L);
+	curl_easy_setopt(curl_, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(curl_, CURLOPT_DNS_CACHE_TIMEOUT, 300L);
+
+	HttpRequest::HttpMethod method = request_.get_method();
+	if (method == HttpRequest::HttpMethod::kPost || method == HttpRequest::HttpMethod::kPatch) {
 		curl_easy_setopt(curl_, CURLOPT_URL, request_.get_url().c_str());
 		curl_easy_setopt(curl_, CURLOPT_POST, 1);
-		// 设置http发送的内容类型为JSON
-		curl_slist* plist = curl_slist_append(NULL, "Content-Type:application/x-www-form-urlencoded;");
-		curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, plist);
+		if (method == HttpRequest::HttpMethod::kPatch) {
+			curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "PATCH");
+		}
+		std::string content_type = request_.get_content_type().empty()
+			? "application/x-www-form-urlencoded;" : request_.get_content_type();
+		headers_ = curl_slist_append(headers_, ("Content-Type:" + content_type).c_str());
 		curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, request_.get_body().c_str());
+		curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, (long)request_.get_body().size());
 		curl_easy_setopt(curl_, CURLOPT_READFUNCTION, NULL);
 		curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, HttpRequestTask::OnWriteData);
 		curl_easy_setopt(curl_, CURLOPT_WRITEDATA, this);
-		curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, 15000);
-		curl_easy_setopt(curl_, CURLOPT_TIMEOUT, request_.get_timeout());
 	}
-	else if (request_.get_method() == HttpRequest::HttpMethod::kGet) {
+	else if (method == HttpRequest::HttpMethod::kGet) {
 		curl_easy_setopt(curl_, CURLOPT_WRITEDATA, this);
 		curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, HttpRequestTask::OnWriteData);
 		curl_easy_setopt(curl_, CURLOPT_URL, request_.get_url().c_str());
-		curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, 15000);
-		curl_easy_setopt(curl_, CURLOPT_TIMEOUT, request_.get_timeout());
+	}
+	else if (method == HttpRequest::HttpMethod::kHead) {
+		// 只为建立连接：DNS解析、TCP/TLS握手的结果留在缓存和连接池里
+		curl_easy_setopt(curl_, CURLOPT_URL, request_.get_url().c_str());
+		curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L);
+	}
+	else if (method == HttpRequest::HttpMethod::kDelete) {
+		curl_easy_setopt(curl_, CURLOPT_URL, request_.get_url().c_str());
+		curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
+		curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, HttpRequestTask::OnWriteData);
+		curl_easy_setopt(curl_, CURLOPT_WRITEDATA, this);
 	}
 	else {
 		return;
 	}
 
-	curl_multi_add_handle(curlm_, curl_);
-	curl_multi_wakeup(curlm_);
+	for (auto& header : request_.get_headers()) {
+		headers_ = curl_slist_append(headers_, header.c_str());
+	}
+	if (headers_) {
+		curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers_);
+	}
+	curl_easy_setopt(curl_, CURLOPT_HEADERFUNCTION, HttpRequestTask::OnHeaderData);
+	curl_easy_setopt(curl_, CURLOPT_HEADERDATA, this);
+	curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, 15000);
+	curl_easy_setopt(curl_, CURLOPT_TIMEOUT, request_.get_timeout());
 }
 
 HttpRequestTask::~HttpRequestTask() {
 	curl_multi_remove_handle(curlm_, curl_);
 	curl_easy_cleanup(curl_);
 	curl_ = nullptr;
+	if (headers_) {
+		curl_slist_free_all(headers_);
+		headers_ = nullptr;
+	}
 }
 
 size_t HttpRequestTask::OnWriteData(void* buffer, size_t size, size_t nmemb, HttpRequestTask* task) {
@@ -62,6 +97,22 @@ size_t HttpRequestTask::OnHttpRequestTaskWriteData(void* buffer, size_t size, si
 	return nmemb;
 }
 
+size_t HttpRequestTask::OnHeaderData(char* buffer, size_t size, size_t nitems, HttpRequestTask* task) {
+	size_t length = size * nitems;
+	static const char kLocation[] = "location:";
+	const size_t kLocationLength = sizeof(kLocation) - 1;
+	if (length <= kLocationLength ||
+		!absl::EqualsIgnoreCase(absl::string_view(buffer, kLocationLength), kLocation)) {
+		return length;
+	}
+
+	std::string location(buffer + kLocationLength, length - kLocationLength);
+	size_t begin = location.find_first_not_of(" \t");
+	size_t end = location.find_last_not_of(" \t\r\n");
+	task->location_ = (begin == std::string::npos) ? "" : location.substr(begin, end - begin + 1);
+	return length;
+}
+
 HttpReply HttpRequestTask::Resp(int err, const std::string& err_msg, long status_code) {
 	uint32_t duration = rtc::Time32() - start_time_;
 	HttpReply reply;
@@ -74,6 +125,11 @@ HttpReply HttpRequestTask::Resp(int err, const std::string& err_msg, long status
 	reply.set_status_code(status_code);
 	reply.set_form(request_.get_form());
 	reply.set_obj(request_.get_obj());
+	reply.set_location(location_);
+
+	long new_connects = 0;
+	curl_easy_getinfo(curl_, CURLINFO_NUM_CONNECTS, &new_connects);
+	reply.set_reused_connection(new_connects == 0);
 
 	return reply;
 }
@@ -83,14 +139,36 @@ HttpManager::HttpManager() {
 	multi_ = curl_multi_init();
 	/* Limit the amount of simultaneous connections curl should allow: */
 	curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, (long)100);
+	// 同一源最多保持4条连接，HTTP/2下并发请求复用同一条连接
+	curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, (long)4);
+	curl_multi_setopt(multi_, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+
+	// DNS结果和TLS会话在所有请求间共享，新连接可以跳过解析并恢复TLS会话
+	share_ = curl_share_init();
+	curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, HttpManager::OnShareLock);
+	curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, HttpManager::OnShareUnlock);
+	curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+	prewarm_obj_ = AddObject();
 }
 
 HttpManager::~HttpManager() {
+	// 任务析构时要从multi handle上摘下easy handle，先于multi_释放
+	pending_handles_.clear();
+	request_list_.clear();
+
 	if (multi_) {
 		curl_multi_cleanup(multi_);
 		multi_ = nullptr;
 	}
 
+	if (share_) {
+		curl_share_cleanup(share_);
+		share_ = nullptr;
+	}
+
 	if (http_thread_) {
 		delete http_thread_;
 		http_thread_ = nullptr;
@@ -104,32 +182,99 @@ std::string HttpManager::UrlEncode(const std::string& content) {
 	return res;
 }
 
-void HttpManager::Get(HttpRequest request, std::function<void(HttpReply)> resp, void* obj) {
-	std::unique_lock<std::mutex> auto_lock(mutex_);
+void HttpManager::Get(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj) {
 	request.set_method(HttpRequest::HttpMethod::kGet);
 	request.set_obj(obj);
-	request_list_.push_back(std::make_shared<HttpRequestTask>(multi_, request, resp));
-	curl_multi_wakeup(multi_);
+	AddHttpRequestTask(request, resp);
 }
 
-void HttpManager::Post(HttpRequest request, std::function<void(HttpReply)> resp, void* obj) {
-	std::unique_lock<std::mutex> auto_lock(mutex_);
+void HttpManager::Post(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj) {
 	request.set_method(HttpRequest::HttpMethod::kPost);
 	request.set_obj(obj);
-	request_list_.push_back(std::make_shared<HttpRequestTask>(multi_, request, resp));
-	curl_multi_wakeup(multi_);
+	AddHttpRequestTask(request, resp);
 }
 
-void HttpManager::AddObject(void* obj) {
-	KRTCGlobal::Instance()->worker_thread()->PostTask([=]() {
-		async_objs_.insert(obj);
+void HttpManager::Prewarm(const std::string& url) {
+	HttpRequest request(url);
+	request.set_method(HttpRequest::HttpMethod::kHead);
+	request.set_obj(prewarm_obj_);
+	AddHttpRequestTask(request, [](HttpReply reply) {
+		RTC_LOG(LS_INFO) << "signaling prewarm, url: " << reply.get_url()
+			<< ", status: " << reply.get_status_code()
+			<< ", err_msg: " << reply.get_err_msg()
+			<< ", duration: " << reply.get_duration() << "ms";
 	});
 }
 
-void HttpManager::RemoveObject(void* obj) {
-	KRTCGlobal::Instance()->worker_thread()->PostTask([=]() {
-		async_objs_.erase(obj);
-		});
+void HttpManager::Patch(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj) {
+	request.set_method(HttpRequest::HttpMethod::kPatch);
+	request.set_obj(obj);
+	AddHttpRequestTask(request, resp);
+}
+
+void HttpManager::Delete(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj) {
+	request.set_method(HttpRequest::HttpMethod::kDelete);
+	request.set_obj(obj);
+	AddHttpRequestTask(request, resp);
+}
+
+void HttpManager::AddHttpRequestTask(const HttpRequest& request, std::function<void(HttpReply)> resp) {
+	std::unique_lock<std::mutex> auto_lock(mutex_);
+	request_list_.push_back(std::make_shared<HttpRequestTask>(multi_, share_, request, resp));
+	request_list_.back()->set_position(std::prev(request_list_.end()));
+	// multi handle只在http_thread上操作，这里只排队并唤醒
+	pending_handles_.push_back(request_list_.back()->get_curl_handle());
+	curl_multi_wakeup(multi_);
+}
+
+void HttpManager::AddPendingHandles() {
+	std::vector<CURL*> handles;
+	{
+		std::unique_lock<std::mutex> auto_lock(mutex_);
+		handles.swap(pending_handles_);
+	}
+
+	for (CURL* handle : handles) {
+		curl_multi_add_handle(multi_, handle);
+	}
+}
+
+HttpObjectHandle HttpManager::AddObject() {
+	std::unique_lock<std::mutex> auto_lock(objs_mutex_);
+	uint32_t slot = 0;
+	if (!free_obj_slots_.empty()) {
+		slot = free_obj_slots_.back();
+		free_obj_slots_.pop_back();
+	}
+	else {
+		slot = static_cast<uint32_t>(obj_generations_.size());
+		obj_generations_.push_back(0);
+	}
+
+	uint32_t generation = ++obj_generations_[slot];
+	return (static_cast<uint64_t>(generation) << 32) | slot;
+}
+
+void HttpManager::RemoveObject(HttpObjectHandle obj) {
+	std::unique_lock<std::mutex> auto_lock(objs_mutex_);
+	if (!IsObjectAliveLocked(obj)) {
+		return;
+	}
+
+	uint32_t slot = static_cast<uint32_t>(obj);
+	obj_generations_[slot]++;
+	free_obj_slots_.push_back(slot);
+}
+
+bool HttpManager::IsObjectAlive(HttpObjectHandle obj) {
+	std::unique_lock<std::mutex> auto_lock(objs_mutex_);
+	return IsObjectAliveLocked(obj);
+}
+
+bool HttpManager::IsObjectAliveLocked(HttpObjectHandle obj) {
+	uint32_t slot = static_cast<uint32_t>(obj);
+	uint32_t generation = static_cast<uint32_t>(obj >> 32);
+	return (generation & 1) && slot < obj_generations_.size() && obj_generations_[slot] == generation;
 }
 
 void HttpManager::Start() {
@@ -146,14 +291,20 @@ void HttpManager::Start() {
 		int still_alive = 0;
 		int msgs_left;
 		int index = 0;
+		// 有请求完成时不等poll，马上再perform一次：连接池满时排队的请求要等连接
+		// 空出来才开始，libcurl这时不一定唤醒poll，否则要等满超时才发出去
+		bool finished = false;
 
 		do {
-			CURLMcode mc = curl_multi_poll(multi_, NULL, 0, 10000, NULL);
+			CURLMcode mc = curl_multi_poll(multi_, NULL, 0, finished ? 0 : 10000, NULL);
+			finished = false;
 			index++;
+			AddPendingHandles();
 			curl_multi_perform(multi_, &still_alive);
 
 			while ((msg = curl_multi_info_read(multi_, &msgs_left))) {
 				if (msg->msg == CURLMSG_DONE) {
+					finished = true;
 					std::shared_ptr<HttpRequestTask> req = GetHttpRequestTask(msg->easy_handle);
 					if (req != nullptr) {
 						int errNo = msg->data.result;
@@ -164,16 +315,13 @@ void HttpManager::Start() {
 						HttpReply reply = req->Resp(errNo, errMsg, status_code);
 						std::function<void(HttpReply)> resp_func = req->get_resp_func();
 
-						void* obj = reply.get_obj();
+						HttpObjectHandle obj = reply.get_obj();
 						KRTCGlobal::Instance()->worker_thread()->PostTask([=]() {
-							for (auto alive_obj : async_objs_) {
-								if (obj == alive_obj && resp_func) {
-									resp_func(reply);
-								}
+							if (resp_func && IsObjectAlive(obj)) {
+								resp_func(reply);
 							}
 							});
 					}
-					break;
 				}
 			}
 		} while (running_);
@@ -193,16 +341,27 @@ void HttpManager::Stop() {
 	RTC_LOG(LS_INFO) << "HttpManager Stop Finished";
 }
 
+void HttpManager::OnShareLock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr) {
+	HttpManager* manager = static_cast<HttpManager*>(userptr);
+	manager->share_mutexes_[data % CURL_LOCK_DATA_LAST].lock();
+}
+
+void HttpManager::OnShareUnlock(CURL* handle, curl_lock_data data, void* userptr) {
+	HttpManager* manager = static_cast<HttpManager*>(userptr);
+	manager->share_mutexes_[data % CURL_LOCK_DATA_LAST].unlock();
+}
+
 std::shared_ptr<HttpRequestTask> HttpManager::GetHttpRequestTask(CURL* handle) {
-	std::unique_lock<std::mutex> auto_lock(mutex_);
-	for (auto itor = request_list_.begin(); itor != request_list_.end(); ++itor) {
-		if (handle == (*itor)->get_curl_handle()) {
-			std::shared_ptr<HttpRequestTask> req = std::move(*itor);
-			request_list_.erase(itor);
-			return req;
-		}
+	HttpRequestTask* task = nullptr;
+	if (curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**)&task) != CURLE_OK || !task) {
+		return nullptr;
 	}
-	return nullptr;
+
+	std::unique_lock<std::mutex> auto_lock(mutex_);
+	auto itor = task->get_position();
+	std::shared_ptr<HttpRequestTask> req = std::move(*itor);
+	request_list_.erase(itor);
+	return req;
 }
 
 } // namespace krtc
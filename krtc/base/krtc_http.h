@@ -9,18 +9,26 @@
 #include <functional>
 #include <mutex>
 #include <memory>
-#include <set>
+#include <vector>
 
 #include <curl/curl.h>
 
 namespace krtc {
 
+// 回调对象的弱句柄：低32位是槽位，高32位是代数。RemoveObject后槽位代数加一，
+// 旧句柄随即失效，槽位可以被复用而不会误判为存活
+using HttpObjectHandle = uint64_t;
+const HttpObjectHandle kInvalidHttpObjectHandle = 0;
+
 class HttpRequest {
 public:
     enum class HttpMethod {
         kGet = 0,
         kPost,
-        kPostForm
+        kPostForm,
+        kHead,
+        kPatch,
+        kDelete
     };
 
     HttpRequest() {}
@@ -46,8 +54,16 @@ public:
     void set_form(std::map<std::string, std::string> form) { form_ = form; }
     std::map<std::string, std::string> get_form() { return form_; }
 
-    void set_obj(void* obj) { obj_ = obj; }
-    void* get_obj() { return obj_; }
+    // 默认application/x-www-form-urlencoded
+    void set_content_type(const std::string& content_type) { content_type_ = content_type; }
+    std::string& get_content_type() { return content_type_; }
+
+    // 额外的请求头，如"Authorization: Bearer xxx"
+    void add_header(const std::string& header) { headers_.push_back(header); }
+    std::vector<std::string>& get_headers() { return headers_; }
+
+    void set_obj(HttpObjectHandle obj) { obj_ = obj; }
+    HttpObjectHandle get_obj() { return obj_; }
 
 private:
     std::string url_;
@@ -55,8 +71,10 @@ private:
     std::string body_;
     std::string encode_body_;
     std::map<std::string, std::string> form_;
+    std::string content_type_;
+    std::vector<std::string> headers_;
     HttpMethod method_ = HttpMethod::kGet;
-    void* obj_ = nullptr;
+    HttpObjectHandle obj_ = kInvalidHttpObjectHandle;
 };
 
 class HttpReply {
@@ -65,31 +83,39 @@ public:
     ~HttpReply() = default;
 
     void set_duration(int duration) { duration_ = duration; }
-    uint32_t get_duration() { return duration_; }
+    uint32_t get_duration() const { return duration_; }
 
     void set_error(int err) { err_ = err; }
     int get_errno() const { return err_; }
 
     void set_err_msg(const std::string& err_msg) { err_msg_ = err_msg; }
-    std::string get_err_msg() { return err_msg_; }
+    std::string get_err_msg() const { return err_msg_; }
 
     void set_resp(const std::string& resp) { resp_ = resp; }
     std::string get_resp() const { return resp_; }
 
     void set_url(const std::string& url) { url_ = url; }
-    std::string get_url() { return url_; }
+    std::string get_url() const { return url_; }
 
     void set_body(const std::string& body) { body_ = body; }
-    std::string get_body() { return body_; }
+    std::string get_body() const { return body_; }
 
     void set_status_code(long status_code) { status_code_ = status_code; }
     long get_status_code() const { return status_code_; }
 
     void set_form(const std::map<std::string, std::string>& form) { form_ = form; }
-    std::map<std::string, std::string> get_form() { return form_; }
+    std::map<std::string, std::string> get_form() const { return form_; }
+
+    void set_obj(HttpObjectHandle obj) { obj_ = obj; }
+    HttpObjectHandle get_obj() const { return obj_; }
 
-    void set_obj(void* obj) { obj_ = obj; }
-    void* get_obj() { return obj_; }
+    // 应答的Location头，WHIP/WHEP用它给出会话资源地址
+    void set_location(const std::string& location) { location_ = location; }
+    std::string get_location() const { return location_; }
+
+    // 请求复用了连接池里的连接，没有新的TCP/TLS握手
+    void set_reused_connection(bool reused) { reused_connection_ = reused; }
+    bool get_reused_connection() const { return reused_connection_; }
 
 private:
     uint32_t duration_ = 0;
@@ -100,29 +126,40 @@ private:
     std::string body_;
     long status_code_ = 0;
     std::map<std::string, std::string> form_;
-    void* obj_ = nullptr;
+    std::string location_;
+    HttpObjectHandle obj_ = kInvalidHttpObjectHandle;
+    bool reused_connection_ = false;
 };
 
 class HttpRequestTask {
 public:
-    HttpRequestTask(CURLM* curlm, const HttpRequest& request, std::function<void(HttpReply)> resp_func);
+    HttpRequestTask(CURLM* curlm, CURLSH* share, const HttpRequest& request, std::function<void(HttpReply)> resp_func);
     ~HttpRequestTask();
 
     HttpReply Resp(int err, const std::string& err_msg, long status_code);
     std::function<void(HttpReply)> get_resp_func() { return resp_func_; }
     CURL* get_curl_handle() { return curl_; }
 
+    // 任务在HttpManager::request_list_中的位置，完成时O(1)删除
+    using Position = std::list<std::shared_ptr<HttpRequestTask>>::iterator;
+    void set_position(Position position) { position_ = position; }
+    Position get_position() { return position_; }
+
 protected:
     static size_t OnWriteData(void* buffer, size_t size, size_t nmemb, HttpRequestTask* _this);
     size_t OnHttpRequestTaskWriteData(void* buffer, size_t size, size_t nmemb);
+    static size_t OnHeaderData(char* buffer, size_t size, size_t nitems, HttpRequestTask* task);
 
 private:
     CURL* curl_ = nullptr;
     CURLM* curlm_ = nullptr;
+    curl_slist* headers_ = nullptr;
     std::string resp_;
+    std::string location_;
     std::function<void(HttpReply)> resp_func_;
     uint32_t start_time_ = 0;
     HttpRequest request_;
+    Position position_;
 };
 
 class HttpManager {
@@ -135,22 +172,44 @@ public:
     void Start();
     void Stop();
 
-    void Get(HttpRequest request, std::function<void(HttpReply)> resp, void* obj);
-    void Post(HttpRequest request, std::function<void(HttpReply)> resp, void* obj);
+    // obj为AddObject返回的句柄，对象RemoveObject之后完成的请求不再回调
+    void Get(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj);
+    void Post(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj);
+    void Patch(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj);
+    void Delete(HttpRequest request, std::function<void(HttpReply)> resp, HttpObjectHandle obj);
 
-    void AddObject(void* obj);
-    void RemoveObject(void* obj);
+    // 提前解析DNS并建立TCP/TLS连接，之后同一源的信令请求直接复用
+    void Prewarm(const std::string& url);
+
+    HttpObjectHandle AddObject();
+    void RemoveObject(HttpObjectHandle obj);
+    bool IsObjectAlive(HttpObjectHandle obj);
 
 private:
+    void AddHttpRequestTask(const HttpRequest& request, std::function<void(HttpReply)> resp);
+    // http_thread上把新任务的easy handle加入multi handle
+    void AddPendingHandles();
+    bool IsObjectAliveLocked(HttpObjectHandle obj);
+    static void OnShareLock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void OnShareUnlock(CURL* handle, curl_lock_data data, void* userptr);
     std::shared_ptr<HttpRequestTask> GetHttpRequestTask(CURL* handle);
 
 private:
     std::mutex mutex_;
     CURLM* multi_ = nullptr;
+    CURLSH* share_ = nullptr;
+    std::mutex share_mutexes_[CURL_LOCK_DATA_LAST];
     std::thread* http_thread_ = nullptr;
     std::list<std::shared_ptr<HttpRequestTask>> request_list_;
+    // 等待http_thread加入multi handle的easy handle，mutex_保护
+    std::vector<CURL*> pending_handles_;
     std::atomic<bool> running_{ false };
-    std::set<void*> async_objs_;
+
+    std::mutex objs_mutex_;
+    // 每个槽位当前的代数，奇数表示存活
+    std::vector<uint32_t> obj_generations_;
+    std::vector<uint32_t> free_obj_slots_;
+    HttpObjectHandle prewarm_obj_ = kInvalidHttpObjectHandle;
 };
 
 } // namespace xrtc
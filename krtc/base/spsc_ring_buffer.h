@@ -0,0 +1,87 @@
+#ifndef KRTCSDK_KRTC_BASE_SPSC_RING_BUFFER_H_
+#define KRTCSDK_KRTC_BASE_SPSC_RING_BUFFER_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace krtc {
+
+// 单生产者单消费者的环形缓冲区，读写两端都不加锁、不分配内存。
+// 读写位置单调递增，容量取2的幂，下标用掩码计算。
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t min_capacity) {
+        size_t capacity = 1;
+        while (capacity < min_capacity) {
+            capacity <<= 1;
+        }
+        buffer_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    size_t capacity() const { return buffer_.size(); }
+
+    // 生产者调用，返回实际写入的个数，空间不够时只写能放下的部分
+    size_t Write(const T* data, size_t count) {
+        size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+        size_t read_pos = read_pos_.load(std::memory_order_acquire);
+        count = std::min(count, capacity() - (write_pos - read_pos));
+        Copy(data, count, write_pos);
+        write_pos_.store(write_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    // 生产者调用，可写入的个数
+    size_t WritableSize() const {
+        return capacity() - (write_pos_.load(std::memory_order_relaxed) -
+            read_pos_.load(std::memory_order_acquire));
+    }
+
+    // 消费者调用，返回实际读出的个数
+    size_t Read(T* data, size_t count) {
+        size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+        size_t write_pos = write_pos_.load(std::memory_order_acquire);
+        count = std::min(count, write_pos - read_pos);
+        size_t offset = read_pos & mask_;
+        size_t first = std::min(count, capacity() - offset);
+        std::copy(buffer_.begin() + offset, buffer_.begin() + offset + first, data);
+        std::copy(buffer_.begin(), buffer_.begin() + (count - first), data + first);
+        read_pos_.store(read_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    // 消费者调用，丢弃最多count个
+    size_t Discard(size_t count) {
+        size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+        count = std::min(count, write_pos_.load(std::memory_order_acquire) - read_pos);
+        read_pos_.store(read_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    // 消费者调用，可读出的个数
+    size_t ReadableSize() const {
+        return write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Copy(const T* data, size_t count, size_t write_pos) {
+        size_t offset = write_pos & mask_;
+        size_t first = std::min(count, capacity() - offset);
+        std::copy(data, data + first, buffer_.begin() + offset);
+        std::copy(data + first, data + count, buffer_.begin());
+    }
+
+    std::vector<T> buffer_;
+    size_t mask_ = 0;
+    // 分开放在不同的缓存行，避免读写两端互相失效
+    alignas(64) std::atomic<size_t> write_pos_{ 0 };
+    alignas(64) std::atomic<size_t> read_pos_{ 0 };
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_BASE_SPSC_RING_BUFFER_H_
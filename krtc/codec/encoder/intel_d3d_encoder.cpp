@@ -3,6 +3,7 @@
 #include "libyuv.h"
 #include <Windows.h>
 #include <versionhelpers.h>
+#include <chrono>
 
 #define LOG(format, ...)  	\
 {								\
@@ -14,6 +15,12 @@
 namespace xop
 {
 
+static int64_t NowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 IntelD3DEncoder::IntelD3DEncoder()
 	: sps_buffer_(new mfxU8[1024])
 	, pps_buffer_(new mfxU8[1024])
@@ -114,6 +121,10 @@ bool IntelD3DEncoder::Init()
 		goto failed;
 	}
 
+	if (IsPipelined()) {
+		StartSyncThread();
+	}
+
 	return true;
 
 failed:
@@ -127,6 +138,7 @@ failed:
 void IntelD3DEncoder::Destroy()
 {
 	if (mfx_encoder_) {
+		StopSyncThread();
 		FreeBuffer();
 		FreeSurface();
 		mfx_encoder_->Close();
@@ -145,6 +157,7 @@ int IntelD3DEncoder::Encode(std::vector<uint8_t> in_image, std::vector<uint8_t>&
 		return -2;
 	}
 
+	int64_t submit_time_us = NowUs();
 	int frame_index = CopyImage(in_image);
 	if (frame_index < 0) {
 		return -3;
@@ -154,10 +167,224 @@ int IntelD3DEncoder::Encode(std::vector<uint8_t> in_image, std::vector<uint8_t>&
 	if (frame_size < 0) {
 		LOG("Encode frame failed.");
 	}
+	else if (frame_size > 0) {
+		UpdateEncodeLatency(NowUs() - submit_time_us);
+	}
 
 	return frame_size;
 }
 
+void IntelD3DEncoder::SetEncodedFrameCallback(const EncodedFrameCallback& callback)
+{
+	std::lock_guard<std::mutex> locker(pending_mutex_);
+	encoded_frame_callback_ = callback;
+}
+
+int IntelD3DEncoder::EncodeAsync(std::vector<uint8_t>& in_image, int64_t frame_tag)
+{
+	if (!mfx_encoder_ || !IsPipelined()) {
+		return -1;
+	}
+
+	if (!UpdateEvent()) {
+		return -2;
+	}
+
+	int bs_index = -1;
+	{
+		// Back-pressure: with async_depth_ frames in flight wait for the oldest one
+		std::unique_lock<std::mutex> locker(pending_mutex_);
+		pending_cond_.wait(locker, [this] { return !free_bs_index_.empty() || !sync_running_; });
+		if (!sync_running_) {
+			return -1;
+		}
+		bs_index = free_bs_index_.back();
+		free_bs_index_.pop_back();
+	}
+
+	auto release_bitstream = [this, bs_index] {
+		std::lock_guard<std::mutex> locker(pending_mutex_);
+		free_bs_index_.push_back(bs_index);
+	};
+
+	int64_t submit_time_us = NowUs();
+	int frame_index = CopyImage(in_image);
+	if (frame_index < 0) {
+		release_bitstream();
+		return -3;
+	}
+
+	mfxSyncPoint syncp = nullptr;
+	mfxStatus sts = SubmitFrame(frame_index, &async_bs_[bs_index], &syncp, bs_index);
+	if (sts != MFX_ERR_NONE || !syncp) {
+		release_bitstream();
+		if (sts == MFX_ERR_MORE_DATA) {
+			return 0;
+		}
+		LOG("Submit frame failed, %d.\n", sts);
+		return -4;
+	}
+
+	{
+		std::lock_guard<std::mutex> locker(pending_mutex_);
+		PendingFrame frame;
+		frame.syncp = syncp;
+		frame.bitstream_index = bs_index;
+		frame.frame_tag = frame_tag;
+		frame.submit_time_us = submit_time_us;
+		pending_frames_.push_back(frame);
+	}
+	pending_cond_.notify_all();
+
+	return 0;
+}
+
+void IntelD3DEncoder::StartSyncThread()
+{
+	{
+		std::lock_guard<std::mutex> locker(pending_mutex_);
+		sync_running_ = true;
+	}
+	sync_thread_.reset(new std::thread([this] {
+		SyncThread();
+	}));
+}
+
+void IntelD3DEncoder::StopSyncThread()
+{
+	{
+		std::lock_guard<std::mutex> locker(pending_mutex_);
+		sync_running_ = false;
+	}
+	pending_cond_.notify_all();
+
+	if (sync_thread_ && sync_thread_->joinable()) {
+		sync_thread_->join();
+	}
+	sync_thread_.reset();
+}
+
+void IntelD3DEncoder::WaitPendingFrames()
+{
+	if (!IsPipelined()) {
+		return;
+	}
+
+	// Every bitstream back in the free list means nothing is queued or being synced
+	std::unique_lock<std::mutex> locker(pending_mutex_);
+	pending_cond_.wait(locker, [this] {
+		return (pending_frames_.empty() && free_bs_index_.size() == async_bs_.size()) || !sync_running_;
+	});
+}
+
+void IntelD3DEncoder::SyncThread()
+{
+	for (;;) {
+		PendingFrame frame;
+		EncodedFrameCallback callback;
+		{
+			std::unique_lock<std::mutex> locker(pending_mutex_);
+			pending_cond_.wait(locker, [this] { return !pending_frames_.empty() || !sync_running_; });
+			if (pending_frames_.empty()) {
+				// stopped and drained
+				break;
+			}
+			frame = pending_frames_.front();
+			pending_frames_.pop_front();
+			callback = encoded_frame_callback_;
+		}
+
+		mfxBitstream& bs = async_bs_[frame.bitstream_index];
+		mfxStatus sts = mfx_session_.SyncOperation(frame.syncp, 60000);
+		if (sts == MFX_ERR_NONE && bs.DataLength > 0) {
+			UpdateEncodeLatency(NowUs() - frame.submit_time_us);
+
+			std::vector<uint8_t> out_frame(bs.Data + bs.DataOffset, bs.Data + bs.DataOffset + bs.DataLength);
+			int temporal_id = TakeTemporalId(out_frame);
+			if (callback) {
+				callback(out_frame, frame.frame_tag, temporal_id);
+			}
+		}
+		else if (sts != MFX_ERR_NONE) {
+			LOG("SyncOperation failed, %d.\n", sts);
+		}
+
+		bs.DataLength = 0;
+		bs.DataOffset = 0;
+
+		{
+			std::lock_guard<std::mutex> locker(pending_mutex_);
+			free_bs_index_.push_back(frame.bitstream_index);
+		}
+		pending_cond_.notify_all();
+	}
+}
+
+int IntelD3DEncoder::TakeTemporalId(std::vector<uint8_t>& out_frame)
+{
+	if (temporal_layers_ <= 1) {
+		return 0;
+	}
+
+	// MSDK writes temporal_id into SVC prefix NAL units (type 14) that WebRTC
+	// receivers don't understand, read it and strip them from the frame.
+	std::vector<std::pair<size_t, size_t>> nalus; // start code offset, payload offset
+	size_t size = out_frame.size();
+	for (size_t i = 0; i + 3 <= size; i++) {
+		if (out_frame[i] == 0 && out_frame[i + 1] == 0 && out_frame[i + 2] == 1) {
+			size_t start_code = (i > 0 && out_frame[i - 1] == 0) ? i - 1 : i;
+			nalus.emplace_back(start_code, i + 3);
+			i += 2;
+		}
+	}
+
+	int temporal_id = -1;
+	bool is_idr = false;
+	std::vector<uint8_t> stripped;
+	stripped.reserve(size);
+	for (size_t n = 0; n < nalus.size(); n++) {
+		size_t begin = nalus[n].first;
+		size_t payload = nalus[n].second;
+		size_t end = (n + 1 < nalus.size()) ? nalus[n + 1].first : size;
+		if (payload >= end) {
+			continue;
+		}
+
+		uint8_t nal_type = out_frame[payload] & 0x1f;
+		if (nal_type == 14) {
+			if (end - payload >= 4) {
+				temporal_id = (out_frame[payload + 3] >> 5) & 0x07;
+			}
+			continue;
+		}
+		if (nal_type == 5) {
+			is_idr = true;
+		}
+		stripped.insert(stripped.end(), out_frame.begin() + begin, out_frame.begin() + end);
+	}
+	if (!nalus.empty()) {
+		out_frame.swap(stripped);
+	}
+
+	// 没有前缀NAL时按二进制层级模式推算，IDR处重新开始
+	if (is_idr) {
+		temporal_frame_index_ = 0;
+	}
+	uint32_t position = temporal_frame_index_++ % (1u << (temporal_layers_ - 1));
+	if (temporal_id < 0) {
+		temporal_id = 0;
+		if (position != 0) {
+			int trailing_zeros = 0;
+			while (((position >> trailing_zeros) & 1) == 0) {
+				trailing_zeros++;
+			}
+			temporal_id = temporal_layers_ - 1 - trailing_zeros;
+		}
+	}
+
+	return std::min(temporal_id, temporal_layers_ - 1);
+}
+
 int IntelD3DEncoder::CopyImage(std::vector<uint8_t>& in_image)
 {
 	mfxStatus sts = MFX_ERR_NONE;
@@ -217,26 +444,71 @@ int IntelD3DEncoder::CopyImage(std::vector<uint8_t>& in_image)
 	return index;
 }
 
-int IntelD3DEncoder::EncodeFrame(int suface_index, std::vector<uint8_t>& out_frame)
+mfxEncodeCtrl* IntelD3DEncoder::PrepareEncodeCtrl(int ctrl_index)
+{
+	std::vector<EncodeRegion> regions = GetRegionsOfInterest();
+	if (ctrl_index < 0 || ctrl_index >= (int)enc_ctrls_.size()) {
+		return nullptr;
+	}
+
+	EncodeControl& control = enc_ctrls_[ctrl_index];
+	memset(&control.ctrl, 0, sizeof(mfxEncodeCtrl));
+	control.ctrl.FrameType = enc_ctrl_.FrameType;
+	enc_ctrl_.FrameType = 0;
+
+	if (qp_map_ && !regions.empty()) {
+		// Most hardware supports far fewer regions than the 256 slots of mfxExtEncoderROI
+		const size_t max_roi = 8;
+		memset(&control.roi, 0, sizeof(mfxExtEncoderROI));
+		control.roi.Header.BufferId = MFX_EXTBUFF_ENCODER_ROI;
+		control.roi.Header.BufferSz = sizeof(mfxExtEncoderROI);
+		control.roi.ROIMode = MFX_ROI_MODE_QP_DELTA;
+
+		for (size_t i = 0; i < regions.size() && control.roi.NumROI < max_roi; i++) {
+			// AVC needs macroblock aligned rectangles
+			int left = (std::max(regions[i].x, 0) >> 4) << 4;
+			int top = (std::max(regions[i].y, 0) >> 4) << 4;
+			int right = std::min((int)MSDK_ALIGN16(regions[i].x + regions[i].width), (int)MSDK_ALIGN16(width_));
+			int bottom = std::min((int)MSDK_ALIGN16(regions[i].y + regions[i].height), (int)MSDK_ALIGN16(height_));
+			if (left >= right || top >= bottom) {
+				continue;
+			}
+
+			auto& roi = control.roi.ROI[control.roi.NumROI++];
+			roi.Left = left;
+			roi.Top = top;
+			roi.Right = right;
+			roi.Bottom = bottom;
+			roi.DeltaQP = static_cast<mfxI16>(std::min(std::max(regions[i].qp_delta, -51), 51));
+		}
+
+		if (control.roi.NumROI > 0) {
+			control.ext_buffers[0] = (mfxExtBuffer*)&control.roi;
+			control.ctrl.ExtParam = control.ext_buffers;
+			control.ctrl.NumExtParam = 1;
+		}
+	}
+
+	if (!control.ctrl.FrameType && !control.ctrl.NumExtParam) {
+		return nullptr;
+	}
+	return &control.ctrl;
+}
+
+mfxStatus IntelD3DEncoder::SubmitFrame(int suface_index, mfxBitstream* bitstream, mfxSyncPoint* syncp, int ctrl_index)
 {
-	mfxSyncPoint syncp;
 	mfxStatus sts = MFX_ERR_NONE;
-	uint32_t frame_size = 0;
+	mfxEncodeCtrl* enc_ctrl = PrepareEncodeCtrl(ctrl_index);
 
 	for (;;) {
 		// Encode a frame asychronously (returns immediately)
-		mfxEncodeCtrl* enc_ctrl = nullptr;
-		if (enc_ctrl_.FrameType) {
-			enc_ctrl = &enc_ctrl_;
-		}
-		sts = mfx_encoder_->EncodeFrameAsync(enc_ctrl, &mfx_surfaces_[suface_index], &mfx_enc_bs_, &syncp);
-		enc_ctrl_.FrameType = 0;
+		sts = mfx_encoder_->EncodeFrameAsync(enc_ctrl, &mfx_surfaces_[suface_index], bitstream, syncp);
 
-		if (MFX_ERR_NONE < sts && !syncp) {  // Repeat the call if warning and no output
+		if (MFX_ERR_NONE < sts && !*syncp) {  // Repeat the call if warning and no output
 			if (MFX_WRN_DEVICE_BUSY == sts)
 				MSDK_SLEEP(1);  // Wait if device is busy, then repeat the same call
 		}
-		else if (MFX_ERR_NONE < sts && syncp) {
+		else if (MFX_ERR_NONE < sts && *syncp) {
 			sts = MFX_ERR_NONE;     // Ignore warnings if output is available
 			break;
 		}
@@ -244,11 +516,30 @@ int IntelD3DEncoder::EncodeFrame(int suface_index, std::vector<uint8_t>& out_fra
 			// Allocate more bitstream buffer memory here if needed...
 			break;
 		}
+		else if ((MFX_ERR_INVALID_VIDEO_PARAM == sts || MFX_ERR_UNSUPPORTED == sts)
+				 && enc_ctrl && enc_ctrl->NumExtParam) {
+			// Driver rejected the ROI for this rate control mode, stop sending it.
+			// Other errors (device lost, out of memory...) are returned to the caller.
+			LOG("ROI unsupported, %d.\n", sts);
+			qp_map_ = false;
+			enc_ctrl->NumExtParam = 0;
+			enc_ctrl->ExtParam = nullptr;
+		}
 		else {
 			break;
 		}
 	}
 
+	return sts;
+}
+
+int IntelD3DEncoder::EncodeFrame(int suface_index, std::vector<uint8_t>& out_frame)
+{
+	mfxSyncPoint syncp = nullptr;
+	uint32_t frame_size = 0;
+
+	mfxStatus sts = SubmitFrame(suface_index, &mfx_enc_bs_, &syncp, 0);
+
 	if (MFX_ERR_NONE == sts) {
 		sts = mfx_session_.SyncOperation(syncp, 60000);   // Synchronize. Wait until encoded frame is ready
 		MSDK_CHECK_RESULT(sts, MFX_ERR_NONE, sts);
@@ -270,6 +561,9 @@ int IntelD3DEncoder::EncodeFrame(int suface_index, std::vector<uint8_t>& out_fra
 
 			frame_size += mfx_enc_bs_.DataLength;
 			mfx_enc_bs_.DataLength = 0;
+
+			last_temporal_id_ = TakeTemporalId(out_frame);
+			frame_size = (uint32_t)out_frame.size();
 		}
 	}
 
@@ -286,6 +580,11 @@ bool IntelD3DEncoder::UpdateOption()
 	gop_ = GetOption(VE_OPT_GOP, 300);
 	dxgi_format_ = GetOption(VE_OPT_TEXTURE_FORMAT, 87);
 	codec_ = GetOption(VE_OPT_CODEC, VE_OPT_CODEC_H264);
+	async_depth_ = std::min(std::max(GetOption(VE_OPT_ASYNC_DEPTH, 1), 1), 4);
+	qp_map_ = GetOption(VE_OPT_QP_MAP, 0) != 0;
+	intra_refresh_frames_ = std::max(GetOption(VE_OPT_INTRA_REFRESH, 0), 0);
+	temporal_layers_ = std::min(std::max(GetOption(VE_OPT_TEMPORAL_LAYERS, 1), 1), 3);
+	temporal_frame_index_ = 0;
 
 	memset(&mfx_enc_params_, 0, sizeof(mfx_enc_params_));
 
@@ -342,8 +641,10 @@ bool IntelD3DEncoder::UpdateOption()
 	mfx_enc_params_.IOPattern = MFX_IOPATTERN_IN_VIDEO_MEMORY;
 
 	// Configuration for low latency
-	mfx_enc_params_.AsyncDepth = 1;  //1 is best for low latency
-	mfx_enc_params_.mfx.GopRefDist = 1; //1 is best for low latency, I and P frames only
+	// AsyncDepth 1 is best for low latency, >1 lets the GPU overlap in-flight frames.
+	// GopRefDist stays 1 in both modes: I and P frames only, no reordering lookahead.
+	mfx_enc_params_.AsyncDepth = static_cast<mfxU16>(async_depth_);
+	mfx_enc_params_.mfx.GopRefDist = 1;
 
 	memset(&extended_coding_options_, 0, sizeof(mfxExtCodingOption));
 	extended_coding_options_.Header.BufferId = MFX_EXTBUFF_CODING_OPTION;
@@ -358,12 +659,36 @@ bool IntelD3DEncoder::UpdateOption()
 	extended_coding_options2_.Header.BufferId = MFX_EXTBUFF_CODING_OPTION2;
 	extended_coding_options2_.Header.BufferSz = sizeof(mfxExtCodingOption2);
 	extended_coding_options2_.RepeatPPS = MFX_CODINGOPTION_OFF;
+	if (intra_refresh_frames_ > 0) {
+		// MSDK has no on-demand refresh, a vertical refresh column sweeps the picture
+		// every IntRefCycleSize frames so losses heal without waiting for an IDR
+		extended_coding_options2_.IntRefType = MFX_REFRESH_VERTICAL;
+		extended_coding_options2_.IntRefCycleSize = static_cast<mfxU16>(intra_refresh_frames_);
+	}
 
 	extended_buffers_[0] = (mfxExtBuffer*)(&extended_coding_options_);
 	extended_buffers_[1] = (mfxExtBuffer*)(&extended_coding_options2_);
 	mfx_enc_params_.ExtParam = extended_buffers_;
 	mfx_enc_params_.NumExtParam = 2;
 
+	if (temporal_layers_ > 1 && codec_ == VE_OPT_CODEC_H264) {
+		// hierarchical P, layer i runs at 1/Scale of the frame rate relative to the top layer
+		memset(&temporal_layers_option_, 0, sizeof(mfxExtAvcTemporalLayers));
+		temporal_layers_option_.Header.BufferId = MFX_EXTBUFF_AVC_TEMPORAL_LAYERS;
+		temporal_layers_option_.Header.BufferSz = sizeof(mfxExtAvcTemporalLayers);
+		for (int i = 0; i < temporal_layers_; i++) {
+			temporal_layers_option_.Layer[i].Scale = static_cast<mfxU16>(1 << i);
+		}
+		mfx_enc_params_.mfx.NumRefFrame = static_cast<mfxU16>(temporal_layers_);
+		// The DPB advertised in the SPS has to hold every frame the layers reference
+		extended_coding_options_.MaxDecFrameBuffering = mfx_enc_params_.mfx.NumRefFrame;
+		extended_buffers_[2] = (mfxExtBuffer*)(&temporal_layers_option_);
+		mfx_enc_params_.NumExtParam = 3;
+	}
+	else {
+		temporal_layers_ = 1;
+	}
+
 	return true;
 }
 
@@ -378,14 +703,10 @@ bool IntelD3DEncoder::UpdateEvent()
 		return true;
 	}
 
+	// Reset from the init params so the CodingOption/CodingOption2/temporal layer ext buffers
+	// survive, GetVideoParam returns the params without them.
 	bool config_updated = false;
-	mfxVideoParam video_param;
-	memset(&video_param, 0, sizeof(mfxVideoParam));
-	mfxStatus status = mfx_encoder_->GetVideoParam(&video_param);
-	MSDK_IGNORE_MFX_STS(status, MFX_WRN_INCOMPATIBLE_VIDEO_PARAM);
-	if (status != MFX_ERR_NONE) {
-		return false;
-	}
+	mfxVideoParam video_param = mfx_enc_params_;
 
 	for (auto iter : encoder_events) {
 		int event = iter.first;
@@ -397,6 +718,12 @@ bool IntelD3DEncoder::UpdateEvent()
 			enc_ctrl_.FrameType = MFX_FRAMETYPE_I | MFX_FRAMETYPE_IDR | MFX_FRAMETYPE_REF;
 			break;
 
+		case VE_EVENT_INTRA_REFRESH:
+			if (intra_refresh_frames_ == 0) {
+				enc_ctrl_.FrameType = MFX_FRAMETYPE_I | MFX_FRAMETYPE_IDR | MFX_FRAMETYPE_REF;
+			}
+			break;
+
 		case VE_EVENT_RESET_BITRATE_KBPS:
 			config_updated = true;
 			video_param.mfx.TargetKbps= value;
@@ -413,13 +740,17 @@ bool IntelD3DEncoder::UpdateEvent()
 	}
 
 	if (config_updated) {
-		if (status == MFX_ERR_NONE) {
-			status = mfx_encoder_->Reset(&video_param);
-			MSDK_IGNORE_MFX_STS(status, MFX_WRN_INCOMPATIBLE_VIDEO_PARAM);
-			if (status != MFX_ERR_NONE) {
-				return false;
-			}
+		// Reset must not race frames still owned by the sync thread
+		WaitPendingFrames();
+		mfxStatus status = mfx_encoder_->Reset(&video_param);
+		MSDK_IGNORE_MFX_STS(status, MFX_WRN_INCOMPATIBLE_VIDEO_PARAM);
+		if (status != MFX_ERR_NONE) {
+			return false;
 		}
+		mfx_enc_params_.mfx.TargetKbps = video_param.mfx.TargetKbps;
+		mfx_enc_params_.mfx.FrameInfo.FrameRateExtN = video_param.mfx.FrameInfo.FrameRateExtN;
+		bitrate_kbps_ = video_param.mfx.TargetKbps;
+		frame_rate_ = video_param.mfx.FrameInfo.FrameRateExtN;
 	}
 
 	return true;
@@ -482,6 +813,22 @@ bool IntelD3DEncoder::AllocateBuffer()
 	mfx_enc_bs_.MaxLength = param.mfx.BufferSizeInKB * 1000;
 	bst_enc_data_.resize(mfx_enc_bs_.MaxLength);
 	mfx_enc_bs_.Data = bst_enc_data_.data();
+
+	// one encode control per bitstream, index 0 in low latency mode
+	enc_ctrls_.resize(async_depth_);
+
+	if (IsPipelined()) {
+		async_bs_.resize(async_depth_);
+		async_bs_data_.resize(async_depth_);
+		free_bs_index_.clear();
+		for (int i = 0; i < async_depth_; i++) {
+			memset(&async_bs_[i], 0, sizeof(mfxBitstream));
+			async_bs_[i].MaxLength = mfx_enc_bs_.MaxLength;
+			async_bs_data_[i].resize(async_bs_[i].MaxLength);
+			async_bs_[i].Data = async_bs_data_[i].data();
+			free_bs_index_.push_back(i);
+		}
+	}
 	return true;
 }
 
@@ -489,6 +836,10 @@ void IntelD3DEncoder::FreeBuffer()
 {
 	memset(&mfx_enc_bs_, 0, sizeof(mfxBitstream));
 	bst_enc_data_.clear();
+	async_bs_.clear();
+	async_bs_data_.clear();
+	free_bs_index_.clear();
+	enc_ctrls_.clear();
 }
 
 bool IntelD3DEncoder::GetVideoParam()
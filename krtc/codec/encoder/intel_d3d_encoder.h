@@ -6,6 +6,10 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <deque>
+#include <thread>
+#include <functional>
+#include <condition_variable>
 
 namespace xop {
 
@@ -22,7 +26,31 @@ public:
 
 	virtual int  Encode(std::vector<uint8_t> image, std::vector<uint8_t>& out_frame);
 
+	// Pipelined mode (VE_OPT_ASYNC_DEPTH > 1): EncodeAsync() returns once the frame
+	// is queued on the GPU, the sync thread hands finished frames to the callback
+	// in submit order. frame_tag is passed back untouched.
+	using EncodedFrameCallback = std::function<void(std::vector<uint8_t>& out_frame, int64_t frame_tag, int temporal_id)>;
+	void SetEncodedFrameCallback(const EncodedFrameCallback& callback);
+	bool IsPipelined() const { return async_depth_ > 1; }
+	virtual int  EncodeAsync(std::vector<uint8_t>& in_image, int64_t frame_tag);
+
 private:
+	struct PendingFrame
+	{
+		mfxSyncPoint syncp = nullptr;
+		int bitstream_index = 0;
+		int64_t frame_tag = 0;
+		int64_t submit_time_us = 0;
+	};
+
+	// Per in-flight frame, MSDK reads it until the frame is synced
+	struct EncodeControl
+	{
+		mfxEncodeCtrl ctrl;
+		mfxExtEncoderROI roi;
+		mfxExtBuffer* ext_buffers[1];
+	};
+
 	bool UpdateOption();
 	bool UpdateEvent();
 	bool AllocateSurfaces();
@@ -32,6 +60,14 @@ private:
 	bool GetVideoParam();
 	int  CopyImage(std::vector<uint8_t>& in_image);
 	int  EncodeFrame(int suface_index, std::vector<uint8_t>& out_frame);
+	mfxStatus SubmitFrame(int suface_index, mfxBitstream* bitstream, mfxSyncPoint* syncp, int ctrl_index);
+	mfxEncodeCtrl* PrepareEncodeCtrl(int ctrl_index);
+	int  TakeTemporalId(std::vector<uint8_t>& out_frame);
+	void StartSyncThread();
+	void StopSyncThread();
+	void SyncThread();
+	// Blocks until the sync thread has handed back every in-flight frame
+	void WaitPendingFrames();
 
 	bool use_d3d11_ = false;
 	bool use_d3d9_ = false;
@@ -44,6 +80,11 @@ private:
 	int gop_ = 300;
 	int codec_ = 1;
 	int dxgi_format_ = 87;
+	int async_depth_ = 1;
+	bool qp_map_ = false;
+	int intra_refresh_frames_ = 0;
+	int temporal_layers_ = 1;
+	uint32_t temporal_frame_index_ = 0;
 
 	mfxIMPL                mfx_impl_;
 	mfxVersion             mfx_ver_;
@@ -54,8 +95,10 @@ private:
 	mfxFrameAllocResponse  mfx_alloc_response_;
 	mfxExtCodingOption     extended_coding_options_;
 	mfxExtCodingOption2    extended_coding_options2_;
-	mfxExtBuffer* extended_buffers_[2];
+	mfxExtAvcTemporalLayers temporal_layers_option_;
+	mfxExtBuffer* extended_buffers_[3];
 	mfxEncodeCtrl          enc_ctrl_;
+	std::vector<EncodeControl> enc_ctrls_;
 
 	std::unique_ptr<MFXVideoENCODE> mfx_encoder_;
 
@@ -63,6 +106,17 @@ private:
 	std::vector<mfxU8>     bst_enc_data_;
 	std::vector<mfxFrameSurface1> mfx_surfaces_;
 
+	// pipelined mode, one bitstream per in-flight frame
+	std::vector<mfxBitstream> async_bs_;
+	std::vector<std::vector<mfxU8>> async_bs_data_;
+	std::vector<int> free_bs_index_;
+	std::deque<PendingFrame> pending_frames_;
+	std::mutex pending_mutex_;
+	std::condition_variable pending_cond_;
+	std::unique_ptr<std::thread> sync_thread_;
+	bool sync_running_ = false;
+	EncodedFrameCallback encoded_frame_callback_;
+
 	mfxU16 sps_size_ = 0;
 	mfxU16 pps_size_ = 0;
 	std::unique_ptr<mfxU8[]> sps_buffer_;
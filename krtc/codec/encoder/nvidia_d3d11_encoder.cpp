@@ -122,6 +122,46 @@ bool NvidiaD3D11Encoder::Init()
 	initialize_params.encodeConfig->rcParams.averageBitRate = bitrate_kbps_ * 1000;
 	initialize_params.encodeConfig->rcParams.maxBitRate = bitrate_kbps_ * 1000;
 	initialize_params.encodeConfig->rcParams.rateControlMode = NV_ENC_PARAMS_RC_CBR;
+	if (qp_map_) {
+		initialize_params.encodeConfig->rcParams.qpMapMode = NV_ENC_QP_MAP_DELTA;
+	}
+
+	if (intra_refresh_frames_ > 0 && !nv_encoder_->GetCapabilityValue(nv_codec_id_, NV_ENC_CAPS_SUPPORT_INTRA_REFRESH)) {
+		LOG("Intra refresh unsupported.\n");
+		intra_refresh_frames_ = 0;
+	}
+
+	if (intra_refresh_frames_ > 0) {
+		// refresh waves are only started on demand, see UpdateIntraRefresh()
+		if (codec_ == VE_OPT_CODEC_HEVC) {
+			initialize_params.encodeConfig->encodeCodecConfig.hevcConfig.enableIntraRefresh = 1;
+			initialize_params.encodeConfig->encodeCodecConfig.hevcConfig.intraRefreshPeriod = gop_;
+			initialize_params.encodeConfig->encodeCodecConfig.hevcConfig.intraRefreshCnt = intra_refresh_frames_;
+		}
+		else {
+			initialize_params.encodeConfig->encodeCodecConfig.h264Config.enableIntraRefresh = 1;
+			initialize_params.encodeConfig->encodeCodecConfig.h264Config.intraRefreshPeriod = gop_;
+			initialize_params.encodeConfig->encodeCodecConfig.h264Config.intraRefreshCnt = intra_refresh_frames_;
+		}
+	}
+
+	if (temporal_layers_ > 1 && (codec_ != VE_OPT_CODEC_H264 ||
+		nv_encoder_->GetCapabilityValue(nv_codec_id_, NV_ENC_CAPS_NUM_MAX_LTR_FRAMES) < temporal_layers_ - 1)) {
+		LOG("Temporal layers unsupported.\n");
+		temporal_layers_ = 1;
+	}
+
+	if (temporal_layers_ > 1) {
+		// Layers are built from per-picture LTR marking (see UpdateTemporalLayer), an IDR
+		// inside the pattern would break it so periodic IDRs are issued by us as well
+		initialize_params.encodeConfig->gopLength = NVENC_INFINITE_GOPLENGTH;
+		initialize_params.encodeConfig->encodeCodecConfig.h264Config.idrPeriod = NVENC_INFINITE_GOPLENGTH;
+		initialize_params.encodeConfig->encodeCodecConfig.h264Config.enableLTR = 1;
+		initialize_params.encodeConfig->encodeCodecConfig.h264Config.ltrTrustMode = 0;
+		initialize_params.encodeConfig->encodeCodecConfig.h264Config.ltrNumFrames = temporal_layers_ - 1;
+		initialize_params.encodeConfig->encodeCodecConfig.h264Config.maxNumRefFrames = temporal_layers_;
+	}
+	temporal_frame_index_ = 0;
 
 	try {
 		nv_encoder_->CreateEncoder(&initialize_params);
@@ -189,8 +229,12 @@ int NvidiaD3D11Encoder::Encode(std::vector<uint8_t> in_image, std::vector<uint8_
 	ID3D11Texture2D* input_texture = reinterpret_cast<ID3D11Texture2D*>(input_frame->inputPtr);
 	d3d11_context_->CopyResource(input_texture, d3d11_copy_texture_);
 
+	NV_ENC_PIC_PARAMS pic_params = {};
 	std::vector<std::vector<uint8_t>> packets;
-	nv_encoder_->EncodeFrame(packets);
+	bool has_pic_params = UpdateQpDeltaMap(&pic_params);
+	has_pic_params = UpdateIntraRefresh(&pic_params) || has_pic_params;
+	has_pic_params = UpdateTemporalLayer(&pic_params) || has_pic_params;
+	nv_encoder_->EncodeFrame(packets, has_pic_params ? &pic_params : nullptr);
 
 	int frame_size = 0;
 	for (std::vector<uint8_t>& packet : packets) {
@@ -223,8 +267,12 @@ int NvidiaD3D11Encoder::Encode(HANDLE shared_handle, std::vector<uint8_t>& out_f
 	ID3D11Texture2D* input_texture = reinterpret_cast<ID3D11Texture2D*>(input_frame->inputPtr);
 	d3d11_context_->CopyResource(input_texture, shared_texture);
 
+	NV_ENC_PIC_PARAMS pic_params = {};
 	std::vector<std::vector<uint8_t>> packets;
-	nv_encoder_->EncodeFrame(packets);
+	bool has_pic_params = UpdateQpDeltaMap(&pic_params);
+	has_pic_params = UpdateIntraRefresh(&pic_params) || has_pic_params;
+	has_pic_params = UpdateTemporalLayer(&pic_params) || has_pic_params;
+	nv_encoder_->EncodeFrame(packets, has_pic_params ? &pic_params : nullptr);
 
 	if (shared_texture) {
 		shared_texture->Release();
@@ -351,6 +399,9 @@ bool NvidiaD3D11Encoder::UpdateOption()
 	gop_          = GetOption(VE_OPT_GOP, 300);
 	dxgi_format_  = GetOption(VE_OPT_TEXTURE_FORMAT, 87);
 	codec_        = GetOption(VE_OPT_CODEC, VE_OPT_CODEC_H264);
+	qp_map_       = GetOption(VE_OPT_QP_MAP, 0) != 0;
+	intra_refresh_frames_ = std::max(GetOption(VE_OPT_INTRA_REFRESH, 0), 0);
+	temporal_layers_ = std::min(std::max(GetOption(VE_OPT_TEMPORAL_LAYERS, 1), 1), 3);
 
 	if (dxgi_format_ == VE_OPT_FORMAT_NV12) {
 		nv_buffer_format_ = NV_ENC_BUFFER_FORMAT_NV12;
@@ -405,6 +456,17 @@ void NvidiaD3D11Encoder::UpdateEvent()
 		{
 		case VE_EVENT_FORCE_IDR:
 			nv_encoder_->ForceIDR();
+			temporal_frame_index_ = 0;
+			break;
+
+		case VE_EVENT_INTRA_REFRESH:
+			if (intra_refresh_frames_ > 0) {
+				intra_refresh_pending_ = true;
+			}
+			else {
+				nv_encoder_->ForceIDR();
+				temporal_frame_index_ = 0;
+			}
 			break;
 
 		case VE_EVENT_RESET_BITRATE_KBPS: 
@@ -440,4 +502,98 @@ void NvidiaD3D11Encoder::UpdateEvent()
 	}
 }
 
+bool NvidiaD3D11Encoder::UpdateQpDeltaMap(NV_ENC_PIC_PARAMS* pic_params)
+{
+	std::vector<EncodeRegion> regions = GetRegionsOfInterest();
+	if (!qp_map_ || regions.empty()) {
+		return false;
+	}
+
+	// one value per macroblock (H.264) or CTB (HEVC), raster order
+	int mb_size = (codec_ == VE_OPT_CODEC_HEVC) ? 32 : 16;
+	int mb_cols = (width_ + mb_size - 1) / mb_size;
+	int mb_rows = (height_ + mb_size - 1) / mb_size;
+	qp_delta_map_.assign(mb_cols * mb_rows, 0);
+
+	// paint lowest priority first so the first region ends up on top
+	for (auto iter = regions.rbegin(); iter != regions.rend(); iter++) {
+		int x0 = std::max(iter->x, 0) / mb_size;
+		int y0 = std::max(iter->y, 0) / mb_size;
+		int x1 = std::min((iter->x + iter->width + mb_size - 1) / mb_size, mb_cols);
+		int y1 = std::min((iter->y + iter->height + mb_size - 1) / mb_size, mb_rows);
+		if (x0 >= x1 || y0 >= y1) {
+			continue;
+		}
+
+		int8_t qp_delta = static_cast<int8_t>(std::min(std::max(iter->qp_delta, -51), 51));
+		for (int y = y0; y < y1; y++) {
+			memset(&qp_delta_map_[y * mb_cols + x0], qp_delta, x1 - x0);
+		}
+	}
+
+	pic_params->qpDeltaMap = qp_delta_map_.data();
+	pic_params->qpDeltaMapSize = static_cast<uint32_t>(qp_delta_map_.size());
+	return true;
+}
+
+bool NvidiaD3D11Encoder::UpdateIntraRefresh(NV_ENC_PIC_PARAMS* pic_params)
+{
+	if (!intra_refresh_pending_) {
+		return false;
+	}
+	intra_refresh_pending_ = false;
+
+	if (codec_ == VE_OPT_CODEC_HEVC) {
+		pic_params->codecPicParams.hevcPicParams.forceIntraRefreshWithFrameCnt = intra_refresh_frames_;
+	}
+	else {
+		pic_params->codecPicParams.h264PicParams.forceIntraRefreshWithFrameCnt = intra_refresh_frames_;
+	}
+	return true;
+}
+
+bool NvidiaD3D11Encoder::UpdateTemporalLayer(NV_ENC_PIC_PARAMS* pic_params)
+{
+	if (temporal_layers_ <= 1) {
+		last_temporal_id_ = 0;
+		return false;
+	}
+
+	// keep the periodic IDR on a pattern boundary
+	uint32_t pattern_size = (temporal_layers_ == 3) ? 4 : 2;
+	uint32_t idr_interval = std::max((uint32_t)gop_ / pattern_size, 1u) * pattern_size;
+	if (gop_ > 0 && temporal_frame_index_ >= idr_interval) {
+		temporal_frame_index_ = 0;
+	}
+
+	// L1T2: T0 T1 T0 T1 ...      every frame references the last T0 (LTR 0)
+	// L1T3: T0 T2 T1 T2 T0 ...   T1 is kept as LTR 1 for the second T2
+	NV_ENC_PIC_PARAMS_H264& h264_params = pic_params->codecPicParams.h264PicParams;
+	uint32_t position = temporal_frame_index_ % pattern_size;
+	if (position == 0) {
+		last_temporal_id_ = 0;
+		h264_params.ltrMarkFrame = 1;
+		h264_params.ltrMarkFrameIdx = 0;
+	}
+	else if (temporal_layers_ == 3 && position == 2) {
+		last_temporal_id_ = 1;
+		h264_params.ltrMarkFrame = 1;
+		h264_params.ltrMarkFrameIdx = 1;
+	}
+	else {
+		last_temporal_id_ = temporal_layers_ - 1;
+	}
+
+	if (temporal_frame_index_ == 0) {
+		pic_params->encodePicFlags |= NV_ENC_PIC_FLAG_FORCEIDR;
+	}
+	else {
+		h264_params.ltrUseFrames = 1;
+		h264_params.ltrUseFrameBitmap = (temporal_layers_ == 3 && position == 3) ? 0x2 : 0x1;
+	}
+
+	temporal_frame_index_++;
+	return true;
+}
+
 }
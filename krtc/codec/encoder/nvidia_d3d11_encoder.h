@@ -25,6 +25,9 @@ public:
 private:
 	bool UpdateOption();
 	void UpdateEvent();
+	bool UpdateQpDeltaMap(NV_ENC_PIC_PARAMS* pic_params);
+	bool UpdateIntraRefresh(NV_ENC_PIC_PARAMS* pic_params);
+	bool UpdateTemporalLayer(NV_ENC_PIC_PARAMS* pic_params);
 	bool InitD3D11();
 	void ClearD3D11();
 
@@ -42,6 +45,13 @@ private:
 	int gop_           = 300;
 	int dxgi_format_   = 87;
 	int codec_         = 1;
+	bool qp_map_       = false;
+	int intra_refresh_frames_    = 0;
+	bool intra_refresh_pending_  = false;
+	int temporal_layers_         = 1;
+	uint32_t temporal_frame_index_ = 0;
+
+	std::vector<int8_t> qp_delta_map_;
 
 	NV_ENC_BUFFER_FORMAT nv_buffer_format_ = NV_ENC_BUFFER_FORMAT_ARGB;
 	GUID nv_codec_id_ = NV_ENC_CODEC_H264_GUID;
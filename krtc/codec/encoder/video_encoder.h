@@ -4,6 +4,7 @@
 #include <vector>
 #include <mutex>
 #include <map>
+#include <algorithm>
 
 namespace xop
 {
@@ -31,6 +32,10 @@ enum VIDEO_ENCODER_OPTION
 	VE_OPT_GOP,
 	VE_OPT_CODEC,
 	VE_OPT_TEXTURE_FORMAT,
+	VE_OPT_ASYNC_DEPTH,     // 1: low latency (sync per frame), 2~4: pipelined
+	VE_OPT_QP_MAP,          // 1: accept per-frame regions of interest
+	VE_OPT_INTRA_REFRESH,   // frames per intra refresh wave, 0: off
+	VE_OPT_TEMPORAL_LAYERS, // 1~3, hierarchical P (L1T2 / L1T3)
 };
 
 enum VIDEO_ENCODER_EVENT
@@ -38,7 +43,26 @@ enum VIDEO_ENCODER_EVENT
 	VE_EVENT_UNKNOW = 0,
 	VE_EVENT_FORCE_IDR,
 	VE_EVENT_RESET_BITRATE_KBPS,
-	VE_EVENT_RESET_FRAME_RATE
+	VE_EVENT_RESET_FRAME_RATE,
+	VE_EVENT_INTRA_REFRESH
+};
+
+struct EncodeLatencyStats
+{
+	uint32_t frames   = 0;
+	int64_t  last_us  = 0;
+	int64_t  avg_us   = 0;
+	int64_t  max_us   = 0;
+};
+
+// Pixel rectangle with a QP modifier on top of rate control, < 0 spends more bits.
+struct EncodeRegion
+{
+	int x        = 0;
+	int y        = 0;
+	int width    = 0;
+	int height   = 0;
+	int qp_delta = 0;
 };
 
 class VideoEncoder
@@ -81,14 +105,63 @@ public:
 		return events;
 	}
 
+	//  set before Encode(), applies to the next frame only.
+	//  Regions are in priority order, the first one covering a block wins.
+	void SetRegionsOfInterest(const std::vector<EncodeRegion>& regions)
+	{
+		std::lock_guard<std::mutex> locker(roi_mutex_);
+		encoder_regions_ = regions;
+	}
+
+	std::vector<EncodeRegion> GetRegionsOfInterest()
+	{
+		std::lock_guard<std::mutex> locker(roi_mutex_);
+		std::vector<EncodeRegion> regions;
+		regions.swap(encoder_regions_);
+		return regions;
+	}
+
+	// submit -> bitstream ready, accumulated since the last reset
+	EncodeLatencyStats GetEncodeLatencyStats(bool reset = true)
+	{
+		std::lock_guard<std::mutex> locker(latency_mutex_);
+		EncodeLatencyStats stats = latency_stats_;
+		if (stats.frames > 0) {
+			stats.avg_us = latency_sum_us_ / stats.frames;
+		}
+		if (reset) {
+			latency_stats_ = EncodeLatencyStats();
+			latency_sum_us_ = 0;
+		}
+		return stats;
+	}
+
+	// temporal layer of the frame last returned by Encode(), 0 without layering
+	int GetLastTemporalId() const { return last_temporal_id_; }
+
 	virtual bool Init()     = 0;
 	virtual void Destroy()  = 0;
 
 protected:
+	void UpdateEncodeLatency(int64_t latency_us)
+	{
+		std::lock_guard<std::mutex> locker(latency_mutex_);
+		latency_stats_.frames++;
+		latency_stats_.last_us = latency_us;
+		latency_stats_.max_us = std::max(latency_stats_.max_us, latency_us);
+		latency_sum_us_ += latency_us;
+	}
+
 	std::mutex option_mutex_;
 	std::map<int, int> encoder_options_;
 	std::mutex event_mutex_;
 	std::map<int, int> encoder_events_;
+	std::mutex roi_mutex_;
+	std::vector<EncodeRegion> encoder_regions_;
+	std::mutex latency_mutex_;
+	EncodeLatencyStats latency_stats_;
+	int64_t latency_sum_us_ = 0;
+	int last_temporal_id_ = 0;
 };
 
 }
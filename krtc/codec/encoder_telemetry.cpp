@@ -0,0 +1,186 @@
+#include "encoder_telemetry.h"
+
+#include <algorithm>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+namespace {
+
+int SizeBucket(uint32_t size_bytes)
+{
+	int bucket = 0;
+	uint32_t bound = 2048;
+	while (bucket < KRTCEncoderStats::kSizeBuckets - 1 && size_bytes >= bound) {
+		bound <<= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+int QpBucket(int qp)
+{
+	if (qp < 20) {
+		return 0;
+	}
+	return std::min((qp - 15) / 5, KRTCEncoderStats::kQpBuckets - 1);
+}
+
+}  // namespace
+
+EncoderTelemetry::EncoderTelemetry(const char* implementation)
+	: implementation_(implementation)
+{
+}
+
+void EncoderTelemetry::RecordFrame(int64_t time_ms, uint32_t size_bytes, int qp, bool key_frame)
+{
+	FrameRecord record;
+	record.time_ms = time_ms;
+	record.size_bytes = size_bytes;
+	record.target_bps = target_bps_;
+	record.qp = qp;
+	record.key_frame = key_frame;
+	Record(record);
+}
+
+void EncoderTelemetry::RecordDrop(int64_t time_ms)
+{
+	FrameRecord record;
+	record.time_ms = time_ms;
+	record.target_bps = target_bps_;
+	record.dropped = true;
+	Record(record);
+}
+
+void EncoderTelemetry::SetKeyFrameRequestCounts(uint32_t requests, uint32_t coalesced, uint32_t intra_refreshes)
+{
+	key_frame_requests_ = requests;
+	coalesced_key_frame_requests_ = coalesced;
+	intra_refreshes_ = intra_refreshes;
+}
+
+void EncoderTelemetry::Record(const FrameRecord& record)
+{
+	uint64_t index = write_index_.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = slots_[index % kRingSize];
+
+	// 奇数：正在写；偶数：写完，值里带上index防止读到被覆盖过一圈的旧数据
+	slot.seq.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.record = record;
+	slot.seq.store(index * 2 + 2, std::memory_order_release);
+}
+
+bool EncoderTelemetry::GetStats(int64_t now_ms, KRTCEncoderStats* stats) const
+{
+	*stats = KRTCEncoderStats();
+	stats->implementation = implementation_;
+
+	uint64_t end = write_index_.load(std::memory_order_acquire);
+	uint64_t begin = end > kRingSize ? end - kRingSize : 0;
+
+	uint64_t total_bytes = 0;
+	uint64_t total_target_bps = 0;
+	int64_t total_qp = 0;
+	uint32_t qp_frames = 0;
+	uint32_t records = 0;
+	int64_t oldest_ms = now_ms;
+
+	for (uint64_t index = end; index > begin; index--) {
+		const Slot& slot = slots_[(index - 1) % kRingSize];
+		uint64_t seq = slot.seq.load(std::memory_order_acquire);
+		if (seq != index * 2) {
+			continue;
+		}
+		FrameRecord record = slot.record;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) != seq) {
+			continue;
+		}
+
+		if (now_ms - record.time_ms > KRTCEncoderStats::kWindowMs) {
+			break;
+		}
+
+		records++;
+		oldest_ms = std::min(oldest_ms, record.time_ms);
+		total_target_bps += record.target_bps;
+
+		if (record.dropped) {
+			stats->dropped_frames++;
+			continue;
+		}
+
+		stats->frames++;
+		if (record.key_frame) {
+			stats->key_frames++;
+		}
+		total_bytes += record.size_bytes;
+		stats->max_frame_bytes = std::max(stats->max_frame_bytes, record.size_bytes);
+		stats->size_histogram[SizeBucket(record.size_bytes)]++;
+
+		if (record.qp >= 0) {
+			total_qp += record.qp;
+			qp_frames++;
+			stats->min_qp = (stats->min_qp < 0) ? record.qp : std::min(stats->min_qp, record.qp);
+			stats->max_qp = std::max(stats->max_qp, record.qp);
+			stats->qp_histogram[QpBucket(record.qp)]++;
+		}
+	}
+
+	if (records == 0) {
+		return false;
+	}
+
+	// 刚开始编码时窗口不满，按实际时长算，至少1秒
+	int64_t span_ms = std::max<int64_t>(now_ms - oldest_ms, 1000);
+	stats->actual_bps = static_cast<uint32_t>(total_bytes * 8 * 1000 / span_ms);
+	stats->target_bps = static_cast<uint32_t>(total_target_bps / records);
+	if (stats->target_bps > 0) {
+		stats->rc_tracking_error = (static_cast<float>(stats->actual_bps) - stats->target_bps) / stats->target_bps;
+	}
+	if (stats->frames > 0) {
+		stats->avg_frame_bytes = static_cast<uint32_t>(total_bytes / stats->frames);
+	}
+	if (qp_frames > 0) {
+		stats->avg_qp = static_cast<int32_t>(total_qp / qp_frames);
+	}
+
+	return true;
+}
+
+void EncoderTelemetry::MaybeReport(int64_t now_ms)
+{
+	if (now_ms - last_report_ms_ < 1000) {
+		return;
+	}
+	last_report_ms_ = now_ms;
+
+	KRTCEncoderStats stats;
+	if (!GetStats(now_ms, &stats)) {
+		return;
+	}
+	stats.key_frame_requests = key_frame_requests_;
+	stats.coalesced_key_frame_requests = coalesced_key_frame_requests_;
+	stats.intra_refreshes = intra_refreshes_;
+
+	if (KRTCGlobal::Instance()->engine_observer()) {
+		KRTCGlobal::Instance()->engine_observer()->OnEncoderStats(stats);
+	}
+}
+
+void EncoderTelemetry::Reset()
+{
+	for (Slot& slot : slots_) {
+		slot.seq.store(0, std::memory_order_relaxed);
+	}
+	write_index_.store(0, std::memory_order_release);
+	last_report_ms_ = 0;
+	key_frame_requests_ = 0;
+	coalesced_key_frame_requests_ = 0;
+	intra_refreshes_ = 0;
+}
+
+}  // namespace krtc
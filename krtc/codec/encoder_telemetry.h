@@ -0,0 +1,69 @@
+#ifndef KRTCSDK_KRTC_CODEC_ENCODER_TELEMETRY_H_
+#define KRTCSDK_KRTC_CODEC_ENCODER_TELEMETRY_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 每个编码器一份，固定大小的环形缓冲记录最近的编码帧。
+// Record()可以在编码线程或QSV的sync线程调用，GetStats()随时读取，均不加锁：
+// 每个槽位带一个序号(seqlock)，读到正在写的槽位直接跳过。
+class EncoderTelemetry {
+public:
+	struct FrameRecord
+	{
+		int64_t time_ms = 0;
+		uint32_t size_bytes = 0;
+		uint32_t target_bps = 0;
+		int qp = -1;
+		bool key_frame = false;
+		bool dropped = false;
+	};
+
+	static const size_t kRingSize = 512;
+
+	explicit EncoderTelemetry(const char* implementation);
+
+	void SetTargetBitrate(uint32_t target_bps) { target_bps_ = target_bps; }
+	uint32_t target_bitrate() const { return target_bps_; }
+
+	void RecordFrame(int64_t time_ms, uint32_t size_bytes, int qp, bool key_frame);
+	void RecordDrop(int64_t time_ms);
+
+	// Cumulative counters owned by the encode thread, copied into each report.
+	void SetKeyFrameRequestCounts(uint32_t requests, uint32_t coalesced, uint32_t intra_refreshes);
+
+	// Aggregates the records of the last KRTCEncoderStats::kWindowMs.
+	bool GetStats(int64_t now_ms, KRTCEncoderStats* stats) const;
+
+	// Posts OnEncoderStats at most once per second, call from the encode thread.
+	void MaybeReport(int64_t now_ms);
+
+	void Reset();
+
+private:
+	struct Slot
+	{
+		std::atomic<uint64_t> seq{ 0 };
+		FrameRecord record;
+	};
+
+	void Record(const FrameRecord& record);
+
+	const char* implementation_;
+	std::atomic<uint32_t> target_bps_{ 0 };
+	std::atomic<uint64_t> write_index_{ 0 };
+	std::array<Slot, kRingSize> slots_;
+	int64_t last_report_ms_ = 0;
+	uint32_t key_frame_requests_ = 0;
+	uint32_t coalesced_key_frame_requests_ = 0;
+	uint32_t intra_refreshes_ = 0;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_CODEC_ENCODER_TELEMETRY_H_
@@ -0,0 +1,65 @@
+#ifndef KRTCSDK_KRTC_CODEC_FRAME_META_QUEUE_H_
+#define KRTCSDK_KRTC_CODEC_FRAME_META_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace krtc {
+
+// 流水线编码时每路流一个：编码线程提交帧时按顺序分配标签并保存元数据，
+// sync线程拿回码流时按标签取回。标签只在本路流内递增，取回时一并丢掉
+// 更早的标签(编码器跳过的帧)，不会影响其他路流。
+template <typename Meta>
+class FrameMetaQueue {
+public:
+	int64_t Push(const Meta& meta)
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		int64_t tag = next_tag_++;
+		metas_[tag] = meta;
+		return tag;
+	}
+
+	// 提交失败时撤回
+	void Erase(int64_t tag)
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		metas_.erase(tag);
+	}
+
+	bool Take(int64_t tag, Meta* meta)
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		auto iter = metas_.find(tag);
+		if (iter == metas_.end()) {
+			return false;
+		}
+		*meta = iter->second;
+		metas_.erase(metas_.begin(), ++iter);
+		return true;
+	}
+
+	void Clear()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		metas_.clear();
+		next_tag_ = 0;
+	}
+
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return metas_.size();
+	}
+
+private:
+	mutable std::mutex mutex_;
+	int64_t next_tag_ = 0;
+	std::map<int64_t, Meta> metas_;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_CODEC_FRAME_META_QUEUE_H_
@@ -0,0 +1,68 @@
+#include "key_frame_gate.h"
+
+#include <algorithm>
+
+namespace krtc {
+
+void KeyFrameGate::Configure(const KRTCKeyFrameConfig& config, float frame_rate)
+{
+	config_ = config;
+	config_.min_interval_ms = std::max(config_.min_interval_ms, config_.coalesce_window_ms);
+	refresh_duration_ms_ = static_cast<int64_t>(config_.intra_refresh_frames * 1000 / std::max(frame_rate, 1.0f));
+
+	pending_ = false;
+	has_served_ = false;
+	last_served_ms_ = 0;
+	last_action_ = Action::kNone;
+	requests_ = 0;
+	coalesced_ = 0;
+	intra_refreshes_ = 0;
+}
+
+KeyFrameGate::Action KeyFrameGate::OnFrame(int64_t now_ms, bool forced, bool requested)
+{
+	if (forced) {
+		pending_ = false;
+		has_served_ = true;
+		last_served_ms_ = now_ms;
+		last_action_ = Action::kIdr;
+		return Action::kIdr;
+	}
+
+	if (requested) {
+		requests_++;
+		if (has_served_ && now_ms - last_served_ms_ < config_.coalesce_window_ms) {
+			// 刚发出的关键帧还在路上，这次请求由它满足
+			coalesced_++;
+		}
+		else if (pending_) {
+			coalesced_++;
+		}
+		else {
+			pending_ = true;
+		}
+	}
+
+	if (!pending_ || (has_served_ && now_ms - last_served_ms_ < config_.min_interval_ms)) {
+		return Action::kNone;
+	}
+
+	// 上一轮刷新结束后接收端还在请求，说明它无法靠刷新恢复(比如刚加入)，改发IDR
+	Action action = Action::kIdr;
+	if (config_.intra_refresh) {
+		bool refresh_failed = last_action_ == Action::kIntraRefresh &&
+			now_ms - last_served_ms_ < refresh_duration_ms_ + config_.min_interval_ms;
+		if (!refresh_failed) {
+			action = Action::kIntraRefresh;
+			intra_refreshes_++;
+		}
+	}
+
+	pending_ = false;
+	has_served_ = true;
+	last_served_ms_ = now_ms;
+	last_action_ = action;
+	return action;
+}
+
+}  // namespace krtc
@@ -0,0 +1,46 @@
+#ifndef KRTCSDK_KRTC_CODEC_KEY_FRAME_GATE_H_
+#define KRTCSDK_KRTC_CODEC_KEY_FRAME_GATE_H_
+
+#include <cstdint>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 每个编码器(对应一个PeerConnection，即一个接收端)一份，只在编码线程使用。
+// 合并短时间内的PLI/FIR、限制关键帧频率，开启帧内刷新时优先用刷新代替IDR。
+class KeyFrameGate {
+public:
+	enum class Action {
+		kNone,
+		kIdr,
+		kIntraRefresh
+	};
+
+	void Configure(const KRTCKeyFrameConfig& config, float frame_rate);
+
+	// forced: 编码器自身需要关键帧(开始发送、层重新打开)，不受限制
+	// requested: 本帧的frame_types里带了接收端的关键帧请求
+	Action OnFrame(int64_t now_ms, bool forced, bool requested);
+
+	uint32_t requests() const { return requests_; }
+	uint32_t coalesced() const { return coalesced_; }
+	uint32_t intra_refreshes() const { return intra_refreshes_; }
+
+private:
+	KRTCKeyFrameConfig config_;
+	int64_t refresh_duration_ms_ = 0;
+
+	bool pending_ = false;
+	bool has_served_ = false;
+	int64_t last_served_ms_ = 0;
+	Action last_action_ = Action::kNone;
+
+	uint32_t requests_ = 0;
+	uint32_t coalesced_ = 0;
+	uint32_t intra_refreshes_ = 0;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_CODEC_KEY_FRAME_GATE_H_
@@ -16,6 +16,8 @@
 #include "third_party/libyuv/include/libyuv/convert.h"
 #include "third_party/libyuv/include/libyuv/scale.h"
 
+#include "krtc/base/krtc_global.h"
+
 namespace krtc {
 
 NvEncoder::NvEncoder(const cricket::VideoCodec& codec)
@@ -25,8 +27,7 @@ NvEncoder::NvEncoder(const cricket::VideoCodec& codec)
       encoded_image_callback_(nullptr),
       has_reported_init_(false),
       has_reported_error_(false),
-      num_temporal_layers_(1),
-	  tl0sync_limit_(0)
+      num_temporal_layers_(1)
 {
 	RTC_CHECK(absl::EqualsIgnoreCase(codec.name, cricket::kH264CodecName));
 	std::string packetization_mode_string;
@@ -38,6 +39,7 @@ NvEncoder::NvEncoder(const cricket::VideoCodec& codec)
 	encoded_images_.reserve(webrtc::kMaxSimulcastStreams);
 	nv_encoders_.reserve(webrtc::kMaxSimulcastStreams);
 	configurations_.reserve(webrtc::kMaxSimulcastStreams);
+	tl0sync_limit_.reserve(webrtc::kMaxSimulcastStreams);
 	image_buffer_ = nullptr;
 }
 
@@ -82,6 +84,7 @@ int32_t NvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 	encoded_images_.resize(number_of_streams);
 	nv_encoders_.resize(number_of_streams);
 	configurations_.resize(number_of_streams);
+	tl0sync_limit_.resize(number_of_streams);
 
 	number_of_cores_ = number_of_cores;
 	max_payload_size_ = max_payload_size;
@@ -96,6 +99,17 @@ int32_t NvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 
 	num_temporal_layers_ = codec_.H264()->numberOfTemporalLayers;
 
+	telemetry_.Reset();
+	KRTCKeyFrameConfig key_frame_config = KRTCGlobal::Instance()->key_frame_config();
+	key_frame_gate_.Configure(key_frame_config, static_cast<float>(codec_.maxFramerate));
+
+	if (KRTCGlobal::Instance()->screen_share_roi()) {
+		roi_builder_.reset(new ScreenRoiBuilder(KRTCGlobal::Instance()->screen_share_detect_text()));
+	}
+	else {
+		roi_builder_.reset();
+	}
+
 	for (int i = 0, idx = number_of_streams - 1; i < number_of_streams;  ++i, --idx) {
 		// Store nvidia encoder.
 		xop::NvidiaD3D11Encoder* nv_encoder = new xop::NvidiaD3D11Encoder();
@@ -124,6 +138,10 @@ int32_t NvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 		nv_encoder->SetOption(xop::VE_OPT_CODEC, xop::VE_OPT_CODEC_H264);
 		nv_encoder->SetOption(xop::VE_OPT_BITRATE_KBPS, configurations_[i].target_bps / 1000);
 		nv_encoder->SetOption(xop::VE_OPT_TEXTURE_FORMAT, xop::VE_OPT_FORMAT_B8G8R8A8);
+		nv_encoder->SetOption(xop::VE_OPT_QP_MAP, roi_builder_ ? 1 : 0);
+		nv_encoder->SetOption(xop::VE_OPT_INTRA_REFRESH,
+			key_frame_config.intra_refresh ? static_cast<int>(key_frame_config.intra_refresh_frames) : 0);
+		nv_encoder->SetOption(xop::VE_OPT_TEMPORAL_LAYERS, configurations_[i].num_temporal_layers);
 		if (!nv_encoder->Init()) {
 			Release();
 			ReportError();
@@ -142,6 +160,8 @@ int32_t NvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 		encoded_images_[i]._encodedWidth = codec_.simulcastStream[idx].width;
 		encoded_images_[i]._encodedHeight = codec_.simulcastStream[idx].height;
 		encoded_images_[i].set_size(0);
+
+		tl0sync_limit_[i] = configurations_[i].num_temporal_layers;
 	}
 
 	webrtc::SimulcastRateAllocator init_allocator(codec_);
@@ -164,6 +184,7 @@ int32_t NvEncoder::Release()
 
 	configurations_.clear();
 	encoded_images_.clear();
+	tl0sync_limit_.clear();
 
 	return WEBRTC_VIDEO_CODEC_OK;
 }
@@ -180,6 +201,7 @@ void NvEncoder::SetRates(const RateControlParameters& parameters)
 		// Encoder paused, turn off all encoding.
 		for (size_t i = 0; i < configurations_.size(); ++i)
 			configurations_[i].SetStreamState(false);
+		telemetry_.SetTargetBitrate(0);
 		return;
 	}
 
@@ -191,6 +213,7 @@ void NvEncoder::SetRates(const RateControlParameters& parameters)
 		RTC_DCHECK_GE(parameters.bitrate.get_sum_kbps(), codec_.simulcastStream[0].minBitrate);
 
 	codec_.maxFramerate = static_cast<uint32_t>(parameters.framerate_fps);
+	telemetry_.SetTargetBitrate(parameters.bitrate.get_sum_bps());
 
 	size_t stream_idx = nv_encoders_.size() - 1;
 	for (size_t i = 0; i < nv_encoders_.size(); ++i, --stream_idx) {
@@ -239,6 +262,8 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 	RTC_CHECK(frame_buffer->type() == webrtc::VideoFrameBuffer::Type::kI420 ||
 		frame_buffer->type() == webrtc::VideoFrameBuffer::Type::kI420A);
 
+	telemetry_.MaybeReport(rtc::TimeMillis());
+
 	bool send_key_frame = false;
 	for (size_t i = 0; i < configurations_.size(); ++i) {
 		if (configurations_[i].key_frame_request && configurations_[i].sending) {
@@ -246,14 +271,21 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 			break;
 		}
 	}
+	bool key_frame_requested = false;
 	if (!send_key_frame && frame_types) {
 		for (size_t i = 0; i < frame_types->size() && i < configurations_.size(); ++i) {
 			if ((*frame_types)[i] == webrtc::VideoFrameType::kVideoFrameKey && configurations_[i].sending) {
-				send_key_frame = true;
+				key_frame_requested = true;
 				break;
 			}
 		}
 	}
+	// 接收端的关键帧请求先经过合并/限频，可能改为帧内刷新
+	KeyFrameGate::Action key_frame_action = key_frame_gate_.OnFrame(rtc::TimeMillis(), send_key_frame, key_frame_requested);
+	send_key_frame = (key_frame_action == KeyFrameGate::Action::kIdr);
+	bool intra_refresh = (key_frame_action == KeyFrameGate::Action::kIntraRefresh);
+	telemetry_.SetKeyFrameRequestCounts(key_frame_gate_.requests(), key_frame_gate_.coalesced(),
+		key_frame_gate_.intra_refreshes());
 	
 	RTC_DCHECK_EQ(configurations_[0].width, frame_buffer->width());
 	RTC_DCHECK_EQ(configurations_[0].height, frame_buffer->height());
@@ -267,6 +299,7 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 		if (frame_types != nullptr) {
 			// Skip frame?
 			if ((*frame_types)[i] == webrtc::VideoFrameType::kEmptyFrame) {
+				telemetry_.RecordDrop(rtc::TimeMillis());
 				continue;
 			}
 		}
@@ -279,6 +312,15 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 
 			configurations_[i].key_frame_request = false;
 		}
+		else if (intra_refresh && nv_encoders_[i]) {
+			xop::NvidiaD3D11Encoder* nv_encoder = reinterpret_cast<xop::NvidiaD3D11Encoder*>(nv_encoders_[i]);
+			nv_encoder->SetEvent(xop::VE_EVENT_INTRA_REFRESH, 1);
+		}
+
+		if (roi_builder_ && nv_encoders_[i]) {
+			xop::NvidiaD3D11Encoder* nv_encoder = reinterpret_cast<xop::NvidiaD3D11Encoder*>(nv_encoders_[i]);
+			nv_encoder->SetRegionsOfInterest(roi_builder_->Build(input_frame, *frame_buffer, send_key_frame || intra_refresh));
+		}
 
 		// EncodeFrame output.
 		SFrameBSInfo info;
@@ -291,6 +333,7 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 		}
 
 		if (frame_packet.size() == 0) {
+			telemetry_.RecordDrop(rtc::TimeMillis());
 			return WEBRTC_VIDEO_CODEC_OK;
 		}
 		else {
@@ -311,6 +354,13 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 		encoded_images_[i]._frameType = ConvertToVideoFrameType(info.eFrameType);
 		encoded_images_[i].SetSpatialIndex(configurations_[i].simulcast_idx);
 
+		int temporal_id = 0;
+		if (configurations_[i].num_temporal_layers > 1) {
+			xop::NvidiaD3D11Encoder* nv_encoder = reinterpret_cast<xop::NvidiaD3D11Encoder*>(nv_encoders_[i]);
+			temporal_id = nv_encoder->GetLastTemporalId();
+			encoded_images_[i].SetTemporalIndex(temporal_id);
+		}
+
 		// Split encoded image up into fragments. This also updates
 		// |encoded_image_|.
 		RtpFragmentize(&encoded_images_[i], frame_packet);
@@ -322,6 +372,8 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 			h264_bitstream_parser_.ParseBitstream(encoded_images_[i]);
 			encoded_images_[i].qp_ =
 				h264_bitstream_parser_.GetLastSliceQp().value_or(-1);
+			telemetry_.RecordFrame(rtc::TimeMillis(), static_cast<uint32_t>(encoded_images_[i].size()),
+				encoded_images_[i].qp_, info.eFrameType == videoFrameTypeIDR);
 
 			// Deliver encoded image.
 			webrtc::CodecSpecificInfo codec_specific;
@@ -330,6 +382,17 @@ int32_t NvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 			codec_specific.codecSpecific.H264.temporal_idx = webrtc::kNoTemporalIdx;
 			codec_specific.codecSpecific.H264.idr_frame = info.eFrameType == videoFrameTypeIDR;
 			codec_specific.codecSpecific.H264.base_layer_sync = false;
+			if (configurations_[i].num_temporal_layers > 1) {
+				codec_specific.codecSpecific.H264.temporal_idx = static_cast<uint8_t>(temporal_id);
+				codec_specific.codecSpecific.H264.base_layer_sync =
+					temporal_id > 0 && temporal_id < tl0sync_limit_[i];
+				if (codec_specific.codecSpecific.H264.base_layer_sync) {
+					tl0sync_limit_[i] = temporal_id;
+				}
+				if (temporal_id == 0) {
+					tl0sync_limit_[i] = configurations_[i].num_temporal_layers;
+				}
+			}
 
 			encoded_image_callback_->OnEncodedImage(encoded_images_[i], &codec_specific);
 		}
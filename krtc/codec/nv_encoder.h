@@ -14,6 +14,9 @@
 #include "modules/video_coding/codecs/h264/include/h264.h"
 #include "modules/video_coding/utility/quality_scaler.h"
 //#include "third_party/openh264/src/codec/api/svc/codec_app_def.h"
+#include "encoder_telemetry.h"
+#include "key_frame_gate.h"
+#include "screen_roi_builder.h"
 #include "encoder/nvidia_d3d11_encoder.h"
 
 namespace krtc {
@@ -86,9 +89,12 @@ private:
 	bool has_reported_error_;
 	int video_format_;
 	int num_temporal_layers_;
-	uint8_t tl0sync_limit_;
+	std::vector<uint8_t> tl0sync_limit_;
 
 	std::unique_ptr<uint8_t[]> image_buffer_;
+	std::unique_ptr<ScreenRoiBuilder> roi_builder_;
+	KeyFrameGate key_frame_gate_;
+	EncoderTelemetry telemetry_{ "NvEncoder" };
 };
 
 }  // namespace krtc
@@ -494,8 +494,11 @@ void NvEncoder::DoEncode(NV_ENC_INPUT_PTR inputBuffer, std::vector<std::vector<u
     picParams.outputBitstream = m_vBitstreamOutputBuffer[m_iToSend % m_nEncoderBuffer];
     picParams.completionEvent = m_vpCompletionEvent[m_iToSend % m_nEncoderBuffer];
 
-    picParams.qpDeltaMap = m_qpDeltaMap.get();
-    picParams.qpDeltaMapSize = m_qpDeltaMapSize;
+    if (m_qpDeltaMap)
+    {
+        picParams.qpDeltaMap = m_qpDeltaMap.get();
+        picParams.qpDeltaMapSize = m_qpDeltaMapSize;
+    }
 
 	if (m_forceIDR) {
 		picParams.pictureType = NV_ENC_PIC_TYPE_IDR;
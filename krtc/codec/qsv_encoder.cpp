@@ -1,6 +1,7 @@
 #include "qsv_encoder.h"
 #include "common_encoder.h"
 
+#include <algorithm>
 #include <limits>
 #include <string>
 
@@ -17,6 +18,8 @@
 #include "third_party/libyuv/include/libyuv/scale.h"
 #include "third_party/libyuv/include/libyuv/video_common.h"
 
+#include "krtc/base/krtc_global.h"
+
 namespace krtc {
 
 QsvEncoder::QsvEncoder(const cricket::VideoCodec& codec)
@@ -84,6 +87,10 @@ int32_t QsvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 	qsv_encoders_.resize(number_of_streams);
 	configurations_.resize(number_of_streams);
 	tl0sync_limit_.resize(number_of_streams);
+	for (int i = 0; i < number_of_streams; ++i) {
+		h264_bitstream_parsers_.emplace_back(new webrtc::H264BitstreamParser());
+		pending_meta_.emplace_back(new FrameMetaQueue<FrameMeta>());
+	}
 
 	number_of_cores_ = number_of_cores;
 	max_payload_size_ = max_payload_size;
@@ -98,6 +105,20 @@ int32_t QsvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 
 	num_temporal_layers_ = codec_.H264()->numberOfTemporalLayers;
 
+	telemetry_.Reset();
+	KRTCKeyFrameConfig key_frame_config = KRTCGlobal::Instance()->key_frame_config();
+	key_frame_gate_.Configure(key_frame_config, static_cast<float>(codec_.maxFramerate));
+
+	if (KRTCGlobal::Instance()->screen_share_roi()) {
+		roi_builder_.reset(new ScreenRoiBuilder(KRTCGlobal::Instance()->screen_share_detect_text()));
+	}
+	else {
+		roi_builder_.reset();
+	}
+
+	pipelined_ = KRTCGlobal::Instance()->video_encode_mode() == VIDEO_ENCODE_MODE::PIPELINED;
+	last_latency_report_ms_ = rtc::TimeMillis();
+
 	for (int i = 0, idx = number_of_streams - 1; i < number_of_streams; ++i, --idx) {
 		// Store nvidia encoder.
 		xop::IntelD3DEncoder* qsv_encoder = new xop::IntelD3DEncoder();
@@ -126,6 +147,17 @@ int32_t QsvEncoder::InitEncode(const webrtc::VideoCodec* inst,
 		qsv_encoder->SetOption(xop::VE_OPT_CODEC, xop::VE_OPT_CODEC_H264);
 		qsv_encoder->SetOption(xop::VE_OPT_BITRATE_KBPS, configurations_[i].target_bps / 1000);
 		qsv_encoder->SetOption(xop::VE_OPT_TEXTURE_FORMAT, xop::VE_OPT_FORMAT_NV12);
+		qsv_encoder->SetOption(xop::VE_OPT_QP_MAP, roi_builder_ ? 1 : 0);
+		qsv_encoder->SetOption(xop::VE_OPT_INTRA_REFRESH,
+			key_frame_config.intra_refresh ? static_cast<int>(key_frame_config.intra_refresh_frames) : 0);
+		qsv_encoder->SetOption(xop::VE_OPT_TEMPORAL_LAYERS, configurations_[i].num_temporal_layers);
+		qsv_encoder->SetOption(xop::VE_OPT_ASYNC_DEPTH,
+			pipelined_ ? KRTCGlobal::Instance()->video_encode_pipeline_depth() : 1);
+		if (pipelined_) {
+			qsv_encoder->SetEncodedFrameCallback([this, i](std::vector<uint8_t>& frame_packet, int64_t frame_tag, int temporal_id) {
+				OnAsyncEncodedFrame(i, frame_packet, frame_tag, temporal_id);
+			});
+		}
 		if (!qsv_encoder->Init()) {
 			Release();
 			ReportError();
@@ -167,9 +199,12 @@ int32_t QsvEncoder::Release()
 		qsv_encoders_.pop_back();
 	}
 
+	// sync threads are joined by Destroy() above, nothing delivers any more
 	configurations_.clear();
 	encoded_images_.clear();
 	tl0sync_limit_.clear();
+	h264_bitstream_parsers_.clear();
+	pending_meta_.clear();
 
 	return WEBRTC_VIDEO_CODEC_OK;
 }
@@ -192,14 +227,17 @@ void QsvEncoder::SetRates(const RateControlParameters& parameters)
 		return;
 	}
 
+	std::lock_guard<std::mutex> locker(deliver_mutex_);
 	if (parameters.bitrate.get_sum_bps() == 0) {
 		// Encoder paused, turn off all encoding.
 		for (size_t i = 0; i < configurations_.size(); ++i)
 			configurations_[i].SetStreamState(false);
+		telemetry_.SetTargetBitrate(0);
 		return;
 	}
 
 	codec_.maxFramerate = static_cast<uint32_t>(parameters.framerate_fps);
+	telemetry_.SetTargetBitrate(parameters.bitrate.get_sum_bps());
 
 	size_t stream_idx = qsv_encoders_.size() - 1;
 	for (size_t i = 0; i < qsv_encoders_.size(); ++i, --stream_idx) {
@@ -249,6 +287,8 @@ int32_t QsvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 	RTC_CHECK(frame_buffer->type() == webrtc::VideoFrameBuffer::Type::kI420 ||
 		frame_buffer->type() == webrtc::VideoFrameBuffer::Type::kI420A);
 
+	telemetry_.MaybeReport(rtc::TimeMillis());
+
 	bool send_key_frame = false;
 	for (size_t i = 0; i < configurations_.size(); ++i) {
 		if (configurations_[i].key_frame_request && configurations_[i].sending) {
@@ -257,17 +297,24 @@ int32_t QsvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 		}
 	}
 
+	bool key_frame_requested = false;
 	if (!send_key_frame && frame_types) {
 		for (size_t i = 0; i < configurations_.size(); ++i) {
 			const size_t simulcast_idx =
 				static_cast<size_t>(configurations_[i].simulcast_idx);
 			if (configurations_[i].sending && simulcast_idx < frame_types->size() &&
 				(*frame_types)[simulcast_idx] == webrtc::VideoFrameType::kVideoFrameKey) {
-				send_key_frame = true;
+				key_frame_requested = true;
 				break;
 			}
 		}
 	}
+	// 接收端的关键帧请求先经过合并/限频，可能改为帧内刷新
+	KeyFrameGate::Action key_frame_action = key_frame_gate_.OnFrame(rtc::TimeMillis(), send_key_frame, key_frame_requested);
+	send_key_frame = (key_frame_action == KeyFrameGate::Action::kIdr);
+	bool intra_refresh = (key_frame_action == KeyFrameGate::Action::kIntraRefresh);
+	telemetry_.SetKeyFrameRequestCounts(key_frame_gate_.requests(), key_frame_gate_.coalesced(),
+		key_frame_gate_.intra_refreshes());
 
 	RTC_DCHECK_EQ(configurations_[0].width, frame_buffer->width());
 	RTC_DCHECK_EQ(configurations_[0].height, frame_buffer->height());
@@ -281,6 +328,7 @@ int32_t QsvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 		if (frame_types != nullptr) {
 			// Skip frame?
 			if ((*frame_types)[i] == webrtc::VideoFrameType::kEmptyFrame) {
+				telemetry_.RecordDrop(rtc::TimeMillis());
 				continue;
 			}
 		}
@@ -293,72 +341,175 @@ int32_t QsvEncoder::Encode(const webrtc::VideoFrame& input_frame,
 
 			configurations_[i].key_frame_request = false;
 		}
+		else if (intra_refresh && qsv_encoders_[i]) {
+			xop::IntelD3DEncoder* qsv_encoder = reinterpret_cast<xop::IntelD3DEncoder*>(qsv_encoders_[i]);
+			qsv_encoder->SetEvent(xop::VE_EVENT_INTRA_REFRESH, 1);
+		}
 
-		// EncodeFrame output.
-		SFrameBSInfo info;
-		memset(&info, 0, sizeof(SFrameBSInfo));
-		std::vector<uint8_t> frame_packet;
+		if (roi_builder_ && qsv_encoders_[i]) {
+			xop::IntelD3DEncoder* qsv_encoder = reinterpret_cast<xop::IntelD3DEncoder*>(qsv_encoders_[i]);
+			qsv_encoder->SetRegionsOfInterest(roi_builder_->Build(input_frame, *frame_buffer, send_key_frame || intra_refresh));
+		}
 
-		bool enc_ret = EncodeFrame((int)i, input_frame, frame_packet);
+		FrameMeta meta;
+		meta.timestamp = input_frame.timestamp();
+		meta.ntp_time_ms = input_frame.ntp_time_ms();
+		meta.capture_time_ms = input_frame.render_time_ms();
+		meta.rotation = input_frame.rotation();
+		meta.color_space = input_frame.color_space();
+
+		int64_t frame_tag = pipelined_ ? pending_meta_[i]->Push(meta) : 0;
+
+		std::vector<uint8_t> frame_packet;
+		bool enc_ret = EncodeFrame((int)i, input_frame, frame_tag, frame_packet);
 		if (!enc_ret) {
 			RTC_LOG(LS_ERROR)
 				<< "OpenH264 frame encoding failed";
+			if (pipelined_) {
+				pending_meta_[i]->Erase(frame_tag);
+			}
 			ReportError();
 			return WEBRTC_VIDEO_CODEC_ERROR;
 		}
 
+		if (pipelined_) {
+			// Delivered later from the sync thread, see OnAsyncEncodedFrame().
+			continue;
+		}
+
 		if (frame_packet.size() == 0) {
+			telemetry_.RecordDrop(rtc::TimeMillis());
 			return WEBRTC_VIDEO_CODEC_OK;
 		}
-		else {
-			if ((frame_packet[4] & 0x1f) == 0x07) {
-				// sps + pps + idr
-				info.eFrameType = videoFrameTypeIDR;
+
+		xop::IntelD3DEncoder* qsv_encoder = reinterpret_cast<xop::IntelD3DEncoder*>(qsv_encoders_[i]);
+		DeliverEncodedImage(i, meta, frame_packet, qsv_encoder->GetLastTemporalId());
+	}
+
+	ReportEncodeLatency();
+
+	return WEBRTC_VIDEO_CODEC_OK;
+}
+
+void QsvEncoder::OnAsyncEncodedFrame(size_t index, std::vector<uint8_t>& frame_packet, int64_t frame_tag,
+									 int temporal_id)
+{
+	if (index >= pending_meta_.size()) {
+		return;
+	}
+
+	FrameMeta meta;
+	if (!pending_meta_[index]->Take(frame_tag, &meta) || frame_packet.empty()) {
+		return;
+	}
+
+	DeliverEncodedImage(index, meta, frame_packet, temporal_id);
+}
+
+void QsvEncoder::DeliverEncodedImage(size_t i, const FrameMeta& meta,
+									 std::vector<uint8_t>& frame_packet, int temporal_id)
+{
+	std::lock_guard<std::mutex> locker(deliver_mutex_);
+	if (i >= encoded_images_.size()) {
+		return;
+	}
+
+	// EncodeFrame output.
+	SFrameBSInfo info;
+	memset(&info, 0, sizeof(SFrameBSInfo));
+
+	if ((frame_packet[4] & 0x1f) == 0x07) {
+		// sps + pps + idr
+		info.eFrameType = videoFrameTypeIDR;
+	}
+	else {
+		info.eFrameType = videoFrameTypeP;
+	}
+
+	encoded_images_[i]._encodedWidth = configurations_[i].width;
+	encoded_images_[i]._encodedHeight = configurations_[i].height;
+	encoded_images_[i].SetTimestamp(meta.timestamp);
+	encoded_images_[i].ntp_time_ms_ = meta.ntp_time_ms;
+	encoded_images_[i].capture_time_ms_ = meta.capture_time_ms;
+	encoded_images_[i].rotation_ = meta.rotation;
+	encoded_images_[i].SetColorSpace(meta.color_space);
+	encoded_images_[i].content_type_ = (codec_.mode == webrtc::VideoCodecMode::kScreensharing)
+		? webrtc::VideoContentType::SCREENSHARE
+		: webrtc::VideoContentType::UNSPECIFIED;
+	encoded_images_[i].timing_.flags = webrtc::VideoSendTiming::kInvalid;
+	encoded_images_[i]._frameType = ConvertToVideoFrameType(info.eFrameType);
+	encoded_images_[i].SetSpatialIndex(configurations_[i].simulcast_idx);
+	if (configurations_[i].num_temporal_layers > 1) {
+		encoded_images_[i].SetTemporalIndex(temporal_id);
+	}
+
+	// Split encoded image up into fragments. This also updates
+	// |encoded_image_|.
+	RtpFragmentize(&encoded_images_[i], frame_packet);
+
+	// Encoder can skip frames to save bandwidth in which case
+	// |encoded_images_[i]._length| == 0.
+	if (encoded_images_[i].size() > 0) {
+		// Parse QP.
+		h264_bitstream_parsers_[i]->ParseBitstream(encoded_images_[i]);
+		encoded_images_[i].qp_ =
+			h264_bitstream_parsers_[i]->GetLastSliceQp().value_or(-1);
+		telemetry_.RecordFrame(rtc::TimeMillis(), static_cast<uint32_t>(encoded_images_[i].size()),
+			encoded_images_[i].qp_, info.eFrameType == videoFrameTypeIDR);
+
+		// Deliver encoded image.
+		webrtc::CodecSpecificInfo codec_specific;
+		codec_specific.codecType = webrtc::kVideoCodecH264;
+		codec_specific.codecSpecific.H264.packetization_mode = packetization_mode_;
+		codec_specific.codecSpecific.H264.temporal_idx = webrtc::kNoTemporalIdx;
+		codec_specific.codecSpecific.H264.idr_frame = (info.eFrameType == videoFrameTypeIDR);
+		codec_specific.codecSpecific.H264.base_layer_sync = false;
+		if (configurations_[i].num_temporal_layers > 1) {
+			codec_specific.codecSpecific.H264.temporal_idx = static_cast<uint8_t>(temporal_id);
+			codec_specific.codecSpecific.H264.base_layer_sync =
+				temporal_id > 0 && temporal_id < tl0sync_limit_[i];
+			if (codec_specific.codecSpecific.H264.base_layer_sync) {
+				tl0sync_limit_[i] = temporal_id;
 			}
-			else {
-				info.eFrameType = videoFrameTypeP;
+			if (temporal_id == 0) {
+				tl0sync_limit_[i] = configurations_[i].num_temporal_layers;
 			}
 		}
 
-		encoded_images_[i]._encodedWidth = configurations_[i].width;
-		encoded_images_[i]._encodedHeight = configurations_[i].height;
-		encoded_images_[i].SetTimestamp(input_frame.timestamp());
-		encoded_images_[i].ntp_time_ms_ = input_frame.ntp_time_ms();
-		encoded_images_[i].capture_time_ms_ = input_frame.render_time_ms();
-		encoded_images_[i].rotation_ = input_frame.rotation();
-		encoded_images_[i].SetColorSpace(input_frame.color_space());
-		encoded_images_[i].content_type_ = (codec_.mode == webrtc::VideoCodecMode::kScreensharing)
-			? webrtc::VideoContentType::SCREENSHARE
-			: webrtc::VideoContentType::UNSPECIFIED;
-		encoded_images_[i].timing_.flags = webrtc::VideoSendTiming::kInvalid;
-		encoded_images_[i]._frameType = ConvertToVideoFrameType(info.eFrameType);
-		encoded_images_[i].SetSpatialIndex(configurations_[i].simulcast_idx);
-
-		// Split encoded image up into fragments. This also updates
-		// |encoded_image_|.
-		RtpFragmentize(&encoded_images_[i], frame_packet);
-
-		// Encoder can skip frames to save bandwidth in which case
-		// |encoded_images_[i]._length| == 0.
-		if (encoded_images_[i].size() > 0) {
-			// Parse QP.
-			h264_bitstream_parser_.ParseBitstream(encoded_images_[i]);
-			encoded_images_[i].qp_ =
-				h264_bitstream_parser_.GetLastSliceQp().value_or(-1);
-
-			// Deliver encoded image.
-			webrtc::CodecSpecificInfo codec_specific;
-			codec_specific.codecType = webrtc::kVideoCodecH264;
-			codec_specific.codecSpecific.H264.packetization_mode = packetization_mode_;
-			codec_specific.codecSpecific.H264.temporal_idx = webrtc::kNoTemporalIdx;
-			codec_specific.codecSpecific.H264.idr_frame = (info.eFrameType == videoFrameTypeIDR);
-			codec_specific.codecSpecific.H264.base_layer_sync = false;
-
-			encoded_image_callback_->OnEncodedImage(encoded_images_[i], &codec_specific);
+		encoded_image_callback_->OnEncodedImage(encoded_images_[i], &codec_specific);
+	}
+}
+
+void QsvEncoder::ReportEncodeLatency()
+{
+	int64_t now_ms = rtc::TimeMillis();
+	if (now_ms - last_latency_report_ms_ < 1000) {
+		return;
+	}
+	last_latency_report_ms_ = now_ms;
+
+	// Aggregate over all simulcast streams, weighted by their frame counts.
+	uint32_t frames = 0;
+	int64_t total_us = 0;
+	int64_t max_us = 0;
+	for (void* encoder : qsv_encoders_) {
+		if (!encoder) {
+			continue;
 		}
+		xop::IntelD3DEncoder* qsv_encoder = reinterpret_cast<xop::IntelD3DEncoder*>(encoder);
+		xop::EncodeLatencyStats stats = qsv_encoder->GetEncodeLatencyStats();
+		frames += stats.frames;
+		total_us += stats.avg_us * stats.frames;
+		max_us = std::max(max_us, stats.max_us);
+	}
+	if (frames == 0) {
+		return;
 	}
 
-	return WEBRTC_VIDEO_CODEC_OK;
+	if (KRTCGlobal::Instance()->engine_observer()) {
+		KRTCGlobal::Instance()->engine_observer()->OnVideoEncodeLatency(frames,
+			static_cast<uint32_t>(total_us / frames), static_cast<uint32_t>(max_us));
+	}
 }
 
 void QsvEncoder::ReportInit()
@@ -421,7 +572,7 @@ void i420ToNv12(unsigned char* src_i420_data, int width, int height, unsigned ch
 		width, height);
 }
 
-bool QsvEncoder::EncodeFrame(int index, const webrtc::VideoFrame& input_frame,
+bool QsvEncoder::EncodeFrame(int index, const webrtc::VideoFrame& input_frame, int64_t frame_tag,
 	std::vector<uint8_t>& frame_packet)
 {
 	frame_packet.clear();
@@ -447,8 +598,10 @@ bool QsvEncoder::EncodeFrame(int index, const webrtc::VideoFrame& input_frame,
 	int image_size = width * height * 3 / 2; // nv12
 	xop::IntelD3DEncoder* qsv_encoder = reinterpret_cast<xop::IntelD3DEncoder*>(qsv_encoders_[index]);
 	if (qsv_encoder) {
-		int frame_size = qsv_encoder->Encode(std::vector<uint8_t>(image_buffer_.get(), image_buffer_.get() + image_size), frame_packet);
-		if (frame_size < 0) {
+		std::vector<uint8_t> image(image_buffer_.get(), image_buffer_.get() + image_size);
+		int ret = pipelined_ ? qsv_encoder->EncodeAsync(image, frame_tag)
+							 : qsv_encoder->Encode(std::move(image), frame_packet);
+		if (ret < 0) {
 			return false;
 		}
 	}
@@ -1,7 +1,9 @@
 #ifndef KRTCSDK_KRTC_CODEC_QSV_ENCODER_H_
 #define KRTCSDK_KRTC_CODEC_QSV_ENCODER_H_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string.h>
 
@@ -14,6 +16,10 @@
 #include "modules/video_coding/codecs/h264/include/h264.h"
 #include "modules/video_coding/utility/quality_scaler.h"
 //#include "third_party/openh264/src/codec/api/svc/codec_app_def.h"
+#include "encoder_telemetry.h"
+#include "frame_meta_queue.h"
+#include "key_frame_gate.h"
+#include "screen_roi_builder.h"
 #include "encoder/intel_d3d_encoder.h"
 
 namespace krtc {
@@ -63,17 +69,34 @@ public:
 	}
 
 private:
-	webrtc::H264BitstreamParser h264_bitstream_parser_;
+	// Per-frame data needed once the bitstream comes back, possibly on the
+	// encoder's sync thread in pipelined mode.
+	struct FrameMeta
+	{
+		uint32_t timestamp = 0;
+		int64_t ntp_time_ms = 0;
+		int64_t capture_time_ms = 0;
+		webrtc::VideoRotation rotation = webrtc::kVideoRotation_0;
+		absl::optional<webrtc::ColorSpace> color_space;
+	};
+
 	// Reports statistics with histograms.
 	void ReportInit();
 	void ReportError();
+	void ReportEncodeLatency();
 
-	bool EncodeFrame(int index, const webrtc::VideoFrame& input_frame,
+	bool EncodeFrame(int index, const webrtc::VideoFrame& input_frame, int64_t frame_tag,
 					 std::vector<uint8_t>& frame_packet);
+	void DeliverEncodedImage(size_t index, const FrameMeta& meta,
+							 std::vector<uint8_t>& frame_packet, int temporal_id);
+	void OnAsyncEncodedFrame(size_t index, std::vector<uint8_t>& frame_packet, int64_t frame_tag,
+							 int temporal_id);
 
 	std::vector<void*> qsv_encoders_;
 	std::vector<LayerConfig> configurations_;
 	std::vector<webrtc::EncodedImage> encoded_images_;
+	// Per stream, QP parsing keeps SPS/PPS state of its own stream.
+	std::vector<std::unique_ptr<webrtc::H264BitstreamParser>> h264_bitstream_parsers_;
 
 	webrtc::VideoCodec codec_;
 	webrtc::H264PacketizationMode packetization_mode_;
@@ -88,6 +111,17 @@ private:
 	std::vector<uint8_t> tl0sync_limit_;
 
 	std::unique_ptr<uint8_t[]> image_buffer_;
+	std::unique_ptr<ScreenRoiBuilder> roi_builder_;
+	KeyFrameGate key_frame_gate_;
+	EncoderTelemetry telemetry_{ "QsvEncoder" };
+
+	bool pipelined_ = false;
+	// Per stream, each stream's sync thread only takes its own frames.
+	std::vector<std::unique_ptr<FrameMetaQueue<FrameMeta>>> pending_meta_;
+	// Serializes DeliverEncodedImage() between the encode thread and the
+	// per-stream sync threads, and guards configurations_ against SetRates().
+	std::mutex deliver_mutex_;
+	int64_t last_latency_report_ms_ = 0;
 };
 
 }  // namespace webrtc
@@ -0,0 +1,183 @@
+#include "screen_roi_builder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace krtc {
+
+namespace {
+
+const int kMbSize = 16;
+// 静止区域的QP增量，码控QP之上再加，基本只剩skip宏块
+const int kStaticQpDelta = 8;
+// 变化区域中的文字/细线
+const int kTextQpDelta = -4;
+// 相邻像素亮度差超过该值算一条边
+const int kEdgeThreshold = 40;
+// 宏块内边缘像素占比(%)超过该值判定为文字
+const int kTextEdgePercent = 12;
+// 文字区域过多时合并成一个外接矩形，硬件编码器支持的ROI个数有限
+const size_t kMaxTextRegions = 6;
+
+bool IsFullFrame(const webrtc::VideoFrame::UpdateRect& rect, int width, int height)
+{
+	return rect.offset_x <= 0 && rect.offset_y <= 0 &&
+		rect.offset_x + rect.width >= width && rect.offset_y + rect.height >= height;
+}
+
+}  // namespace
+
+ScreenRoiBuilder::ScreenRoiBuilder(bool detect_text)
+	: detect_text_(detect_text)
+{
+}
+
+void ScreenRoiBuilder::Reset()
+{
+	width_ = 0;
+	height_ = 0;
+	last_y_.clear();
+}
+
+std::vector<xop::EncodeRegion> ScreenRoiBuilder::Build(const webrtc::VideoFrame& frame,
+													   const webrtc::I420BufferInterface& buffer,
+													   bool key_frame)
+{
+	std::vector<xop::EncodeRegion> regions;
+	int width = buffer.width();
+	int height = buffer.height();
+	webrtc::VideoFrame::UpdateRect full_rect = { 0, 0, width, height };
+
+	bool size_changed = (width != width_ || height != height_);
+	if (size_changed) {
+		width_ = width;
+		height_ = height;
+		last_y_.resize(width * height);
+	}
+
+	// 关键帧要完整刷新静止区域，否则抬高的QP会一直保留到下一个关键帧
+	if (key_frame || size_changed || !frame.has_update_rect()) {
+		SaveLumaPlane(buffer, full_rect);
+		return regions;
+	}
+
+	webrtc::VideoFrame::UpdateRect rect = frame.update_rect();
+	if (rect.IsEmpty()) {
+		regions.push_back({ 0, 0, width, height, kStaticQpDelta });
+		return regions;
+	}
+
+	if (IsFullFrame(rect, width, height)) {
+		SaveLumaPlane(buffer, full_rect);
+		return regions;
+	}
+
+	if (detect_text_) {
+		DetectText(buffer, rect, &regions);
+	}
+	regions.push_back({ rect.offset_x, rect.offset_y, rect.width, rect.height, 0 });
+	regions.push_back({ 0, 0, width, height, kStaticQpDelta });
+
+	SaveLumaPlane(buffer, rect);
+	return regions;
+}
+
+void ScreenRoiBuilder::DetectText(const webrtc::I420BufferInterface& buffer,
+								  const webrtc::VideoFrame::UpdateRect& rect,
+								  std::vector<xop::EncodeRegion>* regions)
+{
+	const uint8_t* data_y = buffer.DataY();
+	int stride_y = buffer.StrideY();
+
+	int mb_x0 = std::max(rect.offset_x, 0) / kMbSize;
+	int mb_y0 = std::max(rect.offset_y, 0) / kMbSize;
+	int mb_x1 = (std::min(rect.offset_x + rect.width, width_) + kMbSize - 1) / kMbSize;
+	int mb_y1 = (std::min(rect.offset_y + rect.height, height_) + kMbSize - 1) / kMbSize;
+
+	// 按宏块行合并成横向条带，再和上一行宽度相同的条带纵向合并
+	std::vector<xop::EncodeRegion> text_regions;
+	for (int mb_y = mb_y0; mb_y < mb_y1; mb_y++) {
+		int y_begin = mb_y * kMbSize;
+		int y_end = std::min(y_begin + kMbSize, height_);
+		int run_start = -1;
+
+		for (int mb_x = mb_x0; mb_x <= mb_x1; mb_x++) {
+			bool is_text = false;
+			if (mb_x < mb_x1) {
+				int x_begin = mb_x * kMbSize;
+				int x_end = std::min(x_begin + kMbSize, width_);
+				bool changed = false;
+				int edges = 0;
+				for (int y = y_begin; y < y_end; y++) {
+					const uint8_t* row = data_y + y * stride_y;
+					if (!changed && memcmp(row + x_begin, &last_y_[y * width_ + x_begin], x_end - x_begin) != 0) {
+						changed = true;
+					}
+					for (int x = x_begin; x < x_end - 1; x++) {
+						if (std::abs(row[x] - row[x + 1]) > kEdgeThreshold) {
+							edges++;
+						}
+					}
+				}
+				int pixels = (x_end - x_begin) * (y_end - y_begin);
+				is_text = changed && edges * 100 >= pixels * kTextEdgePercent;
+			}
+
+			if (is_text && run_start < 0) {
+				run_start = mb_x;
+			}
+			else if (!is_text && run_start >= 0) {
+				xop::EncodeRegion run = { run_start * kMbSize, y_begin, (mb_x - run_start) * kMbSize,
+										  y_end - y_begin, kTextQpDelta };
+				auto iter = std::find_if(text_regions.begin(), text_regions.end(), [&run](const xop::EncodeRegion& region) {
+					return region.x == run.x && region.width == run.width && region.y + region.height == run.y;
+				});
+				if (iter != text_regions.end()) {
+					iter->height += run.height;
+				}
+				else {
+					text_regions.push_back(run);
+				}
+				run_start = -1;
+			}
+		}
+	}
+
+	if (text_regions.size() > kMaxTextRegions) {
+		int left = width_, top = height_, right = 0, bottom = 0;
+		for (auto& region : text_regions) {
+			left = std::min(left, region.x);
+			top = std::min(top, region.y);
+			right = std::max(right, region.x + region.width);
+			bottom = std::max(bottom, region.y + region.height);
+		}
+		text_regions.clear();
+		text_regions.push_back({ left, top, right - left, bottom - top, kTextQpDelta });
+	}
+
+	regions->insert(regions->end(), text_regions.begin(), text_regions.end());
+}
+
+void ScreenRoiBuilder::SaveLumaPlane(const webrtc::I420BufferInterface& buffer,
+									 const webrtc::VideoFrame::UpdateRect& rect)
+{
+	if (!detect_text_) {
+		return;
+	}
+
+	int x_begin = std::max(rect.offset_x, 0);
+	int x_end = std::min(rect.offset_x + rect.width, width_);
+	int y_begin = std::max(rect.offset_y, 0);
+	int y_end = std::min(rect.offset_y + rect.height, height_);
+	if (x_begin >= x_end) {
+		return;
+	}
+
+	// update_rect外的像素没变，只拷贝变化的部分
+	for (int y = y_begin; y < y_end; y++) {
+		memcpy(&last_y_[y * width_ + x_begin], buffer.DataY() + y * buffer.StrideY() + x_begin, x_end - x_begin);
+	}
+}
+
+}  // namespace krtc
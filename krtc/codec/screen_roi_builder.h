@@ -0,0 +1,41 @@
+#ifndef KRTCSDK_KRTC_CODEC_SCREEN_ROI_BUILDER_H_
+#define KRTCSDK_KRTC_CODEC_SCREEN_ROI_BUILDER_H_
+
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_frame_buffer.h"
+#include "encoder/video_encoder.h"
+
+namespace krtc {
+
+// 屏幕共享的按区域QP：静止区域抬高QP让编码器尽量skip，
+// 变化区域保持码控QP，变化区域里的文字/细边缘再降低QP。
+// 变化区域来自VideoFrame::update_rect()，由DesktopCapturer从updated_region()填写。
+class ScreenRoiBuilder {
+public:
+	explicit ScreenRoiBuilder(bool detect_text);
+
+	// Regions in priority order for the next frame, empty when the frame should be
+	// encoded uniformly (key frame, no update rect, or the whole frame changed).
+	std::vector<xop::EncodeRegion> Build(const webrtc::VideoFrame& frame,
+										 const webrtc::I420BufferInterface& buffer,
+										 bool key_frame);
+	void Reset();
+
+private:
+	void DetectText(const webrtc::I420BufferInterface& buffer,
+					const webrtc::VideoFrame::UpdateRect& rect,
+					std::vector<xop::EncodeRegion>* regions);
+	void SaveLumaPlane(const webrtc::I420BufferInterface& buffer,
+					   const webrtc::VideoFrame::UpdateRect& rect);
+
+	bool detect_text_;
+	int width_ = 0;
+	int height_ = 0;
+	std::vector<uint8_t> last_y_;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_CODEC_SCREEN_ROI_BUILDER_H_
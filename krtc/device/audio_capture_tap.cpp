@@ -0,0 +1,164 @@
+#include "krtc/device/audio_capture_tap.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/media/media_frame.h"
+
+namespace krtc {
+
+AudioCaptureTap::AudioCaptureTap() :
+    ring_(kRingCapacity)
+{
+    // 默认和以前一样回调OnPureAudioFrame
+    SetDelivery(true);
+}
+
+AudioCaptureTap::~AudioCaptureTap() {
+    SetDelivery(false);
+}
+
+void AudioCaptureTap::OnCaptureData(const int16_t* samples, size_t frames,
+    size_t channels, uint32_t sample_rate)
+{
+    if (channels == 0) {
+        return;
+    }
+
+    if (channels != channels_.load(std::memory_order_relaxed) ||
+        sample_rate != sample_rate_.load(std::memory_order_relaxed))
+    {
+        sample_rate_.store(sample_rate, std::memory_order_relaxed);
+        channels_.store(static_cast<uint32_t>(channels), std::memory_order_relaxed);
+        format_generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    // 只写整帧，放不下的部分丢掉
+    size_t writable = std::min(frames, ring_.WritableSize() / channels);
+    ring_.Write(samples, writable * channels);
+    if (writable < frames) {
+        overrun_frames_.fetch_add(frames - writable, std::memory_order_relaxed);
+    }
+}
+
+int32_t AudioCaptureTap::Read(int16_t* buffer, int32_t frames) {
+    std::lock_guard<std::mutex> locker(consumer_mutex_);
+    if (delivery_) {
+        return -1;
+    }
+    if (!buffer || frames <= 0) {
+        return 0;
+    }
+
+    uint32_t channels = SyncFormatLocked();
+    size_t read = channels ? ring_.Read(buffer, static_cast<size_t>(frames) * channels) / channels : 0;
+    if (read < static_cast<size_t>(frames)) {
+        underrun_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return static_cast<int32_t>(read);
+}
+
+void AudioCaptureTap::SetDelivery(bool enable) {
+    std::unique_ptr<std::thread> thread;
+    {
+        std::lock_guard<std::mutex> locker(consumer_mutex_);
+        if (delivery_ == enable) {
+            return;
+        }
+        delivery_ = enable;
+        if (enable) {
+            delivery_running_ = true;
+            delivery_thread_.reset(new std::thread([this] {
+                DeliveryThread();
+            }));
+        }
+        else {
+            delivery_running_ = false;
+            thread = std::move(delivery_thread_);
+        }
+    }
+
+    // 投递线程每次读缓冲区都要拿consumer_mutex_，在锁外等它退出
+    if (thread) {
+        thread->join();
+    }
+}
+
+KRTCCapturedAudioStats AudioCaptureTap::stats() {
+    std::lock_guard<std::mutex> locker(consumer_mutex_);
+    KRTCCapturedAudioStats stats;
+    stats.channels = SyncFormatLocked();
+    stats.sample_rate = sample_rate_.load(std::memory_order_relaxed);
+    stats.buffered_frames = stats.channels ? static_cast<uint32_t>(ring_.ReadableSize() / stats.channels) : 0;
+    stats.overrun_frames = overrun_frames_.load(std::memory_order_relaxed);
+    stats.underrun_count = underrun_count_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint32_t AudioCaptureTap::SyncFormatLocked() {
+    uint32_t generation = format_generation_.load(std::memory_order_acquire);
+    if (generation != consumer_generation_) {
+        consumer_generation_ = generation;
+        // 缓冲区里可能还有旧格式的数据
+        ring_.Discard(ring_.ReadableSize());
+    }
+    return channels_.load(std::memory_order_relaxed);
+}
+
+void AudioCaptureTap::DeliveryThread() {
+    const auto interval = std::chrono::milliseconds(10);
+    auto next = std::chrono::steady_clock::now();
+    while (delivery_running_) {
+        // 把攒下的整10ms帧都投递出去
+        while (delivery_running_) {
+            uint32_t channels = 0;
+            uint32_t sample_rate = 0;
+            {
+                std::lock_guard<std::mutex> locker(consumer_mutex_);
+                channels = SyncFormatLocked();
+                sample_rate = sample_rate_.load(std::memory_order_relaxed);
+                size_t frame_samples = static_cast<size_t>(sample_rate / 100) * channels;
+                if (frame_samples == 0 || ring_.ReadableSize() < frame_samples) {
+                    break;
+                }
+                delivery_buffer_.resize(frame_samples);
+                ring_.Read(delivery_buffer_.data(), frame_samples);
+            }
+
+            KRTCEngineObserver* observer = KRTCGlobal::Instance()->engine_observer();
+            if (!observer) {
+                continue;
+            }
+
+            int len = static_cast<int>(delivery_buffer_.size() * sizeof(int16_t));
+            auto frame = std::make_shared<MediaFrame>(len);
+            frame->fmt.media_type = MainMediaType::kMainTypeAudio;
+            frame->fmt.sub_fmt.audio_fmt.type = SubMediaType::kSubTypePcm;
+            frame->fmt.sub_fmt.audio_fmt.nbytes_per_sample = sizeof(int16_t) * channels;
+            frame->fmt.sub_fmt.audio_fmt.samples_per_channel = sample_rate / 100;
+            frame->fmt.sub_fmt.audio_fmt.channels = channels;
+            frame->fmt.sub_fmt.audio_fmt.samples_per_sec = sample_rate;
+            frame->data_len[0] = len;
+            frame->data[0] = new char[len];
+            memcpy(frame->data[0], delivery_buffer_.data(), len);
+
+            // 计算时间戳，根据采样频率进行单调递增
+            timestamp_ += sample_rate / 100;
+            frame->ts = timestamp_;
+
+            observer->OnPureAudioFrame(frame);
+        }
+
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+} // namespace krtc
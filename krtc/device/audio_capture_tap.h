@@ -0,0 +1,63 @@
+#ifndef KRTCSDK_KRTC_DEVICE_AUDIO_CAPTURE_TAP_H_
+#define KRTCSDK_KRTC_DEVICE_AUDIO_CAPTURE_TAP_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "krtc/krtc.h"
+#include "krtc/base/spsc_ring_buffer.h"
+
+namespace krtc {
+
+// 麦克风采集数据的旁路输出。
+// ADM采集线程只往无锁环形缓冲区里写，不分配内存也不回调应用；
+// 应用可以用ReadCapturedAudio自己拉取，或者由投递线程每10ms读出后回调OnPureAudioFrame。
+// 两种方式同一时间只能用一种，缓冲区只支持一个消费者。
+class AudioCaptureTap {
+public:
+    AudioCaptureTap();
+    ~AudioCaptureTap();
+
+    // ADM采集线程调用，samples为16bit交织PCM
+    void OnCaptureData(const int16_t* samples, size_t frames, size_t channels, uint32_t sample_rate);
+
+    // 开启投递线程时返回-1，否则返回读到的帧数(每帧含所有声道)
+    int32_t Read(int16_t* buffer, int32_t frames);
+
+    void SetDelivery(bool enable);
+    KRTCCapturedAudioStats stats();
+
+private:
+    void DeliveryThread();
+    // 消费端发现格式变化后丢掉旧格式的数据，返回当前声道数
+    uint32_t SyncFormatLocked();
+
+    // 约1秒48kHz双声道
+    static const size_t kRingCapacity = 96000;
+
+    SpscRingBuffer<int16_t> ring_;
+
+    // 生产端写
+    std::atomic<uint32_t> sample_rate_{ 0 };
+    std::atomic<uint32_t> channels_{ 0 };
+    std::atomic<uint32_t> format_generation_{ 0 };
+    std::atomic<uint64_t> overrun_frames_{ 0 };
+    std::atomic<uint64_t> underrun_count_{ 0 };
+
+    // 消费端，读、投递线程启停都在consumer_mutex_下，应用线程的Read不会和投递线程同时读
+    std::mutex consumer_mutex_;
+    uint32_t consumer_generation_ = 0;
+    bool delivery_ = false;
+    std::atomic<bool> delivery_running_{ false };
+    std::unique_ptr<std::thread> delivery_thread_;
+    // 只在投递线程访问
+    std::vector<int16_t> delivery_buffer_;
+    uint32_t timestamp_ = 0;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_AUDIO_CAPTURE_TAP_H_
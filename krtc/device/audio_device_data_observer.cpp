@@ -1,6 +1,7 @@
 #include "audio_device_data_observer.h"
-#include "krtc/base/krtc_global.h"
-#include "krtc/media/media_frame.h"
+#include "krtc/base/allocation_guard.h"
+#include "krtc/device/audio_capture_tap.h"
+#include "krtc/device/audio_processing_profiler.h"
 
 namespace krtc {
 
@@ -14,25 +15,17 @@ namespace krtc {
             << " num_channels:" << num_channels
             << "samples_per_sec:" << samples_per_sec;*/
 
-        int len = static_cast<int>(num_samples * bytes_per_sample);
-        auto frame = std::make_shared<MediaFrame>(len); //webrtc::AudioFrame::kMaxDataSizeBytes
-        frame->fmt.media_type = MainMediaType::kMainTypeAudio;
-        frame->fmt.sub_fmt.audio_fmt.type = SubMediaType::kSubTypePcm;
-        frame->fmt.sub_fmt.audio_fmt.nbytes_per_sample = bytes_per_sample;
-        frame->fmt.sub_fmt.audio_fmt.samples_per_channel = num_samples;
-        frame->fmt.sub_fmt.audio_fmt.channels = num_channels;
-        frame->fmt.sub_fmt.audio_fmt.samples_per_sec = samples_per_sec;
-        frame->data_len[0] = len;
-        frame->data[0] = new char[len];
-        memcpy(frame->data[0], audio_samples, len);
-
-        // 计算时间戳，根据采样频率进行单调递增
-        timestamp_ += num_samples;
-        frame->ts = timestamp_;
-
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPureAudioFrame(frame);
+        // 实时音频线程，不能分配内存，也不能等应用的回调
+        ScopedNoAllocation no_allocation;
+
+        // bytes_per_sample是一帧所有声道的字节数
+        if (bytes_per_sample != num_channels * sizeof(int16_t)) {
+            return;
         }
+        capture_tap_->OnCaptureData(static_cast<const int16_t*>(audio_samples),
+            num_samples, num_channels, samples_per_sec);
+        profiler_->OnCaptureData(static_cast<const int16_t*>(audio_samples),
+            num_samples, num_channels, samples_per_sec);
     }
 
     void ADMDataObserver::OnRenderData(const void* audio_samples,
@@ -44,6 +37,14 @@ namespace krtc {
             << " bytes_per_sample:" << bytes_per_sample
             << " num_channels:" << num_channels
             << "samples_per_sec:" << samples_per_sec;*/
+
+        ScopedNoAllocation no_allocation;
+
+        if (bytes_per_sample != num_channels * sizeof(int16_t)) {
+            return;
+        }
+        profiler_->OnRenderData(static_cast<const int16_t*>(audio_samples),
+            num_samples, num_channels, samples_per_sec);
     }
 
 }
\ No newline at end of file
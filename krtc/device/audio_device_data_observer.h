@@ -6,7 +6,15 @@
 
 namespace krtc{
 
+class AudioCaptureTap;
+class AudioProcessingProfiler;
+
 class ADMDataObserver : public webrtc::AudioDeviceDataObserver {
+public:
+    ADMDataObserver(AudioCaptureTap* capture_tap, AudioProcessingProfiler* profiler) :
+        capture_tap_(capture_tap),
+        profiler_(profiler) {}
+
 private:
     virtual void OnCaptureData(const void* audio_samples,
         const size_t num_samples,
@@ -21,7 +29,10 @@ private:
         const uint32_t samples_per_sec) override;
 
 private:
-    uint32_t timestamp_ = 0;
+    // 采集数据只写入旁路缓冲区，由其他线程回调应用
+    AudioCaptureTap* capture_tap_;
+    // 开启APM耗时统计时旁路一份采集和播放数据
+    AudioProcessingProfiler* profiler_;
 
 };
 
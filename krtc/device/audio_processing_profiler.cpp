@@ -0,0 +1,293 @@
+#include "krtc/device/audio_processing_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+AudioProcessingProfiler::Stream::Stream() :
+    ring(kRingCapacity)
+{
+}
+
+void AudioProcessingProfiler::Stream::Write(const int16_t* samples, size_t frames,
+    size_t channels, uint32_t sample_rate)
+{
+    if (channels != this->channels.load(std::memory_order_relaxed) ||
+        sample_rate != this->sample_rate.load(std::memory_order_relaxed))
+    {
+        this->sample_rate.store(sample_rate, std::memory_order_relaxed);
+        this->channels.store(static_cast<uint32_t>(channels), std::memory_order_relaxed);
+        format_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // 只写整帧，放不下的部分丢掉
+    size_t writable = std::min(frames, ring.WritableSize() / channels);
+    ring.Write(samples, writable * channels);
+}
+
+bool AudioProcessingProfiler::Stream::SyncFormat() {
+    uint32_t generation = format_generation.load(std::memory_order_acquire);
+    if (generation == consumer_generation) {
+        return false;
+    }
+    consumer_generation = generation;
+    ring.Discard(ring.ReadableSize());
+    return true;
+}
+
+bool AudioProcessingProfiler::Stream::ReadFrame(std::vector<int16_t>* frame) {
+    size_t frame_samples = static_cast<size_t>(sample_rate.load(std::memory_order_relaxed) / 100) *
+        channels.load(std::memory_order_relaxed);
+    if (frame_samples == 0 || ring.ReadableSize() < frame_samples) {
+        return false;
+    }
+    frame->resize(frame_samples);
+    ring.Read(frame->data(), frame_samples);
+    return true;
+}
+
+AudioProcessingProfiler::AudioProcessingProfiler() {}
+
+AudioProcessingProfiler::~AudioProcessingProfiler() {
+    KRTCAudioProcessingConfig config;
+    config.profile = false;
+    SetConfig(config);
+}
+
+webrtc::AudioProcessing::Config AudioProcessingProfiler::ToApmConfig(const KRTCAudioProcessingConfig& config) {
+    webrtc::AudioProcessing::Config apm_config;
+    apm_config.pipeline.maximum_internal_processing_rate = config.processing_sample_rate <= 32000 ? 32000 : 48000;
+    apm_config.pipeline.multi_channel_capture = config.stereo_capture;
+
+    apm_config.echo_canceller.enabled = config.echo_cancellation;
+    apm_config.echo_canceller.mobile_mode = false;
+
+    using NsLevel = webrtc::AudioProcessing::Config::NoiseSuppression::Level;
+    apm_config.noise_suppression.enabled = config.noise_suppression;
+    switch (config.noise_suppression_level) {
+    case NOISE_SUPPRESSION_LEVEL::LOW:
+        apm_config.noise_suppression.level = NsLevel::kLow;
+        break;
+    case NOISE_SUPPRESSION_LEVEL::MODERATE:
+        apm_config.noise_suppression.level = NsLevel::kModerate;
+        break;
+    case NOISE_SUPPRESSION_LEVEL::VERY_HIGH:
+        apm_config.noise_suppression.level = NsLevel::kVeryHigh;
+        break;
+    case NOISE_SUPPRESSION_LEVEL::HIGH:
+    default:
+        apm_config.noise_suppression.level = NsLevel::kHigh;
+        break;
+    }
+
+    // 用AGC2的自适应数字增益代替引擎默认打开的AGC1
+    apm_config.gain_controller1.enabled = false;
+    apm_config.gain_controller2.enabled = config.auto_gain_control;
+    apm_config.gain_controller2.adaptive_digital.enabled = config.auto_gain_control;
+
+    apm_config.high_pass_filter.enabled = config.high_pass_filter;
+    return apm_config;
+}
+
+void AudioProcessingProfiler::SetConfig(const KRTCAudioProcessingConfig& config) {
+    std::unique_ptr<std::thread> thread;
+    {
+        std::lock_guard<std::mutex> locker(config_mutex_);
+        config_ = config;
+        config_changed_ = true;
+        if (config.profile && !running_) {
+            running_ = true;
+            profile_thread_.reset(new std::thread([this] {
+                ProfileThread();
+            }));
+        }
+        else if (!config.profile && running_) {
+            running_ = false;
+            thread = std::move(profile_thread_);
+        }
+    }
+
+    // profiler线程重建模块时要拿config_mutex_，在锁外等它退出
+    if (thread) {
+        thread->join();
+    }
+}
+
+void AudioProcessingProfiler::OnCaptureData(const int16_t* samples, size_t frames,
+    size_t channels, uint32_t sample_rate)
+{
+    if (running_.load(std::memory_order_relaxed) && channels > 0) {
+        capture_.Write(samples, frames, channels, sample_rate);
+    }
+}
+
+void AudioProcessingProfiler::OnRenderData(const int16_t* samples, size_t frames,
+    size_t channels, uint32_t sample_rate)
+{
+    if (running_.load(std::memory_order_relaxed) && channels > 0) {
+        render_.Write(samples, frames, channels, sample_rate);
+    }
+}
+
+void AudioProcessingProfiler::ProfileThread() {
+    // 丢掉上一次开启时残留的数据
+    capture_.SyncFormat();
+    capture_.ring.Discard(capture_.ring.ReadableSize());
+    render_.SyncFormat();
+    render_.ring.Discard(render_.ring.ReadableSize());
+    {
+        std::lock_guard<std::mutex> locker(config_mutex_);
+        config_changed_ = true;
+    }
+
+    const auto interval = std::chrono::milliseconds(10);
+    auto next = std::chrono::steady_clock::now();
+    while (running_) {
+        bool rebuild = capture_.SyncFormat();
+        render_.SyncFormat();
+        {
+            std::lock_guard<std::mutex> locker(config_mutex_);
+            rebuild |= config_changed_;
+            config_changed_ = false;
+        }
+        if (rebuild) {
+            CreateModules();
+        }
+
+        ProcessRender();
+        ProcessCapture();
+
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+
+    for (auto& module : modules_) {
+        module = nullptr;
+    }
+}
+
+void AudioProcessingProfiler::CreateModules() {
+    KRTCAudioProcessingConfig config;
+    {
+        std::lock_guard<std::mutex> locker(config_mutex_);
+        config = config_;
+    }
+
+    // 每个模块用当前的参数单独开启
+    webrtc::AudioProcessing::Config base_config = ToApmConfig(config);
+    base_config.echo_canceller.enabled = false;
+    base_config.noise_suppression.enabled = false;
+    base_config.gain_controller2.enabled = false;
+    base_config.gain_controller2.adaptive_digital.enabled = false;
+    base_config.high_pass_filter.enabled = false;
+
+    for (int i = 0; i < kModuleCount; i++) {
+        webrtc::AudioProcessing::Config module_config = base_config;
+        switch (i) {
+        case kHighPassFilter:
+            module_config.high_pass_filter.enabled = true;
+            break;
+        case kEchoCancellation:
+            module_config.echo_canceller.enabled = true;
+            break;
+        case kNoiseSuppression:
+            module_config.noise_suppression.enabled = true;
+            break;
+        case kAutoGainControl:
+            module_config.gain_controller2.enabled = true;
+            module_config.gain_controller2.adaptive_digital.enabled = true;
+            break;
+        }
+        modules_[i] = webrtc::AudioProcessingBuilder().Create();
+        modules_[i]->ApplyConfig(module_config);
+    }
+
+    pending_render_us_ = 0;
+    for (auto& cost : costs_) {
+        cost = ModuleCost();
+    }
+    frames_ = 0;
+}
+
+void AudioProcessingProfiler::ProcessRender() {
+    webrtc::AudioProcessing* aec = modules_[kEchoCancellation].get();
+    while (render_.ReadFrame(&render_frame_)) {
+        if (!aec) {
+            continue;
+        }
+        webrtc::StreamConfig stream_config(render_.sample_rate.load(std::memory_order_relaxed),
+            render_.channels.load(std::memory_order_relaxed));
+        output_frame_.resize(render_frame_.size());
+
+        int64_t begin_us = rtc::TimeMicros();
+        aec->ProcessReverseStream(render_frame_.data(), stream_config, stream_config, output_frame_.data());
+        pending_render_us_ += rtc::TimeMicros() - begin_us;
+    }
+}
+
+void AudioProcessingProfiler::ProcessCapture() {
+    while (capture_.ReadFrame(&capture_frame_)) {
+        if (!modules_[0]) {
+            continue;
+        }
+        webrtc::StreamConfig stream_config(capture_.sample_rate.load(std::memory_order_relaxed),
+            capture_.channels.load(std::memory_order_relaxed));
+        output_frame_.resize(capture_frame_.size());
+
+        // 每个模块都处理原始采集数据，互不影响
+        for (int i = 0; i < kModuleCount; i++) {
+            if (i == kEchoCancellation) {
+                // 延迟交给AEC3自己估计
+                modules_[i]->set_stream_delay_ms(0);
+            }
+            int64_t begin_us = rtc::TimeMicros();
+            modules_[i]->ProcessStream(capture_frame_.data(), stream_config, stream_config, output_frame_.data());
+            int64_t elapsed_us = rtc::TimeMicros() - begin_us;
+            if (i == kEchoCancellation) {
+                elapsed_us += pending_render_us_;
+                pending_render_us_ = 0;
+            }
+            costs_[i].total_us += elapsed_us;
+            costs_[i].max_us = std::max(costs_[i].max_us, elapsed_us);
+        }
+
+        if (++frames_ >= kReportFrames) {
+            ReportStats();
+        }
+    }
+}
+
+void AudioProcessingProfiler::ReportStats() {
+    KRTCAudioProcessingStats stats;
+    KRTCAudioProcessingStats::ModuleCost* outputs[kModuleCount] = {
+        &stats.high_pass_filter,
+        &stats.echo_cancellation,
+        &stats.noise_suppression,
+        &stats.auto_gain_control,
+    };
+    for (int i = 0; i < kModuleCount; i++) {
+        outputs[i]->avg_us = static_cast<uint32_t>(costs_[i].total_us / frames_);
+        outputs[i]->max_us = static_cast<uint32_t>(costs_[i].max_us);
+        costs_[i] = ModuleCost();
+    }
+    stats.frames = frames_;
+    stats.sample_rate = capture_.sample_rate.load(std::memory_order_relaxed);
+    stats.channels = capture_.channels.load(std::memory_order_relaxed);
+    frames_ = 0;
+
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnAudioProcessingStats(stats);
+    }
+}
+
+} // namespace krtc
@@ -0,0 +1,101 @@
+#ifndef KRTCSDK_KRTC_DEVICE_AUDIO_PROCESSING_PROFILER_H_
+#define KRTCSDK_KRTC_DEVICE_AUDIO_PROCESSING_PROFILER_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <api/scoped_refptr.h>
+#include <modules/audio_processing/include/audio_processing.h>
+
+#include "krtc/krtc.h"
+#include "krtc/base/spsc_ring_buffer.h"
+
+namespace krtc {
+
+// APM各模块的耗时统计。
+// webrtc的APM没有逐模块计时的接口，这里把ADM回调出来的采集和播放数据旁路到profiler线程，
+// 按当前配置为每个模块各建一个只开该模块的APM，分别处理同样的数据并计时。
+// ADM线程只写无锁环形缓冲区，不开启时什么也不做。
+class AudioProcessingProfiler {
+public:
+    AudioProcessingProfiler();
+    ~AudioProcessingProfiler();
+
+    static webrtc::AudioProcessing::Config ToApmConfig(const KRTCAudioProcessingConfig& config);
+
+    void SetConfig(const KRTCAudioProcessingConfig& config);
+
+    // ADM线程调用，samples为16bit交织PCM
+    void OnCaptureData(const int16_t* samples, size_t frames, size_t channels, uint32_t sample_rate);
+    void OnRenderData(const int16_t* samples, size_t frames, size_t channels, uint32_t sample_rate);
+
+private:
+    enum Module {
+        kHighPassFilter,
+        kEchoCancellation,
+        kNoiseSuppression,
+        kAutoGainControl,
+        kModuleCount,
+    };
+
+    // 一个方向的数据，ADM线程写，profiler线程读
+    struct Stream {
+        Stream();
+
+        void Write(const int16_t* samples, size_t frames, size_t channels, uint32_t sample_rate);
+        // 格式变化后丢掉旧格式的数据，返回是否变化过
+        bool SyncFormat();
+        // 读出一帧10ms，不够时返回false
+        bool ReadFrame(std::vector<int16_t>* frame);
+
+        SpscRingBuffer<int16_t> ring;
+        std::atomic<uint32_t> sample_rate{ 0 };
+        std::atomic<uint32_t> channels{ 0 };
+        std::atomic<uint32_t> format_generation{ 0 };
+        // 只在profiler线程访问
+        uint32_t consumer_generation = 0;
+    };
+
+    struct ModuleCost {
+        int64_t total_us = 0;
+        int64_t max_us = 0;
+    };
+
+    void ProfileThread();
+    void CreateModules();
+    void ProcessRender();
+    void ProcessCapture();
+    void ReportStats();
+
+    // 约200ms 48kHz双声道，profiler跟不上时丢数据
+    static const size_t kRingCapacity = 19200;
+    // 每秒上报一次
+    static const uint32_t kReportFrames = 100;
+
+    std::mutex config_mutex_;
+    KRTCAudioProcessingConfig config_;
+    bool config_changed_ = false;
+
+    std::atomic<bool> running_{ false };
+    std::unique_ptr<std::thread> profile_thread_;
+
+    Stream capture_;
+    Stream render_;
+
+    // 以下只在profiler线程访问
+    rtc::scoped_refptr<webrtc::AudioProcessing> modules_[kModuleCount];
+    std::vector<int16_t> capture_frame_;
+    std::vector<int16_t> render_frame_;
+    std::vector<int16_t> output_frame_;
+    // 两帧采集之间回声消除分析远端数据的耗时
+    int64_t pending_render_us_ = 0;
+    ModuleCost costs_[kModuleCount];
+    uint32_t frames_ = 0;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_AUDIO_PROCESSING_PROFILER_H_
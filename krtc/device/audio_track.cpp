@@ -1,5 +1,7 @@
 #include "krtc/device/audio_track.h"
 
+#include <algorithm>
+
 #include <rtc_base/ref_counted_object.h>
 
 namespace krtc {
@@ -11,6 +13,27 @@ rtc::scoped_refptr<LocalAudioSource> LocalAudioSource::Create(
     return source;
 }
 
+void LocalAudioSource::AddSink(webrtc::AudioTrackSinkInterface* sink) {
+    std::lock_guard<std::mutex> locker(sinks_mutex_);
+    if (std::find(sinks_.begin(), sinks_.end(), sink) == sinks_.end()) {
+        sinks_.push_back(sink);
+    }
+}
+
+void LocalAudioSource::RemoveSink(webrtc::AudioTrackSinkInterface* sink) {
+    std::lock_guard<std::mutex> locker(sinks_mutex_);
+    sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink), sinks_.end());
+}
+
+void LocalAudioSource::OnData(const int16_t* audio_data, int sample_rate,
+    size_t number_of_channels, size_t number_of_frames)
+{
+    std::lock_guard<std::mutex> locker(sinks_mutex_);
+    for (auto* sink : sinks_) {
+        sink->OnData(audio_data, 16, sample_rate, number_of_channels, number_of_frames);
+    }
+}
+
 void LocalAudioSource::Initialize(const cricket::AudioOptions* audio_options) {
     if (!audio_options)
         return;
@@ -18,4 +41,4 @@ void LocalAudioSource::Initialize(const cricket::AudioOptions* audio_options) {
     options_ = *audio_options;
 }
 
-} // namespace krtc
\ No newline at end of file
+} // namespace krtc
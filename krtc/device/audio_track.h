@@ -1,6 +1,9 @@
 #ifndef KRTCSDK_KRTC_DEVICE_AUDIO_TRACK_H_
 #define KRTCSDK_KRTC_DEVICE_AUDIO_TRACK_H_
 
+#include <mutex>
+#include <vector>
+
 #include <api/media_stream_interface.h>
 #include <api/audio_options.h>
 #include <api/notifier.h>
@@ -8,6 +11,7 @@
 
 namespace krtc {
 
+// 不经过ADM的本地音频源，OnData送进来的数据直接交给发送流编码
 class LocalAudioSource : public webrtc::Notifier<webrtc::AudioSourceInterface> {
 public:
     static rtc::scoped_refptr<LocalAudioSource> Create(
@@ -21,8 +25,12 @@ public:
 
     const cricket::AudioOptions options() const override { return options_; }
 
-    void AddSink(webrtc::AudioTrackSinkInterface* sink) override {}
-    void RemoveSink(webrtc::AudioTrackSinkInterface* sink) override {}
+    void AddSink(webrtc::AudioTrackSinkInterface* sink) override;
+    void RemoveSink(webrtc::AudioTrackSinkInterface* sink) override;
+
+    // 每次10ms的16bit交织PCM
+    void OnData(const int16_t* audio_data, int sample_rate, size_t number_of_channels,
+        size_t number_of_frames);
 
 protected:
     LocalAudioSource() {}
@@ -32,6 +40,9 @@ private:
     void Initialize(const cricket::AudioOptions* audio_options);
 
     cricket::AudioOptions options_;
+    // 回调时也持有，RemoveSink返回后不会再回调
+    std::mutex sinks_mutex_;
+    std::vector<webrtc::AudioTrackSinkInterface*> sinks_;
 };
 
 } // namespace krtc
@@ -0,0 +1,162 @@
+#include "krtc/device/camera_capability.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <tuple>
+
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+namespace {
+
+const int64_t kStatsIntervalMs = 1000;
+
+// 越小越优先，不认识的格式(RGB等)排在最后
+int FormatRank(webrtc::VideoType type) {
+    switch (type) {
+    case webrtc::VideoType::kNV12:
+        return 0;
+    case webrtc::VideoType::kI420:
+        return 1;
+    case webrtc::VideoType::kYUY2:
+        return 2;
+    case webrtc::VideoType::kUYVY:
+        return 3;
+    case webrtc::VideoType::kMJPEG:
+        return 4;
+    default:
+        return 5;
+    }
+}
+
+bool MatchFormat(CAMERA_FORMAT format, webrtc::VideoType type) {
+    switch (format) {
+    case CAMERA_FORMAT::AUTO:
+        return true;
+    case CAMERA_FORMAT::I420:
+        return type == webrtc::VideoType::kI420;
+    case CAMERA_FORMAT::NV12:
+        return type == webrtc::VideoType::kNV12;
+    case CAMERA_FORMAT::YUY2:
+        return type == webrtc::VideoType::kYUY2;
+    case CAMERA_FORMAT::MJPEG:
+        return type == webrtc::VideoType::kMJPEG;
+    }
+    return false;
+}
+
+} // namespace
+
+bool SelectCameraCapability(const std::vector<webrtc::VideoCaptureCapability>& capabilities,
+    const KRTCCameraCaptureConfig& config,
+    webrtc::VideoCaptureCapability* selected)
+{
+    const int target_fps = static_cast<int>(config.fps);
+    // (分辨率差，达不到目标帧率，差多少帧，格式排序)
+    std::tuple<int, int, int, int> best_key;
+    bool found = false;
+    for (const auto& cap : capabilities) {
+        if (!MatchFormat(config.format, cap.videoType)) {
+            continue;
+        }
+
+        int size_diff = abs(cap.width - static_cast<int>(config.width)) +
+            abs(cap.height - static_cast<int>(config.height));
+        bool fps_ok = cap.maxFPS >= target_fps;
+        auto key = std::make_tuple(size_diff, fps_ok ? 0 : 1, fps_ok ? 0 : target_fps - cap.maxFPS,
+            FormatRank(cap.videoType));
+        if (!found || key < best_key) {
+            best_key = key;
+            *selected = cap;
+            found = true;
+        }
+    }
+
+    if (found) {
+        RTC_LOG(LS_INFO) << "select camera capability " << selected->width << "x" << selected->height
+            << "@" << selected->maxFPS << " type:" << static_cast<int>(selected->videoType);
+    }
+    return found;
+}
+
+CAMERA_FORMAT ToCameraFormat(webrtc::VideoType type) {
+    switch (type) {
+    case webrtc::VideoType::kI420:
+        return CAMERA_FORMAT::I420;
+    case webrtc::VideoType::kNV12:
+        return CAMERA_FORMAT::NV12;
+    case webrtc::VideoType::kYUY2:
+        return CAMERA_FORMAT::YUY2;
+    case webrtc::VideoType::kMJPEG:
+        return CAMERA_FORMAT::MJPEG;
+    default:
+        return CAMERA_FORMAT::AUTO;
+    }
+}
+
+CameraStatsCounter::CameraStatsCounter(const std::string& cam_id) :
+    cam_id_(cam_id)
+{
+}
+
+void CameraStatsCounter::SetCapability(const webrtc::VideoCaptureCapability& capability,
+    uint32_t decode_threads)
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    stats_ = KRTCCameraStats();
+    stats_.width = capability.width;
+    stats_.height = capability.height;
+    stats_.fps = capability.maxFPS;
+    stats_.format = ToCameraFormat(capability.videoType);
+    stats_.decode_threads = decode_threads;
+    decode_us_total_ = 0;
+    last_report_ms_ = rtc::TimeMillis();
+}
+
+void CameraStatsCounter::AddFrame(int64_t decode_us) {
+    KRTCCameraStats report;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        ++stats_.frames;
+        decode_us_total_ += decode_us;
+        stats_.decode_max_us = std::max(stats_.decode_max_us, static_cast<uint32_t>(decode_us));
+        if (!TakeReport(rtc::TimeMillis(), &report)) {
+            return;
+        }
+    }
+
+    // 不持锁回调
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnCameraStats(cam_id_.c_str(), report);
+    }
+}
+
+void CameraStatsCounter::AddDropped() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    ++stats_.frames_dropped;
+}
+
+bool CameraStatsCounter::TakeReport(int64_t now_ms, KRTCCameraStats* report) {
+    if (now_ms - last_report_ms_ < kStatsIntervalMs) {
+        return false;
+    }
+
+    if (stats_.frames > 0) {
+        stats_.decode_avg_us = static_cast<uint32_t>(decode_us_total_ / stats_.frames);
+    }
+    *report = stats_;
+
+    stats_.frames = 0;
+    stats_.decode_avg_us = 0;
+    stats_.decode_max_us = 0;
+    decode_us_total_ = 0;
+    last_report_ms_ = now_ms;
+    return true;
+}
+
+}  // namespace krtc
@@ -0,0 +1,47 @@
+#ifndef KRTCSDK_KRTC_DEVICE_CAMERA_CAPABILITY_H_
+#define KRTCSDK_KRTC_DEVICE_CAMERA_CAPABILITY_H_
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <modules/video_capture/video_capture_defines.h>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 按采集配置选择摄像头能力：分辨率最接近的优先，其次能达到目标帧率，
+// 最后按格式排序，原始格式(NV12 > I420 > YUY2 > UYVY)不用解码，排在MJPEG前面。
+// format不是AUTO时只在该格式里选，没有可选的能力时返回false
+bool SelectCameraCapability(const std::vector<webrtc::VideoCaptureCapability>& capabilities,
+    const KRTCCameraCaptureConfig& config,
+    webrtc::VideoCaptureCapability* selected);
+
+CAMERA_FORMAT ToCameraFormat(webrtc::VideoType type);
+
+// 统计采集输出帧数和解码耗时，每秒通过OnCameraStats回调一次
+class CameraStatsCounter {
+public:
+    explicit CameraStatsCounter(const std::string& cam_id);
+
+    void SetCapability(const webrtc::VideoCaptureCapability& capability, uint32_t decode_threads);
+    // 每输出一帧调用一次，可能来自不同的解码线程
+    void AddFrame(int64_t decode_us);
+    void AddDropped();
+
+private:
+    bool TakeReport(int64_t now_ms, KRTCCameraStats* report);
+
+    std::string cam_id_;
+    std::mutex mutex_;
+    KRTCCameraStats stats_;
+    uint64_t decode_us_total_ = 0;
+    int64_t last_report_ms_ = 0;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_DEVICE_CAMERA_CAPABILITY_H_
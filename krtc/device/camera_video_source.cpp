@@ -6,22 +6,23 @@ namespace krtc {
 
 CameraVideoSource::CameraVideoSource(const char* cam_id)
 {
-    KRTCGlobal::Instance()->CreateVcmCapturerSource(cam_id);
+    source_id_ = KRTCGlobal::Instance()->video_source_registry()->AddCamera(cam_id);
 }
 
 CameraVideoSource::~CameraVideoSource() {
-    Destroy();
+    KRTCGlobal::Instance()->video_source_registry()->Remove(source_id_);
 }
 
 void CameraVideoSource::Start() {
-    KRTCGlobal::Instance()->StartVcmCapturerSource();      
+    KRTCGlobal::Instance()->video_source_registry()->Start(source_id_);
 }
 
 void CameraVideoSource::Stop() {
-    KRTCGlobal::Instance()->StopVcmCapturerSource();
+    KRTCGlobal::Instance()->video_source_registry()->Stop(source_id_);
 }
 
 void CameraVideoSource::Destroy() {
+    delete this;
 }
 
 } // namespace krtc
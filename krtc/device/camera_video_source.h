@@ -2,10 +2,11 @@
 #define KRTCSDK_KRTC_DEVICE_CAMERA_VIDEO_SOURCE_H_
 
 #include "krtc/krtc.h"
+#include "krtc/device/video_source_registry.h"
 
 namespace krtc {
 
-class CameraVideoSource : public IVideoHandler
+class CameraVideoSource : public VideoSourceHandler
 {
 public:
 	void Start() override;
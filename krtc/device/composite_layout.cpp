@@ -0,0 +1,110 @@
+#include "krtc/device/composite_layout.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace krtc {
+
+namespace {
+
+// I420的色度是2x2采样，区域坐标和宽高都取偶数
+int AlignEven(float value) {
+	return static_cast<int>(value) & ~1;
+}
+
+// 裁到输出画面内，左上角移进画面时宽高相应减少
+CompositeRect ClipToOutput(int x, int y, int width, int height, int out_width, int out_height) {
+	int left = std::max(x, 0);
+	int top = std::max(y, 0);
+	int right = std::min(x + width, out_width);
+	int bottom = std::min(y + height, out_height);
+
+	CompositeRect rect;
+	if (right <= left || bottom <= top) {
+		return rect;
+	}
+	rect.x = left;
+	rect.y = top;
+	rect.width = right - left;
+	rect.height = bottom - top;
+	return rect;
+}
+
+} // namespace
+
+CompositeRect CompositeRegionFor(const KRTCCompositeConfig& config, size_t index, size_t count,
+	int src_width, int src_height)
+{
+	const int out_width_px = static_cast<int>(config.width);
+	const int out_height_px = static_cast<int>(config.height);
+	const float out_width = static_cast<float>(config.width);
+	const float out_height = static_cast<float>(config.height);
+
+	float x = 0, y = 0, width = out_width, height = out_height;
+	switch (config.layout) {
+	case COMPOSITE_LAYOUT::GRID: {
+		size_t cols = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+		size_t rows = (count + cols - 1) / cols;
+		width = out_width / cols;
+		height = out_height / rows;
+		x = (index % cols) * width;
+		y = (index / cols) * height;
+		break;
+	}
+	case COMPOSITE_LAYOUT::PIP:
+		if (index > 0) {
+			const float margin = out_width * 0.02f;
+			width = out_width * std::min(std::max(config.pip_scale, 0.05f), 1.0f);
+			height = width * out_height / out_width;
+			x = out_width - margin - width;
+			y = out_height - index * (margin + height);
+		}
+		break;
+	case COMPOSITE_LAYOUT::CUSTOM: {
+		// 自定义区域直接拉伸铺满
+		const KRTCCompositeRegion& custom = config.regions[index];
+		return ClipToOutput(AlignEven(custom.x * out_width), AlignEven(custom.y * out_height),
+			AlignEven(custom.width * out_width), AlignEven(custom.height * out_height),
+			out_width_px, out_height_px);
+	}
+	}
+
+	// 网格和画中画保持输入宽高比，在区域内居中
+	if (src_width > 0 && src_height > 0) {
+		float scale = std::min(width / src_width, height / src_height);
+		float fit_width = src_width * scale;
+		float fit_height = src_height * scale;
+		x += (width - fit_width) / 2;
+		y += (height - fit_height) / 2;
+		width = fit_width;
+		height = fit_height;
+	}
+
+	return ClipToOutput(AlignEven(x), AlignEven(y), AlignEven(width), AlignEven(height),
+		out_width_px, out_height_px);
+}
+
+bool CompositeReferenceTimestamp(const std::vector<int64_t>& latest_us, int64_t now_us, int64_t stale_us,
+	int64_t* reference_us)
+{
+	if (latest_us.empty()) {
+		return false;
+	}
+
+	bool has_live = false;
+	int64_t newest_us = latest_us[0];
+	for (int64_t timestamp_us : latest_us) {
+		newest_us = std::max(newest_us, timestamp_us);
+		if (now_us - timestamp_us > stale_us) {
+			continue;
+		}
+		*reference_us = has_live ? std::min(*reference_us, timestamp_us) : timestamp_us;
+		has_live = true;
+	}
+	if (!has_live) {
+		*reference_us = newest_us;
+	}
+	return true;
+}
+
+} // namespace krtc
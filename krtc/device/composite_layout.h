@@ -0,0 +1,33 @@
+#ifndef KRTCSDK_KRTC_DEVICE_COMPOSITE_LAYOUT_H_
+#define KRTCSDK_KRTC_DEVICE_COMPOSITE_LAYOUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 输出画面里的像素区域，坐标和宽高都是偶数
+struct CompositeRect {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// 第index路(共count路)输入在输出画面里的区域，超出画面的部分裁掉，完全不可见时宽高为0。
+// config的宽高要是偶数
+CompositeRect CompositeRegionFor(const KRTCCompositeConfig& config, size_t index, size_t count,
+	int src_width, int src_height);
+
+// 合成时各路对齐的基准时间：stale_us内还在出帧的输入里，最新帧最早的那一路的时间。
+// 停止出帧的输入不参与，所有输入都停了时取最新的一帧。latest_us里只放已经有帧的输入
+bool CompositeReferenceTimestamp(const std::vector<int64_t>& latest_us, int64_t now_us, int64_t stale_us,
+	int64_t* reference_us);
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_COMPOSITE_LAYOUT_H_
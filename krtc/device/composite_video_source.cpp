@@ -0,0 +1,28 @@
+#include "krtc/device/composite_video_source.h"
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+CompositeVideoSource::CompositeVideoSource(const std::vector<VideoSourceId>& inputs,
+	const KRTCCompositeConfig& config)
+{
+	source_id_ = KRTCGlobal::Instance()->video_source_registry()->AddComposite(inputs, config);
+}
+
+CompositeVideoSource::~CompositeVideoSource() {
+	KRTCGlobal::Instance()->video_source_registry()->Remove(source_id_);
+}
+
+void CompositeVideoSource::Start() {
+	KRTCGlobal::Instance()->video_source_registry()->Start(source_id_);
+}
+
+void CompositeVideoSource::Stop() {
+	KRTCGlobal::Instance()->video_source_registry()->Stop(source_id_);
+}
+
+void CompositeVideoSource::Destroy() {
+	delete this;
+}
+
+} // namespace krtc
@@ -0,0 +1,29 @@
+#ifndef KRTCSDK_KRTC_DEVICE_COMPOSITE_VIDEO_SOURCE_H_
+#define KRTCSDK_KRTC_DEVICE_COMPOSITE_VIDEO_SOURCE_H_
+
+#include <vector>
+
+#include "krtc/krtc.h"
+#include "krtc/device/video_source_registry.h"
+
+namespace krtc {
+
+class CompositeVideoSource : public VideoSourceHandler
+{
+public:
+	void Start() override;
+	void Stop() override;
+	void Destroy() override;
+	void SetEnableVideo(bool enable) {}
+	void SetEnableAudio(bool enable) {}
+
+private:
+	CompositeVideoSource(const std::vector<VideoSourceId>& inputs, const KRTCCompositeConfig& config);
+	~CompositeVideoSource();
+
+	friend class KRTCEngine;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_COMPOSITE_VIDEO_SOURCE_H_
@@ -137,6 +137,8 @@ namespace krtc {
         bool is_found = false;
         webrtc::DesktopCapturer::SourceList source_list;
         webrtc::DesktopCaptureOptions options = webrtc::DesktopCaptureOptions::CreateDefault();
+        // 采集器本身不给出变化区域时由differ逐块比较得到
+        options.set_detect_updated_region(KRTCGlobal::Instance()->screen_share_roi());
 
         source_list.clear();
         desktop_capturer_ = webrtc::DesktopCapturer::CreateScreenCapturer(options);
@@ -224,7 +226,19 @@ namespace krtc {
             i420_buffer->width(), i420_buffer->height(),
             libyuv::kRotate0, libyuv::FOURCC_ARGB);
 
-        auto video_frame = webrtc::VideoFrame(i420_buffer, webrtc::kVideoRotation_0, rtc::TimeMicros());
+        // 把桌面变化区域带给编码器，用于屏幕共享的ROI
+        webrtc::DesktopRect updated_rect;
+        for (webrtc::DesktopRegion::Iterator iter(frame->updated_region()); !iter.IsAtEnd(); iter.Advance()) {
+            updated_rect.UnionWith(iter.rect());
+        }
+
+        auto video_frame = webrtc::VideoFrame::Builder()
+            .set_video_frame_buffer(i420_buffer)
+            .set_rotation(webrtc::kVideoRotation_0)
+            .set_timestamp_us(rtc::TimeMicros())
+            .set_update_rect(webrtc::VideoFrame::UpdateRect{ updated_rect.left(), updated_rect.top(),
+                updated_rect.width(), updated_rect.height() })
+            .build();
         if (frame_callback_) {
             frame_callback_(video_frame);
         }
@@ -38,8 +38,8 @@ public:
 
 	void OnFrame(const webrtc::VideoFrame& frame) override;
 
-	void Start();
-	void Stop();
+	void Start() override;
+	void Stop() override;
 	void Destroy();
 	void SetEnableVideo(bool enable) {}
 	void SetEnableAudio(bool enable) {}
@@ -67,7 +67,7 @@ private:
 
 };
 
-class DesktopCapturerTrackSource : public webrtc::VideoTrackSource
+class DesktopCapturerTrackSource : public CapturerTrackSource
 {
 public:
 	static rtc::scoped_refptr<DesktopCapturerTrackSource> Create(const uint32_t& screen_index, size_t target_fps = 30)
@@ -82,26 +82,9 @@ public:
 		return nullptr;
 	}
 
-	void Start() {
-		capture_->Start();
-	}
-
-	void Stop() {
-		capture_->Stop();
-	}
-
 protected:
 	explicit DesktopCapturerTrackSource(std::unique_ptr<DesktopCapturer> capture)
-		: VideoTrackSource(false)
-		, capture_(std::move(capture)) {}
-
-private:
-	rtc::VideoSourceInterface<webrtc::VideoFrame>* source() override
-	{
-		return capture_.get();
-	}
-
-	std::unique_ptr<DesktopCapturer> capture_;
+		: CapturerTrackSource(std::move(capture)) {}
 };
 
 } // namespace krtc
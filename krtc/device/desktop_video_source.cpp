@@ -4,19 +4,23 @@
 namespace krtc {
 
 DesktopVideoSource::DesktopVideoSource(uint16_t screen_index, uint16_t target_fps) {
-	KRTCGlobal::Instance()->CreateDesktopCapturerSource(screen_index, target_fps);
+	source_id_ = KRTCGlobal::Instance()->video_source_registry()->AddScreen(screen_index, target_fps);
 }
 
-DesktopVideoSource::~DesktopVideoSource() {}
+DesktopVideoSource::~DesktopVideoSource() {
+	KRTCGlobal::Instance()->video_source_registry()->Remove(source_id_);
+}
 
 void DesktopVideoSource::Start() {
-	KRTCGlobal::Instance()->StartDesktopCapturerSource();
+	KRTCGlobal::Instance()->video_source_registry()->Start(source_id_);
 }
 
 void DesktopVideoSource::Stop() {
-	KRTCGlobal::Instance()->StopDesktopCapturerSource();
+	KRTCGlobal::Instance()->video_source_registry()->Stop(source_id_);
 }
 
-void DesktopVideoSource::Destroy() {}
+void DesktopVideoSource::Destroy() {
+	delete this;
+}
 
 } // namespace krtc
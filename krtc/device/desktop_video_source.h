@@ -2,10 +2,11 @@
 #define KRTCSDK_KRTC_DEVICE_DESKTOP_VIDEO_SOURCE_H_
 
 #include "krtc/krtc.h"
+#include "krtc/device/video_source_registry.h"
 
 namespace krtc {
 
-class DesktopVideoSource : public IVideoHandler
+class DesktopVideoSource : public VideoSourceHandler
 {
 private:
 	void Start() override;
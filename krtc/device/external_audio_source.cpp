@@ -0,0 +1,107 @@
+#include "krtc/device/external_audio_source.h"
+
+#include <algorithm>
+
+#include <rtc_base/logging.h>
+
+namespace krtc {
+
+namespace {
+
+// Opus的编码采样率，发送流不用再重采样
+const int kOutputSampleRate = 48000;
+
+} // namespace
+
+ExternalAudioSource::ExternalAudioSource(int sample_rate, size_t channels) :
+    sample_rate_(sample_rate),
+    channels_(channels),
+    source_(LocalAudioSource::Create(nullptr))
+{
+    resampler_.InitializeIfNeeded(sample_rate_, kOutputSampleRate, channels_);
+    size_t chunk = static_cast<size_t>(sample_rate_ / 100) * channels_;
+    pending_.reserve(chunk);
+    silence_.assign(chunk, 0);
+    resampled_.resize(static_cast<size_t>(kOutputSampleRate / 100) * channels_);
+}
+
+ExternalAudioSource::~ExternalAudioSource() {}
+
+bool ExternalAudioSource::PushAudioFrame(const int16_t* data, uint32_t frames) {
+    if (!data || frames == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (!started_) {
+        return false;
+    }
+
+    const size_t chunk = static_cast<size_t>(sample_rate_ / 100) * channels_;
+    const int16_t* src = data;
+    size_t remaining = static_cast<size_t>(frames) * channels_;
+
+    // 先把上一次剩下的补齐10ms
+    if (!pending_.empty()) {
+        size_t take = std::min(chunk - pending_.size(), remaining);
+        pending_.insert(pending_.end(), src, src + take);
+        src += take;
+        remaining -= take;
+        if (pending_.size() < chunk) {
+            return true;
+        }
+        Deliver(pending_.data());
+        pending_.clear();
+    }
+
+    while (remaining >= chunk) {
+        Deliver(src);
+        src += chunk;
+        remaining -= chunk;
+    }
+    pending_.insert(pending_.end(), src, src + remaining);
+    return true;
+}
+
+void ExternalAudioSource::Deliver(const int16_t* chunk) {
+    if (!enabled_) {
+        chunk = silence_.data();
+    }
+
+    int length = resampler_.Resample(chunk, silence_.size(), resampled_.data(), resampled_.size());
+    if (length <= 0) {
+        RTC_LOG(LS_WARNING) << "external audio resample failed, sample_rate: " << sample_rate_;
+        return;
+    }
+    source_->OnData(resampled_.data(), kOutputSampleRate, channels_, length / channels_);
+}
+
+void ExternalAudioSource::Start() {
+    RTC_LOG(LS_INFO) << "ExternalAudioSource Start, sample_rate: " << sample_rate_
+        << ", channels: " << channels_;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    started_ = true;
+}
+
+void ExternalAudioSource::Stop() {
+    RTC_LOG(LS_INFO) << "ExternalAudioSource Stop";
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    started_ = false;
+    pending_.clear();
+}
+
+void ExternalAudioSource::Destroy() {
+    RTC_LOG(LS_INFO) << "ExternalAudioSource Destroy";
+
+    // 推流持有source_的引用，已经在推的流不受影响
+    delete this;
+}
+
+void ExternalAudioSource::SetEnableAudio(bool enable) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    enabled_ = enable;
+}
+
+} // namespace krtc
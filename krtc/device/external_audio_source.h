@@ -0,0 +1,54 @@
+#ifndef KRTCSDK_KRTC_DEVICE_EXTERNAL_AUDIO_SOURCE_H_
+#define KRTCSDK_KRTC_DEVICE_EXTERNAL_AUDIO_SOURCE_H_
+
+#include <mutex>
+#include <vector>
+
+#include <api/scoped_refptr.h>
+#include <common_audio/resampler/include/push_resampler.h>
+
+#include "krtc/krtc.h"
+#include "krtc/device/audio_track.h"
+
+namespace krtc {
+
+// 应用送进来的PCM，重采样到48kHz并切成10ms后直接交给推流的发送流
+class ExternalAudioSource : public IExternalAudioSource
+{
+public:
+    bool PushAudioFrame(const int16_t* data, uint32_t frames) override;
+
+    void Start() override;
+    void Stop() override;
+    void Destroy() override;
+    void SetEnableVideo(bool enable) override {}
+    // 关闭后发送静音，保持时间戳连续
+    void SetEnableAudio(bool enable) override;
+
+    rtc::scoped_refptr<LocalAudioSource> source() const { return source_; }
+
+private:
+    ExternalAudioSource(int sample_rate, size_t channels);
+    ~ExternalAudioSource() override;
+
+    void Deliver(const int16_t* chunk);
+
+    const int sample_rate_;
+    const size_t channels_;
+    rtc::scoped_refptr<LocalAudioSource> source_;
+
+    std::mutex mutex_;
+    bool started_ = false;
+    bool enabled_ = true;
+    webrtc::PushResampler<int16_t> resampler_;
+    // 不足10ms的输入留到下一次
+    std::vector<int16_t> pending_;
+    std::vector<int16_t> silence_;
+    std::vector<int16_t> resampled_;
+
+    friend class KRTCEngine;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_EXTERNAL_AUDIO_SOURCE_H_
@@ -0,0 +1,327 @@
+#include "krtc/device/headless_audio_device.h"
+
+#include <string.h>
+
+#include <chrono>
+
+#include <rtc_base/logging.h>
+#include <rtc_base/system/file_wrapper.h>
+
+namespace krtc {
+
+namespace {
+
+const int kPlayoutSampleRate = 48000;
+const size_t kPlayoutChannels = 2;
+const char kPlayoutDeviceName[] = "headless playout";
+const char kRecordingDeviceName[] = "headless wav capture";
+
+void CopyDeviceName(const char* value, char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize])
+{
+    strncpy(name, value, webrtc::kAdmMaxDeviceNameSize - 1);
+    name[webrtc::kAdmMaxDeviceNameSize - 1] = '\0';
+    if (guid) {
+        strncpy(guid, value, webrtc::kAdmMaxGuidSize - 1);
+        guid[webrtc::kAdmMaxGuidSize - 1] = '\0';
+    }
+}
+
+} // namespace
+
+HeadlessAudioDevice::HeadlessAudioDevice(const std::string& capture_wav_file) :
+    capture_wav_file_(capture_wav_file)
+{
+}
+
+HeadlessAudioDevice::~HeadlessAudioDevice() {
+    Terminate();
+}
+
+int32_t HeadlessAudioDevice::RegisterAudioCallback(webrtc::AudioTransport* audio_callback) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    audio_callback_ = audio_callback;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::Init() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (initialized_) {
+        return 0;
+    }
+
+    if (!capture_wav_file_.empty()) {
+        // WavReader打不开文件会直接崩溃，先检查一次
+        if (webrtc::FileWrapper::OpenReadOnly(capture_wav_file_).is_open()) {
+            wav_reader_ = std::make_unique<webrtc::WavReader>(capture_wav_file_);
+            RTC_LOG(LS_INFO) << "headless audio capture from " << capture_wav_file_
+                << ", sample_rate: " << wav_reader_->sample_rate()
+                << ", channels: " << wav_reader_->num_channels();
+        }
+        else {
+            RTC_LOG(LS_WARNING) << "headless audio capture file not found: " << capture_wav_file_;
+        }
+    }
+
+    quit_ = false;
+    process_thread_.reset(new std::thread([this] {
+        ProcessThread();
+    }));
+    initialized_ = true;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::Terminate() {
+    std::unique_ptr<std::thread> thread;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        if (!initialized_) {
+            return 0;
+        }
+        initialized_ = false;
+        playing_ = recording_ = false;
+        playout_initialized_ = recording_initialized_ = false;
+        quit_ = true;
+        thread = std::move(process_thread_);
+    }
+    cond_.notify_all();
+    thread->join();
+    return 0;
+}
+
+bool HeadlessAudioDevice::Initialized() const {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return initialized_;
+}
+
+int16_t HeadlessAudioDevice::PlayoutDevices() {
+    return 1;
+}
+
+int16_t HeadlessAudioDevice::RecordingDevices() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return wav_reader_ ? 1 : 0;
+}
+
+int32_t HeadlessAudioDevice::PlayoutDeviceName(uint16_t index,
+    char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize])
+{
+    if (index != 0) {
+        return -1;
+    }
+    CopyDeviceName(kPlayoutDeviceName, name, guid);
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::RecordingDeviceName(uint16_t index,
+    char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize])
+{
+    if (index >= RecordingDevices()) {
+        return -1;
+    }
+    CopyDeviceName(kRecordingDeviceName, name, guid);
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::SetPlayoutDevice(uint16_t index) {
+    return index == 0 ? 0 : -1;
+}
+
+int32_t HeadlessAudioDevice::SetPlayoutDevice(WindowsDeviceType device) {
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::SetRecordingDevice(uint16_t index) {
+    return index < RecordingDevices() ? 0 : -1;
+}
+
+int32_t HeadlessAudioDevice::SetRecordingDevice(WindowsDeviceType device) {
+    return RecordingDevices() > 0 ? 0 : -1;
+}
+
+int32_t HeadlessAudioDevice::PlayoutIsAvailable(bool* available) {
+    *available = true;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::InitPlayout() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    playout_initialized_ = initialized_;
+    return playout_initialized_ ? 0 : -1;
+}
+
+bool HeadlessAudioDevice::PlayoutIsInitialized() const {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return playout_initialized_;
+}
+
+int32_t HeadlessAudioDevice::RecordingIsAvailable(bool* available) {
+    *available = RecordingDevices() > 0;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::InitRecording() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    recording_initialized_ = initialized_ && wav_reader_;
+    return recording_initialized_ ? 0 : -1;
+}
+
+bool HeadlessAudioDevice::RecordingIsInitialized() const {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return recording_initialized_;
+}
+
+int32_t HeadlessAudioDevice::StartPlayout() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        if (!playout_initialized_) {
+            return -1;
+        }
+        playing_ = true;
+    }
+    cond_.notify_all();
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::StopPlayout() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    playing_ = false;
+    playout_initialized_ = false;
+    return 0;
+}
+
+bool HeadlessAudioDevice::Playing() const {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return playing_;
+}
+
+int32_t HeadlessAudioDevice::StartRecording() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        if (!recording_initialized_) {
+            return -1;
+        }
+        recording_ = true;
+    }
+    cond_.notify_all();
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::StopRecording() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    recording_ = false;
+    recording_initialized_ = false;
+    return 0;
+}
+
+bool HeadlessAudioDevice::Recording() const {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return recording_;
+}
+
+int32_t HeadlessAudioDevice::StereoPlayoutIsAvailable(bool* available) const {
+    *available = true;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::SetStereoPlayout(bool enable) {
+    // 固定按双声道拉取
+    return enable ? 0 : -1;
+}
+
+int32_t HeadlessAudioDevice::StereoPlayout(bool* enabled) const {
+    *enabled = true;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::StereoRecordingIsAvailable(bool* available) const {
+    std::lock_guard<std::mutex> locker(mutex_);
+    *available = wav_reader_ && wav_reader_->num_channels() == 2;
+    return 0;
+}
+
+int32_t HeadlessAudioDevice::SetStereoRecording(bool enable) {
+    // 声道数由WAV文件决定
+    bool available = false;
+    StereoRecordingIsAvailable(&available);
+    return enable == available ? 0 : -1;
+}
+
+int32_t HeadlessAudioDevice::StereoRecording(bool* enabled) const {
+    return StereoRecordingIsAvailable(enabled);
+}
+
+int32_t HeadlessAudioDevice::PlayoutDelay(uint16_t* delay_ms) const {
+    *delay_ms = 0;
+    return 0;
+}
+
+void HeadlessAudioDevice::ProcessThread() {
+    const auto interval = std::chrono::milliseconds(10);
+    auto next = std::chrono::steady_clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            if (!playing_ && !recording_ && !quit_) {
+                cond_.wait(locker, [this] { return playing_ || recording_ || quit_; });
+                next = std::chrono::steady_clock::now();
+            }
+            if (quit_) {
+                return;
+            }
+
+            // 回调期间持有锁，Stop返回后不会再回调
+            if (audio_callback_ && playing_) {
+                PlayoutOnce();
+            }
+            if (audio_callback_ && recording_) {
+                CaptureOnce();
+            }
+        }
+
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void HeadlessAudioDevice::PlayoutOnce() {
+    const size_t samples_per_channel = kPlayoutSampleRate / 100;
+    playout_buffer_.resize(samples_per_channel * kPlayoutChannels);
+
+    size_t samples_out = 0;
+    int64_t elapsed_time_ms = -1;
+    int64_t ntp_time_ms = -1;
+    audio_callback_->NeedMorePlayData(samples_per_channel, kPlayoutChannels * sizeof(int16_t),
+        kPlayoutChannels, kPlayoutSampleRate, playout_buffer_.data(), samples_out,
+        &elapsed_time_ms, &ntp_time_ms);
+}
+
+void HeadlessAudioDevice::CaptureOnce() {
+    const size_t channels = wav_reader_->num_channels();
+    const size_t samples_per_channel = static_cast<size_t>(wav_reader_->sample_rate() / 100);
+    const size_t total = samples_per_channel * channels;
+    capture_buffer_.resize(total);
+
+    size_t read = wav_reader_->ReadSamples(total, capture_buffer_.data());
+    if (read < total) {
+        // 读到文件末尾从头循环
+        wav_reader_->Reset();
+        read += wav_reader_->ReadSamples(total - read, capture_buffer_.data() + read);
+    }
+    if (read < total) {
+        memset(capture_buffer_.data() + read, 0, (total - read) * sizeof(int16_t));
+    }
+
+    uint32_t new_mic_level = 0;
+    audio_callback_->RecordedDataIsAvailable(capture_buffer_.data(), samples_per_channel,
+        channels * sizeof(int16_t), channels, wav_reader_->sample_rate(),
+        0, 0, 0, false, new_mic_level);
+}
+
+} // namespace krtc
@@ -0,0 +1,93 @@
+#ifndef KRTCSDK_KRTC_DEVICE_HEADLESS_AUDIO_DEVICE_H_
+#define KRTCSDK_KRTC_DEVICE_HEADLESS_AUDIO_DEVICE_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <common_audio/wav_file.h>
+#include <modules/audio_device/include/audio_device_default.h>
+
+namespace krtc {
+
+// 没有声卡的服务器上使用的ADM，由自己的线程按10ms节拍驱动：
+// 播放端照常拉取解码后的数据然后丢弃，拉流的音轨sink、混音都能正常工作；
+// 采集端循环读取16bit WAV文件，没有文件时不产生采集数据，推流使用外部音频源。
+class HeadlessAudioDevice
+    : public webrtc::webrtc_impl::AudioDeviceModuleDefault<webrtc::AudioDeviceModule> {
+public:
+    explicit HeadlessAudioDevice(const std::string& capture_wav_file);
+    ~HeadlessAudioDevice() override;
+
+    int32_t RegisterAudioCallback(webrtc::AudioTransport* audio_callback) override;
+
+    int32_t Init() override;
+    int32_t Terminate() override;
+    bool Initialized() const override;
+
+    int16_t PlayoutDevices() override;
+    int16_t RecordingDevices() override;
+    int32_t PlayoutDeviceName(uint16_t index,
+        char name[webrtc::kAdmMaxDeviceNameSize],
+        char guid[webrtc::kAdmMaxGuidSize]) override;
+    int32_t RecordingDeviceName(uint16_t index,
+        char name[webrtc::kAdmMaxDeviceNameSize],
+        char guid[webrtc::kAdmMaxGuidSize]) override;
+    int32_t SetPlayoutDevice(uint16_t index) override;
+    int32_t SetPlayoutDevice(WindowsDeviceType device) override;
+    int32_t SetRecordingDevice(uint16_t index) override;
+    int32_t SetRecordingDevice(WindowsDeviceType device) override;
+
+    int32_t PlayoutIsAvailable(bool* available) override;
+    int32_t InitPlayout() override;
+    bool PlayoutIsInitialized() const override;
+    int32_t RecordingIsAvailable(bool* available) override;
+    int32_t InitRecording() override;
+    bool RecordingIsInitialized() const override;
+
+    int32_t StartPlayout() override;
+    int32_t StopPlayout() override;
+    bool Playing() const override;
+    int32_t StartRecording() override;
+    int32_t StopRecording() override;
+    bool Recording() const override;
+
+    int32_t StereoPlayoutIsAvailable(bool* available) const override;
+    int32_t SetStereoPlayout(bool enable) override;
+    int32_t StereoPlayout(bool* enabled) const override;
+    int32_t StereoRecordingIsAvailable(bool* available) const override;
+    int32_t SetStereoRecording(bool enable) override;
+    int32_t StereoRecording(bool* enabled) const override;
+
+    int32_t PlayoutDelay(uint16_t* delay_ms) const override;
+
+private:
+    void ProcessThread();
+    void PlayoutOnce();
+    void CaptureOnce();
+
+    const std::string capture_wav_file_;
+    std::unique_ptr<webrtc::WavReader> wav_reader_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    webrtc::AudioTransport* audio_callback_ = nullptr;
+    bool initialized_ = false;
+    bool playout_initialized_ = false;
+    bool recording_initialized_ = false;
+    bool playing_ = false;
+    bool recording_ = false;
+    bool quit_ = false;
+    std::unique_ptr<std::thread> process_thread_;
+
+    // 只在处理线程访问
+    std::vector<int16_t> playout_buffer_;
+    std::vector<int16_t> capture_buffer_;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_HEADLESS_AUDIO_DEVICE_H_
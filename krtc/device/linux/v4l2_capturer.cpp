@@ -0,0 +1,568 @@
+#include "krtc/device/linux/v4l2_capturer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <api/video/i420_buffer.h>
+#include <api/video/nv12_buffer.h>
+#include <api/video/video_frame.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+#include <third_party/libyuv/include/libyuv/convert.h>
+#include <third_party/libyuv/include/libyuv/convert_from.h>
+#include <third_party/libyuv/include/libyuv/planar_functions.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+namespace {
+
+const int kMaxVideoDevices = 64;
+const uint32_t kBufferCount = 4;
+const int kPollTimeoutMs = 100;
+// 编码器和预览也会持有帧
+const size_t kPoolBuffers = 8;
+
+int Ioctl(int fd, unsigned long request, void* arg) {
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+bool IsVideoCaptureDevice(const v4l2_capability& cap) {
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    return (caps & V4L2_CAP_VIDEO_CAPTURE) && (caps & V4L2_CAP_STREAMING);
+}
+
+// 和WebRTC的DeviceInfoV4L2一样，优先用bus_info作为设备id
+std::string DeviceUniqueId(const v4l2_capability& cap) {
+    if (cap.bus_info[0] != 0) {
+        return reinterpret_cast<const char*>(cap.bus_info);
+    }
+    return reinterpret_cast<const char*>(cap.card);
+}
+
+webrtc::VideoType ToVideoType(uint32_t pixel_format) {
+    switch (pixel_format) {
+    case V4L2_PIX_FMT_YUV420:
+        return webrtc::VideoType::kI420;
+    case V4L2_PIX_FMT_NV12:
+        return webrtc::VideoType::kNV12;
+    case V4L2_PIX_FMT_YUYV:
+        return webrtc::VideoType::kYUY2;
+    case V4L2_PIX_FMT_UYVY:
+        return webrtc::VideoType::kUYVY;
+    case V4L2_PIX_FMT_MJPEG:
+    case V4L2_PIX_FMT_JPEG:
+        return webrtc::VideoType::kMJPEG;
+    default:
+        return webrtc::VideoType::kUnknown;
+    }
+}
+
+// 取该尺寸下的最高帧率，查不到时按30fps
+int GetMaxFps(int fd, uint32_t pixel_format, uint32_t width, uint32_t height) {
+    int max_fps = 0;
+    v4l2_frmivalenum ival;
+    memset(&ival, 0, sizeof(ival));
+    ival.pixel_format = pixel_format;
+    ival.width = width;
+    ival.height = height;
+    for (ival.index = 0; Ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0; ++ival.index) {
+        // 连续/步进的间隔只需要看最小值
+        const v4l2_fract& interval = ival.type == V4L2_FRMIVAL_TYPE_DISCRETE ?
+            ival.discrete : ival.stepwise.min;
+        if (interval.numerator > 0) {
+            max_fps = std::max(max_fps, static_cast<int>(interval.denominator / interval.numerator));
+        }
+        if (ival.type != V4L2_FRMIVAL_TYPE_DISCRETE) {
+            break;
+        }
+    }
+    return max_fps > 0 ? max_fps : 30;
+}
+
+} // namespace
+
+std::unique_ptr<V4l2Capturer> V4l2Capturer::Create(const std::string& cam_id,
+                                                   const KRTCCameraCaptureConfig& config)
+{
+    std::string device_path = FindDevice(cam_id);
+    if (device_path.empty()) {
+        RTC_LOG(LS_WARNING) << "v4l2 device not found, cam_id:" << cam_id;
+        return nullptr;
+    }
+    return std::unique_ptr<V4l2Capturer>(new V4l2Capturer(cam_id, device_path, config));
+}
+
+V4l2Capturer::V4l2Capturer(const std::string& cam_id, const std::string& device_path,
+                           const KRTCCameraCaptureConfig& config) :
+    cam_id_(cam_id),
+    device_path_(device_path),
+    config_(config),
+    signaling_thread_(rtc::Thread::Current()),
+    pool_(false, kPoolBuffers),
+    stats_(cam_id)
+{
+}
+
+V4l2Capturer::~V4l2Capturer() {
+    Destroy();
+}
+
+std::string V4l2Capturer::FindDevice(const std::string& cam_id) {
+    for (int i = 0; i < kMaxVideoDevices; ++i) {
+        char path[32];
+        snprintf(path, sizeof(path), "/dev/video%d", i);
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+
+        v4l2_capability cap;
+        memset(&cap, 0, sizeof(cap));
+        bool found = Ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0 && IsVideoCaptureDevice(cap) &&
+            DeviceUniqueId(cap) == cam_id;
+        close(fd);
+        if (found) {
+            return path;
+        }
+    }
+    return std::string();
+}
+
+void V4l2Capturer::Start()
+{
+    RTC_LOG(LS_INFO) << "V4l2Capturer Start call";
+    signaling_thread_->PostTask([=] {
+        KRTCError err = KRTCError::kNoErr;
+        do {
+            if (has_start_) {
+                RTC_LOG(LS_WARNING) << "V4l2Capturer already start, ignore";
+                break;
+            }
+
+            if (!OpenDevice()) {
+                err = KRTCError::kVideoCreateCaptureErr;
+                break;
+            }
+
+            std::vector<uint32_t> pixel_formats;
+            std::vector<webrtc::VideoCaptureCapability> capabilities = GetCapabilities(&pixel_formats);
+            if (capabilities.empty()) {
+                err = KRTCError::kVideoNoCapabilitiesErr;
+                RTC_LOG(LS_WARNING) << "V4l2Capturer no capabilities";
+                break;
+            }
+
+            webrtc::VideoCaptureCapability capability;
+            if (!SelectCameraCapability(capabilities, config_, &capability)) {
+                err = KRTCError::kVideoNoBestCapabilitiesErr;
+                RTC_LOG(LS_WARNING) << "V4l2Capturer no best capabilities";
+                break;
+            }
+
+            // 驱动可以换成别的格式，这时去掉该格式重新选择
+            bool format_set = false;
+            while (true) {
+                size_t index = std::find(capabilities.begin(), capabilities.end(), capability) -
+                    capabilities.begin();
+                const uint32_t pixel_format = pixel_formats[index];
+                bool substituted = false;
+                if (SetFormat(capability, pixel_format, &substituted)) {
+                    format_set = true;
+                    break;
+                }
+                if (!substituted) {
+                    break;
+                }
+                for (size_t i = capabilities.size(); i-- > 0;) {
+                    if (pixel_formats[i] == pixel_format) {
+                        capabilities.erase(capabilities.begin() + i);
+                        pixel_formats.erase(pixel_formats.begin() + i);
+                    }
+                }
+                if (!SelectCameraCapability(capabilities, config_, &capability)) {
+                    RTC_LOG(LS_WARNING) << "V4l2Capturer no capability accepted by driver";
+                    break;
+                }
+            }
+
+            if (!format_set || !StartStreaming(capability)) {
+                err = KRTCError::kVideoStartCaptureErr;
+                break;
+            }
+
+            has_start_ = true;
+        } while (0);
+
+        if (err != KRTCError::kNoErr) {
+            StopStreaming();
+            if (KRTCGlobal::Instance()->engine_observer()) {
+                KRTCGlobal::Instance()->engine_observer()->OnVideoSourceFailed(err);
+            }
+        }
+        else {
+            if (KRTCGlobal::Instance()->engine_observer()) {
+                KRTCGlobal::Instance()->engine_observer()->OnVideoSourceSuccess();
+            }
+        }
+    });
+}
+
+void V4l2Capturer::Stop() {
+    if (has_start_) {
+        Destroy();
+        has_start_ = false;
+    }
+}
+
+void V4l2Capturer::Destroy() {
+    StopStreaming();
+}
+
+bool V4l2Capturer::OpenDevice() {
+    fd_ = open(device_path_.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd_ < 0) {
+        RTC_LOG(LS_WARNING) << "open " << device_path_ << " failed, errno:" << errno;
+        return false;
+    }
+    return true;
+}
+
+std::vector<webrtc::VideoCaptureCapability> V4l2Capturer::GetCapabilities(
+    std::vector<uint32_t>* pixel_formats)
+{
+    std::vector<webrtc::VideoCaptureCapability> capabilities;
+    pixel_formats->clear();
+
+    v4l2_fmtdesc fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    for (fmt.index = 0; Ioctl(fd_, VIDIOC_ENUM_FMT, &fmt) == 0; ++fmt.index) {
+        webrtc::VideoType video_type = ToVideoType(fmt.pixelformat);
+        if (video_type == webrtc::VideoType::kUnknown) {
+            continue;
+        }
+
+        v4l2_frmsizeenum size;
+        memset(&size, 0, sizeof(size));
+        size.pixel_format = fmt.pixelformat;
+        for (size.index = 0; Ioctl(fd_, VIDIOC_ENUM_FRAMESIZES, &size) == 0; ++size.index) {
+            webrtc::VideoCaptureCapability cap;
+            cap.videoType = video_type;
+            if (size.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+                cap.width = size.discrete.width;
+                cap.height = size.discrete.height;
+            }
+            else {
+                // 连续/步进的尺寸取最接近配置的值
+                cap.width = std::min(std::max(config_.width, size.stepwise.min_width), size.stepwise.max_width);
+                cap.height = std::min(std::max(config_.height, size.stepwise.min_height), size.stepwise.max_height);
+            }
+            cap.maxFPS = GetMaxFps(fd_, fmt.pixelformat, cap.width, cap.height);
+            capabilities.push_back(cap);
+            pixel_formats->push_back(fmt.pixelformat);
+
+            if (size.type != V4L2_FRMSIZE_TYPE_DISCRETE) {
+                break;
+            }
+        }
+    }
+    return capabilities;
+}
+
+bool V4l2Capturer::SetFormat(const webrtc::VideoCaptureCapability& capability, uint32_t pixel_format,
+                             bool* substituted)
+{
+    // 请求枚举出来的fourcc，MJPEG和JPEG摄像头一般只列出其中一个
+    v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = capability.width;
+    fmt.fmt.pix.height = capability.height;
+    fmt.fmt.pix.pixelformat = pixel_format;
+    fmt.fmt.pix.field = V4L2_FIELD_ANY;
+    if (Ioctl(fd_, VIDIOC_S_FMT, &fmt) < 0) {
+        RTC_LOG(LS_WARNING) << "VIDIOC_S_FMT failed, errno:" << errno;
+        return false;
+    }
+    if (fmt.fmt.pix.pixelformat != pixel_format) {
+        RTC_LOG(LS_WARNING) << "v4l2 driver substituted pixel format " << pixel_format
+            << " with " << fmt.fmt.pix.pixelformat;
+        *substituted = true;
+        return false;
+    }
+    width_ = fmt.fmt.pix.width;
+    height_ = fmt.fmt.pix.height;
+    bytes_per_line_ = fmt.fmt.pix.bytesperline;
+    capability_ = capability;
+    capability_.width = width_;
+    capability_.height = height_;
+    return true;
+}
+
+bool V4l2Capturer::StartStreaming(const webrtc::VideoCaptureCapability& capability) {
+
+    // 驱动不支持设置帧率时按默认帧率采集
+    v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (Ioctl(fd_, VIDIOC_G_PARM, &parm) == 0 && (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+        parm.parm.capture.timeperframe.numerator = 1;
+        parm.parm.capture.timeperframe.denominator = config_.fps > 0 ?
+            std::min<uint32_t>(config_.fps, capability.maxFPS) : capability.maxFPS;
+        if (Ioctl(fd_, VIDIOC_S_PARM, &parm) < 0) {
+            RTC_LOG(LS_WARNING) << "VIDIOC_S_PARM failed, errno:" << errno;
+        }
+    }
+
+    v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = kBufferCount;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (Ioctl(fd_, VIDIOC_REQBUFS, &req) < 0 || req.count == 0) {
+        RTC_LOG(LS_WARNING) << "VIDIOC_REQBUFS failed, errno:" << errno;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < req.count; ++i) {
+        v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (Ioctl(fd_, VIDIOC_QUERYBUF, &buf) < 0) {
+            return false;
+        }
+
+        MappedBuffer mapped;
+        mapped.length = buf.length;
+        mapped.start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buf.m.offset);
+        if (mapped.start == MAP_FAILED) {
+            RTC_LOG(LS_WARNING) << "mmap failed, errno:" << errno;
+            return false;
+        }
+        buffers_.push_back(mapped);
+
+        if (Ioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+            return false;
+        }
+    }
+
+    int decode_threads = 0;
+    if (capability_.videoType == webrtc::VideoType::kMJPEG) {
+        decode_threads = config_.decode_threads > 0 ? static_cast<int>(config_.decode_threads) :
+            MjpegDecoder::DefaultThreads(width_, height_);
+        mjpeg_decoder_.reset(new MjpegDecoder(config_.output_nv12, decode_threads,
+            [this](rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer, int64_t timestamp_us, int64_t decode_us) {
+                OnDecodedFrame(std::move(buffer), timestamp_us, decode_us);
+            }));
+        decode_threads = mjpeg_decoder_->threads();
+    }
+    stats_.SetCapability(capability_, decode_threads);
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (Ioctl(fd_, VIDIOC_STREAMON, &type) < 0) {
+        RTC_LOG(LS_WARNING) << "VIDIOC_STREAMON failed, errno:" << errno;
+        return false;
+    }
+
+    RTC_LOG(LS_INFO) << "V4l2Capturer start " << device_path_ << " " << width_ << "x" << height_
+        << "@" << capability_.maxFPS << " type:" << static_cast<int>(capability_.videoType)
+        << " decode_threads:" << decode_threads;
+
+    is_capturing_ = true;
+    capture_thread_.reset(new std::thread([this] {
+        CaptureThread();
+    }));
+    return true;
+}
+
+void V4l2Capturer::StopStreaming() {
+    if (capture_thread_) {
+        is_capturing_ = false;
+        capture_thread_->join();
+        capture_thread_.reset();
+    }
+    // 解码线程还可能在输出，先于缓冲和设备释放
+    mjpeg_decoder_.reset();
+
+    if (fd_ >= 0) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        Ioctl(fd_, VIDIOC_STREAMOFF, &type);
+    }
+    for (const auto& mapped : buffers_) {
+        munmap(mapped.start, mapped.length);
+    }
+    buffers_.clear();
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void V4l2Capturer::CaptureThread() {
+    while (is_capturing_) {
+        pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, kPollTimeoutMs);
+        if (ret < 0 && errno != EINTR) {
+            RTC_LOG(LS_WARNING) << "v4l2 poll failed, errno:" << errno;
+            break;
+        }
+        if (ret > 0 && (pfd.revents & POLLIN)) {
+            if (!ReadFrame()) {
+                break;
+            }
+        }
+    }
+}
+
+bool V4l2Capturer::ReadFrame() {
+    v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (Ioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+        if (errno == EAGAIN) {
+            return true;
+        }
+        RTC_LOG(LS_WARNING) << "VIDIOC_DQBUF failed, errno:" << errno;
+        return false;
+    }
+
+    int64_t timestamp_us = rtc::TimeMicros();
+    const uint8_t* data = static_cast<const uint8_t*>(buffers_[buf.index].start);
+    size_t size = buf.bytesused;
+    if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+        stats_.AddDropped();
+    }
+    else if (mjpeg_decoder_) {
+        // 多线程解码时拷贝了输入，同步解码时返回前已经解完，缓冲都可以立即还给驱动
+        if (!mjpeg_decoder_->Decode(data, size, timestamp_us)) {
+            stats_.AddDropped();
+        }
+    }
+    else {
+        int64_t start_us = rtc::TimeMicros();
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = ConvertRawFrame(data, size);
+        OnDecodedFrame(buffer, timestamp_us, rtc::TimeMicros() - start_us);
+    }
+
+    if (Ioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+        RTC_LOG(LS_WARNING) << "VIDIOC_QBUF failed, errno:" << errno;
+        return false;
+    }
+    return true;
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> V4l2Capturer::ConvertRawFrame(const uint8_t* data, size_t size) {
+    const int chroma_height = (height_ + 1) / 2;
+    const webrtc::VideoType type = capability_.videoType;
+    const bool packed = type == webrtc::VideoType::kYUY2 || type == webrtc::VideoType::kUYVY;
+    const int stride = bytes_per_line_ > 0 ? bytes_per_line_ : (packed ? width_ * 2 : width_);
+    const size_t expected = packed ? static_cast<size_t>(stride) * height_ :
+        static_cast<size_t>(stride) * height_ + static_cast<size_t>((stride + 1) / 2) * 2 * chroma_height;
+    if (size < expected) {
+        RTC_LOG(LS_WARNING) << "v4l2 frame too small, size:" << size << " expected:" << expected;
+        return nullptr;
+    }
+
+    const uint8_t* src_y = data;
+    const uint8_t* src_chroma = data + static_cast<size_t>(stride) * height_;
+    const int src_stride_chroma = (stride + 1) / 2;
+
+    // UYVY只有转I420的SIMD实现，总是输出I420
+    if (config_.output_nv12 && type != webrtc::VideoType::kUYVY) {
+        rtc::scoped_refptr<webrtc::NV12Buffer> nv12 = pool_.CreateNV12Buffer(width_, height_);
+        if (!nv12) {
+            RTC_LOG(LS_WARNING) << "v4l2 capturer pool exhausted, drop frame";
+            return nullptr;
+        }
+        switch (type) {
+        case webrtc::VideoType::kYUY2:
+            libyuv::YUY2ToNV12(data, stride, nv12->MutableDataY(), nv12->StrideY(),
+                nv12->MutableDataUV(), nv12->StrideUV(), width_, height_);
+            break;
+        case webrtc::VideoType::kNV12:
+            libyuv::CopyPlane(src_y, stride, nv12->MutableDataY(), nv12->StrideY(), width_, height_);
+            libyuv::CopyPlane(src_chroma, stride, nv12->MutableDataUV(), nv12->StrideUV(),
+                (width_ + 1) / 2 * 2, chroma_height);
+            break;
+        default:
+            libyuv::I420ToNV12(src_y, stride,
+                src_chroma, src_stride_chroma,
+                src_chroma + static_cast<size_t>(src_stride_chroma) * chroma_height, src_stride_chroma,
+                nv12->MutableDataY(), nv12->StrideY(), nv12->MutableDataUV(), nv12->StrideUV(),
+                width_, height_);
+            break;
+        }
+        return nv12;
+    }
+
+    rtc::scoped_refptr<webrtc::I420Buffer> i420 = pool_.CreateI420Buffer(width_, height_);
+    if (!i420) {
+        RTC_LOG(LS_WARNING) << "v4l2 capturer pool exhausted, drop frame";
+        return nullptr;
+    }
+    switch (type) {
+    case webrtc::VideoType::kYUY2:
+        libyuv::YUY2ToI420(data, stride,
+            i420->MutableDataY(), i420->StrideY(), i420->MutableDataU(), i420->StrideU(),
+            i420->MutableDataV(), i420->StrideV(), width_, height_);
+        break;
+    case webrtc::VideoType::kUYVY:
+        libyuv::UYVYToI420(data, stride,
+            i420->MutableDataY(), i420->StrideY(), i420->MutableDataU(), i420->StrideU(),
+            i420->MutableDataV(), i420->StrideV(), width_, height_);
+        break;
+    case webrtc::VideoType::kNV12:
+        libyuv::NV12ToI420(src_y, stride, src_chroma, stride,
+            i420->MutableDataY(), i420->StrideY(), i420->MutableDataU(), i420->StrideU(),
+            i420->MutableDataV(), i420->StrideV(), width_, height_);
+        break;
+    default:
+        libyuv::I420Copy(src_y, stride,
+            src_chroma, src_stride_chroma,
+            src_chroma + static_cast<size_t>(src_stride_chroma) * chroma_height, src_stride_chroma,
+            i420->MutableDataY(), i420->StrideY(), i420->MutableDataU(), i420->StrideU(),
+            i420->MutableDataV(), i420->StrideV(), width_, height_);
+        break;
+    }
+    return i420;
+}
+
+void V4l2Capturer::OnDecodedFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                                  int64_t timestamp_us, int64_t decode_us)
+{
+    if (!buffer) {
+        stats_.AddDropped();
+        return;
+    }
+
+    webrtc::VideoFrame frame = webrtc::VideoFrame::Builder()
+        .set_video_frame_buffer(buffer)
+        .set_rotation(webrtc::kVideoRotation_0)
+        .set_timestamp_us(timestamp_us)
+        .build();
+    VideoCapturer::OnFrame(frame);
+    stats_.AddFrame(decode_us);
+}
+
+}  // namespace krtc
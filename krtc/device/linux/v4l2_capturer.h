@@ -0,0 +1,90 @@
+#ifndef KRTCSDK_KRTC_DEVICE_LINUX_V4L2_CAPTURER_H_
+#define KRTCSDK_KRTC_DEVICE_LINUX_V4L2_CAPTURER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <api/scoped_refptr.h>
+#include <api/video/video_frame_buffer.h>
+#include <common_video/include/video_frame_buffer_pool.h>
+#include <modules/video_capture/video_capture_defines.h>
+#include <rtc_base/thread.h>
+
+#include "krtc/krtc.h"
+#include "krtc/device/camera_capability.h"
+#include "krtc/device/mjpeg_decoder.h"
+#include "krtc/device/video_capturer.h"
+
+namespace krtc {
+
+// Linux摄像头采集。WebRTC的VideoCaptureModule在内部把所有格式转换成I420，拿不到原始MJPEG，
+// 这里直接用V4L2按原始格式采集：MJPEG交给MjpegDecoder，YUY2/UYVY/NV12/I420在采集线程上
+// 转换到池化的I420或NV12缓冲
+class V4l2Capturer : public VideoCapturer {
+public:
+    // 找不到cam_id对应的/dev/videoN时返回nullptr
+    static std::unique_ptr<V4l2Capturer> Create(const std::string& cam_id,
+                                                const KRTCCameraCaptureConfig& config);
+    ~V4l2Capturer() override;
+
+    void Start() override;
+    void Stop() override;
+
+private:
+    V4l2Capturer(const std::string& cam_id, const std::string& device_path,
+                 const KRTCCameraCaptureConfig& config);
+
+    static std::string FindDevice(const std::string& cam_id);
+
+    bool OpenDevice();
+    // pixel_formats按下标对应每个能力枚举出来的V4L2 fourcc
+    std::vector<webrtc::VideoCaptureCapability> GetCapabilities(std::vector<uint32_t>* pixel_formats);
+    // 驱动换成了别的像素格式时返回false并设置substituted
+    bool SetFormat(const webrtc::VideoCaptureCapability& capability, uint32_t pixel_format,
+                   bool* substituted);
+    // 在SetFormat成功之后调用
+    bool StartStreaming(const webrtc::VideoCaptureCapability& capability);
+    void StopStreaming();
+    void Destroy();
+
+    void CaptureThread();
+    bool ReadFrame();
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> ConvertRawFrame(const uint8_t* data, size_t size);
+    void OnDecodedFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                        int64_t timestamp_us, int64_t decode_us);
+
+    struct MappedBuffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+
+    std::string cam_id_;
+    std::string device_path_;
+    KRTCCameraCaptureConfig config_;
+    rtc::Thread* signaling_thread_;
+    bool has_start_ = false;
+
+    int fd_ = -1;
+    std::vector<MappedBuffer> buffers_;
+    webrtc::VideoCaptureCapability capability_;
+    // S_FMT之后驱动给出的实际尺寸和行宽
+    int width_ = 0;
+    int height_ = 0;
+    int bytes_per_line_ = 0;
+
+    std::atomic<bool> is_capturing_{ false };
+    std::unique_ptr<std::thread> capture_thread_;
+    std::unique_ptr<MjpegDecoder> mjpeg_decoder_;
+    // 原始格式转换只在采集线程上，不用加锁
+    webrtc::VideoFrameBufferPool pool_;
+    CameraStatsCounter stats_;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_DEVICE_LINUX_V4L2_CAPTURER_H_
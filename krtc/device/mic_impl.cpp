@@ -73,8 +73,11 @@ void MicImpl::Start() {
                 break;
             }
 
-            // 6. 设置为立体声采集
-            audio_device->SetStereoRecording(true);
+            // 6. 按配置选择单声道或立体声采集，立体声时APM的开销约翻倍
+            bool stereo = KRTCGlobal::Instance()->audio_processing_config().stereo_capture;
+            bool stereo_available = false;
+            audio_device->StereoRecordingIsAvailable(&stereo_available);
+            audio_device->SetStereoRecording(stereo && stereo_available);
 
             // 7. 初始化麦克风
             if (audio_device->InitRecording() || !audio_device->RecordingIsInitialized()) {
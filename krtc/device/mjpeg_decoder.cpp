@@ -0,0 +1,197 @@
+#include "krtc/device/mjpeg_decoder.h"
+
+#include <algorithm>
+
+#include <api/video/i420_buffer.h>
+#include <api/video/nv12_buffer.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+#include <third_party/libyuv/include/libyuv/convert.h>
+
+namespace krtc {
+
+namespace {
+
+const int kMaxThreads = 4;
+// 编码器和预览也会持有帧，池子比排队的帧数多留一些
+const size_t kPoolExtraBuffers = 8;
+
+} // namespace
+
+MjpegDecoder::MjpegDecoder(bool output_nv12, int threads, FrameCallback callback) :
+    output_nv12_(output_nv12),
+    threads_(std::min(std::max(threads, 1), kMaxThreads)),
+    callback_(std::move(callback)),
+    pool_(false, kPoolExtraBuffers + 2 * threads_)
+{
+    if (threads_ > 1) {
+        for (int i = 0; i < threads_; ++i) {
+            workers_.emplace_back(new std::thread([this] {
+                WorkerThread();
+            }));
+        }
+    }
+}
+
+MjpegDecoder::~MjpegDecoder() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        stopped_ = true;
+    }
+    cond_.notify_all();
+    for (auto& worker : workers_) {
+        worker->join();
+    }
+}
+
+int MjpegDecoder::DefaultThreads(int width, int height) {
+    if (width * height < 3840 * 2160) {
+        return 1;
+    }
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::min(std::max(cores / 2, 2), kMaxThreads);
+}
+
+bool MjpegDecoder::Decode(const uint8_t* data, size_t size, int64_t timestamp_us) {
+    if (threads_ <= 1) {
+        int64_t decode_us = 0;
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = DecodeFrame(data, size, &decode_us);
+        if (!buffer) {
+            return false;
+        }
+        callback_(buffer, timestamp_us, decode_us);
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        // 每个线程最多排队一帧，再多说明解码跟不上，丢掉最新的帧
+        if (in_flight_.size() >= static_cast<size_t>(2 * threads_)) {
+            return false;
+        }
+
+        std::unique_ptr<Job> job;
+        if (!free_jobs_.empty()) {
+            job = std::move(free_jobs_.back());
+            free_jobs_.pop_back();
+        }
+        else {
+            job.reset(new Job());
+        }
+        job->data.assign(data, data + size);
+        job->timestamp_us = timestamp_us;
+        job->done = false;
+        pending_.push_back(job.get());
+        in_flight_.push_back(std::move(job));
+    }
+    cond_.notify_one();
+    return true;
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> MjpegDecoder::DecodeFrame(const uint8_t* data, size_t size,
+    int64_t* decode_us)
+{
+    int64_t start_us = rtc::TimeMicros();
+
+    // 以码流里的尺寸为准，不依赖协商的采集能力
+    int width = 0;
+    int height = 0;
+    if (libyuv::MJPGSize(data, size, &width, &height) != 0 || width <= 0 || height <= 0) {
+        RTC_LOG(LS_WARNING) << "invalid mjpeg frame, size:" << size;
+        return nullptr;
+    }
+
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> output;
+    int ret = -1;
+    if (output_nv12_) {
+        rtc::scoped_refptr<webrtc::NV12Buffer> nv12;
+        {
+            std::lock_guard<std::mutex> locker(pool_mutex_);
+            nv12 = pool_.CreateNV12Buffer(width, height);
+        }
+        if (nv12) {
+            ret = libyuv::MJPGToNV12(data, size,
+                nv12->MutableDataY(), nv12->StrideY(), nv12->MutableDataUV(), nv12->StrideUV(),
+                width, height, width, height);
+            output = nv12;
+        }
+    }
+    else {
+        rtc::scoped_refptr<webrtc::I420Buffer> i420;
+        {
+            std::lock_guard<std::mutex> locker(pool_mutex_);
+            i420 = pool_.CreateI420Buffer(width, height);
+        }
+        if (i420) {
+            ret = libyuv::MJPGToI420(data, size,
+                i420->MutableDataY(), i420->StrideY(),
+                i420->MutableDataU(), i420->StrideU(),
+                i420->MutableDataV(), i420->StrideV(),
+                width, height, width, height);
+            output = i420;
+        }
+    }
+
+    if (!output) {
+        RTC_LOG(LS_WARNING) << "mjpeg decoder pool exhausted, drop frame";
+        return nullptr;
+    }
+    if (ret != 0) {
+        RTC_LOG(LS_WARNING) << "mjpeg decode failed, ret:" << ret;
+        return nullptr;
+    }
+
+    *decode_us = rtc::TimeMicros() - start_us;
+    return output;
+}
+
+void MjpegDecoder::WorkerThread() {
+    while (true) {
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            cond_.wait(locker, [this] { return stopped_ || !pending_.empty(); });
+            if (stopped_) {
+                return;
+            }
+            job = pending_.front();
+            pending_.pop_front();
+        }
+
+        int64_t decode_us = 0;
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> output =
+            DecodeFrame(job->data.data(), job->data.size(), &decode_us);
+        {
+            std::lock_guard<std::mutex> locker(mutex_);
+            job->output = std::move(output);
+            job->decode_us = decode_us;
+            job->done = true;
+        }
+
+        DeliverDecoded();
+    }
+}
+
+void MjpegDecoder::DeliverDecoded() {
+    // 先解完的帧等前面的帧，由解完最早那帧的线程一起按顺序输出
+    std::lock_guard<std::mutex> deliver_locker(deliver_mutex_);
+    while (true) {
+        std::unique_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> locker(mutex_);
+            if (in_flight_.empty() || !in_flight_.front()->done) {
+                return;
+            }
+            job = std::move(in_flight_.front());
+            in_flight_.pop_front();
+        }
+
+        callback_(std::move(job->output), job->timestamp_us, job->decode_us);
+
+        std::lock_guard<std::mutex> locker(mutex_);
+        job->output = nullptr;
+        free_jobs_.push_back(std::move(job));
+    }
+}
+
+}  // namespace krtc
@@ -0,0 +1,79 @@
+#ifndef KRTCSDK_KRTC_DEVICE_MJPEG_DECODER_H_
+#define KRTCSDK_KRTC_DEVICE_MJPEG_DECODER_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <api/scoped_refptr.h>
+#include <api/video/video_frame_buffer.h>
+#include <common_video/include/video_frame_buffer_pool.h>
+
+namespace krtc {
+
+// 摄像头MJPEG解码，libyuv的MJPGToI420/MJPGToNV12(底层是libjpeg-turbo)直接解码到池化的I420/NV12缓冲。
+// threads<=1时在调用线程上解码；否则每个线程解码整帧，多帧并行，按输入顺序输出。
+// 4K单帧解码要10ms以上，按帧并行可以让30fps跟上，代价是多出threads-1帧的延迟
+class MjpegDecoder {
+public:
+    // 按输入顺序回调，多线程时在解码线程上回调。异步解码失败时buffer为nullptr
+    using FrameCallback = std::function<void(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+        int64_t timestamp_us, int64_t decode_us)>;
+
+    MjpegDecoder(bool output_nv12, int threads, FrameCallback callback);
+    ~MjpegDecoder();
+
+    // 4K及以上用多线程
+    static int DefaultThreads(int width, int height);
+
+    // 返回false表示这一帧被丢弃(解码失败、缓冲池耗尽或者解码线程都忙)，不会再回调。
+    // 多线程时先拷贝输入，返回后data就可以复用
+    bool Decode(const uint8_t* data, size_t size, int64_t timestamp_us);
+
+    int threads() const { return threads_; }
+
+private:
+    struct Job {
+        std::vector<uint8_t> data;
+        int64_t timestamp_us = 0;
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> output;
+        int64_t decode_us = 0;
+        bool done = false;
+    };
+
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> DecodeFrame(const uint8_t* data, size_t size,
+        int64_t* decode_us);
+    void WorkerThread();
+    void DeliverDecoded();
+
+    const bool output_nv12_;
+    const int threads_;
+    FrameCallback callback_;
+
+    // VideoFrameBufferPool不是线程安全的
+    std::mutex pool_mutex_;
+    webrtc::VideoFrameBufferPool pool_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopped_ = false;
+    // 等待解码的任务
+    std::deque<Job*> pending_;
+    // 按输入顺序排列，包括解码中和已解码未输出的任务
+    std::deque<std::unique_ptr<Job>> in_flight_;
+    // 复用的任务，保留输入缓冲的内存
+    std::vector<std::unique_ptr<Job>> free_jobs_;
+    // 串行化输出，保证回调顺序
+    std::mutex deliver_mutex_;
+    std::vector<std::unique_ptr<std::thread>> workers_;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_DEVICE_MJPEG_DECODER_H_
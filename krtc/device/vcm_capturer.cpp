@@ -11,26 +11,27 @@
 
 #include "krtc/base/krtc_global.h"
 #include "krtc/media/media_frame.h"
+#if defined(WEBRTC_LINUX)
+#include "krtc/device/linux/v4l2_capturer.h"
+#endif
 
 namespace krtc {
 
-std::unique_ptr<VcmCapturer> VcmCapturer::Create(const std::string& cam_id,  size_t width, size_t height,
-                                                size_t target_fps)
+std::unique_ptr<VcmCapturer> VcmCapturer::Create(const std::string& cam_id,
+                                                const KRTCCameraCaptureConfig& config)
 {
-    std::unique_ptr<VcmCapturer> vcm_capturer(new VcmCapturer(cam_id, width, height, target_fps));
+    std::unique_ptr<VcmCapturer> vcm_capturer(new VcmCapturer(cam_id, config));
     return std::move(vcm_capturer);
 }
 
-VcmCapturer::VcmCapturer(const std::string& cam_id, size_t width, size_t height, size_t target_fps) :
+VcmCapturer::VcmCapturer(const std::string& cam_id, const KRTCCameraCaptureConfig& config) :
     cam_id_(cam_id),
     vcm_(nullptr),
     signaling_thread_(rtc::Thread::Current()),
-    device_info_(KRTCGlobal::Instance()->video_device_info())
+    device_info_(KRTCGlobal::Instance()->video_device_info()),
+    config_(config),
+    stats_(cam_id)
 {
-    capability_.width = static_cast<int32_t>(width);
-    capability_.height = static_cast<int32_t>(height);
-    capability_.maxFPS = static_cast<int32_t>(target_fps);
-    capability_.videoType = webrtc::VideoType::kI420;
 }
 
 void VcmCapturer::Start()
@@ -52,21 +53,29 @@ void VcmCapturer::Start()
                 break;
             }
 
-            if (device_info_->NumberOfCapabilities(cam_id_.c_str()) <= 0) {
+            int32_t num_capabilities = device_info_->NumberOfCapabilities(cam_id_.c_str());
+            if (num_capabilities <= 0) {
                 err = KRTCError::kVideoNoCapabilitiesErr;
                 RTC_LOG(LS_WARNING) << "CamImpl no capabilities";
                 break;
             }
 
-            webrtc::VideoCaptureCapability best_cap;
+            // 按原始格式选择，不再固定要求I420：很多USB摄像头1080p30只有MJPEG
+            std::vector<webrtc::VideoCaptureCapability> capabilities;
+            for (int32_t i = 0; i < num_capabilities; ++i) {
+                webrtc::VideoCaptureCapability cap;
+                if (device_info_->GetCapability(cam_id_.c_str(), i, cap) == 0) {
+                    capabilities.push_back(cap);
+                }
+            }
 
-            if (device_info_->GetBestMatchedCapability(cam_id_.c_str(),
-                capability_, best_cap) < 0)
-            {
+            webrtc::VideoCaptureCapability best_cap;
+            if (!SelectCameraCapability(capabilities, config_, &best_cap)) {
                 err = KRTCError::kVideoNoBestCapabilitiesErr;
                 RTC_LOG(LS_WARNING) << "CamImpl no best capabilities";
                 break;
             }
+            stats_.SetCapability(best_cap, 0);
 
             vcm_->RegisterCaptureDataCallback(this);
 
@@ -121,6 +130,26 @@ VcmCapturer::~VcmCapturer() {
 
 void VcmCapturer::OnFrame(const webrtc::VideoFrame& frame) {
     VideoCapturer::OnFrame(frame);
+    stats_.AddFrame(0);
+}
+
+rtc::scoped_refptr<VcmCapturerTrackSource> VcmCapturerTrackSource::Create(const std::string& cam_id)
+{
+    KRTCCameraCaptureConfig config = KRTCGlobal::Instance()->camera_capture_config();
+
+    std::unique_ptr<VideoCapturer> capture;
+#if defined(WEBRTC_LINUX)
+    capture = V4l2Capturer::Create(cam_id, config);
+#endif
+    if (!capture) {
+        capture = VcmCapturer::Create(cam_id, config);
+    }
+    //capture->SetFramePreprocessor(std::make_unique<VcmFramePreprocessor>());
+
+    if (capture) {
+        return rtc::make_ref_counted<VcmCapturerTrackSource>(std::move(capture));
+    }
+    return nullptr;
 }
 
 webrtc::VideoFrame VcmFramePreprocessor::Preprocess(const webrtc::VideoFrame& frame)
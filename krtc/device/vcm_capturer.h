@@ -12,6 +12,7 @@
 #include <pc/video_track_source.h>
 
 #include "krtc/krtc.h"
+#include "krtc/device/camera_capability.h"
 #include "krtc/device/video_capturer.h"
 
 namespace krtc {
@@ -28,18 +29,18 @@ public:
                      public rtc::VideoSinkInterface<webrtc::VideoFrame> 
 {
  public:
-	 static std::unique_ptr<VcmCapturer> Create(const std::string& cam_id, size_t width, size_t height, 
-												size_t target_fps);
+	 static std::unique_ptr<VcmCapturer> Create(const std::string& cam_id,
+												const KRTCCameraCaptureConfig& config);
 
      virtual ~VcmCapturer();
 
-     void Start();
-     void Stop();
+     void Start() override;
+     void Stop() override;
 
      void OnFrame(const webrtc::VideoFrame& frame) override;
 
  private:
-	 VcmCapturer(const std::string& cam_id, size_t width, size_t height, size_t target_fps);
+	 VcmCapturer(const std::string& cam_id, const KRTCCameraCaptureConfig& config);
 
 	 void Destroy();
 	 void SetEnableVideo(bool enable) {}
@@ -48,49 +49,22 @@ public:
      std::string cam_id_;
      rtc::scoped_refptr<webrtc::VideoCaptureModule> vcm_;
      webrtc::VideoCaptureModule::DeviceInfo* device_info_;
-     webrtc::VideoCaptureCapability capability_;
+     KRTCCameraCaptureConfig config_;
      rtc::Thread* signaling_thread_;
      bool has_start_ = false;
-
+     // WebRTC内部转换成I420，解码耗时统计不到
+     CameraStatsCounter stats_;
  };
 
- class VcmCapturerTrackSource : public webrtc::VideoTrackSource
+ class VcmCapturerTrackSource : public CapturerTrackSource
  {
  public:
-	 static rtc::scoped_refptr<VcmCapturerTrackSource> Create(const std::string& cam_id)
-	 {
-		 const size_t width = 640;
-		 const size_t height = 480;
-		 const size_t fps = 30;
-
-		 auto vcm_capture = VcmCapturer::Create(cam_id, width, height, fps);
-		 //vcm_capture->SetFramePreprocessor(std::make_unique<VcmFramePreprocessor>());
-
-		 if (vcm_capture) {
-			 return rtc::make_ref_counted<VcmCapturerTrackSource>(std::move(vcm_capture));
-		 }
-		 return nullptr;
-	 }
-
-	 void Start() {
-		 capture_->Start();
-	 }
-
-	 void Stop() {
-		 capture_->Stop();
-	 }
+	 // 按KRTCGlobal的摄像头采集配置创建，Linux下用V4l2Capturer按原始格式采集
+	 static rtc::scoped_refptr<VcmCapturerTrackSource> Create(const std::string& cam_id);
 
  protected:
-	 explicit VcmCapturerTrackSource(std::unique_ptr<VcmCapturer> capture)
-		 : VideoTrackSource(false)
-		 , capture_(std::move(capture)) {}
-
- private:
-	 rtc::VideoSourceInterface<webrtc::VideoFrame>* source() override {
-		 return capture_.get();
-	 }
-
-	 std::unique_ptr<VcmCapturer> capture_;
+	 explicit VcmCapturerTrackSource(std::unique_ptr<VideoCapturer> capture)
+		 : CapturerTrackSource(std::move(capture)) {}
  };
 
 }  // namespace krtc
@@ -1,7 +1,9 @@
 #include "krtc/device/video_capturer.h"
 
 #include <algorithm>
+#include <limits>
 
+#include <absl/types/optional.h>
 #include <api/scoped_refptr.h>
 #include <api/video/i420_buffer.h>
 #include <api/video/video_frame_buffer.h>
@@ -12,61 +14,90 @@
 #include "krtc/media/media_frame.h"
 
 namespace krtc {
+namespace {
+
+// 同一帧里已经缩放过的尺寸，其他sink要相同尺寸时直接复用
+struct ScaledFrame {
+    int cropped_width;
+    int cropped_height;
+    webrtc::VideoFrame frame;
+};
+
+webrtc::VideoFrame ScaleFrame(const webrtc::VideoFrame& frame,
+    int cropped_width, int cropped_height, int out_width, int out_height)
+{
+    int offset_x = (frame.width() - cropped_width) / 2;
+    int offset_y = (frame.height() - cropped_height) / 2;
+    // NV12等缓冲的CropAndScale保持原格式，不先转成I420
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> scaled_buffer = frame.video_frame_buffer()->CropAndScale(
+        offset_x, offset_y, cropped_width, cropped_height, out_width, out_height);
+    webrtc::VideoFrame::Builder new_frame_builder =
+        webrtc::VideoFrame::Builder()
+        .set_video_frame_buffer(scaled_buffer)
+        .set_rotation(frame.rotation())
+        .set_timestamp_us(frame.timestamp_us())
+        .set_id(frame.id());
+    if (frame.has_update_rect()) {
+        webrtc::VideoFrame::UpdateRect new_rect = frame.update_rect().ScaleWithFrame(
+            frame.width(), frame.height(), offset_x, offset_y, cropped_width, cropped_height,
+            out_width, out_height);
+        new_frame_builder.set_update_rect(new_rect);
+    }
+    return new_frame_builder.build();
+}
+
+} // namespace
+
 VideoCapturer::~VideoCapturer() = default;
 
 void VideoCapturer::OnFrame(const webrtc::VideoFrame& original_frame) {
     CalcFps(original_frame);
-    
-    int cropped_width = 0;
-    int cropped_height = 0;
-    int out_width = 0;
-    int out_height = 0;
 
     webrtc::VideoFrame frame = MaybePreprocess(original_frame);
 
-    if (!video_adapter_.AdaptFrameResolution(
-        frame.width(), frame.height(), frame.timestamp_us() * 1000,
-        &cropped_width, &cropped_height, &out_width, &out_height)) {
-
-        RTC_LOG(LS_WARNING) << "AdaptFrameResolution width:" << frame.width()
-                << ", height:" << frame.height()
-                << ", timestamp_us:" << frame.timestamp_us();
-
-        // Drop frame in order to respect frame rate constraint.
-        return;
-    }
-
-    if (out_height != frame.height() || out_width != frame.width()) {
-        // Video adapter has requested a down-scale. Allocate a new buffer and
-        // return scaled version.
-        // For simplicity, only scale here without cropping.
-        rtc::scoped_refptr<webrtc::I420Buffer> scaled_buffer =
-            webrtc::I420Buffer::Create(out_width, out_height);
-        scaled_buffer->ScaleFrom(*frame.video_frame_buffer()->ToI420());
-        webrtc::VideoFrame::Builder new_frame_builder =
-            webrtc::VideoFrame::Builder()
-            .set_video_frame_buffer(scaled_buffer)
-            .set_rotation(webrtc::kVideoRotation_0)
-            .set_timestamp_us(frame.timestamp_us())
-            .set_id(frame.id());
-        if (frame.has_update_rect()) {
-            webrtc::VideoFrame::UpdateRect new_rect = frame.update_rect().ScaleWithFrame(
-                frame.width(), frame.height(), 0, 0, frame.width(), frame.height(),
-                out_width, out_height);
-            new_frame_builder.set_update_rect(new_rect);
+    webrtc::MutexLock lock(&sinks_lock_);
+    std::vector<ScaledFrame> scaled_frames;
+    for (SinkAdapter& sink_adapter : sinks_) {
+        int cropped_width = 0;
+        int cropped_height = 0;
+        int out_width = 0;
+        int out_height = 0;
+        if (!sink_adapter.adapter->AdaptFrameResolution(
+            frame.width(), frame.height(), frame.timestamp_us() * 1000,
+            &cropped_width, &cropped_height, &out_width, &out_height)) {
+            // Drop frame in order to respect frame rate constraint.
+            sink_adapter.frame_dropped = true;
+            continue;
         }
 
-        broadcaster_.OnFrame(new_frame_builder.build());
+        absl::optional<webrtc::VideoFrame> adapted;
+        if (sink_adapter.wants.black_frames) {
+            // track被禁用时发黑帧，不用缩放原图
+            adapted = CreateBlackFrame(frame, out_width, out_height);
+        }
+        else if (out_height == frame.height() && out_width == frame.width()) {
+            adapted = frame;
+        }
+        else {
+            for (const ScaledFrame& scaled : scaled_frames) {
+                if (scaled.cropped_width == cropped_width && scaled.cropped_height == cropped_height &&
+                    scaled.frame.width() == out_width && scaled.frame.height() == out_height) {
+                    adapted = scaled.frame;
+                    break;
+                }
+            }
+            if (!adapted) {
+                adapted = ScaleFrame(frame, cropped_width, cropped_height, out_width, out_height);
+                scaled_frames.push_back({ cropped_width, cropped_height, *adapted });
+            }
+        }
 
+        if (sink_adapter.frame_dropped) {
+            adapted->clear_update_rect();
+            sink_adapter.frame_dropped = false;
+        }
+        sink_adapter.sink->OnFrame(*adapted);
     }
-    else {
-        // No adaptations needed, just return the frame as is.
-        broadcaster_.OnFrame(frame);
-    }
-}
-
-rtc::VideoSinkWants VideoCapturer::GetSinkWants() {
-    return broadcaster_.wants();
 }
 
 void VideoCapturer::AddOrUpdateSink(
@@ -75,13 +106,26 @@ void VideoCapturer::AddOrUpdateSink(
 
     RTC_LOG(LS_INFO) << "VideoCapturer AddOrUpdateSink";
 
-    broadcaster_.AddOrUpdateSink(sink, wants);
-    UpdateVideoAdapter();
+    webrtc::MutexLock lock(&sinks_lock_);
+    auto iter = std::find_if(sinks_.begin(), sinks_.end(), [sink](const SinkAdapter& sink_adapter) {
+        return sink_adapter.sink == sink;
+    });
+    if (iter == sinks_.end()) {
+        SinkAdapter sink_adapter;
+        sink_adapter.sink = sink;
+        sink_adapter.adapter = std::make_unique<cricket::VideoAdapter>();
+        sinks_.push_back(std::move(sink_adapter));
+        iter = sinks_.end() - 1;
+    }
+    iter->wants = wants;
+    UpdateVideoAdapter(&*iter);
 }
 
 void VideoCapturer::RemoveSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
-    broadcaster_.RemoveSink(sink);
-    UpdateVideoAdapter();
+    webrtc::MutexLock lock(&sinks_lock_);
+    sinks_.erase(std::remove_if(sinks_.begin(), sinks_.end(), [sink](const SinkAdapter& sink_adapter) {
+        return sink_adapter.sink == sink;
+    }), sinks_.end());
 }
 
 void VideoCapturer::CalcFps(const webrtc::VideoFrame& frame) {
@@ -101,8 +145,41 @@ void VideoCapturer::CalcFps(const webrtc::VideoFrame& frame) {
     }
 }
 
-void VideoCapturer::UpdateVideoAdapter() {
-    video_adapter_.OnSinkWants(broadcaster_.wants());
+void VideoCapturer::SetDegradationPreference(DEGRADATION_PREFERENCE preference) {
+    degradation_preference_ = preference;
+    webrtc::MutexLock lock(&sinks_lock_);
+    for (SinkAdapter& sink_adapter : sinks_) {
+        UpdateVideoAdapter(&sink_adapter);
+    }
+}
+
+void VideoCapturer::UpdateVideoAdapter(SinkAdapter* sink_adapter) {
+    rtc::VideoSinkWants wants = sink_adapter->wants;
+    switch (degradation_preference_) {
+    case DEGRADATION_PREFERENCE::MAINTAIN_RESOLUTION:
+        wants.max_pixel_count = std::numeric_limits<int>::max();
+        wants.target_pixel_count.reset();
+        break;
+    case DEGRADATION_PREFERENCE::MAINTAIN_FRAMERATE:
+        wants.max_framerate_fps = std::numeric_limits<int>::max();
+        break;
+    default:
+        break;
+    }
+    sink_adapter->adapter->OnSinkWants(wants);
+}
+
+webrtc::VideoFrame VideoCapturer::CreateBlackFrame(const webrtc::VideoFrame& frame, int width, int height) {
+    if (!black_buffer_ || black_buffer_->width() != width || black_buffer_->height() != height) {
+        black_buffer_ = webrtc::I420Buffer::Create(width, height);
+        webrtc::I420Buffer::SetBlack(black_buffer_.get());
+    }
+    return webrtc::VideoFrame::Builder()
+        .set_video_frame_buffer(black_buffer_)
+        .set_rotation(frame.rotation())
+        .set_timestamp_us(frame.timestamp_us())
+        .set_id(frame.id())
+        .build();
 }
 
 webrtc::VideoFrame VideoCapturer::MaybePreprocess(const webrtc::VideoFrame& frame) {
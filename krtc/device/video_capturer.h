@@ -5,13 +5,17 @@
 
 #include <memory>
 #include <atomic>
+#include <vector>
 
+#include <api/video/i420_buffer.h>
 #include <api/video/video_frame.h>
 #include <api/video/video_source_interface.h>
 #include <media/base/video_adapter.h>
-#include <media/base/video_broadcaster.h>
+#include <pc/video_track_source.h>
 #include <rtc_base/synchronization/mutex.h>
 
+#include "krtc/krtc.h"
+
 namespace krtc {
 
 class VideoCapturer : public rtc::VideoSourceInterface<webrtc::VideoFrame> {
@@ -25,6 +29,9 @@ public:
 
     ~VideoCapturer() override;
 
+    virtual void Start() = 0;
+    virtual void Stop() = 0;
+
     void AddOrUpdateSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
         const rtc::VideoSinkWants& wants) override;
     void RemoveSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) override;
@@ -32,28 +39,70 @@ public:
         webrtc::MutexLock lock(&lock_);
         preprocessor_ = std::move(preprocessor);
     }
+    // 采集端VideoAdapter只按偏好执行sink的降级请求：保分辨率时忽略降分辨率，保帧率时忽略降帧率
+    void SetDegradationPreference(DEGRADATION_PREFERENCE preference);
 
 protected:
     void OnFrame(const webrtc::VideoFrame& frame);
-    
-    rtc::VideoSinkWants GetSinkWants();
 
 private:
+    // 每个sink一个VideoAdapter，按各自的wants缩放和丢帧，推流降级不影响预览和其他推流
+    struct SinkAdapter {
+        rtc::VideoSinkInterface<webrtc::VideoFrame>* sink = nullptr;
+        rtc::VideoSinkWants wants;
+        std::unique_ptr<cricket::VideoAdapter> adapter;
+        // 丢过帧，下一帧的update_rect不再可靠，整帧更新
+        bool frame_dropped = false;
+    };
+
     void CalcFps(const webrtc::VideoFrame& frame);
 
-    void UpdateVideoAdapter();
+    void UpdateVideoAdapter(SinkAdapter* sink_adapter) RTC_EXCLUSIVE_LOCKS_REQUIRED(sinks_lock_);
     webrtc::VideoFrame MaybePreprocess(const webrtc::VideoFrame& frame);
+    webrtc::VideoFrame CreateBlackFrame(const webrtc::VideoFrame& frame, int width, int height)
+        RTC_EXCLUSIVE_LOCKS_REQUIRED(sinks_lock_);
 
     webrtc::Mutex lock_;
     std::unique_ptr<FramePreprocessor> preprocessor_ RTC_GUARDED_BY(lock_);
-    rtc::VideoBroadcaster broadcaster_;
-    cricket::VideoAdapter video_adapter_;
+    webrtc::Mutex sinks_lock_;
+    std::vector<SinkAdapter> sinks_ RTC_GUARDED_BY(sinks_lock_);
+    rtc::scoped_refptr<webrtc::I420Buffer> black_buffer_ RTC_GUARDED_BY(sinks_lock_);
 
+    std::atomic<DEGRADATION_PREFERENCE> degradation_preference_{ DEGRADATION_PREFERENCE::BALANCED };
     std::atomic<int> fps_{ 0 };
     std::atomic<int64_t> last_frame_ts_{ 0 };
     std::atomic<int64_t> start_time_{ 0 };
 };
 
+// 采集源只有一个VideoCapturer，采集只做一次，分发给所有预览和推流的track，
+// 各sink要求的尺寸相同时缩放也只做一次
+class CapturerTrackSource : public webrtc::VideoTrackSource {
+public:
+    void Start() {
+        capture_->Start();
+    }
+
+    void Stop() {
+        capture_->Stop();
+    }
+
+    void SetDegradationPreference(DEGRADATION_PREFERENCE preference) {
+        capture_->SetDegradationPreference(preference);
+    }
+
+protected:
+    explicit CapturerTrackSource(std::unique_ptr<VideoCapturer> capture)
+        : VideoTrackSource(false)
+        , capture_(std::move(capture)) {}
+
+private:
+    rtc::VideoSourceInterface<webrtc::VideoFrame>* source() override {
+        return capture_.get();
+    }
+
+    std::unique_ptr<VideoCapturer> capture_;
+};
+
 }  // namespace krtc
 
 #endif  // KRTCSDK_KRTC_DEVICE_VIDEO_CAPTURER_H_
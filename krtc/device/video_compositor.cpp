@@ -0,0 +1,232 @@
+#include "krtc/device/video_compositor.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+#include <third_party/libyuv/include/libyuv/planar_functions.h>
+#include <third_party/libyuv/include/libyuv/scale.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+namespace {
+
+// 超过这么久没有新帧的输入不参与对齐
+const int64_t kStaleInputUs = 500 * rtc::kNumMicrosecsPerMillisec;
+
+} // namespace
+
+void VideoCompositor::Input::OnFrame(const webrtc::VideoFrame& frame) {
+	webrtc::MutexLock lock(&lock_);
+	frames_.push_back(frame);
+	if (frames_.size() > kMaxQueuedFrames) {
+		frames_.pop_front();
+	}
+}
+
+bool VideoCompositor::Input::LatestTimestamp(int64_t* timestamp_us) {
+	webrtc::MutexLock lock(&lock_);
+	if (frames_.empty()) {
+		return false;
+	}
+	*timestamp_us = frames_.back().timestamp_us();
+	return true;
+}
+
+absl::optional<webrtc::VideoFrame> VideoCompositor::Input::Pick(int64_t timestamp_us) {
+	webrtc::MutexLock lock(&lock_);
+	if (frames_.empty()) {
+		return absl::nullopt;
+	}
+
+	auto picked = frames_.begin();
+	for (auto iter = frames_.begin(); iter != frames_.end(); ++iter) {
+		if (iter->timestamp_us() <= timestamp_us) {
+			picked = iter;
+		}
+	}
+	webrtc::VideoFrame frame = *picked;
+	// 更早的帧不会再用到
+	frames_.erase(frames_.begin(), picked);
+	return frame;
+}
+
+VideoCompositor::VideoCompositor(const std::vector<VideoSourceId>& inputs,
+	const KRTCCompositeConfig& config) :
+	input_ids_(inputs),
+	config_(config),
+	output_pool_(false, 4),
+	scratch_pool_(false, 2)
+{
+	if (input_ids_.size() > KRTCCompositeConfig::kMaxInputs) {
+		input_ids_.resize(KRTCCompositeConfig::kMaxInputs);
+	}
+	config_.width = std::max<uint32_t>(config_.width & ~1u, 2);
+	config_.height = std::max<uint32_t>(config_.height & ~1u, 2);
+	config_.fps = std::min<uint32_t>(std::max<uint32_t>(config_.fps, 1), 60);
+}
+
+VideoCompositor::~VideoCompositor() {
+	Stop();
+}
+
+void VideoCompositor::Start() {
+	if (running_) {
+		return;
+	}
+
+	for (VideoSourceId id : input_ids_) {
+		auto input = std::make_unique<Input>();
+		input->source = KRTCGlobal::Instance()->video_source_registry()->Get(id);
+		if (!input->source) {
+			RTC_LOG(LS_WARNING) << "composite input " << id << " not found";
+		}
+		else {
+			input->source->AddOrUpdateSink(input.get(), rtc::VideoSinkWants());
+		}
+		inputs_.push_back(std::move(input));
+	}
+
+	running_ = true;
+	compose_thread_.reset(new std::thread([this] {
+		ComposeThread();
+	}));
+}
+
+void VideoCompositor::Stop() {
+	if (running_) {
+		running_ = false;
+		compose_thread_->join();
+		compose_thread_.reset();
+	}
+
+	for (auto& input : inputs_) {
+		if (input->source) {
+			input->source->RemoveSink(input.get());
+		}
+	}
+	inputs_.clear();
+}
+
+void VideoCompositor::ComposeThread() {
+	const auto interval = std::chrono::microseconds(1000000 / config_.fps);
+	auto next = std::chrono::steady_clock::now();
+	while (running_) {
+		Compose();
+
+		next += interval;
+		auto now = std::chrono::steady_clock::now();
+		if (next < now) {
+			// 合成跟不上输出帧率时不追帧
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
+
+void VideoCompositor::Compose() {
+	// 以最慢那一路的最新帧为基准，其余各路取不晚于它的帧。
+	// 停止出帧的输入不参与，否则其余各路会一直停在它最后一帧的时间
+	std::vector<int64_t> latest_us;
+	for (auto& input : inputs_) {
+		int64_t timestamp_us = 0;
+		if (input->LatestTimestamp(&timestamp_us)) {
+			latest_us.push_back(timestamp_us);
+		}
+	}
+	int64_t reference_us = 0;
+	if (!CompositeReferenceTimestamp(latest_us, rtc::TimeMicros(), kStaleInputUs, &reference_us)) {
+		return;
+	}
+
+	std::vector<rtc::scoped_refptr<webrtc::I420BufferInterface>> frames(inputs_.size());
+	for (size_t i = 0; i < inputs_.size(); i++) {
+		absl::optional<webrtc::VideoFrame> frame = inputs_[i]->Pick(reference_us);
+		if (frame) {
+			frames[i] = frame->video_frame_buffer()->ToI420();
+		}
+	}
+
+	rtc::scoped_refptr<webrtc::I420Buffer> output =
+		output_pool_.CreateI420Buffer(config_.width, config_.height);
+	if (!output) {
+		RTC_LOG(LS_WARNING) << "composite output pool exhausted, skip frame";
+		return;
+	}
+	Render(frames, output.get());
+
+	OnFrame(webrtc::VideoFrame::Builder()
+		.set_video_frame_buffer(output)
+		.set_rotation(webrtc::kVideoRotation_0)
+		.set_timestamp_us(rtc::TimeMicros())
+		.build());
+}
+
+void VideoCompositor::Render(const std::vector<rtc::scoped_refptr<webrtc::I420BufferInterface>>& frames,
+	webrtc::I420Buffer* output)
+{
+	libyuv::I420Rect(output->MutableDataY(), output->StrideY(),
+		output->MutableDataU(), output->StrideU(),
+		output->MutableDataV(), output->StrideV(),
+		0, 0, output->width(), output->height(), 16, 128, 128);
+
+	const size_t count = std::min<size_t>(frames.size(), KRTCCompositeConfig::kMaxInputs);
+	for (size_t i = 0; i < count; i++) {
+		const rtc::scoped_refptr<webrtc::I420BufferInterface>& src = frames[i];
+		if (!src) {
+			continue;
+		}
+
+		CompositeRect region = CompositeRegionFor(config_, i, count, src->width(), src->height());
+		uint8_t alpha = config_.layout == COMPOSITE_LAYOUT::CUSTOM ? config_.regions[i].alpha : 255;
+		if (region.width > 0 && region.height > 0 && alpha > 0) {
+			Blend(*src, region, alpha, output);
+		}
+	}
+}
+
+void VideoCompositor::Blend(const webrtc::I420BufferInterface& src, const CompositeRect& region, uint8_t alpha,
+	webrtc::I420Buffer* dst)
+{
+	uint8_t* dst_y = dst->MutableDataY() + region.y * dst->StrideY() + region.x;
+	uint8_t* dst_u = dst->MutableDataU() + region.y / 2 * dst->StrideU() + region.x / 2;
+	uint8_t* dst_v = dst->MutableDataV() + region.y / 2 * dst->StrideV() + region.x / 2;
+
+	if (alpha == 255) {
+		// 不透明时直接缩放到输出缓冲里
+		libyuv::I420Scale(src.DataY(), src.StrideY(), src.DataU(), src.StrideU(), src.DataV(), src.StrideV(),
+			src.width(), src.height(),
+			dst_y, dst->StrideY(), dst_u, dst->StrideU(), dst_v, dst->StrideV(),
+			region.width, region.height, libyuv::kFilterBilinear);
+		return;
+	}
+
+	rtc::scoped_refptr<webrtc::I420Buffer> scaled = scratch_pool_.CreateI420Buffer(region.width, region.height);
+	if (!scaled) {
+		return;
+	}
+	libyuv::I420Scale(src.DataY(), src.StrideY(), src.DataU(), src.StrideU(), src.DataV(), src.StrideV(),
+		src.width(), src.height(),
+		scaled->MutableDataY(), scaled->StrideY(), scaled->MutableDataU(), scaled->StrideU(),
+		scaled->MutableDataV(), scaled->StrideV(),
+		region.width, region.height, libyuv::kFilterBilinear);
+
+	size_t alpha_size = static_cast<size_t>(region.width) * region.height;
+	if (alpha_plane_.size() < alpha_size) {
+		alpha_plane_.resize(alpha_size);
+	}
+	std::fill(alpha_plane_.begin(), alpha_plane_.begin() + alpha_size, alpha);
+
+	// dst = scaled * alpha + dst * (255 - alpha)
+	libyuv::I420Blend(scaled->DataY(), scaled->StrideY(), scaled->DataU(), scaled->StrideU(),
+		scaled->DataV(), scaled->StrideV(),
+		dst_y, dst->StrideY(), dst_u, dst->StrideU(), dst_v, dst->StrideV(),
+		alpha_plane_.data(), region.width,
+		dst_y, dst->StrideY(), dst_u, dst->StrideU(), dst_v, dst->StrideV(),
+		region.width, region.height);
+}
+
+} // namespace krtc
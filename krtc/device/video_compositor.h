@@ -0,0 +1,90 @@
+#ifndef KRTCSDK_KRTC_DEVICE_VIDEO_COMPOSITOR_H_
+#define KRTCSDK_KRTC_DEVICE_VIDEO_COMPOSITOR_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <absl/types/optional.h>
+#include <api/video/i420_buffer.h>
+#include <common_video/include/video_frame_buffer_pool.h>
+#include <rtc_base/synchronization/mutex.h>
+
+#include "krtc/krtc.h"
+#include "krtc/device/composite_layout.h"
+#include "krtc/device/video_capturer.h"
+#include "krtc/device/video_source_registry.h"
+
+namespace krtc {
+
+// 把多路已登记的采集源按布局缩放、混合到一帧I420里输出。
+// 每路输入缓存最近几帧，合成时按采集时间戳对齐到还在出帧的输入里最慢的那一路。
+class VideoCompositor : public VideoCapturer {
+public:
+	VideoCompositor(const std::vector<VideoSourceId>& inputs, const KRTCCompositeConfig& config);
+	~VideoCompositor() override;
+
+	void Start() override;
+	void Stop() override;
+
+	// 把各路输入按布局画到output里，frames按输入顺序，没有帧的位置为空。
+	// 只在合成线程调用，也不依赖已启动，单独测合成开销时直接调用
+	void Render(const std::vector<rtc::scoped_refptr<webrtc::I420BufferInterface>>& frames,
+		webrtc::I420Buffer* output);
+
+private:
+	class Input : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+	public:
+		void OnFrame(const webrtc::VideoFrame& frame) override;
+
+		// 最新一帧的采集时间，还没有帧时返回false
+		bool LatestTimestamp(int64_t* timestamp_us);
+		// 取不晚于timestamp_us的最新一帧，都晚于它时取最早的一帧
+		absl::optional<webrtc::VideoFrame> Pick(int64_t timestamp_us);
+
+		rtc::scoped_refptr<CapturerTrackSource> source;
+
+	private:
+		static const size_t kMaxQueuedFrames = 4;
+
+		webrtc::Mutex lock_;
+		std::deque<webrtc::VideoFrame> frames_ RTC_GUARDED_BY(lock_);
+	};
+
+	void ComposeThread();
+	void Compose();
+	void Blend(const webrtc::I420BufferInterface& src, const CompositeRect& region, uint8_t alpha,
+		webrtc::I420Buffer* dst);
+
+	std::vector<VideoSourceId> input_ids_;
+	KRTCCompositeConfig config_;
+	std::vector<std::unique_ptr<Input>> inputs_;
+
+	webrtc::VideoFrameBufferPool output_pool_;
+	// alpha混合时缩放结果的临时缓冲
+	webrtc::VideoFrameBufferPool scratch_pool_;
+	std::vector<uint8_t> alpha_plane_;
+
+	std::atomic<bool> running_{ false };
+	std::unique_ptr<std::thread> compose_thread_;
+};
+
+class CompositorTrackSource : public CapturerTrackSource {
+public:
+	static rtc::scoped_refptr<CompositorTrackSource> Create(const std::vector<VideoSourceId>& inputs,
+		const KRTCCompositeConfig& config)
+	{
+		return rtc::make_ref_counted<CompositorTrackSource>(
+			std::make_unique<VideoCompositor>(inputs, config));
+	}
+
+protected:
+	explicit CompositorTrackSource(std::unique_ptr<VideoCompositor> compositor)
+		: CapturerTrackSource(std::move(compositor)) {}
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_VIDEO_COMPOSITOR_H_
@@ -0,0 +1,159 @@
+#include "krtc/device/video_source_registry.h"
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/device/vcm_capturer.h"
+#include "krtc/device/desktop_capturer.h"
+#include "krtc/device/video_compositor.h"
+
+namespace krtc {
+
+VideoSourceId VideoSourceRegistry::AddCamera(const std::string& cam_id)
+{
+	VideoSourceId id = Add(CAPTURE_TYPE::CAMERA);
+	KRTCGlobal::Instance()->api_thread()->PostTask([this, id, cam_id]() {
+		OnCreated(id, VcmCapturerTrackSource::Create(cam_id));
+	});
+	return id;
+}
+
+VideoSourceId VideoSourceRegistry::AddScreen(uint16_t screen_index, uint16_t target_fps)
+{
+	VideoSourceId id = Add(CAPTURE_TYPE::SCREEN);
+	KRTCGlobal::Instance()->api_thread()->PostTask([this, id, screen_index, target_fps]() {
+		OnCreated(id, DesktopCapturerTrackSource::Create(screen_index, target_fps));
+	});
+	return id;
+}
+
+VideoSourceId VideoSourceRegistry::AddComposite(const std::vector<VideoSourceId>& inputs,
+	const KRTCCompositeConfig& config)
+{
+	VideoSourceId id = Add(CAPTURE_TYPE::COMPOSITE);
+	KRTCGlobal::Instance()->api_thread()->PostTask([this, id, inputs, config]() {
+		OnCreated(id, CompositorTrackSource::Create(inputs, config));
+	});
+	return id;
+}
+
+VideoSourceId VideoSourceRegistry::Add(const CAPTURE_TYPE& type)
+{
+	std::lock_guard<std::mutex> locker(mutex_);
+	VideoSourceId id = next_id_++;
+	sources_[id].type = type;
+	return id;
+}
+
+void VideoSourceRegistry::OnCreated(VideoSourceId id, rtc::scoped_refptr<CapturerTrackSource> source)
+{
+	if (!source) {
+		{
+			std::lock_guard<std::mutex> locker(mutex_);
+			sources_.erase(id);
+		}
+		if (KRTCGlobal::Instance()->engine_observer()) {
+			KRTCGlobal::Instance()->engine_observer()->OnPreviewFailed(KRTCError::kVideoCreateCaptureErr);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> locker(mutex_);
+	auto iter = sources_.find(id);
+	if (iter == sources_.end()) {
+		// 创建完成前已经被移除
+		return;
+	}
+	source->SetDegradationPreference(
+		KRTCGlobal::Instance()->video_source_config(iter->second.type).degradation_preference);
+	iter->second.source = source;
+	last_id_ = id;
+}
+
+void VideoSourceRegistry::Remove(VideoSourceId id)
+{
+	KRTCGlobal::Instance()->api_thread()->PostTask([this, id]() {
+		rtc::scoped_refptr<CapturerTrackSource> source;
+		{
+			std::lock_guard<std::mutex> locker(mutex_);
+			auto iter = sources_.find(id);
+			if (iter == sources_.end()) {
+				return;
+			}
+			source = iter->second.source;
+			sources_.erase(iter);
+
+			if (last_id_ == id) {
+				last_id_ = kDefaultVideoSource;
+				for (auto& item : sources_) {
+					if (item.second.source) {
+						last_id_ = item.first;
+					}
+				}
+			}
+		}
+
+		// 仍在推流的track持有引用，只停止采集
+		if (source) {
+			source->Stop();
+		}
+	});
+}
+
+void VideoSourceRegistry::Start(VideoSourceId id)
+{
+	KRTCGlobal::Instance()->api_thread()->PostTask([this, id]() {
+		CAPTURE_TYPE type;
+		rtc::scoped_refptr<CapturerTrackSource> source = Get(id, &type);
+		if (source) {
+			source->Start();
+		}
+
+		// 摄像头一直如此回调，桌面采集只在成功时回调
+		if ((source || type == CAPTURE_TYPE::CAMERA) && KRTCGlobal::Instance()->engine_observer()) {
+			KRTCGlobal::Instance()->engine_observer()->OnPreviewSuccess();
+		}
+	});
+}
+
+void VideoSourceRegistry::Stop(VideoSourceId id)
+{
+	KRTCGlobal::Instance()->api_thread()->PostTask([this, id]() {
+		rtc::scoped_refptr<CapturerTrackSource> source = Get(id);
+		if (source) {
+			source->Stop();
+		}
+	});
+}
+
+rtc::scoped_refptr<CapturerTrackSource> VideoSourceRegistry::Get(VideoSourceId id, CAPTURE_TYPE* type)
+{
+	std::lock_guard<std::mutex> locker(mutex_);
+	auto iter = sources_.find(ResolveLocked(id));
+	if (iter == sources_.end()) {
+		if (type) {
+			*type = CAPTURE_TYPE::CAMERA;
+		}
+		return nullptr;
+	}
+	if (type) {
+		*type = iter->second.type;
+	}
+	return iter->second.source;
+}
+
+void VideoSourceRegistry::SetDegradationPreference(const CAPTURE_TYPE& type,
+	DEGRADATION_PREFERENCE preference)
+{
+	std::lock_guard<std::mutex> locker(mutex_);
+	for (auto& item : sources_) {
+		if (item.second.type == type && item.second.source) {
+			item.second.source->SetDegradationPreference(preference);
+		}
+	}
+}
+
+VideoSourceId VideoSourceRegistry::ResolveLocked(VideoSourceId id) const
+{
+	return id == kDefaultVideoSource ? last_id_ : id;
+}
+
+} // namespace krtc
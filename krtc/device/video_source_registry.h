@@ -0,0 +1,69 @@
+#ifndef KRTCSDK_KRTC_DEVICE_VIDEO_SOURCE_REGISTRY_H_
+#define KRTCSDK_KRTC_DEVICE_VIDEO_SOURCE_REGISTRY_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "krtc/krtc.h"
+#include "krtc/device/video_capturer.h"
+
+namespace krtc {
+
+enum class CAPTURE_TYPE {
+	CAMERA,	// 摄像头采集
+	SCREEN, // 桌面采集
+	COMPOSITE, // 多路采集源合成
+};
+
+using VideoSourceId = uint32_t;
+// 推流/预览未指定采集源时使用最近创建的那个
+const VideoSourceId kDefaultVideoSource = 0;
+
+// CreateCameraSource/CreateScreenSource返回的对象，推流和预览通过source_id()绑定采集源
+class VideoSourceHandler : public IVideoHandler {
+public:
+	VideoSourceId source_id() const { return source_id_; }
+
+protected:
+	VideoSourceId source_id_ = kDefaultVideoSource;
+};
+
+// 所有采集源按句柄登记，同一个采集源可以同时给多个推流和预览使用。
+// 采集源在api线程创建和启停，Get可以在任意线程调用。
+class VideoSourceRegistry {
+public:
+	VideoSourceId AddCamera(const std::string& cam_id);
+	VideoSourceId AddScreen(uint16_t screen_index, uint16_t target_fps);
+	VideoSourceId AddComposite(const std::vector<VideoSourceId>& inputs, const KRTCCompositeConfig& config);
+	void Remove(VideoSourceId id);
+
+	void Start(VideoSourceId id);
+	void Stop(VideoSourceId id);
+
+	// 采集源还未创建成功或已移除时返回nullptr
+	rtc::scoped_refptr<CapturerTrackSource> Get(VideoSourceId id, CAPTURE_TYPE* type = nullptr);
+
+	// 作用于该类型的所有采集源
+	void SetDegradationPreference(const CAPTURE_TYPE& type, DEGRADATION_PREFERENCE preference);
+
+private:
+	struct Entry {
+		CAPTURE_TYPE type = CAPTURE_TYPE::CAMERA;
+		rtc::scoped_refptr<CapturerTrackSource> source;
+	};
+
+	VideoSourceId Add(const CAPTURE_TYPE& type);
+	void OnCreated(VideoSourceId id, rtc::scoped_refptr<CapturerTrackSource> source);
+	VideoSourceId ResolveLocked(VideoSourceId id) const;
+
+	std::mutex mutex_;
+	std::map<VideoSourceId, Entry> sources_;
+	VideoSourceId next_id_ = 1;
+	VideoSourceId last_id_ = kDefaultVideoSource;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_DEVICE_VIDEO_SOURCE_REGISTRY_H_
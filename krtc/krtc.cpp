@@ -1,4 +1,5 @@
 #include <map>
+#include <vector>
 
 #include <rtc_base/logging.h>
 
@@ -7,9 +8,13 @@
 #include "krtc/media/krtc_pusher.h"
 #include "krtc/media/krtc_puller.h"
 #include "krtc/media/krtc_preview.h"
+#include "krtc/media/pull_audio_mixer.h"
 #include "krtc/device/camera_video_source.h"
 #include "krtc/device/desktop_video_source.h"
+#include "krtc/device/composite_video_source.h"
 #include "krtc/device/mic_impl.h"
+#include "krtc/device/audio_capture_tap.h"
+#include "krtc/device/external_audio_source.h"
 
 namespace krtc {
 
@@ -33,8 +38,15 @@ KRTCErrStrs KRTCErrStr = {
     {KRTCError::kAudioSetRecordingDeviceErr,    "AudioSetRecordingDeviceErr"},
     {KRTCError::kAudioInitRecordingErr,	        "AudioInitRecordingErr"},
     {KRTCError::kAudioStartRecordingErr,        "AudioStartRecordingErr"},
+    {KRTCError::kCreatePeerConnectionErr,       "CreatePeerConnectionErr"},
+    {KRTCError::kReconnectFailedErr,            "ReconnectFailedErr"},
+    {KRTCError::kStreamBusyErr,                 "StreamBusyErr"},
 };
 
+void KRTCEngine::SetAudioDeviceConfig(const KRTCAudioDeviceConfig& config) {
+    KRTCGlobal::SetAudioDeviceConfig(config);
+}
+
 void KRTCEngine::Init(KRTCEngineObserver* observer) {
     rtc::LogMessage::LogTimestamps(true);
     rtc::LogMessage::LogThreads(true);
@@ -47,6 +59,101 @@ const char* KRTCEngine::GetErrString(const KRTCError& err) {
     return KRTCErrStr[err].c_str();
 }
 
+void KRTCEngine::SetVideoEncodeMode(const VIDEO_ENCODE_MODE& mode, int pipeline_depth) {
+    KRTCGlobal::Instance()->SetVideoEncodeMode(mode, pipeline_depth);
+}
+
+void KRTCEngine::SetScreenShareRoi(bool enable, bool detect_text) {
+    KRTCGlobal::Instance()->SetScreenShareRoi(enable, detect_text);
+}
+
+void KRTCEngine::SetKeyFrameConfig(const KRTCKeyFrameConfig& config) {
+    KRTCGlobal::Instance()->SetKeyFrameConfig(config);
+}
+
+void KRTCEngine::SetVideoTemporalLayers(int layers) {
+    KRTCGlobal::Instance()->SetVideoTemporalLayers(layers);
+}
+
+void KRTCEngine::PrewarmSignaling(const char* server_addr) {
+    if (!server_addr || !*server_addr) {
+        return;
+    }
+    KRTCGlobal::Instance()->http_manager()->Prewarm(server_addr);
+}
+
+void KRTCEngine::SetFastStart(bool enable, int pool_size) {
+    KRTCGlobal::Instance()->SetFastStart(enable, pool_size);
+}
+
+void KRTCEngine::SetSignalingProtocol(const SIGNALING_PROTOCOL& protocol) {
+    KRTCGlobal::Instance()->SetSignalingProtocol(protocol);
+}
+
+void KRTCEngine::SetCameraSourceConfig(const KRTCVideoSourceConfig& config) {
+    KRTCGlobal::Instance()->SetVideoSourceConfig(CAPTURE_TYPE::CAMERA, config);
+}
+
+void KRTCEngine::SetScreenSourceConfig(const KRTCVideoSourceConfig& config) {
+    KRTCGlobal::Instance()->SetVideoSourceConfig(CAPTURE_TYPE::SCREEN, config);
+}
+
+void KRTCEngine::SetCameraCaptureConfig(const KRTCCameraCaptureConfig& config) {
+    KRTCGlobal::Instance()->SetCameraCaptureConfig(config);
+}
+
+void KRTCEngine::SetReconnectConfig(const KRTCReconnectConfig& config) {
+    KRTCGlobal::Instance()->SetReconnectConfig(config);
+}
+
+void KRTCEngine::SetBitrateConfig(const KRTCBitrateConfig& config) {
+    KRTCGlobal::Instance()->SetBitrateConfig(config);
+}
+
+void KRTCEngine::SetAudioSendConfig(const KRTCAudioSendConfig& config) {
+    KRTCGlobal::Instance()->SetAudioSendConfig(config);
+}
+
+void KRTCEngine::SetPullLatencyConfig(const KRTCPullLatencyConfig& config) {
+    KRTCGlobal::Instance()->SetPullLatencyConfig(config);
+}
+
+void KRTCEngine::SetPullVideoFormats(const KRTCPullVideoFormats& formats) {
+    KRTCGlobal::Instance()->SetPullVideoFormats(formats);
+}
+
+void KRTCEngine::SetAudioMixConfig(const KRTCAudioMixConfig& config) {
+    KRTCGlobal::Instance()->pull_audio_mixer()->SetConfig(config);
+}
+
+void KRTCEngine::SetPullAudioGain(IMediaHandler* puller, float gain) {
+    if (puller) {
+        static_cast<KRTCPuller*>(puller)->SetAudioGain(gain);
+    }
+}
+
+void KRTCEngine::SetPullAudioMute(IMediaHandler* puller, bool mute) {
+    if (puller) {
+        static_cast<KRTCPuller*>(puller)->SetAudioMute(mute);
+    }
+}
+
+void KRTCEngine::SetCapturedAudioDelivery(bool enable) {
+    KRTCGlobal::Instance()->audio_capture_tap()->SetDelivery(enable);
+}
+
+int32_t KRTCEngine::ReadCapturedAudio(int16_t* buffer, int32_t frames) {
+    return KRTCGlobal::Instance()->audio_capture_tap()->Read(buffer, frames);
+}
+
+KRTCCapturedAudioStats KRTCEngine::GetCapturedAudioStats() {
+    return KRTCGlobal::Instance()->audio_capture_tap()->stats();
+}
+
+void KRTCEngine::SetAudioProcessingConfig(const KRTCAudioProcessingConfig& config) {
+    KRTCGlobal::Instance()->SetAudioProcessingConfig(config);
+}
+
 uint32_t KRTCEngine::GetCameraCount() {
     return KRTCGlobal::Instance()->api_thread()->BlockingCall([=]() {
         if (!KRTCGlobal::Instance()->video_device_info()) {
@@ -92,6 +199,20 @@ IVideoHandler* KRTCEngine::CreateScreenSource(const uint32_t& screen_index)
     });
 }
 
+IVideoHandler* KRTCEngine::CreateCompositeSource(IVideoHandler* const* sources, int count,
+    const KRTCCompositeConfig& config)
+{
+    std::vector<VideoSourceId> inputs;
+    for (int i = 0; sources && i < count && i < KRTCCompositeConfig::kMaxInputs; i++) {
+        if (sources[i]) {
+            inputs.push_back(static_cast<VideoSourceHandler*>(sources[i])->source_id());
+        }
+    }
+    return KRTCGlobal::Instance()->api_thread()->BlockingCall([=]() {
+        return new CompositeVideoSource(inputs, config);
+    });
+}
+
 int16_t KRTCEngine::GetMicCount() {
     return KRTCGlobal::Instance()->api_thread()->BlockingCall([=]() {
         if (!KRTCGlobal::Instance()->audio_device()) {
@@ -122,15 +243,34 @@ IAudioHandler* KRTCEngine::CreateMicSource(const char* mic_id) {
     });
 }
 
-IMediaHandler* KRTCEngine::CreatePreview(const unsigned int& hwnd) {
+IExternalAudioSource* KRTCEngine::CreateExternalAudioSource(uint32_t sample_rate, uint32_t channels) {
+    if (sample_rate < 8000 || sample_rate > 48000 || sample_rate % 100 != 0 ||
+        channels < 1 || channels > 2)
+    {
+        RTC_LOG(LS_WARNING) << "unsupported external audio format, sample_rate: " << sample_rate
+            << ", channels: " << channels;
+        return nullptr;
+    }
+    return new ExternalAudioSource(sample_rate, channels);
+}
+
+IMediaHandler* KRTCEngine::CreatePreview(const unsigned int& hwnd, IVideoHandler* video_source) {
+   VideoSourceId source_id = video_source
+       ? static_cast<VideoSourceHandler*>(video_source)->source_id() : kDefaultVideoSource;
    return KRTCGlobal::Instance()->api_thread()->BlockingCall([=]() {
-        return new KRTCPreview(hwnd);
+        return new KRTCPreview(hwnd, source_id);
    });
 }
 
-IMediaHandler* KRTCEngine::CreatePusher(const char* server_addr, const char* push_channel) {
+IMediaHandler* KRTCEngine::CreatePusher(const char* server_addr, const char* push_channel,
+    IVideoHandler* video_source, IExternalAudioSource* audio_source)
+{
+   VideoSourceId source_id = video_source
+       ? static_cast<VideoSourceHandler*>(video_source)->source_id() : kDefaultVideoSource;
+   rtc::scoped_refptr<LocalAudioSource> external_audio = audio_source
+       ? static_cast<ExternalAudioSource*>(audio_source)->source() : nullptr;
    return KRTCGlobal::Instance()->api_thread()->BlockingCall([=]() {
-        return new KRTCPusher(server_addr, push_channel);
+        return new KRTCPusher(server_addr, push_channel, source_id, external_audio);
    });
 }
 
@@ -48,7 +48,19 @@ enum class KRTCError {
     kAudioNotFoundErr,
     kAudioSetRecordingDeviceErr,
     kAudioInitRecordingErr,
-    kAudioStartRecordingErr
+    kAudioStartRecordingErr,
+    kCreatePeerConnectionErr,
+    kReconnectFailedErr,
+    // SRS上同名的流还在推(包括本端断线前还没超时的旧会话)
+    kStreamBusyErr
+};
+
+// 最新帧信箱的累计统计
+struct KRTCFrameMailboxStats {
+    uint64_t frames_published = 0;
+    uint64_t frames_acquired = 0;
+    // 渲染前被新帧覆盖的帧
+    uint64_t frames_dropped_before_render = 0;
 };
 
 class IMediaHandler {
@@ -61,14 +73,363 @@ public:
 
     virtual void SetEnableVideo(bool enable) = 0;
     virtual void SetEnableAudio(bool enable) = 0;
+
+    // 只对拉流和不带窗口的预览有效：开启后视频帧不再回调OnPullVideoFrame/OnCapturePureVideoFrame，
+    // 由渲染线程在vsync时调用AcquireLatestFrame取最新一帧，没有新帧时返回nullptr。
+    // AcquireLatestFrame只能在一个线程调用
+    virtual void SetFrameMailbox(bool enable) {}
+    virtual std::shared_ptr<MediaFrame> AcquireLatestFrame() { return nullptr; }
+    virtual KRTCFrameMailboxStats GetFrameMailboxStats() { return KRTCFrameMailboxStats(); }
 };
 
 class IAudioHandler : public IMediaHandler {
 };
 
+// 外部音频源，推送文件、TTS、上游解码得到的PCM，不经过麦克风
+class IExternalAudioSource : public IAudioHandler {
+public:
+    // 16bit交织PCM，frames为每个声道的采样数，长度任意，内部切成10ms；
+    // 需要按实时速度送入，Start()之前或Stop()之后返回false
+    virtual bool PushAudioFrame(const int16_t* data, uint32_t frames) = 0;
+};
+
 class IVideoHandler : public IMediaHandler {
 };
 
+// 编码器码控统计，最近kWindowMs内的滑动窗口
+struct KRTCEncoderStats {
+    static const int kWindowMs = 5000;
+    // 帧大小直方图上界(字节)：<2K <4K <8K <16K <32K <64K <128K >=128K
+    static const int kSizeBuckets = 8;
+    // QP直方图：0-19 20-24 25-29 30-34 35-39 40-51
+    static const int kQpBuckets = 6;
+
+    const char* implementation = "";
+    uint32_t frames = 0;
+    uint32_t key_frames = 0;
+    uint32_t dropped_frames = 0;
+    uint32_t target_bps = 0;
+    uint32_t actual_bps = 0;
+    // (actual_bps - target_bps) / target_bps，正数表示超出目标码率
+    float rc_tracking_error = 0.0f;
+    uint32_t avg_frame_bytes = 0;
+    uint32_t max_frame_bytes = 0;
+    int32_t avg_qp = -1;
+    int32_t min_qp = -1;
+    int32_t max_qp = -1;
+    uint32_t size_histogram[kSizeBuckets] = { 0 };
+    uint32_t qp_histogram[kQpBuckets] = { 0 };
+    // 关键帧请求，编码器创建以来的累计值
+    uint32_t key_frame_requests = 0;
+    uint32_t coalesced_key_frame_requests = 0;
+    uint32_t intra_refreshes = 0;
+};
+
+// 接收端PLI/FIR关键帧请求的处理策略
+struct KRTCKeyFrameConfig {
+    // 用渐进帧内刷新代替IDR(仅NVIDIA/Intel硬编)，刷新后接收端仍在请求时升级为IDR
+    bool intra_refresh = false;
+    uint32_t intra_refresh_frames = 30;
+    // 刚发出关键帧后这段时间内的请求视为同一次丢包引起，直接合并
+    uint32_t coalesce_window_ms = 300;
+    // 两次关键帧之间的最小间隔，期间的请求延后到间隔结束再处理
+    uint32_t min_interval_ms = 1000;
+};
+
+// 推流建立过程中各阶段完成的时刻，相对Start()的毫秒数，未到达的阶段为-1
+struct KRTCSetupTimings {
+    // 使用了快速启动池里预创建的PeerConnection
+    bool warm_start = false;
+    int32_t peer_connection_created_ms = -1;
+    int32_t tracks_added_ms = -1;
+    int32_t offer_created_ms = -1;
+    int32_t local_description_set_ms = -1;
+    // 信令HTTP请求收到应答
+    int32_t answer_received_ms = -1;
+    int32_t remote_description_set_ms = -1;
+    int32_t ice_connected_ms = -1;
+};
+
+// 带宽或CPU不足时优先降低什么
+enum class KRTC_API DEGRADATION_PREFERENCE {
+    BALANCED,               // 分辨率和帧率都降
+    MAINTAIN_FRAMERATE,     // 保帧率，降分辨率，适合摄像头
+    MAINTAIN_RESOLUTION,    // 保分辨率，降帧率，适合屏幕共享里的文字
+};
+
+// 视频内容提示，编码器据此选择码控和屏幕内容相关的编码工具
+enum class KRTC_API VIDEO_CONTENT_HINT {
+    NONE,
+    MOTION,     // 运动画面
+    DETAIL,     // 细节丰富的静态画面
+    TEXT,       // 文字，比DETAIL更严格地保持清晰
+};
+
+// 视频源的降级策略，同时作用于采集端的VideoAdapter和发送端的RtpSender
+struct KRTCVideoSourceConfig {
+    DEGRADATION_PREFERENCE degradation_preference = DEGRADATION_PREFERENCE::MAINTAIN_FRAMERATE;
+    VIDEO_CONTENT_HINT content_hint = VIDEO_CONTENT_HINT::NONE;
+};
+
+enum class KRTC_API CAMERA_FORMAT {
+    AUTO,   // 优先能达到目标帧率的原始格式(NV12 > I420 > YUY2)，达不到时用MJPEG
+    I420,
+    NV12,
+    YUY2,
+    MJPEG,
+};
+
+// 摄像头采集参数，对之后创建的摄像头生效
+struct KRTCCameraCaptureConfig {
+    uint32_t width = 640;
+    uint32_t height = 480;
+    uint32_t fps = 30;
+    CAMERA_FORMAT format = CAMERA_FORMAT::AUTO;
+    // 以下两项只在Linux下生效，Windows下由WebRTC内部解码成I420
+    // 采集输出NV12，硬件编码器可以直接使用，否则输出I420
+    bool output_nv12 = false;
+    // MJPEG解码线程数，0时4K及以上用多线程，其他分辨率在采集线程上解码
+    uint32_t decode_threads = 0;
+};
+
+// 摄像头采集统计，每秒一次
+struct KRTCCameraStats {
+    // 实际使用的采集能力
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t fps = 0;
+    CAMERA_FORMAT format = CAMERA_FORMAT::AUTO;
+    uint32_t decode_threads = 0;
+    // 最近一秒输出的帧数和每帧解码(格式转换)耗时，Windows下由WebRTC内部解码，耗时为0
+    uint32_t frames = 0;
+    uint32_t decode_avg_us = 0;
+    uint32_t decode_max_us = 0;
+    // 解码跟不上或缓冲池耗尽丢弃的帧，累计值
+    uint32_t frames_dropped = 0;
+};
+
+enum class KRTC_API COMPOSITE_LAYOUT {
+    GRID,       // 按输入个数均分为网格
+    PIP,        // 第一路铺满，其余作为小窗口从右下角往上排列
+    CUSTOM,     // 使用KRTCCompositeConfig::regions
+};
+
+// 合成区域，相对输出画面的归一化坐标，超出画面的部分裁掉
+struct KRTCCompositeRegion {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 1.0f;
+    float height = 1.0f;
+    // 255为不透明
+    uint8_t alpha = 255;
+};
+
+// 多路采集源合成为一路视频，在独立线程按固定帧率输出
+struct KRTCCompositeConfig {
+    static const int kMaxInputs = 9;
+
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t fps = 30;
+    COMPOSITE_LAYOUT layout = COMPOSITE_LAYOUT::GRID;
+    // PIP小窗口宽度占输出宽度的比例
+    float pip_scale = 0.25f;
+    // CUSTOM布局下每路输入的区域，后面的输入画在上面
+    KRTCCompositeRegion regions[kMaxInputs];
+};
+
+// 推流断线自动重连：先在原PeerConnection上做ICE restart，多次失败后重建PeerConnection
+// 重新协商，两种方式都复用已有的采集源和音视频track
+struct KRTCReconnectConfig {
+    bool enable = true;
+    // 连接进入disconnected后先等待ICE自行恢复，超时或进入failed后开始重连
+    uint32_t disconnected_timeout_ms = 2000;
+    // 前几次尝试使用ICE restart。只对WHIP/WHEP生效；SRS的/rtc/v1接口不能在旧会话上重新协商，
+    // SRS直接重建PeerConnection重新publish
+    uint32_t ice_restart_attempts = 2;
+    uint32_t max_attempts = 8;
+    // 断线时关闭旧连接的DTLS close_notify到不了SRS，SRS要等旧会话超时(默认30秒)才释放这个流，
+    // 在此之前重新publish会被拒绝(stream busy)。从第一次被拒绝起这段时间内的stream busy不计入尝试次数
+    uint32_t stream_busy_timeout_ms = 35000;
+    // 第n次尝试前等待min(initial_backoff_ms * 2^(n-1), max_backoff_ms)，实际在[一半, 全部]之间随机
+    uint32_t initial_backoff_ms = 500;
+    uint32_t max_backoff_ms = 10000;
+    // 单次尝试超过这个时间仍未连上，进行下一次尝试
+    uint32_t attempt_timeout_ms = 5000;
+};
+
+// 一次断线恢复的统计
+struct KRTCReconnectInfo {
+    // 0表示ICE在等待期间自行恢复
+    uint32_t attempts = 0;
+    // 其中重建PeerConnection的次数
+    uint32_t renegotiations = 0;
+    // 恢复连接的那次尝试是ICE restart
+    bool ice_restart = false;
+    // 从断开到恢复的毫秒数
+    int32_t downtime_ms = 0;
+};
+
+// 推流码率范围，0表示使用WebRTC默认值
+struct KRTCBitrateConfig {
+    int32_t min_bitrate_bps = 0;
+    // 带宽估计的起始值，上行受限但带宽确定的场景设高一些可以更快起量
+    int32_t start_bitrate_bps = 0;
+    int32_t max_bitrate_bps = 0;
+    // 初始探测使用更大的倍数(起始码率的4倍、8倍，默认3倍、6倍)
+    bool aggressive_initial_probe = false;
+};
+
+// 拉流的延迟控制，对之后开始的拉流生效，-1表示用webrtc默认行为
+struct KRTCPullLatencyConfig {
+    // 视频jitter buffer的最小延迟(RtpReceiver::SetJitterBufferMinimumDelay)
+    int32_t min_playout_delay_ms = -1;
+    // 视频播放延迟上限，覆盖推流端playout-delay扩展头的值
+    int32_t max_playout_delay_ms = -1;
+    // 音频NetEq的最小目标延迟
+    int32_t audio_target_delay_ms = -1;
+    // 视频解码完立即渲染，不做平滑，忽略上面两个视频参数
+    bool render_asap = false;
+};
+
+// 拉流OnPullVideoFrame接受的帧格式，对之后开始的拉流生效。
+// 解码输出是接受的格式时直接引用解码缓冲，不转换也不拷贝；都不接受时转换成I420
+struct KRTCPullVideoFormats {
+    bool i420 = true;
+    bool nv12 = false;
+    bool native = false;
+};
+
+// 拉流接收统计，每秒一次，延迟为最近一秒的平均值
+struct KRTCPullStats {
+    uint32_t video_jitter_buffer_delay_ms = 0;
+    uint32_t video_jitter_buffer_target_delay_ms = 0;
+    uint32_t frames_decoded = 0;
+    // 来不及解码或渲染被丢弃的帧，累计值
+    uint32_t frames_dropped = 0;
+    uint32_t freeze_count = 0;
+    uint32_t audio_jitter_buffer_delay_ms = 0;
+    uint32_t audio_jitter_buffer_target_delay_ms = 0;
+    // 丢包隐藏，累计值
+    uint64_t concealment_events = 0;
+    uint64_t concealed_samples = 0;
+    uint64_t total_samples_received = 0;
+    // OnPullVideoFrame回调的帧数和其中做过的格式转换次数，累计值
+    uint64_t frames_delivered = 0;
+    uint64_t frame_conversions = 0;
+    // 开启最新帧信箱时渲染前被覆盖的帧，累计值
+    uint64_t frames_dropped_before_render = 0;
+    // 传入窗口时SDK渲染的帧数(累计值)，上传YUV纹理的平均耗时(最近一秒)和最大耗时
+    uint64_t frames_rendered = 0;
+    uint32_t render_upload_avg_us = 0;
+    uint32_t render_upload_max_us = 0;
+};
+
+enum class KRTC_API OPUS_APPLICATION {
+    // 语音优化
+    VOIP,
+    // 音乐等通用音频
+    AUDIO,
+};
+
+// 推流的Opus编码参数，下一次推流或重连协商时生效
+struct KRTCAudioSendConfig {
+    // 0时用webrtc默认值(单声道32kbps，立体声64kbps)
+    uint32_t bitrate_bps = 0;
+    // 推麦克风时还要打开KRTCAudioProcessingConfig::stereo_capture
+    bool stereo = false;
+    // 带内FEC
+    bool fec = true;
+    bool dtx = false;
+    // 每包时长，10/20/40/60ms
+    uint32_t ptime_ms = 20;
+    OPUS_APPLICATION application = OPUS_APPLICATION::VOIP;
+    // 0-10，-1时用webrtc默认值
+    int32_t complexity = -1;
+};
+
+// 推流带宽估计与拥塞控制统计，每秒一次
+struct KRTCBandwidthStats {
+    // transport-cc带宽估计
+    uint32_t available_send_bps = 0;
+    // 编码器目标码率，音视频之和
+    uint32_t target_bps = 0;
+    // 实际发送码率，含RTP头和重传
+    uint32_t actual_send_bps = 0;
+    uint32_t retransmit_bps = 0;
+    // 最近一秒发出的包在pacer队列里的平均等待时间
+    double pacer_delay_ms = 0.0;
+    int32_t rtt_ms = -1;
+    // 带宽估计首次达到max_bitrate_bps的时刻，相对Start()的毫秒数，
+    // 用来衡量初始探测的效果，未设置max或还未达到为-1
+    int32_t ramp_up_ms = -1;
+};
+
+// 麦克风采集数据的缓冲状态
+struct KRTCCapturedAudioStats {
+    uint32_t sample_rate = 0;
+    uint32_t channels = 0;
+    // 缓冲区里还没读走的帧数，每帧含所有声道
+    uint32_t buffered_frames = 0;
+    // 缓冲区满(约1秒)后丢掉的帧数
+    uint64_t overrun_frames = 0;
+    // ReadCapturedAudio读到的数据不足的次数
+    uint64_t underrun_count = 0;
+};
+
+enum class KRTC_API NOISE_SUPPRESSION_LEVEL {
+    LOW,
+    MODERATE,
+    HIGH,
+    VERY_HIGH,
+};
+
+// 麦克风采集的音频处理(APM)
+struct KRTCAudioProcessingConfig {
+    // AEC3回声消除
+    bool echo_cancellation = true;
+    bool noise_suppression = true;
+    NOISE_SUPPRESSION_LEVEL noise_suppression_level = NOISE_SUPPRESSION_LEVEL::HIGH;
+    // AGC2自适应数字增益
+    bool auto_gain_control = true;
+    bool high_pass_filter = true;
+    // 立体声采集时APM按双声道处理，开销约翻倍，语音场景用单声道即可
+    bool stereo_capture = false;
+    // APM内部处理采样率上限，32000或48000
+    uint32_t processing_sample_rate = 48000;
+    // 每秒回调一次OnAudioProcessingStats，会额外占用和APM差不多的CPU
+    bool profile = false;
+};
+
+// 各模块处理一帧10ms的耗时(微秒)，用采集到的真实数据对每个模块单独计时，
+// 不论该模块当前是否开启
+struct KRTCAudioProcessingStats {
+    struct ModuleCost {
+        uint32_t avg_us = 0;
+        uint32_t max_us = 0;
+    };
+    ModuleCost high_pass_filter;
+    // 含远端参考信号的分析
+    ModuleCost echo_cancellation;
+    ModuleCost noise_suppression;
+    ModuleCost auto_gain_control;
+    // 统计的帧数，以及采集格式
+    uint32_t frames = 0;
+    uint32_t sample_rate = 0;
+    uint32_t channels = 0;
+};
+
+// 多路拉流音频混音，每10ms输出一帧16bit交织PCM
+struct KRTCAudioMixConfig {
+    bool enable = false;
+    // 按音量只混最活跃的N路
+    uint32_t max_active_streams = 3;
+    uint32_t sample_rate = 48000;
+    uint32_t channels = 1;
+    // 各拉流自己的音频设备播放静音，只由应用播放混音结果
+    bool mute_playout = true;
+};
+
 class KRTC_API KRTCEngineObserver {
 public:
     virtual void OnVideoSourceSuccess() {}
@@ -79,16 +440,31 @@ public:
     virtual void OnPreviewFailed(KRTCError) {}
     virtual void OnPushSuccess() {}
     virtual void OnPushFailed(KRTCError) {}
+    // 推流连接建立(PeerConnection connected)后回调一次
+    virtual void OnPushSetupTimings(const KRTCSetupTimings& timings) {}
+    // 自动重连，所有尝试都失败后回调OnPushFailed(kReconnectFailedErr)
+    virtual void OnPushReconnecting(uint32_t attempt, bool ice_restart) {}
+    virtual void OnPushReconnected(const KRTCReconnectInfo& info) {}
     virtual void OnPullSuccess() {}
     virtual void OnPullFailed(KRTCError) {}
+    // puller为CreatePuller的返回值
+    virtual void OnPullStats(IMediaHandler* puller, const KRTCPullStats& stats) {}
     virtual void OnNetworkInfo(uint64_t rtt_ms, uint64_t packets_lost, double fraction_lost) {}
+    virtual void OnBandwidthStats(const KRTCBandwidthStats& stats) {}
+    virtual void OnAudioProcessingStats(const KRTCAudioProcessingStats& stats) {}
     virtual void OnVideoCaptureFps(uint32_t fps) {}
+    // cam_id为CreateCameraSource的参数
+    virtual void OnCameraStats(const char* cam_id, const KRTCCameraStats& stats) {}
+    virtual void OnVideoEncodeLatency(uint32_t frames, uint32_t avg_us, uint32_t max_us) {}
+    virtual void OnEncoderStats(const KRTCEncoderStats& stats) {}
     virtual void OnEncodedVideoFrame(std::shared_ptr<MediaFrame> video_frame) {}
     virtual void OnPureAudioFrame(std::shared_ptr<MediaFrame> audio_frame) {}
     virtual void OnMixedAudioFrame(std::shared_ptr<MediaFrame> audio_frame) {}
     virtual void OnProcessingFilterAudioFrame(std::shared_ptr<MediaFrame> audio_frame) {}
     virtual void OnEncodedAudioFrame(std::shared_ptr<MediaFrame> audio_frame) {}
     virtual void OnCapturePureVideoFrame(std::shared_ptr<krtc::MediaFrame> video_frame) {}
+    // 拉流解码后的视频帧，data直接引用解码缓冲，各平面不再连续存放(以前data[1]、data[2]紧跟在data[0]后面)。
+    // 按data[i]、stride[i]、data_len[i]逐个平面读取，不要从data[0]按整帧大小拷贝
     virtual void OnPullVideoFrame(std::shared_ptr<krtc::MediaFrame> video_frame) {}
     virtual krtc::MediaFrame* OnPreprocessVideoFrame(krtc::MediaFrame* origin_frame) {
         return origin_frame;
@@ -100,11 +476,79 @@ enum class KRTC_API CONTROL_TYPE {
     PULL,
 };
 
+enum class KRTC_API SIGNALING_PROTOCOL {
+    SRS,    // SRS的/rtc/v1/publish/、/rtc/v1/play/ JSON接口，server_addr为https://host:port
+    WHIP,   // 推流WHIP、拉流WHEP，server_addr为完整的endpoint地址，channel不使用
+};
+
+enum class KRTC_API VIDEO_ENCODE_MODE {
+    LOW_LATENCY,    // 逐帧同步等待编码结果，适合互动场景
+    PIPELINED,      // 硬件编码器同时处理2~4帧，提高吞吐
+};
+
+enum class KRTC_API AUDIO_DEVICE_TYPE {
+    PLATFORM,   // 系统声卡
+    HEADLESS,   // 无声卡：播放数据直接丢弃，采集循环读取WAV文件
+};
+
+struct KRTCAudioDeviceConfig {
+    AUDIO_DEVICE_TYPE type = AUDIO_DEVICE_TYPE::PLATFORM;
+    // HEADLESS时的采集文件(16bit WAV)，为空时没有麦克风，只能用外部音频源推流
+    const char* capture_wav_file = nullptr;
+};
+
 class KRTC_API KRTCEngine {
 public:
+    // 音频设备在SDK初始化时创建，必须在Init和其他所有接口之前调用
+    static void SetAudioDeviceConfig(const KRTCAudioDeviceConfig& config);
     static void Init(KRTCEngineObserver* observer);
     static const char* GetErrString(const KRTCError& err);
 
+    // 推流前设置，下一次创建编码器时生效
+    static void SetVideoEncodeMode(const VIDEO_ENCODE_MODE& mode, int pipeline_depth = 3);
+    // 屏幕共享按变化区域分配码率(仅NVIDIA/Intel硬编)，创建桌面采集前设置
+    static void SetScreenShareRoi(bool enable, bool detect_text = true);
+    static void SetKeyFrameConfig(const KRTCKeyFrameConfig& config);
+    // 时域分层(1~3层，L1T2/L1T3)，接收端或SFU可丢弃高层降帧率，推流前设置
+    static void SetVideoTemporalLayers(int layers);
+    // 提前建立到信令服务器的连接(DNS/TCP/TLS)，之后推拉流的信令请求直接复用，
+    // server_addr与CreatePusher/CreatePuller的相同，如https://charlescao92.cn:1986
+    static void PrewarmSignaling(const char* server_addr);
+    // 快速启动：预创建pool_size(1~4)个推流PeerConnection并提前收集ICE候选，
+    // Start()时直接取用，同时信令连接和offer创建并行进行
+    static void SetFastStart(bool enable, int pool_size = 1);
+    // 创建推拉流之前设置，默认SRS
+    static void SetSignalingProtocol(const SIGNALING_PROTOCOL& protocol);
+    // 摄像头/屏幕采集的降级策略，已创建的采集源立即生效，RtpSender在下一次推流时生效。
+    // 默认摄像头保帧率，屏幕保分辨率且内容提示为DETAIL
+    static void SetCameraSourceConfig(const KRTCVideoSourceConfig& config);
+    static void SetScreenSourceConfig(const KRTCVideoSourceConfig& config);
+    // 摄像头采集的分辨率、帧率和格式，CreateCameraSource之前设置
+    static void SetCameraCaptureConfig(const KRTCCameraCaptureConfig& config);
+    // 推流断线重连策略，下一次断线时生效
+    static void SetReconnectConfig(const KRTCReconnectConfig& config);
+    // 推流前设置，下一次创建PeerConnection时生效(快速启动池里已预创建的连接不受探测模式影响)
+    static void SetBitrateConfig(const KRTCBitrateConfig& config);
+    // 推流前设置，下一次推流协商时生效
+    static void SetAudioSendConfig(const KRTCAudioSendConfig& config);
+    // 视频的延迟上限和render_asap只作用于之后开始的拉流，每路拉流用开始时的配置
+    static void SetPullLatencyConfig(const KRTCPullLatencyConfig& config);
+    // 拉流收到视频轨时读取，之后开始的拉流生效，已在拉的流仍按原格式回调
+    static void SetPullVideoFormats(const KRTCPullVideoFormats& formats);
+    // 拉流音频混音，结果通过OnMixedAudioFrame回调，立即生效，已有的拉流也按新格式混音
+    static void SetAudioMixConfig(const KRTCAudioMixConfig& config);
+    // puller为CreatePuller的返回值，只影响混音结果
+    static void SetPullAudioGain(IMediaHandler* puller, float gain);
+    static void SetPullAudioMute(IMediaHandler* puller, bool mute);
+    // 麦克风采集数据默认由SDK的投递线程每10ms回调OnPureAudioFrame，
+    // 关闭后由应用调用ReadCapturedAudio拉取16bit交织PCM，返回读到的帧数，开启投递时返回-1。
+    // 不要在OnPureAudioFrame里切换
+    static void SetCapturedAudioDelivery(bool enable);
+    static int32_t ReadCapturedAudio(int16_t* buffer, int32_t frames);
+    static KRTCCapturedAudioStats GetCapturedAudioStats();
+    // 除stereo_capture在下一次启动麦克风时生效外立即生效
+    static void SetAudioProcessingConfig(const KRTCAudioProcessingConfig& config);
+
     static uint32_t GetCameraCount();
     static int32_t GetCameraInfo(int index, char *device_name, uint32_t device_name_length,
         char* device_id, uint32_t device_id_length);
@@ -112,15 +556,28 @@ public:
 
     static uint32_t GetScreenCount();
     static IVideoHandler* CreateScreenSource(const uint32_t& screen_index = 0);
+    // 把已创建的采集源合成为一路新的采集源，可以像摄像头一样预览和推流。
+    // 输入采集源要在合成源Start()之前创建并各自Start()，count最多KRTCCompositeConfig::kMaxInputs
+    static IVideoHandler* CreateCompositeSource(IVideoHandler* const* sources, int count,
+                                                const KRTCCompositeConfig& config);
    
     static int16_t GetMicCount();
     static int32_t GetMicInfo(int index, char* mic_name, uint32_t mic_name_length,
         char* mic_guid, uint32_t mic_guid_length);
     static IAudioHandler* CreateMicSource(const char* mic_id);
+    // sample_rate为100的整数倍(8000~48000)，channels为1或2，参数不支持时返回nullptr
+    static IExternalAudioSource* CreateExternalAudioSource(uint32_t sample_rate, uint32_t channels);
 
-    static IMediaHandler* CreatePreview(const unsigned int& hwnd = 0);
+    // video_source为CreateCameraSource/CreateScreenSource的返回值，不指定时使用最近创建的采集源。
+    // 同一个采集源可以同时绑定多个预览和推流，采集只做一次。
+    static IMediaHandler* CreatePreview(const unsigned int& hwnd = 0,
+                                        IVideoHandler* video_source = nullptr);
+    // audio_source为CreateExternalAudioSource的返回值，不指定时推麦克风，两者不要同时使用；
+    // 指定时推流期间不打开麦克风录音，所有指定了audio_source的推流都Stop后恢复
     static IMediaHandler* CreatePusher(const char* server_addr, 
-                                        const char* push_channel = "livestream");
+                                        const char* push_channel = "livestream",
+                                        IVideoHandler* video_source = nullptr,
+                                        IExternalAudioSource* audio_source = nullptr);
     static IMediaHandler* CreatePuller(const char* server_addr, 
                                         const char* pull_channel = "livestream",
                                         const unsigned int& hwnd = 0);
@@ -0,0 +1,117 @@
+#include "krtc/media/audio_mix_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <rtc_base/system/arch.h>
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#elif defined(WEBRTC_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace krtc {
+
+float AudioMeanSquare(const int16_t* src, size_t count) {
+    if (count == 0) {
+        return 0.0f;
+    }
+
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // 符号扩展到int32
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16));
+        acc = _mm_add_ps(acc, _mm_mul_ps(lo, lo));
+        acc = _mm_add_ps(acc, _mm_mul_ps(hi, hi));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(WEBRTC_ARCH_ARM64)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s16 = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+        acc = vfmaq_f32(acc, lo, lo);
+        acc = vfmaq_f32(acc, hi, hi);
+    }
+    sum = vaddvq_f32(acc);
+#endif
+    for (; i < count; i++) {
+        float sample = static_cast<float>(src[i]);
+        sum += sample * sample;
+    }
+    return sum / count;
+}
+
+void AudioMixWithRamp(const int16_t* src, size_t count, float gain_begin, float gain_end, float* acc) {
+    if (count == 0) {
+        return;
+    }
+
+    const float step = (gain_end - gain_begin) / count;
+    size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    __m128 gain = _mm_setr_ps(gain_begin, gain_begin + step, gain_begin + 2 * step, gain_begin + 3 * step);
+    const __m128 gain_step = _mm_set1_ps(4 * step);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(lo, gain)));
+        gain = _mm_add_ps(gain, gain_step);
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(hi, gain)));
+        gain = _mm_add_ps(gain, gain_step);
+    }
+#elif defined(WEBRTC_ARCH_ARM64)
+    const float initial[4] = { gain_begin, gain_begin + step, gain_begin + 2 * step, gain_begin + 3 * step };
+    float32x4_t gain = vld1q_f32(initial);
+    const float32x4_t gain_step = vdupq_n_f32(4 * step);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s16 = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+        vst1q_f32(acc + i, vfmaq_f32(vld1q_f32(acc + i), lo, gain));
+        gain = vaddq_f32(gain, gain_step);
+        vst1q_f32(acc + i + 4, vfmaq_f32(vld1q_f32(acc + i + 4), hi, gain));
+        gain = vaddq_f32(gain, gain_step);
+    }
+#endif
+    for (; i < count; i++) {
+        acc[i] += src[i] * (gain_begin + step * i);
+    }
+}
+
+void AudioFloatToS16(const float* src, size_t count, int16_t* dst) {
+    size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    // 先钳位，超出int32范围的值转换后会变成0x80000000
+    const __m128 max_value = _mm_set1_ps(32767.0f);
+    const __m128 min_value = _mm_set1_ps(-32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), min_value), max_value);
+        __m128 hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), min_value), max_value);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+#elif defined(WEBRTC_ARCH_ARM64)
+    for (; i + 8 <= count; i += 8) {
+        int32x4_t lo = vcvtnq_s32_f32(vld1q_f32(src + i));
+        int32x4_t hi = vcvtnq_s32_f32(vld1q_f32(src + i + 4));
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#endif
+    for (; i < count; i++) {
+        float sample = std::min(std::max(src[i], -32768.0f), 32767.0f);
+        dst[i] = static_cast<int16_t>(std::lrint(sample));
+    }
+}
+
+} // namespace krtc
@@ -0,0 +1,22 @@
+#ifndef KRTCSDK_KRTC_MEDIA_AUDIO_MIX_KERNELS_H_
+#define KRTCSDK_KRTC_MEDIA_AUDIO_MIX_KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace krtc {
+
+// 混音用的内层循环，x86走SSE2、arm64走NEON，其余平台和尾部样本用标量实现
+
+// 样本平方的均值，用于比较各路的活跃程度
+float AudioMeanSquare(const int16_t* src, size_t count);
+
+// acc[i] += src[i] * gain，gain在这一帧内从gain_begin线性过渡到gain_end，避免增益突变产生爆音
+void AudioMixWithRamp(const int16_t* src, size_t count, float gain_begin, float gain_end, float* acc);
+
+// 四舍五入并饱和到int16
+void AudioFloatToS16(const float* src, size_t count, int16_t* dst);
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_AUDIO_MIX_KERNELS_H_
@@ -0,0 +1,227 @@
+#include "krtc/media/audio_send_config.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/match.h>
+#include <api/audio_codecs/builtin_audio_encoder_factory.h>
+#include <api/audio_codecs/opus/audio_encoder_opus.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+namespace {
+
+using FmtpParams = std::vector<std::pair<std::string, std::string>>;
+
+FmtpParams ParseFmtp(const std::string& value) {
+    FmtpParams params;
+    std::vector<std::string> items;
+    rtc::split(value, ';', &items);
+    for (auto& item : items) {
+        std::string key, param;
+        if (!rtc::tokenize_first(item, '=', &key, &param)) {
+            key = item;
+        }
+        key.erase(0, key.find_first_not_of(' '));
+        if (!key.empty()) {
+            params.push_back({ key, param });
+        }
+    }
+    return params;
+}
+
+void SetFmtpParam(FmtpParams* params, const std::string& key, const std::string& value) {
+    for (auto& param : *params) {
+        if (param.first == key) {
+            param.second = value;
+            return;
+        }
+    }
+    params->push_back({ key, value });
+}
+
+// 改写每个audio段里opus的fmtp，没有fmtp行时加在rtpmap后面
+std::string MungeOpusFmtp(const std::string& sdp, const std::map<std::string, std::string>& values) {
+    std::vector<std::string> lines;
+    rtc::split(sdp, '\n', &lines);
+    for (auto& line : lines) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+    }
+
+    // 段序号 -> opus的payload type
+    std::map<int, std::string> opus_payload_types;
+    int section = -1;
+    bool audio = false;
+    for (auto& line : lines) {
+        if (absl::StartsWith(line, "m=")) {
+            ++section;
+            audio = absl::StartsWith(line, "m=audio");
+        }
+        else if (audio && absl::StartsWith(line, "a=rtpmap:")) {
+            std::string payload_type, encoding;
+            if (rtc::tokenize_first(line.substr(9), ' ', &payload_type, &encoding) &&
+                absl::StartsWithIgnoreCase(encoding, "opus/"))
+            {
+                opus_payload_types.emplace(section, payload_type);
+            }
+        }
+    }
+    if (opus_payload_types.empty()) {
+        return sdp;
+    }
+
+    std::string result;
+    std::string pending_rtpmap;
+    section = -1;
+    auto build_fmtp = [&values](const std::string& payload_type, const std::string& params_value) {
+        FmtpParams params = ParseFmtp(params_value);
+        for (auto& value : values) {
+            SetFmtpParam(&params, value.first, value.second);
+        }
+        std::string line = "a=fmtp:" + payload_type + " ";
+        for (size_t i = 0; i < params.size(); i++) {
+            line += (i ? ";" : "") + params[i].first;
+            if (!params[i].second.empty()) {
+                line += "=" + params[i].second;
+            }
+        }
+        return line;
+    };
+    // 上一段的opus没有fmtp行
+    auto flush_pending = [&]() {
+        if (!pending_rtpmap.empty()) {
+            result += build_fmtp(pending_rtpmap, "") + "\r\n";
+            pending_rtpmap.clear();
+        }
+    };
+
+    for (auto& line : lines) {
+        if (line.empty()) {
+            continue;
+        }
+        if (absl::StartsWith(line, "m=")) {
+            flush_pending();
+            ++section;
+        }
+
+        auto iter = opus_payload_types.find(section);
+        if (iter == opus_payload_types.end()) {
+            result += line + "\r\n";
+            continue;
+        }
+
+        const std::string& payload_type = iter->second;
+        if (absl::StartsWith(line, "a=rtpmap:" + payload_type + " ")) {
+            pending_rtpmap = payload_type;
+            result += line + "\r\n";
+            continue;
+        }
+        if (absl::StartsWith(line, "a=fmtp:" + payload_type + " ")) {
+            pending_rtpmap.clear();
+            result += build_fmtp(payload_type, line.substr(8 + payload_type.size())) + "\r\n";
+            continue;
+        }
+        if (!pending_rtpmap.empty() && !absl::StartsWith(line, "a=rtcp-fb:")) {
+            flush_pending();
+        }
+        result += line + "\r\n";
+    }
+    flush_pending();
+    return result;
+}
+
+class TunedAudioEncoderFactory : public webrtc::AudioEncoderFactory {
+public:
+    TunedAudioEncoderFactory() : builtin_(webrtc::CreateBuiltinAudioEncoderFactory()) {}
+
+    std::vector<webrtc::AudioCodecSpec> GetSupportedEncoders() override {
+        return builtin_->GetSupportedEncoders();
+    }
+
+    absl::optional<webrtc::AudioCodecInfo> QueryAudioEncoder(const webrtc::SdpAudioFormat& format) override {
+        return builtin_->QueryAudioEncoder(format);
+    }
+
+    std::unique_ptr<webrtc::AudioEncoder> MakeAudioEncoder(int payload_type,
+        const webrtc::SdpAudioFormat& format,
+        absl::optional<webrtc::AudioCodecPairId> codec_pair_id) override
+    {
+        if (absl::EqualsIgnoreCase(format.name, "opus")) {
+            absl::optional<webrtc::AudioEncoderOpusConfig> opus_config = webrtc::AudioEncoderOpus::SdpToConfig(format);
+            if (opus_config) {
+                KRTCAudioSendConfig config = KRTCGlobal::Instance()->audio_send_config();
+                opus_config->application = config.application == OPUS_APPLICATION::AUDIO ?
+                    webrtc::AudioEncoderOpusConfig::ApplicationMode::kAudio :
+                    webrtc::AudioEncoderOpusConfig::ApplicationMode::kVoip;
+                if (config.complexity >= 0) {
+                    opus_config->complexity = std::min(config.complexity, 10);
+                    opus_config->low_rate_complexity = opus_config->complexity;
+                }
+                if (opus_config->IsOk()) {
+                    RTC_LOG(LS_INFO) << "opus encoder, channels: " << opus_config->num_channels
+                        << ", frame_size_ms: " << opus_config->frame_size_ms
+                        << ", fec: " << opus_config->fec_enabled
+                        << ", dtx: " << opus_config->dtx_enabled
+                        << ", complexity: " << opus_config->complexity;
+                    return webrtc::AudioEncoderOpus::MakeAudioEncoder(*opus_config, payload_type, codec_pair_id);
+                }
+                RTC_LOG(LS_WARNING) << "invalid opus config, fall back to the builtin encoder";
+            }
+        }
+        return builtin_->MakeAudioEncoder(payload_type, format, codec_pair_id);
+    }
+
+private:
+    rtc::scoped_refptr<webrtc::AudioEncoderFactory> builtin_;
+};
+
+} // namespace
+
+std::string MungeOpusOffer(const std::string& sdp, const KRTCAudioSendConfig& config) {
+    if (!config.stereo) {
+        return sdp;
+    }
+    // 告诉服务端我们发送立体声
+    return MungeOpusFmtp(sdp, { { "stereo", "1" }, { "sprop-stereo", "1" } });
+}
+
+std::string MungeOpusAnswer(const std::string& sdp, const KRTCAudioSendConfig& config) {
+    std::map<std::string, std::string> values = {
+        { "stereo", config.stereo ? "1" : "0" },
+        { "sprop-stereo", config.stereo ? "1" : "0" },
+        { "useinbandfec", config.fec ? "1" : "0" },
+        { "usedtx", config.dtx ? "1" : "0" },
+    };
+
+    const uint32_t ptimes[] = { 10, 20, 40, 60 };
+    if (std::find(std::begin(ptimes), std::end(ptimes), config.ptime_ms) != std::end(ptimes)) {
+        values["ptime"] = std::to_string(config.ptime_ms);
+        if (config.ptime_ms < 20) {
+            values["minptime"] = std::to_string(config.ptime_ms);
+        }
+    }
+    else {
+        RTC_LOG(LS_WARNING) << "unsupported opus ptime " << config.ptime_ms << "ms, keep default";
+    }
+
+    if (config.bitrate_bps > 0) {
+        // Opus支持6-510kbps
+        values["maxaveragebitrate"] = std::to_string(std::min(std::max(config.bitrate_bps, 6000u), 510000u));
+    }
+    return MungeOpusFmtp(sdp, values);
+}
+
+rtc::scoped_refptr<webrtc::AudioEncoderFactory> CreateTunedAudioEncoderFactory() {
+    return rtc::make_ref_counted<TunedAudioEncoderFactory>();
+}
+
+} // namespace krtc
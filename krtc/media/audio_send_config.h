@@ -0,0 +1,24 @@
+#ifndef KRTCSDK_KRTC_MEDIA_AUDIO_SEND_CONFIG_H_
+#define KRTCSDK_KRTC_MEDIA_AUDIO_SEND_CONFIG_H_
+
+#include <string>
+
+#include <api/audio_codecs/audio_encoder_factory.h>
+#include <api/scoped_refptr.h>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 推流的Opus参数通过SDP协商：发给服务端的offer声明sprop-stereo，
+// 本地使用的answer改写opus的fmtp，webrtc按answer创建编码器。
+std::string MungeOpusOffer(const std::string& sdp, const KRTCAudioSendConfig& config);
+std::string MungeOpusAnswer(const std::string& sdp, const KRTCAudioSendConfig& config);
+
+// SDP里没有对应参数的application和complexity在创建Opus编码器时设置，
+// 其余编码器交给webrtc内置的工厂
+rtc::scoped_refptr<webrtc::AudioEncoderFactory> CreateTunedAudioEncoderFactory();
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_AUDIO_SEND_CONFIG_H_
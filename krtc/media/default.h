@@ -6,6 +6,8 @@
 #include <rtc_base/logging.h>
 #include <api/make_ref_counted.h>
 
+#include <functional>
+
 const char kAudioLabel[] = "audio_label";
 const char kVideoLabel[] = "video_label";
 const char kStreamId[] = "stream_id";
@@ -23,4 +25,26 @@ public:
     }
 };
 
+// 设置完成后回调，用于需要知道SetLocal/RemoteDescription何时完成的地方
+class CallbackSetSessionDescriptionObserver
+    : public webrtc::SetSessionDescriptionObserver {
+public:
+    static rtc::scoped_refptr<CallbackSetSessionDescriptionObserver> Create(
+        std::function<void(webrtc::RTCError)> callback) {
+        return rtc::make_ref_counted<CallbackSetSessionDescriptionObserver>(std::move(callback));
+    }
+    explicit CallbackSetSessionDescriptionObserver(std::function<void(webrtc::RTCError)> callback)
+        : callback_(std::move(callback)) {}
+
+    virtual void OnSuccess() { callback_(webrtc::RTCError::OK()); }
+    virtual void OnFailure(webrtc::RTCError error) {
+        RTC_LOG(LS_INFO) << __FUNCTION__ << " " << ToString(error.type()) << ": "
+            << error.message();
+        callback_(std::move(error));
+    }
+
+private:
+    std::function<void(webrtc::RTCError)> callback_;
+};
+
 #endif // KRTCSDK_KRTC_MEDIA_BASE_DEFAULT_H_
\ No newline at end of file
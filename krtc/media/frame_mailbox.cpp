@@ -0,0 +1,41 @@
+#include "krtc/media/frame_mailbox.h"
+
+namespace krtc {
+
+void FrameMailbox::SetEnabled(bool enable) {
+    enabled_.store(enable, std::memory_order_relaxed);
+}
+
+void FrameMailbox::Publish(std::shared_ptr<MediaFrame> frame) {
+    slots_[back_] = std::move(frame);
+    uint32_t previous = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    back_ = previous & kIndexMask;
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (previous & kFresh) {
+        // 上一帧还没被渲染就被覆盖了
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 换回来的槽位要么是被覆盖的帧，要么已经被取走，尽早释放帧缓冲
+    slots_[back_].reset();
+}
+
+std::shared_ptr<MediaFrame> FrameMailbox::Acquire() {
+    // 只有消费者会清掉kFresh，检查之后不会变成旧帧
+    if (!(middle_.load(std::memory_order_acquire) & kFresh)) {
+        return nullptr;
+    }
+    uint32_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = previous & kIndexMask;
+    acquired_.fetch_add(1, std::memory_order_relaxed);
+    return std::move(slots_[front_]);
+}
+
+KRTCFrameMailboxStats FrameMailbox::stats() const {
+    KRTCFrameMailboxStats stats;
+    stats.frames_published = published_.load(std::memory_order_relaxed);
+    stats.frames_acquired = acquired_.load(std::memory_order_relaxed);
+    stats.frames_dropped_before_render = dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace krtc
@@ -0,0 +1,47 @@
+#ifndef KRTCSDK_KRTC_MEDIA_FRAME_MAILBOX_H_
+#define KRTCSDK_KRTC_MEDIA_FRAME_MAILBOX_H_
+
+#include <atomic>
+#include <memory>
+
+#include "krtc/krtc.h"
+#include "krtc/media/media_frame.h"
+
+namespace krtc {
+
+// 只保留最新一帧的三缓冲信箱，无锁。
+// 解码/采集线程Publish，渲染线程按自己的节奏Acquire，渲染前被新帧覆盖的帧直接释放，不做拷贝。
+// 只支持一个生产者和一个消费者。
+class FrameMailbox {
+public:
+    FrameMailbox() = default;
+
+    void SetEnabled(bool enable);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void Publish(std::shared_ptr<MediaFrame> frame);
+    // 上次取走之后没有新帧时返回nullptr
+    std::shared_ptr<MediaFrame> Acquire();
+
+    KRTCFrameMailboxStats stats() const;
+
+private:
+    // middle_的低2位为槽位序号，这一位表示其中是还没被取走的新帧
+    static const uint32_t kFresh = 0x4;
+    static const uint32_t kIndexMask = 0x3;
+
+    std::shared_ptr<MediaFrame> slots_[3];
+    // 生产者和消费者通过交换middle_交接槽位，back_/front_各自独占
+    std::atomic<uint32_t> middle_{ 1 };
+    uint32_t back_ = 0;
+    uint32_t front_ = 2;
+
+    std::atomic<bool> enabled_{ false };
+    std::atomic<uint64_t> published_{ 0 };
+    std::atomic<uint64_t> acquired_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_FRAME_MAILBOX_H_
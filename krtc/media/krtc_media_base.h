@@ -1,12 +1,15 @@
 #ifndef KRTCSDK_KRTC_MEDIA_KRTC_MEDIA_BASE_H_
 #define KRTCSDK_KRTC_MEDIA_KRTC_MEDIA_BASE_H_
 
+#include <memory>
 #include <string>
 
 #include <api/peer_connection_interface.h>
 
 #include "krtc/krtc.h"
 #include "krtc/tools/utils.h"
+#include "krtc/base/krtc_http.h"
+#include "krtc/media/signaling.h"
 
 namespace krtc {
 
@@ -16,7 +19,7 @@ public:
 		const std::string& server_addr, 
 		const std::string& channel = "", 
 		const int& hwnd = 0);  // 拉流相关，内部渲染则传入窗口句柄，也可以自己实现获取裸流来渲染显示
-	virtual ~KRTCMediaBase() = default;
+	virtual ~KRTCMediaBase();
 
 	virtual void Start() = 0;
 	virtual void Stop() = 0;
@@ -24,9 +27,9 @@ public:
 protected:
 	rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection_;
 
-	std::string httpRequestUrl_;
-	std::string webrtcStreamUrl_;
-	std::string channel_ = "livestream";
+	// 信令的HTTP回调只在该句柄存活时执行
+	HttpObjectHandle http_handle_ = kInvalidHttpObjectHandle;
+	std::unique_ptr<Signaling> signaling_;
 	int hwnd_ = 0;
 };
 
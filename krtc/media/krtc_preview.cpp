@@ -10,12 +10,15 @@
 #include "krtc/device/vcm_capturer.h"
 #include "krtc/device/desktop_capturer.h"
 #include "krtc/media/media_frame.h"
+#include "krtc/media/frame_mailbox.h"
 
 namespace krtc {
 
-KRTCPreview::KRTCPreview(const int& hwnd):
+KRTCPreview::KRTCPreview(const int& hwnd, VideoSourceId video_source_id):
     hwnd_(hwnd),
-    current_thread_(std::make_unique<KRTCThread>(rtc::Thread::Current()))
+    video_source_id_(video_source_id),
+    current_thread_(std::make_unique<KRTCThread>(rtc::Thread::Current())),
+    frame_mailbox_(std::make_shared<FrameMailbox>())
 {
 }
 
@@ -28,13 +31,13 @@ void KRTCPreview::Start() {
         RTC_LOG(LS_INFO) << "KRTCPreview Start PostTask";
 
         KRTCError err = KRTCError::kNoErr;
+        video_source_ = KRTCGlobal::Instance()->video_source_registry()->Get(video_source_id_);
 
         if (hwnd_ != 0) {
             local_renderer_ = VideoRenderer::Create(CONTROL_TYPE::PUSH, hwnd_, 1, 1);
             if (local_renderer_) {
-                webrtc::VideoTrackSource* video_source = KRTCGlobal::Instance()->current_video_source();
-                if (video_source) {
-                    video_source->AddOrUpdateSink(local_renderer_.get(), rtc::VideoSinkWants());
+                if (video_source_) {
+                    video_source_->AddOrUpdateSink(local_renderer_.get(), rtc::VideoSinkWants());
                 }
                 else {
                     err = KRTCError::kPreviewNoVideoSourceErr;
@@ -46,9 +49,8 @@ void KRTCPreview::Start() {
             }
         }
         else {
-            webrtc::VideoTrackSource* video_source = KRTCGlobal::Instance()->current_video_source();
-            if (video_source) {
-                video_source->AddOrUpdateSink(this, rtc::VideoSinkWants());
+            if (video_source_) {
+                video_source_->AddOrUpdateSink(this, rtc::VideoSinkWants());
             }
 
             KRTCGlobal::Instance()->SetPreview(true);
@@ -72,24 +74,53 @@ void KRTCPreview::Stop() {
 
         KRTCGlobal::Instance()->SetPreview(false);
 
-        webrtc::VideoTrackSource* video_source = KRTCGlobal::Instance()->current_video_source();
-        if (!video_source) {
+        if (!video_source_) {
             return;
         }
 
         if (local_renderer_) {
-            video_source->RemoveSink(local_renderer_.get());
+            video_source_->RemoveSink(local_renderer_.get());
         }
         else {
-            video_source->RemoveSink(this);
+            video_source_->RemoveSink(this);
         }
+        video_source_ = nullptr;
 
     });
 }
 
 void KRTCPreview::Destroy() {}
 
+void KRTCPreview::SetFrameMailbox(bool enable) {
+    frame_mailbox_->SetEnabled(enable);
+}
+
+std::shared_ptr<MediaFrame> KRTCPreview::AcquireLatestFrame() {
+    return frame_mailbox_->Acquire();
+}
+
+KRTCFrameMailboxStats KRTCPreview::GetFrameMailboxStats() {
+    return frame_mailbox_->stats();
+}
+
 void KRTCPreview::OnFrame(const webrtc::VideoFrame& frame){
+    if (frame_mailbox_->enabled()) {
+        // 信箱模式下直接持有采集的帧缓冲，由应用在渲染时取最新一帧
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> vfb = frame.video_frame_buffer();
+        if (vfb && vfb->type() != webrtc::VideoFrameBuffer::Type::kI420 &&
+            vfb->type() != webrtc::VideoFrameBuffer::Type::kNV12)
+        {
+            vfb = vfb->ToI420();
+        }
+        if (vfb) {
+            std::shared_ptr<MediaFrame> media_frame = WrapVideoFrameBuffer(vfb, frame.timestamp());
+            if (media_frame) {
+                frame_mailbox_->Publish(std::move(media_frame));
+            }
+        }
+        return;
+    }
+
     if (KRTCGlobal::Instance()->engine_observer()) {
         try {
             rtc::scoped_refptr<webrtc::VideoFrameBuffer> vfb = frame.video_frame_buffer();
@@ -2,6 +2,7 @@
 #define KRTCSDK_KRTC_MEDIA_KRTC_PREVIEW_H_
 
 #include "krtc/krtc.h"
+#include "krtc/device/video_source_registry.h"
 
 #include <api/media_stream_interface.h>
 
@@ -9,11 +10,12 @@ namespace krtc {
 
 class KRTCThread;
 class VideoRenderer;
+class FrameMailbox;
 
 class KRTCPreview : public IMediaHandler,
 					public rtc::VideoSinkInterface<webrtc::VideoFrame> {
 public:
-	explicit KRTCPreview(const int& hwnd = 0);
+	explicit KRTCPreview(const int& hwnd = 0, VideoSourceId video_source_id = kDefaultVideoSource);
 	~KRTCPreview();
 
 public:
@@ -23,6 +25,10 @@ public:
 	void SetEnableVideo(bool enable) {}
 	void SetEnableAudio(bool enable) {}
 
+	void SetFrameMailbox(bool enable) override;
+	std::shared_ptr<MediaFrame> AcquireLatestFrame() override;
+	KRTCFrameMailboxStats GetFrameMailboxStats() override;
+
 private:
 	void OnFrame(const webrtc::VideoFrame& frame) override;
 
@@ -30,6 +36,10 @@ private:
 	std::unique_ptr<KRTCThread> current_thread_;
 	std::unique_ptr<VideoRenderer> local_renderer_;
 	int hwnd_;
+	VideoSourceId video_source_id_;
+	// Start()时绑定的采集源，Stop()从同一个源上移除
+	rtc::scoped_refptr<CapturerTrackSource> video_source_;
+	std::shared_ptr<FrameMailbox> frame_mailbox_;
 };
 
 }
@@ -33,37 +33,38 @@
 
 #include "krtc/media/default.h"
 #include "krtc/media/krtc_pull_impl.h"
+#include "krtc/media/pull_audio_mixer.h"
+#include "krtc/media/frame_mailbox.h"
 #include "krtc/base/krtc_global.h"
+#include "krtc/base/field_trials.h"
+#include "krtc/tools/timer.h"
 
 namespace krtc {
 
-void CRtcStatsCollector1::OnStatsDelivered(
-    const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
-    Json::Reader reader;
-
-    for (auto it = report->begin(); it != report->end(); ++it) {
-        // "type" : "inbound-rtp"
-        Json::Value jmessage;
-        if (!reader.parse(it->ToJson(), jmessage)) {
-            RTC_LOG(LS_WARNING) << "stats report invalid!!!";
-            return;
-        }
-
-        std::string type = jmessage["type"].asString();
-        if (type == "inbound-rtp") {
+namespace {
 
-            RTC_LOG(LS_INFO) << "Stats report : " << it->ToJson();
-        }
+// 两次统计之间每帧/每个采样在jitter buffer里的平均等待时间
+uint32_t AverageDelayMs(double delay, uint64_t emitted_count, double last_delay, uint64_t last_emitted_count) {
+    if (emitted_count <= last_emitted_count || delay < last_delay) {
+        return 0;
     }
+    return static_cast<uint32_t>((delay - last_delay) * 1000 / (emitted_count - last_emitted_count));
 }
 
+} // namespace
+
 KRTCPullImpl::KRTCPullImpl(
     const std::string& server_addr,
     const std::string& pull_channel,
-    const int& hwnd) :
-    KRTCMediaBase(CONTROL_TYPE::PULL, server_addr, pull_channel, hwnd)
+    const int& hwnd,
+    uint32_t mix_stream_id,
+    IMediaHandler* owner,
+    std::shared_ptr<FrameMailbox> frame_mailbox) :
+    KRTCMediaBase(CONTROL_TYPE::PULL, server_addr, pull_channel, hwnd),
+    mix_stream_id_(mix_stream_id),
+    owner_(owner),
+    frame_mailbox_(std::move(frame_mailbox))
 {
-    KRTCGlobal::Instance()->http_manager()->AddObject(this);
 }
 
 KRTCPullImpl::~KRTCPullImpl() {
@@ -73,16 +74,23 @@ KRTCPullImpl::~KRTCPullImpl() {
 void KRTCPullImpl::Start() {
     RTC_LOG(LS_INFO) << "KRTCPullImpl Start";
 
-    peer_connection_factory_ = webrtc::CreatePeerConnectionFactory(
+    latency_config_ = KRTCGlobal::Instance()->pull_latency_config();
+    last_video_counters_ = JitterBufferCounters();
+    last_audio_counters_ = JitterBufferCounters();
+
+    // 播放延迟只作用于这一路拉流的factory，不影响其他拉流和推流
+    std::string trials = PullFieldTrials(latency_config_);
+    peer_connection_factory_ = CreatePeerConnectionFactoryWithTrials(
         KRTCGlobal::Instance()->network_thread() /* network_thread */,
         KRTCGlobal::Instance()->worker_thread() /* worker_thread */,
         KRTCGlobal::Instance()->api_thread() /* signaling_thread */,
-        nullptr /* default_adm */,
+        KRTCGlobal::Instance()->CreatePullAudioDevice() /* default_adm */,
         webrtc::CreateBuiltinAudioEncoderFactory(),
         webrtc::CreateBuiltinAudioDecoderFactory(),
         webrtc::CreateBuiltinVideoEncoderFactory(),
-        webrtc::CreateBuiltinVideoDecoderFactory(), nullptr /* audio_mixer */,
-        nullptr /* audio_processing */);
+        webrtc::CreateBuiltinVideoDecoderFactory(),
+        nullptr /* audio_processing */,
+        std::make_unique<KRTCFieldTrials>([trials]() { return trials; }));
 
     webrtc::PeerConnectionInterface::RTCConfiguration config;
     config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
@@ -105,15 +113,95 @@ void KRTCPullImpl::Start() {
 void KRTCPullImpl::Stop() {
     RTC_LOG(LS_INFO) << "KRTCPullImpl Stop";
 
+    if (stats_timer_) {
+        stats_timer_->Stop();
+        stats_timer_ = nullptr;
+    }
+
+    KRTCGlobal::Instance()->pull_audio_mixer()->DetachTrack(mix_stream_id_);
+
     peer_connection_ = nullptr;
     peer_connection_factory_ = nullptr;
     remote_renderer_ = nullptr;
+
+    signaling_->Stop();
 }
 
 void KRTCPullImpl::GetRtcStats() {
-    rtc::scoped_refptr<CRtcStatsCollector1> stats(
-        new rtc::RefCountedObject<CRtcStatsCollector1>());
-    peer_connection_->GetStats(stats.get());
+    KRTCGlobal::Instance()->api_thread()->PostTask([=]() {
+        if (!stats_) {
+            stats_ = new rtc::RefCountedObject<CRtcStatsCollector>(this);
+        }
+        if (peer_connection_) {
+            peer_connection_->GetStats(stats_.get());
+        }
+    });
+}
+
+void KRTCPullImpl::OnStatsInfo(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
+    Json::Reader reader;
+
+    KRTCPullStats stats;
+    JitterBufferCounters video_counters;
+    JitterBufferCounters audio_counters;
+    for (auto it = report->begin(); it != report->end(); ++it) {
+        Json::Value jmessage;
+        if (!reader.parse(it->ToJson(), jmessage)) {
+            RTC_LOG(LS_WARNING) << "stats report invalid!!!";
+            return;
+        }
+
+        if (jmessage["type"].asString() != "inbound-rtp") {
+            continue;
+        }
+
+        JitterBufferCounters counters;
+        counters.delay = jmessage["jitterBufferDelay"].asDouble();
+        counters.target_delay = jmessage["jitterBufferTargetDelay"].asDouble();
+        counters.emitted_count = jmessage["jitterBufferEmittedCount"].asUInt64();
+        if (jmessage["kind"].asString() == "video") {
+            video_counters = counters;
+            stats.frames_decoded = jmessage["framesDecoded"].asUInt();
+            stats.frames_dropped = jmessage["framesDropped"].asUInt();
+            stats.freeze_count = jmessage["freezeCount"].asUInt();
+        }
+        else {
+            audio_counters = counters;
+            stats.concealment_events = jmessage["concealmentEvents"].asUInt64();
+            stats.concealed_samples = jmessage["concealedSamples"].asUInt64();
+            stats.total_samples_received = jmessage["totalSamplesReceived"].asUInt64();
+        }
+    }
+
+    stats.video_jitter_buffer_delay_ms = AverageDelayMs(video_counters.delay, video_counters.emitted_count,
+        last_video_counters_.delay, last_video_counters_.emitted_count);
+    stats.video_jitter_buffer_target_delay_ms = AverageDelayMs(video_counters.target_delay,
+        video_counters.emitted_count, last_video_counters_.target_delay, last_video_counters_.emitted_count);
+    stats.audio_jitter_buffer_delay_ms = AverageDelayMs(audio_counters.delay, audio_counters.emitted_count,
+        last_audio_counters_.delay, last_audio_counters_.emitted_count);
+    stats.audio_jitter_buffer_target_delay_ms = AverageDelayMs(audio_counters.target_delay,
+        audio_counters.emitted_count, last_audio_counters_.target_delay, last_audio_counters_.emitted_count);
+    if (remote_renderer_) {
+        VideoRenderer::DeliveryStats delivery = remote_renderer_->delivery_stats();
+        stats.frames_delivered = delivery.frames;
+        stats.frame_conversions = delivery.conversions;
+
+        VideoRenderer::RenderStats render = remote_renderer_->render_stats();
+        stats.frames_rendered = render.frames;
+        if (render.frames > last_render_stats_.frames) {
+            stats.render_upload_avg_us = static_cast<uint32_t>((render.upload_us_total - last_render_stats_.upload_us_total) /
+                (render.frames - last_render_stats_.frames));
+        }
+        stats.render_upload_max_us = static_cast<uint32_t>(render.upload_us_max);
+        last_render_stats_ = render;
+    }
+    stats.frames_dropped_before_render = frame_mailbox_->stats().frames_dropped_before_render;
+    last_video_counters_ = video_counters;
+    last_audio_counters_ = audio_counters;
+
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnPullStats(owner_, stats);
+    }
 }
 
 // PeerConnectionObserver implementation.
@@ -128,12 +216,29 @@ void KRTCPullImpl::OnAddTrack(
     auto* track = reinterpret_cast<webrtc::MediaStreamTrackInterface*>(
         receiver->track().release());
 
+    // jitter buffer的最小延迟，视频render_asap时为0
+    int32_t min_delay_ms = -1;
+    if (track->kind() == webrtc::MediaStreamTrackInterface::kVideoKind) {
+        min_delay_ms = latency_config_.render_asap ? 0 : latency_config_.min_playout_delay_ms;
+    }
+    else if (track->kind() == webrtc::MediaStreamTrackInterface::kAudioKind) {
+        min_delay_ms = latency_config_.audio_target_delay_ms;
+    }
+    if (min_delay_ms >= 0) {
+        receiver->SetJitterBufferMinimumDelay(min_delay_ms / 1000.0);
+    }
+
     if (track->kind() == webrtc::MediaStreamTrackInterface::kVideoKind) {
         auto* video_track = static_cast<webrtc::VideoTrackInterface*>(track);
 
-        remote_renderer_ = VideoRenderer::Create(CONTROL_TYPE::PULL, hwnd_, 1, 1);
+        remote_renderer_ = VideoRenderer::Create(CONTROL_TYPE::PULL, hwnd_, 1, 1, frame_mailbox_);
         video_track->AddOrUpdateSink(remote_renderer_.get(), rtc::VideoSinkWants());
     }
+    else if (track->kind() == webrtc::MediaStreamTrackInterface::kAudioKind) {
+        auto* audio_track = static_cast<webrtc::AudioTrackInterface*>(track);
+        KRTCGlobal::Instance()->pull_audio_mixer()->AttachTrack(mix_stream_id_,
+            rtc::scoped_refptr<webrtc::AudioTrackInterface>(audio_track));
+    }
 
     track->Release();
 }
@@ -148,6 +253,13 @@ void KRTCPullImpl::OnDataChannel(
 
 void KRTCPullImpl::OnIceGatheringChange(
     webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+    if (new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+        signaling_->OnGatheringComplete();
+    }
+}
+
+void KRTCPullImpl::OnIceCandidate(const webrtc::IceCandidateInterface* candidate) {
+    signaling_->SendCandidate(candidate);
 }
 
 // CreateSessionDescriptionObserver implementation.
@@ -160,25 +272,11 @@ void KRTCPullImpl::OnSuccess(webrtc::SessionDescriptionInterface* desc) {
     desc->ToString(&sdpOffer);
     RTC_LOG(LS_INFO) << "sdp Offer:" << sdpOffer;
 
-    Json::Value reqMsg;
-    reqMsg["api"] = httpRequestUrl_;
-    reqMsg["streamurl"] = webrtcStreamUrl_;
-    reqMsg["sdp"] = sdpOffer;
-    reqMsg["tid"] = rtc::CreateRandomString(7);
-    Json::StreamWriterBuilder write_builder;
-    write_builder.settings_["indentation"] = "";
-    std::string json_data = Json::writeString(write_builder, reqMsg);
-
     RTC_LOG(LS_INFO) << "send webrtc pull request.....";
 
-    HttpRequest request(httpRequestUrl_, json_data);
-    KRTCGlobal::Instance()->http_manager()->Post(request, [=](HttpReply reply) {
-
-        KRTCGlobal::Instance()->api_thread()->PostTask([=]() {
-            handleHttpPullResponse(reply);
-        });
-
-    }, this);
+    signaling_->SendOffer(sdpOffer, [this](KRTCError err, const std::string& answer) {
+        handlePullAnswer(err, answer);
+    });
 }
 
 void KRTCPullImpl::OnFailure(webrtc::RTCError error) {
@@ -187,46 +285,15 @@ void KRTCPullImpl::OnFailure(webrtc::RTCError error) {
     }
 }
 
-void KRTCPullImpl::handleHttpPullResponse(const HttpReply &reply)
+void KRTCPullImpl::handlePullAnswer(KRTCError err, const std::string& sdpAnswer)
 {
-    if (reply.get_status_code() != 200 || reply.get_errno() != 0) {
-        RTC_LOG(LS_INFO) << "http post error";
-
+    if (err != KRTCError::kNoErr) {
         if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPullFailed(KRTCError::kSendOfferErr);
+            KRTCGlobal::Instance()->engine_observer()->OnPullFailed(err);
         }
         return;
     }
 
-    std::string responseBody = reply.get_resp();
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-    Json::Value root;
-    JSONCPP_STRING err;
-    reader->parse(responseBody.data(), responseBody.data() + responseBody.size(), &root, &err);
-    if (!err.empty()) {
-        RTC_LOG(LS_WARNING) << "Received unknown message. " << responseBody;
-
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPullFailed(KRTCError::kParseAnswerErr);
-        }
-        return;
-    }
-
-    RTC_LOG(LS_INFO) << "http pull response : " << responseBody;
-
-    int code = root["code"].asInt();
-    if (code != 0) {
-        RTC_LOG(LS_INFO) << "http pull response error, code: " << code;
-
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPullFailed(KRTCError::kAnswerResponseErr);
-        }
-        return;
-    }
-
-    std::string sdpAnswer = root["sdp"].asString();
-
     webrtc::SdpParseError error;
     webrtc::SdpType type = webrtc::SdpType::kAnswer;
     std::unique_ptr<webrtc::SessionDescriptionInterface> session_description =
@@ -239,6 +306,13 @@ void KRTCPullImpl::handleHttpPullResponse(const HttpReply &reply)
     if (KRTCGlobal::Instance()->engine_observer()) {
         KRTCGlobal::Instance()->engine_observer()->OnPullSuccess();
     }
+
+    if (!stats_timer_) {
+        stats_timer_ = std::make_unique<CTimer>(1 * 1000, true, [this]() {
+            GetRtcStats();
+        });
+        stats_timer_->Start();
+    }
 }
 
 }  // namespace krtc
@@ -13,24 +13,27 @@
 #include "krtc/tools/utils.h"
 #include "krtc/render/video_renderer.h"
 #include "krtc/media/krtc_media_base.h"
+#include "krtc/media/stats_collector.h"
 #include "krtc/base/krtc_http.h"
 
-namespace krtc {
+class CTimer;
 
-class CRtcStatsCollector1 : public webrtc::RTCStatsCollectorCallback {
-public:
-    virtual void OnStatsDelivered(
-          const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override;
+namespace krtc {
 
-};
+class FrameMailbox;
 
 class KRTCPullImpl : public KRTCMediaBase, 
                      public webrtc::PeerConnectionObserver,
-                     public webrtc::CreateSessionDescriptionObserver {
+                     public webrtc::CreateSessionDescriptionObserver,
+                     public StatsObserver {
 public:
+    // owner为OnPullStats回调给应用的句柄
     explicit KRTCPullImpl(const std::string& server_addr,
                           const std::string& pull_channel,
-                          const int& hwnd);
+                          const int& hwnd,
+                          uint32_t mix_stream_id,
+                          IMediaHandler* owner,
+                          std::shared_ptr<FrameMailbox> frame_mailbox);
     ~KRTCPullImpl();
 
     void Start();
@@ -57,19 +60,39 @@ private:
     void OnIceGatheringChange(
         webrtc::PeerConnectionInterface::IceGatheringState new_state) override;
 
-    void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override {}
+    void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override;
 
     // CreateSessionDescriptionObserver implementation.
     void OnSuccess(webrtc::SessionDescriptionInterface* desc) override;
 
     void OnFailure(webrtc::RTCError error) override;
 
-    void handleHttpPullResponse(const HttpReply& reply);
+    // StatsObserver implementation.
+    void OnStatsInfo(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override;
+
+    void handlePullAnswer(KRTCError err, const std::string& sdpAnswer);
 
 private:
     rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>peer_connection_factory_;
     std::unique_ptr<VideoRenderer> remote_renderer_;
-
+    // 拉流音频混音里的一路
+    uint32_t mix_stream_id_;
+    IMediaHandler* owner_;
+    std::shared_ptr<FrameMailbox> frame_mailbox_;
+
+    // Start()时取出，这次拉流一直使用
+    KRTCPullLatencyConfig latency_config_;
+    rtc::scoped_refptr<CRtcStatsCollector> stats_;
+    std::unique_ptr<CTimer> stats_timer_;
+    // 上一次统计的累计值，用来算最近一秒的平均jitter buffer延迟
+    struct JitterBufferCounters {
+        double delay = 0.0;
+        double target_delay = 0.0;
+        uint64_t emitted_count = 0;
+    };
+    JitterBufferCounters last_video_counters_;
+    JitterBufferCounters last_audio_counters_;
+    VideoRenderer::RenderStats last_render_stats_;
 };
 
 } // namespace krtc
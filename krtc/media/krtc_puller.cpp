@@ -6,16 +6,22 @@
 #include "krtc/base/krtc_global.h"
 #include "krtc/base/krtc_thread.h"
 #include "krtc/media/krtc_pull_impl.h"
+#include "krtc/media/pull_audio_mixer.h"
+#include "krtc/media/frame_mailbox.h"
 
 namespace krtc {
 
 KRTCPuller::KRTCPuller(const std::string& server_addr, const std::string& push_channel, int hwnd) 
-    :current_thread_(std::make_unique<KRTCThread>(rtc::Thread::Current()))
+    :current_thread_(std::make_unique<KRTCThread>(rtc::Thread::Current())),
+    mix_stream_id_(KRTCGlobal::Instance()->pull_audio_mixer()->AddStream()),
+    frame_mailbox_(std::make_shared<FrameMailbox>())
 {
-    pull_impl_ = new rtc::RefCountedObject<KRTCPullImpl>(server_addr, push_channel, hwnd);
+    pull_impl_ = new rtc::RefCountedObject<KRTCPullImpl>(server_addr, push_channel, hwnd,
+        mix_stream_id_, this, frame_mailbox_);
 }
 
 KRTCPuller::~KRTCPuller() {
+    KRTCGlobal::Instance()->pull_audio_mixer()->RemoveStream(mix_stream_id_);
 }
 
 void KRTCPuller::Start() {
@@ -35,6 +41,26 @@ void KRTCPuller::Stop() {
     }
 }
 
+void KRTCPuller::SetAudioGain(float gain) {
+    KRTCGlobal::Instance()->pull_audio_mixer()->SetGain(mix_stream_id_, gain);
+}
+
+void KRTCPuller::SetAudioMute(bool mute) {
+    KRTCGlobal::Instance()->pull_audio_mixer()->SetMute(mix_stream_id_, mute);
+}
+
+void KRTCPuller::SetFrameMailbox(bool enable) {
+    frame_mailbox_->SetEnabled(enable);
+}
+
+std::shared_ptr<MediaFrame> KRTCPuller::AcquireLatestFrame() {
+    return frame_mailbox_->Acquire();
+}
+
+KRTCFrameMailboxStats KRTCPuller::GetFrameMailboxStats() {
+    return frame_mailbox_->stats();
+}
+
 void KRTCPuller::Destroy() {
     RTC_LOG(LS_INFO) << "KRTCPuller Destroy";
 
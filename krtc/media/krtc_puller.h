@@ -7,6 +7,7 @@ namespace krtc {
 
 class KRTCThread;
 class KRTCPullImpl;
+class FrameMailbox;
 
 class KRTCPuller : public IMediaHandler {
 private:
@@ -17,6 +18,14 @@ private:
     void SetEnableVideo(bool enable) {}
     void SetEnableAudio(bool enable) {}
 
+    void SetFrameMailbox(bool enable) override;
+    std::shared_ptr<MediaFrame> AcquireLatestFrame() override;
+    KRTCFrameMailboxStats GetFrameMailboxStats() override;
+
+    // 只影响拉流音频混音的结果
+    void SetAudioGain(float gain);
+    void SetAudioMute(bool mute);
+
 private:
     explicit KRTCPuller(const std::string& server_addr, const std::string& push_channel = "livestream", int hwnd = 0);
     ~KRTCPuller();
@@ -26,6 +35,9 @@ private:
 private:
     std::unique_ptr<KRTCThread> current_thread_;
     rtc::scoped_refptr<KRTCPullImpl> pull_impl_;
+    uint32_t mix_stream_id_ = 0;
+    // 解码线程写、应用渲染线程读，拉流重新开始时继续使用
+    std::shared_ptr<FrameMailbox> frame_mailbox_;
 };
 
 } // namespace krtc
@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -17,6 +18,7 @@
 #include <api/audio_options.h>
 #include <api/create_peerconnection_factory.h>
 #include <api/rtp_sender_interface.h>
+#include <api/units/time_delta.h>
 #include <api/video_codecs/builtin_video_decoder_factory.h>
 #include <api/video_codecs/builtin_video_encoder_factory.h>
 #include <api/video_codecs/video_decoder_factory.h>
@@ -27,11 +29,14 @@
 #include <modules/video_capture/video_capture_factory.h>
 #include <pc/video_track_source.h>
 #include <rtc_base/checks.h>
+#include <rtc_base/helpers.h>
 #include <rtc_base/logging.h>
 #include <rtc_base/ref_counted_object.h>
 #include <rtc_base/strings/json.h>
+#include <rtc_base/time_utils.h>
 
 #include "krtc/media/default.h"
+#include "krtc/media/audio_send_config.h"
 #include "krtc/device/vcm_capturer.h"
 #include "krtc/base/krtc_http.h"
 #include "krtc/base/krtc_global.h"
@@ -40,10 +45,41 @@
 
 namespace krtc {
 
-KRTCPushImpl::KRTCPushImpl(const std::string& server_addr, const std::string& push_channel) :
-    KRTCMediaBase(CONTROL_TYPE::PUSH, server_addr, push_channel)
+namespace {
+
+webrtc::DegradationPreference ToWebrtcDegradationPreference(DEGRADATION_PREFERENCE preference) {
+    switch (preference) {
+    case DEGRADATION_PREFERENCE::MAINTAIN_FRAMERATE:
+        return webrtc::DegradationPreference::MAINTAIN_FRAMERATE;
+    case DEGRADATION_PREFERENCE::MAINTAIN_RESOLUTION:
+        return webrtc::DegradationPreference::MAINTAIN_RESOLUTION;
+    default:
+        return webrtc::DegradationPreference::BALANCED;
+    }
+}
+
+webrtc::VideoTrackInterface::ContentHint ToWebrtcContentHint(VIDEO_CONTENT_HINT hint) {
+    switch (hint) {
+    case VIDEO_CONTENT_HINT::MOTION:
+        return webrtc::VideoTrackInterface::ContentHint::kFluid;
+    case VIDEO_CONTENT_HINT::DETAIL:
+        return webrtc::VideoTrackInterface::ContentHint::kDetailed;
+    case VIDEO_CONTENT_HINT::TEXT:
+        return webrtc::VideoTrackInterface::ContentHint::kText;
+    default:
+        return webrtc::VideoTrackInterface::ContentHint::kNone;
+    }
+}
+
+} // namespace
+
+KRTCPushImpl::KRTCPushImpl(const std::string& server_addr, const std::string& push_channel,
+    VideoSourceId video_source_id,
+    rtc::scoped_refptr<LocalAudioSource> external_audio_source) :
+    KRTCMediaBase(CONTROL_TYPE::PUSH, server_addr, push_channel),
+    video_source_id_(video_source_id),
+    external_audio_source_(external_audio_source)
 {
-    KRTCGlobal::Instance()->http_manager()->AddObject(this);
 }
 
 KRTCPushImpl::~KRTCPushImpl() {
@@ -53,8 +89,20 @@ KRTCPushImpl::~KRTCPushImpl() {
 void KRTCPushImpl::Start() {
     RTC_LOG(LS_INFO) << "KRTCPushImpl Start";
 
-    webrtc::PeerConnectionInterface::RTCConfiguration config;
-    config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
+    start_time_ms_ = rtc::TimeMillis();
+    setup_timings_ = KRTCSetupTimings();
+    setup_timings_reported_ = false;
+    reconnect_state_ = ReconnectState::kConnecting;
+    ++reconnect_generation_;
+    ice_restart_pending_ = false;
+    last_send_counters_ = SendCounters();
+    ramp_up_ms_ = -1;
+
+    bool fast_start = KRTCGlobal::Instance()->fast_start();
+    if (fast_start) {
+        // 信令连接的DNS/TCP/TLS和下面的offer创建并行进行
+        KRTCGlobal::Instance()->http_manager()->Prewarm(signaling_->endpoint());
+    }
 
     webrtc::PeerConnectionFactoryInterface* peer_connection_factory =
         KRTCGlobal::Instance()->push_peer_connection_factory();
@@ -63,58 +111,166 @@ void KRTCPushImpl::Start() {
     options.disable_encryption = false;
     peer_connection_factory->SetOptions(options);
 
-    peer_connection_ = peer_connection_factory->CreatePeerConnection(
-        config, nullptr, nullptr, this);
+    WarmPeerConnection warm;
+    if (fast_start && KRTCGlobal::Instance()->peer_connection_pool()->Acquire(&warm)) {
+        observer_proxy_ = std::move(warm.observer);
+        observer_proxy_->SetTarget(this);
+        peer_connection_ = warm.peer_connection;
+        setup_timings_.warm_start = true;
+    }
+    else {
+        peer_connection_ = PeerConnectionPool::CreatePushPeerConnection(this, fast_start);
+    }
+    setup_timings_.peer_connection_created_ms = ElapsedSinceStart();
+
+    if (!peer_connection_) {
+        if (KRTCGlobal::Instance()->engine_observer()) {
+            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kCreatePeerConnectionErr);
+        }
+        return;
+    }
+    ApplyBitrateConfig();
+
+    // 推外部音频时不打开麦克风，其他外部音频推流都停止后才恢复
+    if (external_audio_source_ && !external_audio_counted_) {
+        external_audio_counted_ = true;
+        if (KRTCGlobal::Instance()->AddExternalAudioPusher()) {
+            peer_connection_->SetAudioRecording(false);
+        }
+    }
+
+    rtc::scoped_refptr<webrtc::AudioSourceInterface> audio_source = external_audio_source_;
+    if (!audio_source) {
+        audio_source = peer_connection_factory->CreateAudioSource(cricket::AudioOptions());
+    }
+    audio_track_ = peer_connection_factory->CreateAudioTrack(kAudioLabel, audio_source.get());
+    video_source_ = KRTCGlobal::Instance()->video_source_registry()->Get(
+        video_source_id_, &video_source_type_);
+    if (video_source_) {
+        video_track_ = peer_connection_factory->CreateVideoTrack(kVideoLabel, video_source_.get());
+    }
+    else {
+        RTC_LOG(LS_WARNING) << "no video source bound, push audio only";
+    }
+
+    if (!AddTracks()) {
+        if (KRTCGlobal::Instance()->engine_observer()) {
+            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kAddTrackErr);
+        }
 
-    webrtc::RtpTransceiverInit rtpTransceiverInit;
-    rtpTransceiverInit.direction = webrtc::RtpTransceiverDirection::kSendOnly;
-    peer_connection_->AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO,
-        rtpTransceiverInit);
-    peer_connection_->AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO,
-        rtpTransceiverInit);
+        return;
+    }
+
+    setup_timings_.tracks_added_ms = ElapsedSinceStart();
+
+    peer_connection_->CreateOffer(
+        this, webrtc::PeerConnectionInterface::RTCOfferAnswerOptions());
 
+}
 
-    audio_track_ = peer_connection_factory->CreateAudioTrack(
-        kAudioLabel,
-        peer_connection_factory->CreateAudioSource(cricket::AudioOptions()).get());
+bool KRTCPushImpl::AddTracks() {
     auto add_audio_track_result = peer_connection_->AddTrack(audio_track_, { kStreamId });
     if (!add_audio_track_result.ok()) {
         RTC_LOG(LS_ERROR) << "Failed to add audio track to PeerConnection: "
             << add_audio_track_result.error().message();
     }
+    else {
+        // SDP里的maxaveragebitrate只在协商时生效，这里再限制一次发送码率
+        KRTCAudioSendConfig audio_config = KRTCGlobal::Instance()->audio_send_config();
+        if (audio_config.bitrate_bps > 0) {
+            auto audio_sender = add_audio_track_result.value();
+            webrtc::RtpParameters parameters = audio_sender->GetParameters();
+            for (auto& encoding : parameters.encodings) {
+                encoding.max_bitrate_bps = static_cast<int>(audio_config.bitrate_bps);
+            }
+            webrtc::RTCError error = audio_sender->SetParameters(parameters);
+            if (!error.ok()) {
+                RTC_LOG(LS_WARNING) << "Failed to set audio sender parameters: " << error.message();
+            }
+        }
+    }
+
+    if (!video_track_) {
+        return add_audio_track_result.ok();
+    }
+
+    KRTCVideoSourceConfig source_config = KRTCGlobal::Instance()->video_source_config(video_source_type_);
+    video_track_->set_content_hint(ToWebrtcContentHint(source_config.content_hint));
 
-    video_track_ = peer_connection_factory->CreateVideoTrack(
-        kVideoLabel, KRTCGlobal::Instance()->current_video_source());
     auto add_video_track_result = peer_connection_->AddTrack(video_track_, { kStreamId });
     if (!add_video_track_result.ok()) {
         RTC_LOG(LS_ERROR) << "Failed to add video track to PeerConnection: "
             << add_video_track_result.error().message();
 
     }
-
-    if (!add_audio_track_result.ok() && !add_video_track_result.ok()) {
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kAddTrackErr);
+    else {
+        auto video_sender = add_video_track_result.value();
+        webrtc::RtpParameters parameters = video_sender->GetParameters();
+        parameters.degradation_preference =
+            ToWebrtcDegradationPreference(source_config.degradation_preference);
+        if (KRTCGlobal::Instance()->video_temporal_layers() > 1) {
+            for (auto& encoding : parameters.encodings) {
+                encoding.num_temporal_layers = KRTCGlobal::Instance()->video_temporal_layers();
+            }
+        }
+        webrtc::RTCError error = video_sender->SetParameters(parameters);
+        if (!error.ok()) {
+            RTC_LOG(LS_WARNING) << "Failed to set video sender parameters: " << error.message();
         }
+    }
+
+    return add_audio_track_result.ok() || add_video_track_result.ok();
+}
 
+void KRTCPushImpl::ApplyBitrateConfig() {
+    KRTCBitrateConfig config = KRTCGlobal::Instance()->bitrate_config();
+    webrtc::BitrateSettings settings;
+    if (config.min_bitrate_bps > 0) {
+        settings.min_bitrate_bps = config.min_bitrate_bps;
+    }
+    if (config.start_bitrate_bps > 0) {
+        settings.start_bitrate_bps = config.start_bitrate_bps;
+    }
+    if (config.max_bitrate_bps > 0) {
+        settings.max_bitrate_bps = config.max_bitrate_bps;
+    }
+    if (!settings.min_bitrate_bps && !settings.start_bitrate_bps && !settings.max_bitrate_bps) {
         return;
     }
 
-    peer_connection_->CreateOffer(
-        this, webrtc::PeerConnectionInterface::RTCOfferAnswerOptions());
-
+    webrtc::RTCError error = peer_connection_->SetBitrate(settings);
+    if (!error.ok()) {
+        RTC_LOG(LS_WARNING) << "Failed to set bitrate: " << error.message();
+    }
 }
 
 void KRTCPushImpl::Stop()
 {
+    reconnect_state_ = ReconnectState::kIdle;
+    ++reconnect_generation_;
+
     if (stats_timer_) {
         stats_timer_->Stop();
         stats_timer_ = nullptr;
     }
 
+    if (observer_proxy_) {
+        observer_proxy_->SetTarget(nullptr);
+    }
+
+    if (external_audio_counted_) {
+        external_audio_counted_ = false;
+        if (KRTCGlobal::Instance()->RemoveExternalAudioPusher() && peer_connection_) {
+            peer_connection_->SetAudioRecording(true);
+        }
+    }
+
     if (peer_connection_) {
         peer_connection_ = nullptr;
     }
+    observer_proxy_.reset();
+
+    signaling_->Stop();
 }
 
 void KRTCPushImpl::GetRtcStats() {
@@ -157,49 +313,274 @@ void KRTCPushImpl::OnDataChannel(
 
 // CreateSessionDescriptionObserver implementation.
 void KRTCPushImpl::OnSuccess(webrtc::SessionDescriptionInterface* desc) {
-    peer_connection_->SetLocalDescription(
-        DummySetSessionDescriptionObserver::Create().get(), desc);
+    // 重连时的offer不计入首次建立的耗时
+    bool initial = reconnect_state_ == ReconnectState::kConnecting;
+    if (initial) {
+        setup_timings_.offer_created_ms = ElapsedSinceStart();
+    }
 
+    // SetLocalDescription会接管desc，先转成字符串
     std::string sdpOffer;
     desc->ToString(&sdpOffer);
+    // 这一轮协商的offer和answer用同一份Opus参数
+    audio_send_config_ = KRTCGlobal::Instance()->audio_send_config();
+    sdpOffer = MungeOpusOffer(sdpOffer, audio_send_config_);
+
+    rtc::scoped_refptr<KRTCPushImpl> self(this);
+    peer_connection_->SetLocalDescription(
+        CallbackSetSessionDescriptionObserver::Create([self, initial](webrtc::RTCError error) {
+            if (error.ok() && initial) {
+                self->setup_timings_.local_description_set_ms = self->ElapsedSinceStart();
+            }
+        }).get(), desc);
+
     RTC_LOG(LS_INFO) << "sdp offer:" << sdpOffer;
 
-    Json::Value reqMsg;
-    reqMsg["api"] = httpRequestUrl_;
-    reqMsg["streamurl"] = webrtcStreamUrl_;
-    reqMsg["sdp"] = sdpOffer;
-    reqMsg["tid"] = rtc::CreateRandomString(7);
-    Json::StreamWriterBuilder write_builder;
-    write_builder.settings_["indentation"] = "";
-    std::string json_data = Json::writeString(write_builder, reqMsg);
-
-    RTC_LOG(LS_INFO) << "send webrtc push request.....";
-
-    HttpRequest request(httpRequestUrl_, json_data);
-    KRTCGlobal::Instance()->http_manager()->Post(request, [=](HttpReply reply) {
-        RTC_LOG(LS_INFO) << "signaling push response, url: " << reply.get_url()
-            << ", body: " << reply.get_body()
-            << ", status: " << reply.get_status_code()
-            << ", err_no: " << reply.get_errno()
-            << ", err_msg: " << reply.get_err_msg()
-            << ", response: " << reply.get_resp();
-        KRTCGlobal::Instance()->api_thread()->PostTask([=]() {
-            handleHttpPushResponse(reply);
-        });
-
-    }, this);
+    RTC_LOG(LS_INFO) << "send webrtc push request....., ice_restart: " << ice_restart_pending_;
+
+    uint32_t generation = reconnect_generation_;
+    auto on_answer = [this, initial, generation](KRTCError err, const std::string& answer) {
+        if (generation != reconnect_generation_) {
+            return;
+        }
+        if (initial) {
+            setup_timings_.answer_received_ms = ElapsedSinceStart();
+        }
+        handlePushAnswer(err, answer);
+    };
+    if (ice_restart_pending_) {
+        signaling_->RestartIce(sdpOffer, on_answer);
+    }
+    else {
+        signaling_->SendOffer(sdpOffer, on_answer);
+    }
+}
+
+void KRTCPushImpl::OnIceGatheringChange(
+    webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+    if (new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+        signaling_->OnGatheringComplete();
+    }
+}
 
+void KRTCPushImpl::OnIceCandidate(const webrtc::IceCandidateInterface* candidate) {
+    signaling_->SendCandidate(candidate);
 }
 
 void KRTCPushImpl::OnFailure(webrtc::RTCError error) {
+    if (reconnect_state_ == ReconnectState::kReconnecting) {
+        RTC_LOG(LS_WARNING) << "reconnect create offer failed: " << error.message();
+        ScheduleAttempt();
+        return;
+    }
+
     if (KRTCGlobal::Instance()->engine_observer()) {
         KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kCreateOfferErr);
     }
 }
 
+void KRTCPushImpl::OnConnectionChange(
+    webrtc::PeerConnectionInterface::PeerConnectionState new_state) {
+    switch (new_state) {
+    case webrtc::PeerConnectionInterface::PeerConnectionState::kConnected:
+        if (reconnect_state_ == ReconnectState::kDisconnected ||
+            reconnect_state_ == ReconnectState::kReconnecting) {
+            OnReconnected();
+        }
+        reconnect_state_ = ReconnectState::kConnected;
+        break;
+    case webrtc::PeerConnectionInterface::PeerConnectionState::kDisconnected:
+        if (reconnect_state_ == ReconnectState::kConnected) {
+            // 短暂的网络抖动ICE一般能自行恢复，先等一会
+            reconnect_config_ = KRTCGlobal::Instance()->reconnect_config();
+            reconnect_state_ = ReconnectState::kDisconnected;
+            disconnected_at_ms_ = rtc::TimeMillis();
+            ++reconnect_generation_;
+            PostReconnectTask(reconnect_config_.disconnected_timeout_ms, [this]() {
+                if (reconnect_state_ == ReconnectState::kDisconnected) {
+                    BeginReconnect();
+                }
+            });
+        }
+        return;
+    case webrtc::PeerConnectionInterface::PeerConnectionState::kFailed:
+        if (reconnect_state_ == ReconnectState::kConnected) {
+            disconnected_at_ms_ = rtc::TimeMillis();
+            BeginReconnect();
+        }
+        else if (reconnect_state_ == ReconnectState::kDisconnected) {
+            BeginReconnect();
+        }
+        else if (reconnect_state_ == ReconnectState::kReconnecting) {
+            // 本次尝试已经失败，不必等到超时
+            ScheduleAttempt();
+        }
+        return;
+    default:
+        return;
+    }
+
+    if (setup_timings_reported_) {
+        return;
+    }
+
+    setup_timings_reported_ = true;
+    setup_timings_.ice_connected_ms = ElapsedSinceStart();
+    RTC_LOG(LS_INFO) << "push setup finished, warm_start: " << setup_timings_.warm_start
+        << ", pc: " << setup_timings_.peer_connection_created_ms
+        << "ms, tracks: " << setup_timings_.tracks_added_ms
+        << "ms, offer: " << setup_timings_.offer_created_ms
+        << "ms, local sdp: " << setup_timings_.local_description_set_ms
+        << "ms, answer: " << setup_timings_.answer_received_ms
+        << "ms, remote sdp: " << setup_timings_.remote_description_set_ms
+        << "ms, connected: " << setup_timings_.ice_connected_ms << "ms";
+
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnPushSetupTimings(setup_timings_);
+    }
+}
+
+int32_t KRTCPushImpl::ElapsedSinceStart() const {
+    return static_cast<int32_t>(rtc::TimeMillis() - start_time_ms_);
+}
+
+void KRTCPushImpl::PostReconnectTask(uint32_t delay_ms, std::function<void()> task) {
+    rtc::scoped_refptr<KRTCPushImpl> self(this);
+    uint32_t generation = reconnect_generation_;
+    KRTCGlobal::Instance()->api_thread()->PostDelayedTask([self, generation, task]() {
+        if (generation == self->reconnect_generation_) {
+            task();
+        }
+    }, webrtc::TimeDelta::Millis(delay_ms));
+}
+
+void KRTCPushImpl::BeginReconnect() {
+    reconnect_config_ = KRTCGlobal::Instance()->reconnect_config();
+    if (!reconnect_config_.enable) {
+        RTC_LOG(LS_WARNING) << "push connection lost, reconnect disabled";
+        reconnect_state_ = ReconnectState::kIdle;
+        if (KRTCGlobal::Instance()->engine_observer()) {
+            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kReconnectFailedErr);
+        }
+        return;
+    }
+
+    RTC_LOG(LS_INFO) << "push connection lost, start reconnecting";
+    reconnect_state_ = ReconnectState::kReconnecting;
+    reconnect_attempt_ = 0;
+    renegotiations_ = 0;
+    stream_busy_since_ms_ = -1;
+    ScheduleAttempt();
+}
+
+void KRTCPushImpl::ScheduleAttempt() {
+    ++reconnect_generation_;
+    ice_restart_pending_ = false;
+
+    if (reconnect_attempt_ >= reconnect_config_.max_attempts) {
+        RTC_LOG(LS_WARNING) << "push reconnect failed after " << reconnect_attempt_ << " attempts";
+        reconnect_state_ = ReconnectState::kIdle;
+        if (KRTCGlobal::Instance()->engine_observer()) {
+            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kReconnectFailedErr);
+        }
+        return;
+    }
+
+    // 指数退避加随机抖动，避免大量客户端在同一时刻重连
+    ++reconnect_attempt_;
+    uint64_t backoff_ms = static_cast<uint64_t>(reconnect_config_.initial_backoff_ms)
+        << std::min<uint32_t>(reconnect_attempt_ - 1, 16);
+    backoff_ms = std::min<uint64_t>(backoff_ms, reconnect_config_.max_backoff_ms);
+    uint32_t delay_ms = static_cast<uint32_t>(backoff_ms / 2 +
+        rtc::CreateRandomId() % (backoff_ms - backoff_ms / 2 + 1));
+
+    RTC_LOG(LS_INFO) << "push reconnect attempt " << reconnect_attempt_ << " in " << delay_ms << "ms";
+    PostReconnectTask(delay_ms, [this]() {
+        RunAttempt();
+    });
+}
+
+void KRTCPushImpl::RunAttempt() {
+    // SRS这类不支持ICE restart的信令跳过这一阶段，直接重建PeerConnection
+    bool ice_restart = peer_connection_ && signaling_->SupportsIceRestart() &&
+        reconnect_attempt_ <= reconnect_config_.ice_restart_attempts;
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnPushReconnecting(reconnect_attempt_, ice_restart);
+    }
+
+    ++reconnect_generation_;
+    if (!ice_restart) {
+        ++renegotiations_;
+        if (!RecreatePeerConnection()) {
+            ScheduleAttempt();
+            return;
+        }
+    }
+    ice_restart_pending_ = ice_restart;
+
+    webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+    options.ice_restart = ice_restart;
+    peer_connection_->CreateOffer(this, options);
+
+    uint32_t attempt = reconnect_attempt_;
+    PostReconnectTask(reconnect_config_.attempt_timeout_ms, [this, attempt]() {
+        RTC_LOG(LS_WARNING) << "push reconnect attempt " << attempt << " timed out";
+        ScheduleAttempt();
+    });
+}
+
+bool KRTCPushImpl::RecreatePeerConnection() {
+    RTC_LOG(LS_INFO) << "recreate push peer connection";
+
+    if (observer_proxy_) {
+        observer_proxy_->SetTarget(nullptr);
+    }
+    if (peer_connection_) {
+        peer_connection_->Close();
+        peer_connection_ = nullptr;
+    }
+    observer_proxy_.reset();
+    signaling_->Stop();
+
+    // 采集源和track不变，只重建传输
+    peer_connection_ = PeerConnectionPool::CreatePushPeerConnection(this, false);
+    if (!peer_connection_) {
+        return false;
+    }
+    ApplyBitrateConfig();
+    // 新连接的发送计数从0开始
+    last_send_counters_ = SendCounters();
+    return AddTracks();
+}
+
+void KRTCPushImpl::OnReconnected() {
+    KRTCReconnectInfo info;
+    if (reconnect_state_ == ReconnectState::kReconnecting) {
+        info.attempts = reconnect_attempt_;
+        info.renegotiations = renegotiations_;
+        info.ice_restart = ice_restart_pending_;
+    }
+    info.downtime_ms = static_cast<int32_t>(rtc::TimeMillis() - disconnected_at_ms_);
+
+    RTC_LOG(LS_INFO) << "push reconnected, attempts: " << info.attempts
+        << ", renegotiations: " << info.renegotiations
+        << ", ice_restart: " << info.ice_restart
+        << ", downtime: " << info.downtime_ms << "ms";
+
+    ++reconnect_generation_;
+    ice_restart_pending_ = false;
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnPushReconnected(info);
+    }
+}
+
 void KRTCPushImpl::OnStatsInfo(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
     Json::Reader reader;
 
+    SendCounters counters;
+    counters.timestamp_us = report->timestamp_us();
+    KRTCBandwidthStats bwe;
+
     for (auto it = report->begin(); it != report->end(); ++it) {
         Json::Value jmessage;
         if (!reader.parse(it->ToJson(), jmessage)) {
@@ -217,58 +598,100 @@ void KRTCPushImpl::OnStatsInfo(const rtc::scoped_refptr<const webrtc::RTCStatsRe
             if (KRTCGlobal::Instance()->engine_observer()) {
                 KRTCGlobal::Instance()->engine_observer()->OnNetworkInfo(rtt_ms, packetsLost, fractionLost);
             }
-        }
-    }
-}
 
-void KRTCPushImpl::handleHttpPushResponse(const HttpReply &reply) {
-    if (reply.get_status_code() != 200 || reply.get_errno() != 0) {
-        RTC_LOG(LS_INFO) << "http post error";
-
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kSendOfferErr);
+            counters.bytes_sent += jmessage["bytesSent"].asUInt64() + jmessage["headerBytesSent"].asUInt64();
+            counters.retransmitted_bytes_sent += jmessage["retransmittedBytesSent"].asUInt64();
+            counters.packets_sent += jmessage["packetsSent"].asUInt64();
+            counters.total_packet_send_delay += jmessage["totalPacketSendDelay"].asDouble();
+            bwe.target_bps += static_cast<uint32_t>(jmessage["targetBitrate"].asDouble());
+        }
+        else if (type == "candidate-pair") {
+            // 只看正在使用的候选对
+            if (!jmessage["nominated"].asBool() || jmessage["state"].asString() != "succeeded") {
+                continue;
+            }
+            bwe.available_send_bps = static_cast<uint32_t>(jmessage["availableOutgoingBitrate"].asDouble());
+            if (jmessage.isMember("currentRoundTripTime")) {
+                bwe.rtt_ms = static_cast<int32_t>(jmessage["currentRoundTripTime"].asDouble() * 1000);
+            }
         }
-        return;
     }
 
-    std::string responseBody = reply.get_resp();
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-    Json::Value root;
-    JSONCPP_STRING err;
-    reader->parse(responseBody.data(), responseBody.data() + responseBody.size(), &root, &err);
-    if (!err.empty()) {
-        RTC_LOG(LS_WARNING) << "Received unknown message. " << responseBody;
-
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kParseAnswerErr);
-        }
+    int32_t max_bitrate_bps = KRTCGlobal::Instance()->bitrate_config().max_bitrate_bps;
+    if (ramp_up_ms_ < 0 && max_bitrate_bps > 0 &&
+        bwe.available_send_bps >= static_cast<uint32_t>(max_bitrate_bps)) {
+        ramp_up_ms_ = ElapsedSinceStart();
+    }
+    bwe.ramp_up_ms = ramp_up_ms_;
+
+    SendCounters last = last_send_counters_;
+    last_send_counters_ = counters;
+    // 第一次统计或者计数被重置(重建了PeerConnection)，没有可比较的上一次
+    if (last.timestamp_us == 0 || counters.timestamp_us <= last.timestamp_us ||
+        counters.bytes_sent < last.bytes_sent ||
+        counters.retransmitted_bytes_sent < last.retransmitted_bytes_sent ||
+        counters.packets_sent < last.packets_sent) {
         return;
     }
 
-    RTC_LOG(LS_INFO) << "http push response : " << responseBody;
+    double interval_s = (counters.timestamp_us - last.timestamp_us) / 1000000.0;
+    bwe.actual_send_bps = static_cast<uint32_t>((counters.bytes_sent - last.bytes_sent) * 8 / interval_s);
+    bwe.retransmit_bps = static_cast<uint32_t>(
+        (counters.retransmitted_bytes_sent - last.retransmitted_bytes_sent) * 8 / interval_s);
+    uint64_t packets = counters.packets_sent - last.packets_sent;
+    if (packets > 0) {
+        bwe.pacer_delay_ms = (counters.total_packet_send_delay - last.total_packet_send_delay) * 1000 / packets;
+    }
 
-    int code = root["code"].asInt();
-    if (code != 0) {
-        RTC_LOG(LS_INFO) << "http push response error, code: " << code;
+    if (KRTCGlobal::Instance()->engine_observer()) {
+        KRTCGlobal::Instance()->engine_observer()->OnBandwidthStats(bwe);
+    }
+}
 
+void KRTCPushImpl::handlePushAnswer(KRTCError err, const std::string& sdpAnswer) {
+    bool reconnecting = reconnect_state_ == ReconnectState::kReconnecting;
+    if (err != KRTCError::kNoErr) {
+        if (reconnecting) {
+            RTC_LOG(LS_WARNING) << "reconnect signaling failed: " << KRTCEngine::GetErrString(err);
+            if (err == KRTCError::kStreamBusyErr) {
+                // 服务端的旧会话还没超时，等它释放，这段时间不计入尝试次数
+                int64_t now_ms = rtc::TimeMillis();
+                if (stream_busy_since_ms_ < 0) {
+                    stream_busy_since_ms_ = now_ms;
+                }
+                if (now_ms - stream_busy_since_ms_ < reconnect_config_.stream_busy_timeout_ms &&
+                    reconnect_attempt_ > 0) {
+                    --reconnect_attempt_;
+                }
+            }
+            ScheduleAttempt();
+            return;
+        }
         if (KRTCGlobal::Instance()->engine_observer()) {
-            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(KRTCError::kAnswerResponseErr);
+            KRTCGlobal::Instance()->engine_observer()->OnPushFailed(err);
         }
         return;
     }
 
-    std::string sdpAnswer = root["sdp"].asString();
-
     webrtc::SdpParseError error;
     webrtc::SdpType type = webrtc::SdpType::kAnswer;
     std::unique_ptr<webrtc::SessionDescriptionInterface> session_description =
-        webrtc::CreateSessionDescription(type, sdpAnswer, &error);
+        webrtc::CreateSessionDescription(type, MungeOpusAnswer(sdpAnswer, audio_send_config_), &error);
 
+    rtc::scoped_refptr<KRTCPushImpl> self(this);
     peer_connection_->SetRemoteDescription(
-        DummySetSessionDescriptionObserver::Create().get(),
+        CallbackSetSessionDescriptionObserver::Create([self, reconnecting](webrtc::RTCError error) {
+            if (error.ok() && !reconnecting) {
+                self->setup_timings_.remote_description_set_ms = self->ElapsedSinceStart();
+            }
+        }).get(),
         session_description.release());
 
+    // 重连不重复通知推流成功，统计定时器一直在运行
+    if (reconnecting) {
+        return;
+    }
+
     if (KRTCGlobal::Instance()->engine_observer()) {
         KRTCGlobal::Instance()->engine_observer()->OnPushSuccess();
     }
@@ -2,7 +2,9 @@
 #ifndef KRTCSDK_KRTC_MEDIA_KRTC_PUSH_IMPL_H_
 #define KRTCSDK_KRTC_MEDIA_KRTC_PUSH_IMPL_H_
 
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -10,7 +12,10 @@
 
 #include <api/media_stream_interface.h>
 
+#include "krtc/device/audio_track.h"
+#include "krtc/device/video_source_registry.h"
 #include "krtc/media/krtc_media_base.h"
+#include "krtc/media/peer_connection_pool.h"
 #include "krtc/media/stats_collector.h"
 #include "krtc/base/krtc_http.h"
 
@@ -24,7 +29,9 @@ class KRTCPushImpl : public KRTCMediaBase,
                      public StatsObserver
 {
 public:
-    explicit KRTCPushImpl(const std::string& server_addr, const std::string& push_channel = "");
+    KRTCPushImpl(const std::string& server_addr, const std::string& push_channel = "",
+        VideoSourceId video_source_id = kDefaultVideoSource,
+        rtc::scoped_refptr<LocalAudioSource> external_audio_source = nullptr);
     ~KRTCPushImpl();
 
     void Start();
@@ -43,9 +50,12 @@ private:
         rtc::scoped_refptr<webrtc::DataChannelInterface> channel) override;
 
     void OnIceGatheringChange(
-        webrtc::PeerConnectionInterface::IceGatheringState new_state) override {}
+        webrtc::PeerConnectionInterface::IceGatheringState new_state) override;
 
-    void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override {}
+    void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override;
+
+    void OnConnectionChange(
+        webrtc::PeerConnectionInterface::PeerConnectionState new_state) override;
 
     // CreateSessionDescriptionObserver implementation.
     void OnSuccess(webrtc::SessionDescriptionInterface* desc) override;
@@ -55,12 +65,74 @@ private:
     // StatsObserver implementation.
     void OnStatsInfo(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report);
 
-    void handleHttpPushResponse(const HttpReply& reply);
+    void handlePushAnswer(KRTCError err, const std::string& sdpAnswer);
+
+    // 把audio_track_/video_track_加到peer_connection_，至少一路成功时返回true
+    bool AddTracks();
+    void ApplyBitrateConfig();
+
+    // 相对Start()的毫秒数
+    int32_t ElapsedSinceStart() const;
+
+    // 断线重连，都在api线程
+    void BeginReconnect();
+    void ScheduleAttempt();
+    void RunAttempt();
+    bool RecreatePeerConnection();
+    void OnReconnected();
+    // 在api线程延迟执行，期间reconnect_generation_变化则放弃
+    void PostReconnectTask(uint32_t delay_ms, std::function<void()> task);
 
 private:
+    enum class ReconnectState {
+        kIdle,
+        kConnecting,    // 首次建立连接
+        kConnected,
+        kDisconnected,  // 等待ICE自行恢复
+        kReconnecting,
+    };
+
+    // 快速启动时预创建的PeerConnection的observer，要比peer_connection_活得久
+    std::unique_ptr<PeerConnectionObserverProxy> observer_proxy_;
+    int64_t start_time_ms_ = 0;
+    KRTCSetupTimings setup_timings_;
+    bool setup_timings_reported_ = false;
+
+    ReconnectState reconnect_state_ = ReconnectState::kIdle;
+    KRTCReconnectConfig reconnect_config_;
+    // 状态每次变化都递增，使之前投递的定时任务和信令应答失效
+    std::atomic<uint32_t> reconnect_generation_{ 0 };
+    uint32_t reconnect_attempt_ = 0;
+    uint32_t renegotiations_ = 0;
+    // 当前offer是ICE restart
+    bool ice_restart_pending_ = false;
+    int64_t disconnected_at_ms_ = 0;
+    // 本次重连第一次被回答stream busy的时间，-1表示还没有
+    int64_t stream_busy_since_ms_ = -1;
     rtc::scoped_refptr<CRtcStatsCollector> stats_;
+    // 上一次统计的累计值，用来算每秒的码率和pacer延迟
+    struct SendCounters {
+        int64_t timestamp_us = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t retransmitted_bytes_sent = 0;
+        uint64_t packets_sent = 0;
+        double total_packet_send_delay = 0.0;
+    };
+    SendCounters last_send_counters_;
+    int32_t ramp_up_ms_ = -1;
     std::unique_ptr<CTimer> stats_timer_;
 
+    // 绑定的采集源，Start()时从登记表取出，断线重连时继续使用
+    VideoSourceId video_source_id_;
+    CAPTURE_TYPE video_source_type_ = CAPTURE_TYPE::CAMERA;
+    rtc::scoped_refptr<CapturerTrackSource> video_source_;
+    // 当前协商使用的Opus参数
+    KRTCAudioSendConfig audio_send_config_;
+    // 外部音频源，为空时推麦克风
+    rtc::scoped_refptr<LocalAudioSource> external_audio_source_;
+    // 已计入KRTCGlobal的外部音频推流计数
+    bool external_audio_counted_ = false;
+
     rtc::scoped_refptr<webrtc::AudioTrackInterface> audio_track_;
     rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track_;
 };
@@ -9,10 +9,12 @@
 
 namespace krtc {
 
-KRTCPusher::KRTCPusher(const std::string& server_addr, const std::string& push_channel) :
+KRTCPusher::KRTCPusher(const std::string& server_addr, const std::string& push_channel,
+    VideoSourceId video_source_id, rtc::scoped_refptr<LocalAudioSource> audio_source) :
     current_thread_(std::make_unique<KRTCThread>(rtc::Thread::Current()))
 {
-    push_impl_ = new rtc::RefCountedObject<KRTCPushImpl>(server_addr, push_channel);  
+    push_impl_ = new rtc::RefCountedObject<KRTCPushImpl>(server_addr, push_channel,
+        video_source_id, audio_source);
 }
 
 KRTCPusher::~KRTCPusher() = default;
@@ -2,6 +2,8 @@
 #define KRTCSDK_KRTC_MEDIA_KRTC_PUSHER_H_
 
 #include "krtc/krtc.h"
+#include "krtc/device/audio_track.h"
+#include "krtc/device/video_source_registry.h"
 
 namespace krtc {
 
@@ -18,7 +20,9 @@ private:
     void SetEnableAudio(bool enable = true);
 
 private:
-    explicit KRTCPusher(const std::string& server_addr, const std::string& push_channel = "livestream");
+    KRTCPusher(const std::string& server_addr, const std::string& push_channel = "livestream",
+        VideoSourceId video_source_id = kDefaultVideoSource,
+        rtc::scoped_refptr<LocalAudioSource> audio_source = nullptr);
     ~KRTCPusher();
 
 private:
@@ -1,6 +1,9 @@
 #ifndef XRTCSDK_XRTC_MEDIA_BASE_MEDIA_FRAME_H_
 #define XRTCSDK_XRTC_MEDIA_BASE_MEDIA_FRAME_H_
 
+#include <cstring>
+#include <memory>
+
 namespace krtc {
 
 enum class MainMediaType {
@@ -16,6 +19,10 @@ enum class SubMediaType {
     kSubTypeH264,
     kSubTypePcm,
     kSubTypeOpus,
+    // data[0]为Y，data[1]为交织的UV
+    kSubTypeNV12,
+    // 硬解等原生buffer，见MediaFrame::native_buffer
+    kSubTypeNative,
 };
 
 struct AudioFormat {
@@ -90,7 +97,7 @@ public:
     }
 
     ~MediaFrame() {
-        if (data[0]) {
+        if (data[0] && !buffer_ref) {
             delete[] data[0];
             data[0] = nullptr;
         }
@@ -104,6 +111,11 @@ public:
     int stride[4];
     uint32_t ts = 0;
     int64_t capture_time_ms = 0;
+    // kSubTypeNative时为webrtc::VideoFrameBuffer*
+    void* native_buffer = nullptr;
+    // 不为空时data直接指向webrtc的帧缓冲，MediaFrame释放前缓冲一直有效，各平面之间不一定连续。
+    // 解码器的缓冲池有上限，用完要尽快释放
+    std::shared_ptr<void> buffer_ref;
 };
 
 } // namespace xrtc
@@ -0,0 +1,151 @@
+#include "krtc/media/peer_connection_pool.h"
+
+#include <rtc_base/logging.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+void PeerConnectionObserverProxy::OnSignalingChange(
+    webrtc::PeerConnectionInterface::SignalingState new_state) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnSignalingChange(new_state);
+    }
+}
+
+void PeerConnectionObserverProxy::OnDataChannel(
+    rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnDataChannel(data_channel);
+    }
+}
+
+void PeerConnectionObserverProxy::OnNegotiationNeededEvent(uint32_t event_id) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnNegotiationNeededEvent(event_id);
+    }
+}
+
+void PeerConnectionObserverProxy::OnIceConnectionChange(
+    webrtc::PeerConnectionInterface::IceConnectionState new_state) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnIceConnectionChange(new_state);
+    }
+}
+
+void PeerConnectionObserverProxy::OnConnectionChange(
+    webrtc::PeerConnectionInterface::PeerConnectionState new_state) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnConnectionChange(new_state);
+    }
+}
+
+void PeerConnectionObserverProxy::OnIceGatheringChange(
+    webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnIceGatheringChange(new_state);
+    }
+}
+
+void PeerConnectionObserverProxy::OnIceCandidate(const webrtc::IceCandidateInterface* candidate) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnIceCandidate(candidate);
+    }
+}
+
+void PeerConnectionObserverProxy::OnAddTrack(rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+    const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>& streams) {
+    if (webrtc::PeerConnectionObserver* target = target_) {
+        target->OnAddTrack(receiver, streams);
+    }
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionInterface> PeerConnectionPool::CreatePushPeerConnection(
+    webrtc::PeerConnectionObserver* observer, bool prewarm_ice) {
+    webrtc::PeerConnectionInterface::RTCConfiguration config;
+    config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
+    if (prewarm_ice) {
+        config.ice_candidate_pool_size = 1;
+    }
+
+    webrtc::PeerConnectionFactoryInterface* peer_connection_factory =
+        KRTCGlobal::Instance()->push_peer_connection_factory();
+
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection =
+        peer_connection_factory->CreatePeerConnection(config, nullptr, nullptr, observer);
+    if (!peer_connection) {
+        RTC_LOG(LS_ERROR) << "Failed to create PeerConnection";
+        return nullptr;
+    }
+
+    webrtc::RtpTransceiverInit rtpTransceiverInit;
+    rtpTransceiverInit.direction = webrtc::RtpTransceiverDirection::kSendOnly;
+    peer_connection->AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO,
+        rtpTransceiverInit);
+    peer_connection->AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO,
+        rtpTransceiverInit);
+
+    return peer_connection;
+}
+
+void PeerConnectionPool::SetSize(size_t size) {
+    size_ = size;
+
+    std::deque<WarmPeerConnection> removed;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        while (pool_.size() > size_) {
+            removed.push_back(std::move(pool_.back()));
+            pool_.pop_back();
+        }
+    }
+    for (auto& warm : removed) {
+        warm.peer_connection->Close();
+        warm.peer_connection = nullptr;
+    }
+
+    Refill();
+}
+
+bool PeerConnectionPool::Acquire(WarmPeerConnection* warm) {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        if (pool_.empty()) {
+            return false;
+        }
+        *warm = std::move(pool_.front());
+        pool_.pop_front();
+    }
+
+    // 当前这次推流还在建立，补充放到之后，不和它抢api线程
+    if (!refill_pending_.exchange(true)) {
+        KRTCGlobal::Instance()->api_thread()->PostTask([this]() {
+            refill_pending_ = false;
+            Refill();
+        });
+    }
+    return true;
+}
+
+void PeerConnectionPool::Refill() {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> locker(mutex_);
+            if (pool_.size() >= size_) {
+                return;
+            }
+        }
+
+        WarmPeerConnection warm;
+        warm.observer = std::make_unique<PeerConnectionObserverProxy>();
+        warm.peer_connection = CreatePushPeerConnection(warm.observer.get(), true);
+        if (!warm.peer_connection) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> locker(mutex_);
+        pool_.push_back(std::move(warm));
+    }
+}
+
+} // namespace krtc
@@ -0,0 +1,71 @@
+#ifndef KRTCSDK_KRTC_MEDIA_PEER_CONNECTION_POOL_H_
+#define KRTCSDK_KRTC_MEDIA_PEER_CONNECTION_POOL_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <api/peer_connection_interface.h>
+
+namespace krtc {
+
+// PeerConnection创建时就要绑定observer，预创建的连接先绑定到这个转发对象，
+// 取出使用时再把真正的observer设置进来。回调都在signaling线程。
+class PeerConnectionObserverProxy : public webrtc::PeerConnectionObserver {
+public:
+    void SetTarget(webrtc::PeerConnectionObserver* target) { target_ = target; }
+
+    void OnSignalingChange(
+        webrtc::PeerConnectionInterface::SignalingState new_state) override;
+    void OnDataChannel(
+        rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) override;
+    void OnNegotiationNeededEvent(uint32_t event_id) override;
+    void OnIceConnectionChange(
+        webrtc::PeerConnectionInterface::IceConnectionState new_state) override;
+    void OnConnectionChange(
+        webrtc::PeerConnectionInterface::PeerConnectionState new_state) override;
+    void OnIceGatheringChange(
+        webrtc::PeerConnectionInterface::IceGatheringState new_state) override;
+    void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override;
+    void OnAddTrack(rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+        const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>& streams) override;
+
+private:
+    std::atomic<webrtc::PeerConnectionObserver*> target_{ nullptr };
+};
+
+struct WarmPeerConnection {
+    // observer要比peer_connection活得久，释放时先释放peer_connection
+    std::unique_ptr<PeerConnectionObserverProxy> observer;
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection;
+};
+
+// 推流用的PeerConnection预创建池：音视频sendonly收发器已添加，
+// 并通过ice_candidate_pool_size提前收集ICE候选，Start()时省掉这部分耗时。
+// 补充在api线程进行，Acquire可以在任意线程调用。
+class PeerConnectionPool {
+public:
+    // 创建推流用的PeerConnection，prewarm_ice为true时立即开始收集候选
+    static rtc::scoped_refptr<webrtc::PeerConnectionInterface> CreatePushPeerConnection(
+        webrtc::PeerConnectionObserver* observer, bool prewarm_ice);
+
+    void SetSize(size_t size);
+    size_t size() const { return size_; }
+
+    // 池为空时返回false，取出后异步补充
+    bool Acquire(WarmPeerConnection* warm);
+
+private:
+    void Refill();
+
+    std::atomic<size_t> size_{ 0 };
+    std::atomic<bool> refill_pending_{ false };
+    std::mutex mutex_;
+    std::deque<WarmPeerConnection> pool_;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_PEER_CONNECTION_POOL_H_
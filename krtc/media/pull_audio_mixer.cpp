@@ -0,0 +1,331 @@
+#include "krtc/media/pull_audio_mixer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <audio/remix_resample.h>
+#include <rtc_base/logging.h>
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/media/media_frame.h"
+#include "krtc/media/audio_mix_kernels.h"
+
+namespace krtc {
+
+namespace {
+
+const int kFrameDurationMs = 10;
+// 每10ms衰减一次，约-22dB/s，说话间隙不会马上被切走
+const float kLevelDecay = 0.95f;
+
+} // namespace
+
+void PullAudioMixer::Stream::SetFormat(int sample_rate, size_t channels) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    converted_.sample_rate_hz_ = sample_rate;
+    converted_.num_channels_ = channels;
+    frame_size_ = static_cast<size_t>(sample_rate / 100) * channels;
+    ring_.assign(frame_size_ * kMaxQueuedFrames, 0);
+    read_index_ = 0;
+    queued_ = 0;
+}
+
+bool PullAudioMixer::Stream::Pop(size_t frame_size, int16_t* dst) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    // 格式刚改过，混音线程还拿着旧的配置
+    if (queued_ == 0 || frame_size != frame_size_) {
+        return false;
+    }
+    memcpy(dst, &ring_[read_index_ * frame_size_], frame_size_ * sizeof(int16_t));
+    read_index_ = (read_index_ + 1) % kMaxQueuedFrames;
+    queued_--;
+    return true;
+}
+
+void PullAudioMixer::Stream::OnData(const void* audio_data,
+    int bits_per_sample,
+    int sample_rate,
+    size_t number_of_channels,
+    size_t number_of_frames)
+{
+    if (bits_per_sample != 16) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (frame_size_ == 0) {
+        return;
+    }
+
+    webrtc::RemixAndResample(static_cast<const int16_t*>(audio_data), number_of_frames,
+        number_of_channels, sample_rate, &resampler_, &converted_);
+    // 远端音轨每次回调10ms
+    if (converted_.samples_per_channel_ * converted_.num_channels_ != frame_size_) {
+        return;
+    }
+
+    if (queued_ == kMaxQueuedFrames) {
+        read_index_ = (read_index_ + 1) % kMaxQueuedFrames;
+        queued_--;
+    }
+    size_t write_index = (read_index_ + queued_) % kMaxQueuedFrames;
+    memcpy(&ring_[write_index * frame_size_], converted_.data(), frame_size_ * sizeof(int16_t));
+    queued_++;
+}
+
+PullAudioMixer::PullAudioMixer() {
+}
+
+PullAudioMixer::~PullAudioMixer() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        quit_ = true;
+    }
+    cond_.notify_all();
+    if (mix_thread_) {
+        mix_thread_->join();
+    }
+}
+
+void PullAudioMixer::SetConfig(const KRTCAudioMixConfig& config) {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        config_ = config;
+        config_.max_active_streams = std::max<uint32_t>(config_.max_active_streams, 1);
+        config_.sample_rate = std::min<uint32_t>(std::max<uint32_t>(config_.sample_rate / 100 * 100, 8000), 48000);
+        config_.channels = std::min<uint32_t>(std::max<uint32_t>(config_.channels, 1), 2);
+
+        // 已经在拉的流按新配置挂上或摘下，播放静音也一起更新
+        for (auto& pair : streams_) {
+            pair.second->SetFormat(config_.sample_rate, config_.channels);
+            UpdateStream(pair.first, pair.second.get());
+        }
+    }
+    cond_.notify_all();
+}
+
+KRTCAudioMixConfig PullAudioMixer::config() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return config_;
+}
+
+PullAudioMixer::StreamId PullAudioMixer::AddStream() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    StreamId id = next_id_++;
+    streams_[id] = std::make_shared<Stream>();
+    return id;
+}
+
+void PullAudioMixer::RemoveStream(StreamId id) {
+    DetachTrack(id);
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    streams_.erase(id);
+}
+
+void PullAudioMixer::AttachTrack(StreamId id, rtc::scoped_refptr<webrtc::AudioTrackInterface> track) {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        auto iter = streams_.find(id);
+        if (!track || iter == streams_.end() || iter->second->track) {
+            return;
+        }
+
+        // 混音关闭时也记下音轨，之后打开混音时直接挂上
+        iter->second->track = track;
+        UpdateStream(id, iter->second.get());
+    }
+    cond_.notify_all();
+}
+
+void PullAudioMixer::DetachTrack(StreamId id) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto iter = streams_.find(id);
+    if (iter == streams_.end() || !iter->second->track) {
+        return;
+    }
+
+    Stream* stream = iter->second.get();
+    if (stream->sink_added) {
+        // 返回后不会再有OnData回调，混音线程手里的shared_ptr保证stream仍然有效
+        stream->track->RemoveSink(stream);
+        stream->sink_added = false;
+        attached_--;
+        RTC_LOG(LS_INFO) << "pull audio mixer detach stream " << id;
+    }
+    stream->playout_muted = false;
+    stream->track = nullptr;
+}
+
+void PullAudioMixer::UpdateStream(StreamId id, Stream* stream) {
+    if (!stream->track) {
+        return;
+    }
+
+    // 挂sink和改音量都不会回调到mixer，可以在mutex_里做，保证和配置修改的顺序一致
+    const bool mix = config_.enable;
+    if (mix && !stream->sink_added) {
+        stream->SetFormat(config_.sample_rate, config_.channels);
+        stream->track->AddSink(stream);
+        stream->sink_added = true;
+        attached_++;
+        if (!mix_thread_) {
+            mix_thread_.reset(new std::thread([this] {
+                MixThread();
+            }));
+        }
+        RTC_LOG(LS_INFO) << "pull audio mixer attach stream " << id;
+    }
+    else if (!mix && stream->sink_added) {
+        stream->track->RemoveSink(stream);
+        stream->sink_added = false;
+        attached_--;
+        RTC_LOG(LS_INFO) << "pull audio mixer detach stream " << id;
+    }
+
+    // sink拿到的是音量缩放之前的数据，播放静音不影响混音
+    const bool mute_playout = mix && config_.mute_playout;
+    if (mute_playout != stream->playout_muted) {
+        stream->track->GetSource()->SetVolume(mute_playout ? 0.0 : 1.0);
+        stream->playout_muted = mute_playout;
+    }
+}
+
+void PullAudioMixer::SetGain(StreamId id, float gain) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto iter = streams_.find(id);
+    if (iter != streams_.end()) {
+        iter->second->gain = std::max(gain, 0.0f);
+    }
+}
+
+void PullAudioMixer::SetMute(StreamId id, bool mute) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto iter = streams_.find(id);
+    if (iter != streams_.end()) {
+        iter->second->mute = mute;
+    }
+}
+
+void PullAudioMixer::MixThread() {
+    const auto interval = std::chrono::milliseconds(kFrameDurationMs);
+    auto next = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Stream>> streams;
+    std::vector<float> gains;
+    while (true) {
+        KRTCAudioMixConfig config;
+        {
+            std::unique_lock<std::mutex> locker(mutex_);
+            if (attached_ == 0 && !quit_) {
+                // 没有拉流时不空转
+                cond_.wait(locker, [this] { return attached_ > 0 || quit_; });
+                next = std::chrono::steady_clock::now();
+            }
+            if (quit_) {
+                return;
+            }
+
+            config = config_;
+            streams.clear();
+            gains.clear();
+            for (auto& pair : streams_) {
+                if (pair.second->sink_added) {
+                    streams.push_back(pair.second);
+                    gains.push_back(pair.second->mute ? 0.0f : pair.second->gain);
+                }
+            }
+        }
+
+        Mix(config, streams, gains);
+
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void PullAudioMixer::Mix(const KRTCAudioMixConfig& config,
+    const std::vector<std::shared_ptr<Stream>>& streams,
+    const std::vector<float>& gains)
+{
+    const size_t frame_size = static_cast<size_t>(config.sample_rate / 100) * config.channels;
+
+    bool has_frame = false;
+    candidates_.clear();
+    for (size_t i = 0; i < streams.size(); i++) {
+        Stream* stream = streams[i].get();
+        stream->samples.resize(frame_size);
+        stream->has_frame = stream->Pop(frame_size, stream->samples.data());
+        stream->target_gain = 0.0f;
+        if (!stream->has_frame) {
+            // 断流后重新出现时从0渐入
+            stream->level *= kLevelDecay;
+            stream->applied_gain = 0.0f;
+            continue;
+        }
+
+        has_frame = true;
+        stream->level = std::max(AudioMeanSquare(stream->samples.data(), frame_size),
+            stream->level * kLevelDecay);
+        if (gains[i] > 0.0f) {
+            candidates_.push_back(i);
+        }
+    }
+    if (!has_frame) {
+        return;
+    }
+
+    // 选音量最大的几路
+    size_t active = std::min<size_t>(candidates_.size(), config.max_active_streams);
+    std::partial_sort(candidates_.begin(), candidates_.begin() + active, candidates_.end(),
+        [&streams](size_t a, size_t b) {
+            return streams[a]->level > streams[b]->level;
+        });
+    for (size_t i = 0; i < active; i++) {
+        streams[candidates_[i]]->target_gain = gains[candidates_[i]];
+    }
+
+    accumulator_.assign(frame_size, 0.0f);
+    for (auto& stream : streams) {
+        if (!stream->has_frame || (stream->applied_gain == 0.0f && stream->target_gain == 0.0f)) {
+            continue;
+        }
+        // 刚被选中或被切走的一路在这一帧内淡入淡出
+        AudioMixWithRamp(stream->samples.data(), frame_size,
+            stream->applied_gain, stream->target_gain, accumulator_.data());
+        stream->applied_gain = stream->target_gain;
+    }
+
+    output_.resize(frame_size);
+    AudioFloatToS16(accumulator_.data(), frame_size, output_.data());
+
+    KRTCEngineObserver* observer = KRTCGlobal::Instance()->engine_observer();
+    if (!observer) {
+        return;
+    }
+
+    int len = static_cast<int>(frame_size * sizeof(int16_t));
+    auto frame = std::make_shared<MediaFrame>(len);
+    frame->fmt.media_type = MainMediaType::kMainTypeAudio;
+    frame->fmt.sub_fmt.audio_fmt.type = SubMediaType::kSubTypePcm;
+    frame->fmt.sub_fmt.audio_fmt.nbytes_per_sample = sizeof(int16_t) * config.channels;
+    frame->fmt.sub_fmt.audio_fmt.samples_per_channel = config.sample_rate / 100;
+    frame->fmt.sub_fmt.audio_fmt.channels = config.channels;
+    frame->fmt.sub_fmt.audio_fmt.samples_per_sec = config.sample_rate;
+    frame->data_len[0] = len;
+    frame->data[0] = new char[len];
+    memcpy(frame->data[0], output_.data(), len);
+
+    // 按采样数单调递增
+    timestamp_ += config.sample_rate / 100;
+    frame->ts = timestamp_;
+
+    observer->OnMixedAudioFrame(frame);
+}
+
+} // namespace krtc
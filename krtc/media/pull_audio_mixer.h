@@ -0,0 +1,117 @@
+#ifndef KRTCSDK_KRTC_MEDIA_PULL_AUDIO_MIXER_H_
+#define KRTCSDK_KRTC_MEDIA_PULL_AUDIO_MIXER_H_
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <api/audio/audio_frame.h>
+#include <api/media_stream_interface.h>
+#include <common_audio/resampler/include/push_resampler.h>
+
+#include "krtc/krtc.h"
+
+namespace krtc {
+
+// 把多路拉流解码后的音频混成一路，通过OnMixedAudioFrame回调。
+// 每10ms从各路取一帧，按音量选出最活跃的几路，乘上各自的增益后叠加。
+// 数据来自远端音轨的sink，只有拉流的音频设备在播放时才会有数据，
+// 所以mute_playout是把播放音量置0而不是停止播放。
+class PullAudioMixer {
+public:
+    using StreamId = uint32_t;
+
+    PullAudioMixer();
+    ~PullAudioMixer();
+
+    void SetConfig(const KRTCAudioMixConfig& config);
+    KRTCAudioMixConfig config();
+
+    // 每个拉流对象一路，增益和静音在重新拉流后保留
+    StreamId AddStream();
+    void RemoveStream(StreamId id);
+
+    // 拉到远端音轨后挂上，停止拉流时摘下，需要在api线程调用。
+    // 混音关闭时也要挂上，之后打开混音时已有的拉流直接参与
+    void AttachTrack(StreamId id, rtc::scoped_refptr<webrtc::AudioTrackInterface> track);
+    void DetachTrack(StreamId id);
+
+    void SetGain(StreamId id, float gain);
+    void SetMute(StreamId id, bool mute);
+
+private:
+    class Stream : public webrtc::AudioTrackSinkInterface {
+    public:
+        void SetFormat(int sample_rate, size_t channels);
+        // 取最早的一帧，没有数据时返回false
+        bool Pop(size_t frame_size, int16_t* dst);
+
+        // webrtc::AudioTrackSinkInterface
+        void OnData(const void* audio_data,
+            int bits_per_sample,
+            int sample_rate,
+            size_t number_of_channels,
+            size_t number_of_frames) override;
+
+        // 以下由mixer的mutex_保护
+        // 拉流的远端音轨，混音关闭时也保留
+        rtc::scoped_refptr<webrtc::AudioTrackInterface> track;
+        // 已挂上sink参与混音
+        bool sink_added = false;
+        // 拉流自己的播放音量已置0
+        bool playout_muted = false;
+        float gain = 1.0f;
+        bool mute = false;
+
+        // 以下只在混音线程访问
+        std::vector<int16_t> samples;
+        bool has_frame = false;
+        // 快起慢落的音量包络，用来挑选活跃的几路
+        float level = 0.0f;
+        // 本帧的目标增益，没被选中的为0
+        float target_gain = 0.0f;
+        // 上一帧实际使用的增益，增益变化时在一帧内渐变
+        float applied_gain = 0.0f;
+
+    private:
+        // 最多缓存80ms，超出后丢最早的帧
+        static const size_t kMaxQueuedFrames = 8;
+
+        std::mutex mutex_;
+        webrtc::PushResampler<int16_t> resampler_;
+        webrtc::AudioFrame converted_;
+        std::vector<int16_t> ring_;
+        size_t frame_size_ = 0;
+        size_t read_index_ = 0;
+        size_t queued_ = 0;
+    };
+
+    // 按当前配置挂上或摘下sink、设置播放静音，需要持有mutex_
+    void UpdateStream(StreamId id, Stream* stream);
+    void MixThread();
+    void Mix(const KRTCAudioMixConfig& config,
+             const std::vector<std::shared_ptr<Stream>>& streams,
+             const std::vector<float>& gains);
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    KRTCAudioMixConfig config_;
+    std::map<StreamId, std::shared_ptr<Stream>> streams_;
+    StreamId next_id_ = 1;
+    size_t attached_ = 0;
+    bool quit_ = false;
+    std::unique_ptr<std::thread> mix_thread_;
+
+    // 只在混音线程访问
+    std::vector<float> accumulator_;
+    std::vector<int16_t> output_;
+    std::vector<size_t> candidates_;
+    uint32_t timestamp_ = 0;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_PULL_AUDIO_MIXER_H_
@@ -0,0 +1,41 @@
+#include "krtc/media/signaling.h"
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/media/srs_signaling.h"
+#include "krtc/media/whip_signaling.h"
+
+namespace krtc {
+
+std::unique_ptr<Signaling> Signaling::Create(const SIGNALING_PROTOCOL& protocol,
+    const CONTROL_TYPE& type,
+    const std::string& server_addr,
+    const std::string& channel,
+    HttpObjectHandle owner)
+{
+    switch (protocol) {
+    case SIGNALING_PROTOCOL::WHIP:
+        // WHIP/WHEP的endpoint已经确定了流，channel不再使用
+        return std::make_unique<WhipSignaling>(server_addr, owner);
+    case SIGNALING_PROTOCOL::SRS:
+    default:
+        return std::make_unique<SrsSignaling>(type, server_addr, channel, owner);
+    }
+}
+
+void Signaling::RestartIce(const std::string& offer, AnswerCallback callback) {
+    Stop();
+    SendOffer(offer, callback);
+}
+
+void Signaling::PostReply(HttpObjectHandle owner, const HttpReply& reply,
+    std::function<void(const HttpReply&)> handler)
+{
+    // 切到api线程的途中对象可能已被销毁，再检查一次句柄
+    KRTCGlobal::Instance()->api_thread()->PostTask([=]() {
+        if (KRTCGlobal::Instance()->http_manager()->IsObjectAlive(owner)) {
+            handler(reply);
+        }
+    });
+}
+
+} // namespace krtc
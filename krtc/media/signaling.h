@@ -0,0 +1,56 @@
+#ifndef KRTCSDK_KRTC_MEDIA_SIGNALING_H_
+#define KRTCSDK_KRTC_MEDIA_SIGNALING_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <api/jsep.h>
+
+#include "krtc/krtc.h"
+#include "krtc/base/krtc_http.h"
+
+namespace krtc {
+
+// 推拉流的信令：发送offer换回answer。实现都只在api线程使用，
+// HTTP应答切回api线程并确认owner(推拉流对象)仍然存活后才回调。
+class Signaling {
+public:
+    // err为kNoErr时answer为远端sdp
+    using AnswerCallback = std::function<void(KRTCError err, const std::string& answer)>;
+
+    static std::unique_ptr<Signaling> Create(const SIGNALING_PROTOCOL& protocol,
+        const CONTROL_TYPE& type,
+        const std::string& server_addr,
+        const std::string& channel,
+        HttpObjectHandle owner);
+
+    virtual ~Signaling() = default;
+
+    // 信令请求的地址，可用于提前建立连接
+    virtual std::string endpoint() const = 0;
+
+    virtual void SendOffer(const std::string& offer, AnswerCallback callback) = 0;
+
+    // trickle ICE，不支持的协议直接忽略
+    virtual void SendCandidate(const webrtc::IceCandidateInterface* candidate) {}
+    virtual void OnGatheringComplete() {}
+
+    // 结束会话，释放服务端资源
+    virtual void Stop() {}
+
+    // 能否在当前会话上用新ICE凭据重新协商。不能时重连直接重建PeerConnection
+    virtual bool SupportsIceRestart() const { return false; }
+
+    // 带新ICE凭据的offer(ICE restart)。默认结束当前会话，把offer作为新会话重新发送
+    virtual void RestartIce(const std::string& offer, AnswerCallback callback);
+
+protected:
+    // 把HTTP应答切回api线程，owner已销毁时丢弃
+    static void PostReply(HttpObjectHandle owner, const HttpReply& reply,
+        std::function<void(const HttpReply&)> handler);
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_SIGNALING_H_
@@ -0,0 +1,116 @@
+#include "krtc/media/srs_signaling.h"
+
+#include <vector>
+
+#include <rtc_base/helpers.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+#include <rtc_base/strings/json.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+namespace {
+
+// SRS的ERROR_SYSTEM_STREAM_BUSY
+const int kSrsStreamBusyCode = 1028;
+
+} // namespace
+
+SrsSignaling::SrsSignaling(const CONTROL_TYPE& type,
+    const std::string& server_addr,
+    const std::string& channel,
+    HttpObjectHandle owner) :
+    owner_(owner)
+{
+    std::vector<std::string> splits;
+    if (!rtc::tokenize(server_addr, '/', &splits)) {
+        return;
+    }
+
+    if (splits.size() < 2) {
+        return;
+    }
+
+    std::string server_ip, server_port;
+    if (!rtc::tokenize_first(splits[1], ':', &server_ip, &server_port)) {
+        return;
+    }
+
+    std::string control;
+    if (type == CONTROL_TYPE::PUSH) {
+        // http://1.14.148.67:1985/rtc/v1/publish/
+        control = "publish";
+    }
+    else if (type == CONTROL_TYPE::PULL) {
+        // http://1.14.148.67:1985/rtc/v1/play/
+        control = "play";
+    }
+
+    httpRequestUrl_ = server_addr + "/rtc/v1/" + control + "/";
+
+    if (!channel.empty()) {
+        channel_ = channel;
+    }
+
+    // webrtc://1.14.148.67/live/livestream
+    webrtcStreamUrl_ = "webrtc://" + server_ip + "/live/" + channel_;
+}
+
+void SrsSignaling::SendOffer(const std::string& offer, AnswerCallback callback) {
+    Json::Value reqMsg;
+    reqMsg["api"] = httpRequestUrl_;
+    reqMsg["streamurl"] = webrtcStreamUrl_;
+    reqMsg["sdp"] = offer;
+    reqMsg["tid"] = rtc::CreateRandomString(7);
+    Json::StreamWriterBuilder write_builder;
+    write_builder.settings_["indentation"] = "";
+    std::string json_data = Json::writeString(write_builder, reqMsg);
+
+    HttpRequest request(httpRequestUrl_, json_data);
+    HttpObjectHandle owner = owner_;
+    KRTCGlobal::Instance()->http_manager()->Post(request, [=](HttpReply reply) {
+        RTC_LOG(LS_INFO) << "signaling response, url: " << reply.get_url()
+            << ", status: " << reply.get_status_code()
+            << ", err_no: " << reply.get_errno()
+            << ", err_msg: " << reply.get_err_msg()
+            << ", duration: " << reply.get_duration() << "ms"
+            << ", reused_connection: " << reply.get_reused_connection()
+            << ", response: " << reply.get_resp();
+        PostReply(owner, reply, [this, callback](const HttpReply& reply) {
+            HandleResponse(reply, callback);
+        });
+    }, owner_);
+}
+
+void SrsSignaling::HandleResponse(const HttpReply& reply, AnswerCallback callback) {
+    if (reply.get_status_code() != 200 || reply.get_errno() != 0) {
+        RTC_LOG(LS_INFO) << "http post error";
+        callback(KRTCError::kSendOfferErr, "");
+        return;
+    }
+
+    std::string responseBody = reply.get_resp();
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value root;
+    JSONCPP_STRING err;
+    reader->parse(responseBody.data(), responseBody.data() + responseBody.size(), &root, &err);
+    if (!err.empty()) {
+        RTC_LOG(LS_WARNING) << "Received unknown message. " << responseBody;
+        callback(KRTCError::kParseAnswerErr, "");
+        return;
+    }
+
+    int code = root["code"].asInt();
+    if (code != 0) {
+        RTC_LOG(LS_INFO) << "http response error, code: " << code;
+        callback(code == kSrsStreamBusyCode ? KRTCError::kStreamBusyErr : KRTCError::kAnswerResponseErr, "");
+        return;
+    }
+
+    callback(KRTCError::kNoErr, root["sdp"].asString());
+}
+
+} // namespace krtc
@@ -0,0 +1,35 @@
+#ifndef KRTCSDK_KRTC_MEDIA_SRS_SIGNALING_H_
+#define KRTCSDK_KRTC_MEDIA_SRS_SIGNALING_H_
+
+#include "krtc/media/signaling.h"
+
+namespace krtc {
+
+// SRS的HTTP JSON接口：POST /rtc/v1/publish/ 或 /rtc/v1/play/，
+// body里带streamurl和sdp，应答JSON的sdp字段为answer。
+// 接口没有结束会话的请求，旧会话还在时同一个流再次publish会被SRS以stream busy拒绝
+// (回调kStreamBusyErr)，所以不支持ICE restart
+class SrsSignaling : public Signaling {
+public:
+    // server_addr  = https://charlescao92.cn:1986
+    SrsSignaling(const CONTROL_TYPE& type,
+        const std::string& server_addr,
+        const std::string& channel,
+        HttpObjectHandle owner);
+
+    std::string endpoint() const override { return httpRequestUrl_; }
+
+    void SendOffer(const std::string& offer, AnswerCallback callback) override;
+
+private:
+    void HandleResponse(const HttpReply& reply, AnswerCallback callback);
+
+    std::string httpRequestUrl_;
+    std::string webrtcStreamUrl_;
+    std::string channel_ = "livestream";
+    HttpObjectHandle owner_;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_SRS_SIGNALING_H_
@@ -0,0 +1,325 @@
+#include "krtc/media/whip_signaling.h"
+
+#include <absl/strings/match.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+
+#include "krtc/base/krtc_global.h"
+
+namespace krtc {
+
+WhipSignaling::WhipSignaling(const std::string& endpoint, HttpObjectHandle owner) :
+    endpoint_(endpoint),
+    owner_(owner)
+{
+}
+
+void WhipSignaling::SendOffer(const std::string& offer, AnswerCallback callback) {
+    ParseOffer(offer);
+    ++session_;
+    resource_url_.clear();
+    remote_answer_.clear();
+    pending_candidates_.clear();
+    gathering_complete_ = false;
+    end_of_candidates_sent_ = false;
+    patch_in_flight_ = false;
+
+    HttpRequest request(endpoint_, offer);
+    request.set_content_type("application/sdp");
+    HttpObjectHandle owner = owner_;
+    KRTCGlobal::Instance()->http_manager()->Post(request, [=](HttpReply reply) {
+        RTC_LOG(LS_INFO) << "whip response, url: " << reply.get_url()
+            << ", status: " << reply.get_status_code()
+            << ", err_no: " << reply.get_errno()
+            << ", err_msg: " << reply.get_err_msg()
+            << ", location: " << reply.get_location()
+            << ", duration: " << reply.get_duration() << "ms"
+            << ", reused_connection: " << reply.get_reused_connection();
+        PostReply(owner, reply, [this, callback](const HttpReply& reply) {
+            HandleOfferResponse(reply, callback);
+        });
+    }, owner_);
+}
+
+void WhipSignaling::HandleOfferResponse(const HttpReply& reply, AnswerCallback callback) {
+    if (reply.get_errno() != 0 ||
+        (reply.get_status_code() != 201 && reply.get_status_code() != 200)) {
+        RTC_LOG(LS_INFO) << "whip post error";
+        callback(KRTCError::kSendOfferErr, "");
+        return;
+    }
+
+    std::string answer = reply.get_resp();
+    if (!absl::StartsWith(answer, "v=")) {
+        RTC_LOG(LS_WARNING) << "whip response is not sdp: " << answer;
+        callback(KRTCError::kParseAnswerErr, "");
+        return;
+    }
+
+    if (reply.get_location().empty()) {
+        RTC_LOG(LS_WARNING) << "whip response without Location, trickle and teardown disabled";
+    }
+    else {
+        resource_url_ = ResolveUrl(reply.get_location());
+    }
+    remote_answer_ = answer;
+
+    callback(KRTCError::kNoErr, answer);
+
+    // answer之前收集到的候选
+    FlushCandidates();
+}
+
+void WhipSignaling::SendCandidate(const webrtc::IceCandidateInterface* candidate) {
+    std::string mid = candidate->sdp_mid();
+    if (mid.empty()) {
+        size_t index = static_cast<size_t>(candidate->sdp_mline_index());
+        if (index >= media_sections_.size()) {
+            return;
+        }
+        mid = media_sections_[index].mid;
+    }
+
+    std::string line;
+    if (!candidate->ToString(&line)) {
+        return;
+    }
+    pending_candidates_[mid].push_back("a=" + line);
+    FlushCandidates();
+}
+
+void WhipSignaling::OnGatheringComplete() {
+    gathering_complete_ = true;
+    FlushCandidates();
+}
+
+void WhipSignaling::Stop() {
+    ++session_;
+    pending_candidates_.clear();
+    patch_in_flight_ = false;
+    if (resource_url_.empty()) {
+        return;
+    }
+
+    // 不需要应答，owner此时一般已经在销毁
+    HttpRequest request(resource_url_);
+    KRTCGlobal::Instance()->http_manager()->Delete(request, nullptr, kInvalidHttpObjectHandle);
+    resource_url_.clear();
+}
+
+void WhipSignaling::RestartIce(const std::string& offer, AnswerCallback callback) {
+    if (resource_url_.empty() || !trickle_supported_) {
+        Signaling::RestartIce(offer, callback);
+        return;
+    }
+
+    ParseOffer(offer);
+    ++session_;
+    pending_candidates_.clear();
+    gathering_complete_ = false;
+    end_of_candidates_sent_ = false;
+    // 应答回来之前新收集的候选先攒着
+    patch_in_flight_ = true;
+
+    std::string fragment = "a=ice-ufrag:" + ice_ufrag_ + "\r\n" + "a=ice-pwd:" + ice_pwd_ + "\r\n";
+    for (auto& section : media_sections_) {
+        fragment += section.m_line + "\r\n";
+        fragment += "a=mid:" + section.mid + "\r\n";
+    }
+
+    HttpRequest request(resource_url_, fragment);
+    request.set_content_type("application/trickle-ice-sdpfrag");
+    request.add_header("If-Match: *");
+    HttpObjectHandle owner = owner_;
+    uint32_t session = session_;
+    KRTCGlobal::Instance()->http_manager()->Patch(request, [=](HttpReply reply) {
+        PostReply(owner, reply, [this, offer, callback, session](const HttpReply& reply) {
+            if (session != session_) {
+                return;
+            }
+            patch_in_flight_ = false;
+
+            if (reply.get_errno() == 0 && reply.get_status_code() == 200) {
+                std::string answer = MergeRestartAnswer(reply.get_resp());
+                if (!answer.empty()) {
+                    remote_answer_ = answer;
+                    callback(KRTCError::kNoErr, answer);
+                    FlushCandidates();
+                    return;
+                }
+            }
+
+            RTC_LOG(LS_WARNING) << "whip ice restart rejected, status: " << reply.get_status_code()
+                << ", err_msg: " << reply.get_err_msg() << ", fall back to a new session";
+            Signaling::RestartIce(offer, callback);
+        });
+    }, owner_);
+}
+
+void WhipSignaling::FlushCandidates() {
+    if (resource_url_.empty() || patch_in_flight_ || end_of_candidates_sent_ || media_sections_.empty()) {
+        return;
+    }
+    bool send_end = gathering_complete_;
+    if (pending_candidates_.empty() && !send_end) {
+        return;
+    }
+
+    // RFC 8840 sdpfrag
+    std::string fragment = "a=ice-ufrag:" + ice_ufrag_ + "\r\n" + "a=ice-pwd:" + ice_pwd_ + "\r\n";
+    for (size_t i = 0; i < media_sections_.size(); i++) {
+        auto iter = pending_candidates_.find(media_sections_[i].mid);
+        bool has_candidates = iter != pending_candidates_.end();
+        // BUNDLE下候选都在第一个m段上，end-of-candidates也只发一次
+        if (!has_candidates && !(send_end && i == 0)) {
+            continue;
+        }
+        fragment += media_sections_[i].m_line + "\r\n";
+        fragment += "a=mid:" + media_sections_[i].mid + "\r\n";
+        if (has_candidates) {
+            for (auto& line : iter->second) {
+                fragment += line + "\r\n";
+            }
+        }
+        if (send_end && i == 0) {
+            fragment += "a=end-of-candidates\r\n";
+        }
+    }
+    pending_candidates_.clear();
+    end_of_candidates_sent_ = send_end;
+    patch_in_flight_ = true;
+
+    HttpRequest request(resource_url_, fragment);
+    request.set_content_type("application/trickle-ice-sdpfrag");
+    HttpObjectHandle owner = owner_;
+    uint32_t session = session_;
+    KRTCGlobal::Instance()->http_manager()->Patch(request, [=](HttpReply reply) {
+        PostReply(owner, reply, [this, session](const HttpReply& reply) {
+            if (session != session_) {
+                return;
+            }
+            patch_in_flight_ = false;
+            if (reply.get_status_code() == 405 || reply.get_status_code() == 501) {
+                // 服务端不支持trickle，answer里的候选已经够用
+                RTC_LOG(LS_INFO) << "whip server does not support trickle ice";
+                trickle_supported_ = false;
+                end_of_candidates_sent_ = true;
+                pending_candidates_.clear();
+                return;
+            }
+            if (reply.get_errno() != 0 || reply.get_status_code() / 100 != 2) {
+                RTC_LOG(LS_WARNING) << "whip patch error, status: " << reply.get_status_code()
+                    << ", err_msg: " << reply.get_err_msg();
+            }
+            FlushCandidates();
+        });
+    }, owner_);
+}
+
+void WhipSignaling::ParseOffer(const std::string& offer) {
+    ice_ufrag_.clear();
+    ice_pwd_.clear();
+    media_sections_.clear();
+
+    std::vector<std::string> lines;
+    rtc::split(offer, '\n', &lines);
+    for (auto& line : lines) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (absl::StartsWith(line, "m=")) {
+            media_sections_.push_back({ line, std::to_string(media_sections_.size()) });
+        }
+        else if (absl::StartsWith(line, "a=mid:") && !media_sections_.empty()) {
+            media_sections_.back().mid = line.substr(6);
+        }
+        else if (absl::StartsWith(line, "a=ice-ufrag:") && ice_ufrag_.empty()) {
+            ice_ufrag_ = line.substr(12);
+        }
+        else if (absl::StartsWith(line, "a=ice-pwd:") && ice_pwd_.empty()) {
+            ice_pwd_ = line.substr(10);
+        }
+    }
+}
+
+std::string WhipSignaling::MergeRestartAnswer(const std::string& fragment) const {
+    std::string ufrag, pwd;
+    std::vector<std::string> candidates;
+    std::vector<std::string> lines;
+    rtc::split(fragment, '\n', &lines);
+    for (auto& line : lines) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (absl::StartsWith(line, "a=ice-ufrag:") && ufrag.empty()) {
+            ufrag = line.substr(12);
+        }
+        else if (absl::StartsWith(line, "a=ice-pwd:") && pwd.empty()) {
+            pwd = line.substr(10);
+        }
+        else if (absl::StartsWith(line, "a=candidate:")) {
+            candidates.push_back(line);
+        }
+    }
+    if (ufrag.empty() || pwd.empty() || remote_answer_.empty()) {
+        return "";
+    }
+
+    std::string answer;
+    bool in_media = false;
+    bool candidates_added = false;
+    rtc::split(remote_answer_, '\n', &lines);
+    for (auto& line : lines) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || absl::StartsWith(line, "a=candidate:") || line == "a=end-of-candidates") {
+            continue;
+        }
+
+        if (absl::StartsWith(line, "m=")) {
+            in_media = true;
+        }
+        else if (absl::StartsWith(line, "a=ice-ufrag:")) {
+            line = "a=ice-ufrag:" + ufrag;
+        }
+        else if (absl::StartsWith(line, "a=ice-pwd:")) {
+            line = "a=ice-pwd:" + pwd;
+        }
+        answer += line + "\r\n";
+
+        // BUNDLE下候选都放在第一个m段
+        if (in_media && !candidates_added && absl::StartsWith(line, "a=ice-pwd:")) {
+            for (auto& candidate : candidates) {
+                answer += candidate + "\r\n";
+            }
+            candidates_added = true;
+        }
+    }
+    return answer;
+}
+
+std::string WhipSignaling::ResolveUrl(const std::string& location) const {
+    if (absl::StartsWith(location, "http://") || absl::StartsWith(location, "https://")) {
+        return location;
+    }
+
+    size_t scheme_end = endpoint_.find("://");
+    size_t host_end = (scheme_end == std::string::npos) ? std::string::npos : endpoint_.find('/', scheme_end + 3);
+    std::string origin = endpoint_.substr(0, host_end);
+    if (!location.empty() && location[0] == '/') {
+        return origin + location;
+    }
+
+    // 相对路径，相对于endpoint所在目录
+    std::string path = endpoint_.substr(0, endpoint_.find('?'));
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos || slash < origin.size()) {
+        return origin + "/" + location;
+    }
+    return path.substr(0, slash + 1) + location;
+}
+
+} // namespace krtc
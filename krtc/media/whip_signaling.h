@@ -0,0 +1,65 @@
+#ifndef KRTCSDK_KRTC_MEDIA_WHIP_SIGNALING_H_
+#define KRTCSDK_KRTC_MEDIA_WHIP_SIGNALING_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "krtc/media/signaling.h"
+
+namespace krtc {
+
+// WHIP(推流)/WHEP(拉流)，两者在信令上完全相同：
+// POST application/sdp的offer，201应答body为answer、Location为会话资源地址；
+// 本地候选通过PATCH application/trickle-ice-sdpfrag发给资源地址，结束时DELETE资源地址。
+class WhipSignaling : public Signaling {
+public:
+    WhipSignaling(const std::string& endpoint, HttpObjectHandle owner);
+
+    std::string endpoint() const override { return endpoint_; }
+
+    void SendOffer(const std::string& offer, AnswerCallback callback) override;
+    void SendCandidate(const webrtc::IceCandidateInterface* candidate) override;
+    void OnGatheringComplete() override;
+    void Stop() override;
+    bool SupportsIceRestart() const override { return true; }
+    // 会话资源上PATCH新的ice-ufrag/ice-pwd，服务端不支持时DELETE旧会话后新建会话
+    void RestartIce(const std::string& offer, AnswerCallback callback) override;
+
+private:
+    struct MediaSection {
+        std::string m_line;
+        std::string mid;
+    };
+
+    void HandleOfferResponse(const HttpReply& reply, AnswerCallback callback);
+    void ParseOffer(const std::string& offer);
+    std::string ResolveUrl(const std::string& location) const;
+    // 用ICE restart应答的sdpfrag替换上一次answer里的ICE凭据和候选
+    std::string MergeRestartAnswer(const std::string& fragment) const;
+    // 把积攒的候选合成一个sdpfrag一次PATCH出去，同一时间只有一个PATCH
+    void FlushCandidates();
+
+    std::string endpoint_;
+    HttpObjectHandle owner_;
+    std::string resource_url_;
+    std::string remote_answer_;
+    // 每次新建/结束会话时递增，丢弃旧会话的PATCH应答
+    uint32_t session_ = 0;
+
+    std::string ice_ufrag_;
+    std::string ice_pwd_;
+    std::vector<MediaSection> media_sections_;
+
+    // mid -> a=candidate行
+    std::map<std::string, std::vector<std::string>> pending_candidates_;
+    bool gathering_complete_ = false;
+    bool end_of_candidates_sent_ = false;
+    bool patch_in_flight_ = false;
+    // 服务端对PATCH返回405/501后不再trickle，ICE restart也只能新建会话
+    bool trickle_supported_ = true;
+};
+
+} // namespace krtc
+
+#endif // KRTCSDK_KRTC_MEDIA_WHIP_SIGNALING_H_
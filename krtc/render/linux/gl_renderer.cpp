@@ -0,0 +1,531 @@
+#include "krtc/render/linux/gl_renderer.h"
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+
+#include <rtc_base/checks.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+
+namespace krtc {
+
+namespace {
+
+const char kVertexShader[] = R"(#version 300 es
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 tex_coord;
+out vec2 v_tex_coord;
+void main() {
+    gl_Position = vec4(position, 0.0, 1.0);
+    v_tex_coord = tex_coord;
+}
+)";
+
+const char kFragmentShader[] = R"(#version 300 es
+precision mediump float;
+in vec2 v_tex_coord;
+uniform sampler2D tex_y;
+uniform sampler2D tex_u;
+uniform sampler2D tex_v;
+uniform mat3 yuv_to_rgb;
+out vec4 color;
+void main() {
+    vec3 yuv = vec3(texture(tex_y, v_tex_coord).r - 0.0625,
+                    texture(tex_u, v_tex_coord).r - 0.5,
+                    texture(tex_v, v_tex_coord).r - 0.5);
+    color = vec4(clamp(yuv_to_rgb * yuv, 0.0, 1.0), 1.0);
+}
+)";
+
+// 有限范围YUV转RGB，按列存放(Y、U、V的系数)
+const GLfloat kBT601Matrix[9] = {
+    1.164f, 1.164f, 1.164f,
+    0.0f, -0.392f, 2.017f,
+    1.596f, -0.813f, 0.0f,
+};
+const GLfloat kBT709Matrix[9] = {
+    1.164f, 1.164f, 1.164f,
+    0.0f, -0.213f, 2.112f,
+    1.793f, -0.533f, 0.0f,
+};
+
+// 位置和纹理坐标，纹理的第一行是图像顶部
+const GLfloat kVertices[] = {
+    -1.0f, -1.0f, 0.0f, 1.0f,
+     1.0f, -1.0f, 1.0f, 1.0f,
+    -1.0f,  1.0f, 0.0f, 0.0f,
+     1.0f,  1.0f, 1.0f, 0.0f,
+};
+
+bool HasExtension(const char* extensions, const char* name) {
+    if (!extensions) {
+        return false;
+    }
+    size_t length = strlen(name);
+    for (const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 没有窗口系统时优先用Mesa的surfaceless平台
+EGLDisplay GetHeadlessDisplay() {
+    if (HasExtension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display) {
+            EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+GLuint CompileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[512] = { 0 };
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        RTC_LOG(LS_WARNING) << "compile shader failed: " << log;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+std::unique_ptr<VideoRenderer> VideoRenderer::CreatePlatformRenderer(int hwnd,
+                                                     size_t width,
+                                                     size_t height)
+{
+    return GlRenderer::Create((EGLNativeWindowType)hwnd, width, height);
+}
+
+std::unique_ptr<VideoRenderer> GlRenderer::Create(EGLNativeWindowType window,
+                                            size_t width,
+                                            size_t height)
+{
+    RTC_LOG(LS_INFO) << "GlRenderer Create, window: " << window;
+
+    GlRenderer* gl_renderer = new GlRenderer(window, width, height);
+
+    return absl::WrapUnique(gl_renderer);
+}
+
+GlRenderer::GlRenderer(EGLNativeWindowType window, size_t width, size_t height) :
+    window_(window),
+    width_(width),
+    height_(height),
+    render_thread_(rtc::Thread::Create())
+{
+    RTC_DCHECK_GT(width, 0);
+    RTC_DCHECK_GT(height, 0);
+
+    // EGL上下文绑定在线程上，渲染单独一个线程
+    render_thread_->SetName("gl_render_thread", nullptr);
+    render_thread_->Start();
+}
+
+GlRenderer::~GlRenderer() {
+    render_thread_->BlockingCall([this] {
+        Destroy();
+    });
+    render_thread_->Stop();
+}
+
+VideoRenderer::RenderStats GlRenderer::render_stats() const {
+    return upload_stats_.Get();
+}
+
+bool GlRenderer::ReadOffscreenPixels(std::vector<uint8_t>* rgba, int* width, int* height) {
+    return render_thread_->BlockingCall([&]() {
+        if (window_ != 0 || !framebuffer_ || target_width_ <= 0 || target_height_ <= 0) {
+            return false;
+        }
+
+        size_t row_size = static_cast<size_t>(target_width_) * 4;
+        std::vector<uint8_t> pixels(row_size * target_height_);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+        glReadPixels(0, 0, target_width_, target_height_, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        if (glGetError() != GL_NO_ERROR) {
+            return false;
+        }
+
+        // GL的第一行是底部
+        rgba->resize(pixels.size());
+        for (int y = 0; y < target_height_; y++) {
+            memcpy(rgba->data() + y * row_size, pixels.data() + (target_height_ - 1 - y) * row_size, row_size);
+        }
+        *width = target_width_;
+        *height = target_height_;
+        return true;
+    });
+}
+
+void GlRenderer::OnFrame(const webrtc::VideoFrame& frame) {
+    // 渲染线程来不及时只保留最新一帧
+    if (pending_frame_.Push(frame)) {
+        render_thread_->PostTask([this] {
+            RenderPending();
+        });
+    }
+}
+
+void GlRenderer::RenderPending() {
+    webrtc::VideoFrame::UpdateRect rect;
+    absl::optional<webrtc::VideoFrame> frame = pending_frame_.Pop(&rect);
+    if (!frame || init_failed_) {
+        return;
+    }
+
+    if (display_ == EGL_NO_DISPLAY) {
+        if (!InitEgl() || !InitGl()) {
+            // 不再重试，避免每一帧都去创建
+            init_failed_ = true;
+            Destroy();
+            return;
+        }
+    }
+
+    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer = frame->video_frame_buffer()->ToI420();
+    if (!buffer) {
+        return;
+    }
+
+    if (buffer->width() != texture_width_ || buffer->height() != texture_height_) {
+        if (!ResizeTextures(buffer->width(), buffer->height())) {
+            return;
+        }
+        rect = { 0, 0, buffer->width(), buffer->height() };
+    }
+    if (window_ == 0 && !ResizeOffscreenTarget(buffer->width(), buffer->height())) {
+        return;
+    }
+
+    YuvUploadRegion region;
+    if (YuvUploadRegion::FromUpdateRect(rect, buffer->width(), buffer->height(), &region)) {
+        int64_t upload_us = Upload(buffer.get(), region);
+        if (upload_us < 0) {
+            // 纹理内容不完整，下一帧整帧上传
+            texture_width_ = 0;
+            texture_height_ = 0;
+            return;
+        }
+        upload_stats_.AddUpload(upload_us);
+    }
+
+    Draw(*frame);
+    upload_stats_.AddFrame();
+}
+
+bool GlRenderer::InitEgl() {
+    display_ = window_ != 0 ? eglGetDisplay(EGL_DEFAULT_DISPLAY) : GetHeadlessDisplay();
+    if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, nullptr, nullptr)) {
+        RTC_LOG(LS_WARNING) << "egl initialize failed: " << eglGetError();
+        display_ = EGL_NO_DISPLAY;
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, window_ != 0 ? EGL_WINDOW_BIT : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(display_, config_attribs, &config, 1, &config_count) || config_count == 0) {
+        RTC_LOG(LS_WARNING) << "egl choose config failed: " << eglGetError();
+        return false;
+    }
+
+    const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, context_attribs);
+    if (context_ == EGL_NO_CONTEXT) {
+        RTC_LOG(LS_WARNING) << "egl create context failed: " << eglGetError();
+        return false;
+    }
+
+    if (window_ != 0) {
+        surface_ = eglCreateWindowSurface(display_, config, window_, nullptr);
+    }
+    else if (!HasExtension(eglQueryString(display_, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+        // 离屏渲染到FBO，surface只是为了能MakeCurrent
+        const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface_ = eglCreatePbufferSurface(display_, config, pbuffer_attribs);
+        if (surface_ == EGL_NO_SURFACE) {
+            RTC_LOG(LS_WARNING) << "egl create pbuffer failed: " << eglGetError();
+            return false;
+        }
+    }
+    if (window_ != 0 && surface_ == EGL_NO_SURFACE) {
+        RTC_LOG(LS_WARNING) << "egl create window surface failed: " << eglGetError();
+        return false;
+    }
+
+    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+        RTC_LOG(LS_WARNING) << "egl make current failed: " << eglGetError();
+        return false;
+    }
+
+    RTC_LOG(LS_INFO) << "GlRenderer use " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION);
+    return true;
+}
+
+bool GlRenderer::InitGl() {
+    GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, kVertexShader);
+    GLuint fragment_shader = CompileShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (!vertex_shader || !fragment_shader) {
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+        return false;
+    }
+
+    program_ = glCreateProgram();
+    glAttachShader(program_, vertex_shader);
+    glAttachShader(program_, fragment_shader);
+    glLinkProgram(program_);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    GLint linked = 0;
+    glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        RTC_LOG(LS_WARNING) << "link program failed";
+        return false;
+    }
+
+    glUseProgram(program_);
+    glUniform1i(glGetUniformLocation(program_, "tex_y"), 0);
+    glUniform1i(glGetUniformLocation(program_, "tex_u"), 1);
+    glUniform1i(glGetUniformLocation(program_, "tex_v"), 2);
+    yuv_to_rgb_location_ = glGetUniformLocation(program_, "yuv_to_rgb");
+
+    glGenBuffers(1, &vertex_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kVertices), kVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+        reinterpret_cast<const void*>(2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    glGenTextures(3, textures_);
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glGenBuffers(2, pbos_);
+    // 平面按紧凑排列放进PBO
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void GlRenderer::Destroy() {
+    RTC_LOG(LS_INFO) << "GlRenderer Destroy";
+    if (display_ == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    if (context_ != EGL_NO_CONTEXT && eglGetCurrentContext() == context_) {
+        glDeleteTextures(3, textures_);
+        glDeleteBuffers(2, pbos_);
+        glDeleteBuffers(1, &vertex_buffer_);
+        glDeleteFramebuffers(1, &framebuffer_);
+        glDeleteRenderbuffers(1, &renderbuffer_);
+        glDeleteProgram(program_);
+    }
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface_ != EGL_NO_SURFACE) {
+        eglDestroySurface(display_, surface_);
+        surface_ = EGL_NO_SURFACE;
+    }
+    if (context_ != EGL_NO_CONTEXT) {
+        eglDestroyContext(display_, context_);
+        context_ = EGL_NO_CONTEXT;
+    }
+    // 同一进程里的display是共享的(应用自己也可能在用)，不调用eglTerminate
+    eglReleaseThread();
+    display_ = EGL_NO_DISPLAY;
+
+    memset(textures_, 0, sizeof(textures_));
+    memset(pbos_, 0, sizeof(pbos_));
+    program_ = vertex_buffer_ = framebuffer_ = renderbuffer_ = 0;
+    pbo_size_ = 0;
+    texture_width_ = texture_height_ = 0;
+    target_width_ = target_height_ = 0;
+}
+
+bool GlRenderer::ResizeTextures(int width, int height) {
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+    const int widths[3] = { width, chroma_width, chroma_width };
+    const int heights[3] = { height, chroma_height, chroma_height };
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, widths[i], heights[i], 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    size_t pbo_size = static_cast<size_t>(width) * height + 2 * static_cast<size_t>(chroma_width) * chroma_height;
+    if (pbo_size != pbo_size_) {
+        for (GLuint pbo : pbos_) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pbo_size_ = pbo_size;
+    }
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR) {
+        RTC_LOG(LS_WARNING) << "allocate textures failed: " << err << ", " << width << "x" << height;
+        return false;
+    }
+    texture_width_ = width;
+    texture_height_ = height;
+    return true;
+}
+
+bool GlRenderer::ResizeOffscreenTarget(int width, int height) {
+    if (width == target_width_ && height == target_height_) {
+        return true;
+    }
+
+    if (!framebuffer_) {
+        glGenFramebuffers(1, &framebuffer_);
+        glGenRenderbuffers(1, &renderbuffer_);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer_);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        RTC_LOG(LS_WARNING) << "offscreen framebuffer incomplete, " << width << "x" << height;
+        target_width_ = target_height_ = 0;
+        return false;
+    }
+    target_width_ = width;
+    target_height_ = height;
+    return true;
+}
+
+int64_t GlRenderer::Upload(const webrtc::I420BufferInterface* buffer, const YuvUploadRegion& region) {
+    size_t y_size = static_cast<size_t>(region.width) * region.height;
+    size_t chroma_size = static_cast<size_t>(region.chroma_width) * region.chroma_height;
+
+    int64_t begin_us = rtc::TimeMicros();
+
+    // 两块PBO轮流用，写这一块时上一帧的那块可能还在传给纹理
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos_[pbo_index_]);
+    pbo_index_ ^= 1;
+    uint8_t* dst = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+        y_size + 2 * chroma_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!dst) {
+        RTC_LOG(LS_WARNING) << "map pixel buffer failed: " << glGetError();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return -1;
+    }
+    // 区域在PBO里紧凑排列
+    CopyI420Region(buffer, region,
+        dst, region.width,
+        dst + y_size, region.chroma_width,
+        dst + y_size + chroma_size, region.chroma_width);
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return -1;
+    }
+
+    // 只更新变化的区域
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textures_[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, region.x, region.y, region.width, region.height,
+        GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, textures_[1]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, region.chroma_x, region.chroma_y, region.chroma_width, region.chroma_height,
+        GL_RED, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(y_size));
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, textures_[2]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, region.chroma_x, region.chroma_y, region.chroma_width, region.chroma_height,
+        GL_RED, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(y_size + chroma_size));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return rtc::TimeMicros() - begin_us;
+}
+
+void GlRenderer::Draw(const webrtc::VideoFrame& frame) {
+    EGLint view_width = target_width_;
+    EGLint view_height = target_height_;
+    if (window_ != 0) {
+        eglQuerySurface(display_, surface_, EGL_WIDTH, &view_width);
+        eglQuerySurface(display_, surface_, EGL_HEIGHT, &view_height);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    else {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    }
+    if (view_width <= 0 || view_height <= 0) {
+        return;
+    }
+
+    glViewport(0, 0, view_width, view_height);
+    glClearColor(30 / 255.0f, 30 / 255.0f, 30 / 255.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // 保持图像宽高比，居中显示
+    float w1 = static_cast<float>(view_width);
+    float h1 = static_cast<float>(view_height);
+    float w2 = static_cast<float>(texture_width_);
+    float h2 = static_cast<float>(texture_height_);
+    int dst_w = 0;
+    int dst_h = 0;
+    int x = 0;
+    int y = 0;
+    if (w1 > (w2 * h1) / h2) {
+        dst_w = static_cast<int>((w2 * h1) / h2);
+        dst_h = view_height;
+        x = (view_width - dst_w) / 2;
+    }
+    else {
+        dst_w = view_width;
+        dst_h = static_cast<int>((h2 * w1) / w2);
+        y = (view_height - dst_h) / 2;
+    }
+    glViewport(x, y, dst_w, dst_h);
+
+    glUseProgram(program_);
+    glUniformMatrix3fv(yuv_to_rgb_location_, 1, GL_FALSE,
+        GetYuvColorMatrix(frame) == YuvColorMatrix::kBT709 ? kBT709Matrix : kBT601Matrix);
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    if (window_ != 0) {
+        eglSwapBuffers(display_, surface_);
+    }
+    else {
+        glFlush();
+    }
+}
+
+}  // namespace krtc
@@ -0,0 +1,80 @@
+#ifndef KRTCSDK_KRTC_RENDER_LINUX_GL_RENDERER_H_
+#define KRTCSDK_KRTC_RENDER_LINUX_GL_RENDERER_H_
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#include <memory>
+#include <vector>
+
+#include <api/video/video_frame.h>
+#include <rtc_base/thread.h>
+
+#include "krtc/render/video_renderer.h"
+#include "krtc/render/yuv_upload.h"
+
+namespace krtc {
+
+// EGL + GLES3渲染，Y/U/V三个平面作为纹理上传，颜色转换在shader里做。
+// window为X11窗口时渲染到窗口，为0时离屏渲染到FBO，用于无窗口环境(Mesa llvmpipe)。
+// 上传经过双缓冲的PBO，只更新帧的update_rect部分。
+class GlRenderer : public VideoRenderer {
+public:
+    static std::unique_ptr<VideoRenderer> Create(EGLNativeWindowType window,
+                                            size_t width,
+                                            size_t height);
+    ~GlRenderer() override;
+
+    void OnFrame(const webrtc::VideoFrame& frame) override;
+    RenderStats render_stats() const override;
+
+    // 离屏渲染时读回FBO里最近画完的一帧，RGBA，行从上到下，用于测试和截图
+    bool ReadOffscreenPixels(std::vector<uint8_t>* rgba, int* width, int* height);
+
+private:
+    GlRenderer(EGLNativeWindowType window, size_t width, size_t height);
+
+    bool InitEgl();
+    bool InitGl();
+    void Destroy();
+
+    void RenderPending();
+    bool ResizeTextures(int width, int height);
+    bool ResizeOffscreenTarget(int width, int height);
+    int64_t Upload(const webrtc::I420BufferInterface* buffer, const YuvUploadRegion& region);
+    void Draw(const webrtc::VideoFrame& frame);
+
+private:
+    EGLNativeWindowType window_;
+    size_t width_;
+    size_t height_;
+    std::unique_ptr<rtc::Thread> render_thread_;
+
+    PendingVideoFrame pending_frame_;
+    UploadStatsCounter upload_stats_;
+
+    // 以下只在render_thread_上访问
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    bool init_failed_ = false;
+
+    GLuint program_ = 0;
+    GLuint vertex_buffer_ = 0;
+    GLint yuv_to_rgb_location_ = -1;
+    GLuint textures_[3] = { 0, 0, 0 };
+    GLuint pbos_[2] = { 0, 0 };
+    int pbo_index_ = 0;
+    size_t pbo_size_ = 0;
+    int texture_width_ = 0;
+    int texture_height_ = 0;
+
+    GLuint framebuffer_ = 0;
+    GLuint renderbuffer_ = 0;
+    int target_width_ = 0;
+    int target_height_ = 0;
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_RENDER_LINUX_GL_RENDERER_H_
@@ -1,15 +1,39 @@
 // H:\webrtc\webrtc-checkout\src\test\video_renderer.cc
 
 #include "krtc/render/video_renderer.h"
+
+#include <atomic>
+
+#include <common_video/include/video_frame_buffer_pool.h>
+#include <rtc_base/logging.h>
+#include <third_party/libyuv/include/libyuv/convert_from.h>
+
 #include "krtc/media/media_frame.h"
+#include "krtc/media/frame_mailbox.h"
 #include "krtc/base/krtc_global.h"
 
 namespace krtc {
 
+namespace {
+
 class NullRenderer : public VideoRenderer {
 public:
-    NullRenderer(CONTROL_TYPE type):
-        type_(type){}
+    NullRenderer(CONTROL_TYPE type, std::shared_ptr<FrameMailbox> mailbox):
+        type_(type),
+        mailbox_(std::move(mailbox)),
+        formats_(KRTCGlobal::Instance()->pull_video_formats())
+    {
+        if (!formats_.i420 && !formats_.nv12 && !formats_.native) {
+            formats_.i420 = true;
+        }
+    }
+
+    DeliveryStats delivery_stats() const override {
+        DeliveryStats stats;
+        stats.frames = frames_.load(std::memory_order_relaxed);
+        stats.conversions = conversions_.load(std::memory_order_relaxed);
+        return stats;
+    }
 
 private:
     void OnFrame(const webrtc::VideoFrame& video_frame) override {
@@ -17,45 +41,163 @@ private:
             return;
         }
 
-        if (KRTCGlobal::Instance()->engine_observer()) {
-            rtc::scoped_refptr<webrtc::VideoFrameBuffer> vfb = video_frame.video_frame_buffer();
-            int src_width = video_frame.width();
-            int src_height = video_frame.height();
-
-            int strideY = vfb.get()->GetI420()->StrideY();
-            int strideU = vfb.get()->GetI420()->StrideU();
-            int strideV = vfb.get()->GetI420()->StrideV();
-
-            int size = strideY * src_height + (strideU + strideV) * ((src_height + 1) / 2);
-            std::shared_ptr<MediaFrame> media_frame = std::make_shared<MediaFrame>(size);
-            media_frame->fmt.media_type = MainMediaType::kMainTypeVideo;
-            media_frame->fmt.sub_fmt.video_fmt.type = SubMediaType::kSubTypeI420;
-            media_frame->fmt.sub_fmt.video_fmt.width = src_width;
-            media_frame->fmt.sub_fmt.video_fmt.height = src_height;
-            media_frame->stride[0] = strideY;
-            media_frame->stride[1] = strideU;
-            media_frame->stride[2] = strideV;
-            media_frame->data_len[0] = strideY * src_height;
-            media_frame->data_len[1] = strideU * ((src_height + 1) / 2);
-            media_frame->data_len[2] = strideV * ((src_height + 1) / 2);
-            media_frame->data[0] = new char[size];
-            media_frame->data[1] = media_frame->data[0] + media_frame->data_len[0];
-            media_frame->data[2] = media_frame->data[1] + media_frame->data_len[1];
-            memcpy(media_frame->data[0], video_frame.video_frame_buffer()->GetI420()->DataY(), media_frame->data_len[0]);
-            memcpy(media_frame->data[1], video_frame.video_frame_buffer()->GetI420()->DataU(), media_frame->data_len[1]);
-            memcpy(media_frame->data[2], video_frame.video_frame_buffer()->GetI420()->DataV(), media_frame->data_len[2]);
-
-            KRTCGlobal::Instance()->engine_observer()->OnPullVideoFrame(media_frame);
+        KRTCEngineObserver* observer = KRTCGlobal::Instance()->engine_observer();
+        if (!observer && !(mailbox_ && mailbox_->enabled())) {
+            return;
+        }
+
+        uint32_t conversions = 0;
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = ToAcceptedFormat(
+            video_frame.video_frame_buffer(), &conversions);
+        if (!buffer) {
+            return;
+        }
+
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        conversions_.fetch_add(conversions, std::memory_order_relaxed);
+        std::shared_ptr<MediaFrame> media_frame = WrapVideoFrameBuffer(buffer, video_frame.timestamp());
+        if (!media_frame) {
+            return;
+        }
+        if (mailbox_ && mailbox_->enabled()) {
+            mailbox_->Publish(std::move(media_frame));
+        }
+        else if (observer) {
+            observer->OnPullVideoFrame(media_frame);
+        }
+    }
+
+    // 只在解码输出不是应用接受的格式时转换，libyuv的转换带SIMD
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> ToAcceptedFormat(
+        rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer, uint32_t* conversions)
+    {
+        using Type = webrtc::VideoFrameBuffer::Type;
+        if (buffer->type() == Type::kNative) {
+            if (formats_.native) {
+                return buffer;
+            }
+            // 原生buffer能直接映射成接受的格式时不再经过I420
+            Type types[2];
+            size_t count = 0;
+            if (formats_.nv12) {
+                types[count++] = Type::kNV12;
+            }
+            if (formats_.i420) {
+                types[count++] = Type::kI420;
+            }
+            rtc::scoped_refptr<webrtc::VideoFrameBuffer> mapped =
+                buffer->GetMappedFrameBuffer(rtc::ArrayView<Type>(types, count));
+            ++*conversions;
+            buffer = mapped ? mapped : rtc::scoped_refptr<webrtc::VideoFrameBuffer>(buffer->ToI420());
+            if (!buffer) {
+                return nullptr;
+            }
+        }
+
+        Type type = buffer->type();
+        bool is_i420 = type == Type::kI420 || type == Type::kI420A;
+        if (is_i420 && formats_.i420) {
+            return buffer;
+        }
+        if (type == Type::kNV12 && formats_.nv12) {
+            return buffer;
+        }
+
+        if (!is_i420) {
+            // NV12或I444/I010等其他格式先转成I420
+            rtc::scoped_refptr<webrtc::I420BufferInterface> i420 = buffer->ToI420();
+            ++*conversions;
+            if (!i420 || formats_.i420) {
+                return i420;
+            }
+            buffer = i420;
+        }
+
+        // 只接受NV12
+        const webrtc::I420BufferInterface* i420 = buffer->GetI420();
+        rtc::scoped_refptr<webrtc::NV12Buffer> nv12 = nv12_pool_.CreateNV12Buffer(i420->width(), i420->height());
+        if (!nv12) {
+            RTC_LOG(LS_WARNING) << "nv12 pool exhausted, drop frame";
+            return nullptr;
         }
+        libyuv::I420ToNV12(i420->DataY(), i420->StrideY(), i420->DataU(), i420->StrideU(),
+            i420->DataV(), i420->StrideV(),
+            nv12->MutableDataY(), nv12->StrideY(), nv12->MutableDataUV(), nv12->StrideUV(),
+            i420->width(), i420->height());
+        ++*conversions;
+        return nv12;
     }
 
 private:
     CONTROL_TYPE type_;
+    std::shared_ptr<FrameMailbox> mailbox_;
+    KRTCPullVideoFormats formats_;
+    // 应用持有的帧也占用缓冲，池子留得大一些
+    webrtc::VideoFrameBufferPool nv12_pool_{ false, 16 };
+    std::atomic<uint64_t> frames_{ 0 };
+    std::atomic<uint64_t> conversions_{ 0 };
 };
 
-std::unique_ptr<VideoRenderer> VideoRenderer::Create(CONTROL_TYPE type, int hwnd, size_t width, size_t height)
+} // namespace
+
+std::shared_ptr<MediaFrame> WrapVideoFrameBuffer(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    uint32_t timestamp)
+{
+    using Type = webrtc::VideoFrameBuffer::Type;
+    if (buffer->type() != Type::kNative && buffer->type() != Type::kNV12 && !buffer->GetI420()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<MediaFrame> media_frame = std::make_shared<MediaFrame>(0);
+    media_frame->fmt.media_type = MainMediaType::kMainTypeVideo;
+    media_frame->fmt.sub_fmt.video_fmt.width = buffer->width();
+    media_frame->fmt.sub_fmt.video_fmt.height = buffer->height();
+    media_frame->fmt.sub_fmt.video_fmt.idr = false;
+    media_frame->ts = timestamp;
+    // 帧缓冲由MediaFrame持有，data直接指向其中的平面
+    media_frame->buffer_ref = std::shared_ptr<void>(buffer.get(), [buffer](void*) {});
+
+    int chroma_height = (buffer->height() + 1) / 2;
+    switch (buffer->type()) {
+    case Type::kNative:
+        media_frame->fmt.sub_fmt.video_fmt.type = SubMediaType::kSubTypeNative;
+        media_frame->native_buffer = buffer.get();
+        break;
+    case Type::kNV12: {
+        const webrtc::NV12BufferInterface* nv12 = buffer->GetNV12();
+        media_frame->fmt.sub_fmt.video_fmt.type = SubMediaType::kSubTypeNV12;
+        media_frame->stride[0] = nv12->StrideY();
+        media_frame->stride[1] = nv12->StrideUV();
+        media_frame->data_len[0] = nv12->StrideY() * buffer->height();
+        media_frame->data_len[1] = nv12->StrideUV() * chroma_height;
+        media_frame->data[0] = reinterpret_cast<char*>(const_cast<uint8_t*>(nv12->DataY()));
+        media_frame->data[1] = reinterpret_cast<char*>(const_cast<uint8_t*>(nv12->DataUV()));
+        break;
+    }
+    default: {
+        const webrtc::I420BufferInterface* i420 = buffer->GetI420();
+        media_frame->fmt.sub_fmt.video_fmt.type = SubMediaType::kSubTypeI420;
+        media_frame->stride[0] = i420->StrideY();
+        media_frame->stride[1] = i420->StrideU();
+        media_frame->stride[2] = i420->StrideV();
+        media_frame->data_len[0] = i420->StrideY() * buffer->height();
+        media_frame->data_len[1] = i420->StrideU() * chroma_height;
+        media_frame->data_len[2] = i420->StrideV() * chroma_height;
+        media_frame->data[0] = reinterpret_cast<char*>(const_cast<uint8_t*>(i420->DataY()));
+        media_frame->data[1] = reinterpret_cast<char*>(const_cast<uint8_t*>(i420->DataU()));
+        media_frame->data[2] = reinterpret_cast<char*>(const_cast<uint8_t*>(i420->DataV()));
+        break;
+    }
+    }
+    media_frame->max_size = media_frame->data_len[0] + media_frame->data_len[1] + media_frame->data_len[2];
+
+    return media_frame;
+}
+
+std::unique_ptr<VideoRenderer> VideoRenderer::Create(CONTROL_TYPE type, int hwnd, size_t width, size_t height,
+    std::shared_ptr<FrameMailbox> mailbox)
 {
-#if defined(_WIN32) || defined(_WIN64)
+#if defined(_WIN32) || defined(_WIN64) || defined(KRTC_USE_EGL_RENDERER)
     if (0 != hwnd) {
         std::unique_ptr<VideoRenderer> renderer = CreatePlatformRenderer(hwnd, width, height);
         if (renderer != nullptr)
@@ -63,7 +205,7 @@ std::unique_ptr<VideoRenderer> VideoRenderer::Create(CONTROL_TYPE type, int hwnd
     }
 #endif
 
-    return std::make_unique<NullRenderer>(type);
+    return std::make_unique<NullRenderer>(type, std::move(mailbox));
 }
 
 }  // namespace krtc
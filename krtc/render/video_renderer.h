@@ -13,21 +13,30 @@
 
 namespace krtc {
 
+class FrameMailbox;
+
+// 把I420/NV12/原生帧缓冲包成MediaFrame，data直接指向缓冲，不拷贝
+std::shared_ptr<MediaFrame> WrapVideoFrameBuffer(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+    uint32_t timestamp);
+
  class VideoRenderer : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
  public:
     // Creates a platform-specific renderer if possible, or a null implementation
-    // if failing.
+    // if failing. The null implementation publishes to |mailbox| when it is
+    // enabled instead of calling OnPullVideoFrame.
     static std::unique_ptr<VideoRenderer> Create(
         CONTROL_TYPE type,
         int hwnd,
         size_t width,
-        size_t height);
+        size_t height,
+        std::shared_ptr<FrameMailbox> mailbox = nullptr);
 
     // Returns a renderer rendering to a platform specific window if possible,
     // NULL if none can be created.
     // Creates a platform-specific renderer if possible, returns NULL if a
     // platform renderer could not be created. This occurs, for instance, when
-    // running without an X environment on Linux.
+    // running without an X environment on Linux. On Linux |hwnd| is an X11
+    // window, or 0 to render offscreen (e.g. with Mesa llvmpipe).
     static std::unique_ptr<VideoRenderer> CreatePlatformRenderer(
         int hwnd,
         size_t width,
@@ -35,6 +44,21 @@ namespace krtc {
 
     virtual ~VideoRenderer() {}
 
+    // 回调给应用的帧数和格式转换次数
+    struct DeliveryStats {
+        uint64_t frames = 0;
+        uint64_t conversions = 0;
+    };
+    virtual DeliveryStats delivery_stats() const { return DeliveryStats(); }
+
+    // 平台渲染器绘制的帧数和上传纹理的耗时，累计值
+    struct RenderStats {
+        uint64_t frames = 0;
+        uint64_t upload_us_total = 0;
+        uint64_t upload_us_max = 0;
+    };
+    virtual RenderStats render_stats() const { return RenderStats(); }
+
 protected:
     VideoRenderer() {}
 
@@ -2,15 +2,22 @@
 
 #include "krtc/render/win/d3d_renderer.h"
 
-#include <common_video/libyuv/include/webrtc_libyuv.h>
 #include <rtc_base/checks.h>
 #include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
 #include <api/video/video_frame.h>
+#include <third_party/libyuv/include/libyuv/convert_argb.h>
 
 #include "krtc/base/krtc_global.h"
 
 namespace krtc {
 
+namespace {
+
+const D3DFORMAT kYV12Format = (D3DFORMAT)MAKEFOURCC('Y', 'V', '1', '2');
+
+} // namespace
+
 std::unique_ptr<VideoRenderer> VideoRenderer::CreatePlatformRenderer(int hwnd,
                                                      size_t width,
                                                      size_t height) 
@@ -48,12 +55,6 @@ void D3dRenderer::Destroy() {
 		d3d9_->Release();
 		d3d9_ = nullptr;
 	}
-
-	if (rgb_buffer_) {
-		delete[] rgb_buffer_;
-		rgb_buffer_ = nullptr;
-		rgb_buffer_size_ = 0;
-	}
 }
 
 void D3dRenderer::HandleErr(const KRTCError& err) {}
@@ -130,14 +131,44 @@ bool D3dRenderer::TryInit(const webrtc::VideoFrame& frame) {
 	}
 
 	// 3. 创建离屏表面
+	if (!CreateSurface(frame.width(), frame.height())) {
+		HandleErr(KRTCError::kPreviewCreateRenderDeviceErr);
+		return false;
+	}
+
+	width_ = frame.width();
+	height_ = frame.height();
+
+	return true;
+}
+
+bool D3dRenderer::CreateSurface(int width, int height) {
 	if (d3d9_surface_) {
 		d3d9_surface_->Release();
 		d3d9_surface_ = nullptr;
 	}
+	surface_dirty_ = true;
+
+	// YV12要求宽高是偶数，并且显卡能在StretchRect时转换到显示格式
+	D3DDISPLAYMODE display_mode;
+	yuv_surface_ = (width % 2 == 0) && (height % 2 == 0) &&
+		SUCCEEDED(d3d9_->GetAdapterDisplayMode(D3DADAPTER_DEFAULT, &display_mode)) &&
+		SUCCEEDED(d3d9_->CheckDeviceFormatConversion(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL,
+			kYV12Format, display_mode.Format));
+	if (yuv_surface_) {
+		HRESULT res = d3d9_device_->CreateOffscreenPlainSurface(width, height,
+			kYV12Format, D3DPOOL_DEFAULT, &d3d9_surface_, NULL);
+		if (SUCCEEDED(res)) {
+			RTC_LOG(LS_INFO) << "d3d9 render with yv12 surface, " << width << "x" << height;
+			return true;
+		}
+		RTC_LOG(LS_WARNING) << "d3d9 create yv12 surface failed: " << res << ", fall back to rgb";
+		yuv_surface_ = false;
+	}
 
-	HRESULT res = res = d3d9_device_->CreateOffscreenPlainSurface(
-		frame.width(),						// 离屏表面的宽度
-		frame.height(),						// 离屏表面的高度
+	HRESULT res = d3d9_device_->CreateOffscreenPlainSurface(
+		width,								// 离屏表面的宽度
+		height,								// 离屏表面的高度
 		D3DFMT_X8R8G8B8,					// 图像像素格式
 		D3DPOOL_DEFAULT,					// 资源对应的内存类型
 		&d3d9_surface_,						// 返回创建的surface
@@ -146,13 +177,8 @@ bool D3dRenderer::TryInit(const webrtc::VideoFrame& frame) {
 
 	if (FAILED(res)) {
 		RTC_LOG(LS_WARNING) << "d3d9 create offscreen surface failed: " << res;
-		HandleErr(KRTCError::kPreviewCreateRenderDeviceErr);
 		return false;
 	}
-
-	width_ = frame.width();
-	height_ = frame.height();
-
 	return true;
 }
 
@@ -169,81 +195,75 @@ std::unique_ptr<VideoRenderer> D3dRenderer::Create(
 }
 
 
-void D3dRenderer::DoRender(const webrtc::VideoFrame& frame) {
-	rtc::scoped_refptr<webrtc::VideoFrameBuffer> vfb = frame.video_frame_buffer();
-	if (webrtc::VideoFrameBuffer::Type::kI420 == vfb.get()->type()) {
-		// 1. 创建RGB buffer，将YUV格式转换成RGB格式
-		int size = frame.width() * frame.height() * 4; // 考虑ARGB，不考虑则是乘以3
-		if (rgb_buffer_size_ != size) {		// 避免渲染过程中图像宽高发生变化
-			if (rgb_buffer_) {
-				delete[] rgb_buffer_;
-			}
-
-			rgb_buffer_ = new char[size];
-			rgb_buffer_size_ = size;
-		}
-
-		ConvertFromI420(frame, webrtc::VideoType::kARGB, 0, (uint8_t*)rgb_buffer_);
-	}
+int64_t D3dRenderer::Upload(const webrtc::VideoFrame& frame,
+	const webrtc::I420BufferInterface* buffer,
+	const YuvUploadRegion& region)
+{
+	int64_t begin_us = rtc::TimeMicros();
 
-	// 2. 将RGB数据拷贝到离屏表面
-	// 2.1 锁定区域
-	HRESULT res;
+	// 1. 锁定离屏表面，数据直接写进去，不经过中间缓冲
 	D3DLOCKED_RECT d3d9_rect;
-	res = d3d9_surface_->LockRect(&d3d9_rect, // 指向描述锁定区域的矩形结构指针
+	HRESULT res = d3d9_surface_->LockRect(&d3d9_rect, // 指向描述锁定区域的矩形结构指针
 		NULL, // 需要锁定的区域，如果NULL，表示整个表面
 		D3DLOCK_DONOTWAIT // 当显卡锁定区域失败的时候，不阻塞应用程序,返回D3DERR_WASSTILLDRAWING
 	);
 
 	if (FAILED(res)) {
 		RTC_LOG(LS_WARNING) << "d3d9 surface LockRect failed: " << res;
-		return;
+		return -1;
 	}
 
-	// 2.2 将RGB数据拷贝到离屏表面
 	// 锁定区域的地址
-	byte* pdest = (byte*)d3d9_rect.pBits;
+	uint8_t* pdest = (uint8_t*)d3d9_rect.pBits;
 	// 锁定区域每一行的数据大小
 	int stride = d3d9_rect.Pitch;
 
-	if (webrtc::VideoFrameBuffer::Type::kI420 == vfb.get()->type()) {
-		int video_width = frame.width();
-		int video_height = frame.height();
-		int video_stride = video_width * 4;
-
-		if (video_stride == stride) {
-			memcpy(pdest, rgb_buffer_, rgb_buffer_size_);
-		}
-		else if (video_stride < stride) {
-			char* src = rgb_buffer_;
-			for (int i = 0; i < video_height; ++i) {
-				memcpy(pdest, src, video_stride);
-				pdest += stride;
-				src += video_stride;
-			}
-		}
+	if (yuv_surface_) {
+		// 2. YV12的平面顺序是Y、V、U，只拷贝变化的区域，颜色转换交给GPU
+		int chroma_stride = stride / 2;
+		uint8_t* dst_v = pdest + stride * height_;
+		uint8_t* dst_u = dst_v + chroma_stride * (height_ / 2);
+		CopyI420Region(buffer, region,
+			pdest + region.y * stride + region.x, stride,
+			dst_u + region.chroma_y * chroma_stride + region.chroma_x, chroma_stride,
+			dst_v + region.chroma_y * chroma_stride + region.chroma_x, chroma_stride);
+	}
+	else {
+		// 2. 不支持YV12表面时在CPU上转换，libyuv直接写到锁定的表面
+		const libyuv::YuvConstants* constants = GetYuvColorMatrix(frame) == YuvColorMatrix::kBT709 ?
+			&libyuv::kYuvH709Constants : &libyuv::kYuvI601Constants;
+		libyuv::I420ToARGBMatrix(
+			buffer->DataY() + region.y * buffer->StrideY() + region.x, buffer->StrideY(),
+			buffer->DataU() + region.chroma_y * buffer->StrideU() + region.chroma_x, buffer->StrideU(),
+			buffer->DataV() + region.chroma_y * buffer->StrideV() + region.chroma_x, buffer->StrideV(),
+			pdest + region.y * stride + region.x * 4, stride,
+			constants, region.width, region.height);
 	}
 
-	// 2.3 解除锁定
+	// 3. 解除锁定
 	d3d9_surface_->UnlockRect();
 
-	// 3. 清除后台缓冲
+	return rtc::TimeMicros() - begin_us;
+}
+
+void D3dRenderer::DoRender() {
+	// 1. 清除后台缓冲
 	d3d9_device_->Clear(0,          // 第二个矩形数组参数的大小
 		NULL,                       // 需要清除的矩形数组，如果是NULL，表示清除所有
 		D3DCLEAR_TARGET,            // 清除渲染目标
 		D3DCOLOR_XRGB(30, 30, 30),  // 使用的颜色值
 		1.0f, 0);
 
-	// 4. 将离屏表面的数据拷贝到后台缓冲表面
+	// 2. 将离屏表面的数据拷贝到后台缓冲表面，YV12表面在这里由GPU转换成RGB
 	d3d9_device_->BeginScene();
-	// 4.1 获取后台缓冲表面
+	// 2.1 获取后台缓冲表面
 	IDirect3DSurface9* pback_buffer = nullptr;
 	d3d9_device_->GetBackBuffer(0, // 正在使用的交换链的索引
 		0,							// 后台缓冲表面的索引
 		D3DBACKBUFFER_TYPE_MONO,	// 后台缓冲表面类型
 		&pback_buffer);
 
-	// 4.2调整图像和显示区域的宽高比
+	// 2.2调整图像和显示区域的宽高比
 	// 显示区域的宽高
 	float w1 = rt_viewport_.right - rt_viewport_.left;
 	float h1 = rt_viewport_.bottom - rt_viewport_.top;
@@ -270,7 +290,7 @@ void D3dRenderer::DoRender(const webrtc::VideoFrame& frame) {
 
 	RECT dest_rect{ x, y, x + dst_w, y + dst_h };
 
-	// 4.3.复制离屏表面的数据到后台缓冲表面
+	// 2.3.复制离屏表面的数据到后台缓冲表面
 	d3d9_device_->StretchRect(d3d9_surface_, // 源表面
 		NULL,           // 源表面的矩形区域，如果是NULL，表示所有区域
 		pback_buffer,   // 目标表面
@@ -279,24 +299,57 @@ void D3dRenderer::DoRender(const webrtc::VideoFrame& frame) {
 	);
 	d3d9_device_->EndScene();
 
-	// 5. 显示图像，表面翻转
+	// 3. 显示图像，表面翻转
 	d3d9_device_->Present(NULL, // 后台缓冲表面的矩形区域， NULL表示整个区域
 		NULL,	// 显示区域， NULL表示整个客户显示区域
 		NULL,   // 显示窗口， NULL表示主窗口
 		NULL);
 
-	// 6. 释放后台缓冲
+	// 4. 释放后台缓冲
 	pback_buffer->Release();
 }
 
+VideoRenderer::RenderStats D3dRenderer::render_stats() const {
+    return upload_stats_.Get();
+}
+
 void D3dRenderer::OnFrame(const webrtc::VideoFrame& frame) {
-    // worker_thread执行渲染工作
-    KRTCGlobal::Instance()->worker_thread()->PostTask([=] {
-        if (!TryInit(frame)) {
+    // worker_thread执行渲染工作，来不及渲染时只保留最新一帧
+    if (pending_frame_.Push(frame)) {
+        KRTCGlobal::Instance()->worker_thread()->PostTask([=] {
+            RenderPending();
+        });
+    }
+}
+
+void D3dRenderer::RenderPending() {
+    webrtc::VideoFrame::UpdateRect rect;
+    absl::optional<webrtc::VideoFrame> frame = pending_frame_.Pop(&rect);
+    if (!frame || !TryInit(*frame)) {
+        return;
+    }
+
+    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer = frame->video_frame_buffer()->ToI420();
+    if (!buffer) {
+        return;
+    }
+
+    if (surface_dirty_) {
+        rect = { 0, 0, buffer->width(), buffer->height() };
+    }
+    YuvUploadRegion region;
+    if (YuvUploadRegion::FromUpdateRect(rect, buffer->width(), buffer->height(), &region)) {
+        int64_t upload_us = Upload(*frame, buffer.get(), region);
+        // 上传失败时表面内容不完整，下一帧整帧上传
+        surface_dirty_ = upload_us < 0;
+        if (upload_us < 0) {
             return;
         }
-        DoRender(frame);
-    });
+        upload_stats_.AddUpload(upload_us);
+    }
+
+    DoRender();
+    upload_stats_.AddFrame();
 }
 
 }  // namespace krtc
@@ -9,6 +9,7 @@
 #include <api/scoped_refptr.h>
 
 #include "krtc/render/video_renderer.h"
+#include "krtc/render/yuv_upload.h"
 #include "krtc/krtc.h"
 
 namespace krtc {
@@ -21,12 +22,18 @@ public:
     virtual ~D3dRenderer();
 
     void OnFrame(const webrtc::VideoFrame& frame) override;
+    RenderStats render_stats() const override;
 
 private:
     explicit D3dRenderer(HWND hwnd, size_t width, size_t height);
 
+    void RenderPending();
     bool TryInit(const webrtc::VideoFrame& frame);
-    void DoRender(const webrtc::VideoFrame& frame);
+    bool CreateSurface(int width, int height);
+    int64_t Upload(const webrtc::VideoFrame& frame,
+                   const webrtc::I420BufferInterface* buffer,
+                   const YuvUploadRegion& region);
+    void DoRender();
     void Destroy();
 
     void HandleErr(const KRTCError &err);
@@ -38,12 +45,17 @@ private:
     IDirect3D9* d3d9_ = nullptr;
     IDirect3DDevice9* d3d9_device_ = nullptr;
     IDirect3DSurface9* d3d9_surface_ = nullptr;
+    // 显卡支持时离屏表面用YV12，StretchRect时由GPU转成RGB，否则用X8R8G8B8在CPU上转换
+    bool yuv_surface_ = false;
+    // 表面刚创建或者上一次上传失败，下一帧整帧上传
+    bool surface_dirty_ = true;
 
     rtc::scoped_refptr<webrtc::VideoTrackInterface> rendered_track_;
     bool isInvalidHwnd_ = false;
     RECT rt_viewport_ = {0,0,0,0};
-    char* rgb_buffer_ = nullptr;
-    int rgb_buffer_size_ = 0;
+
+    PendingVideoFrame pending_frame_;
+    UploadStatsCounter upload_stats_;
 };
 }  // namespace krtc
 
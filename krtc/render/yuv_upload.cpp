@@ -0,0 +1,93 @@
+#include "krtc/render/yuv_upload.h"
+
+#include <algorithm>
+
+#include <third_party/libyuv/include/libyuv/planar_functions.h>
+
+namespace krtc {
+
+bool YuvUploadRegion::FromUpdateRect(const webrtc::VideoFrame::UpdateRect& rect, int frame_width, int frame_height,
+    YuvUploadRegion* region)
+{
+    if (rect.IsEmpty()) {
+        return false;
+    }
+    int x = std::max(rect.offset_x, 0) & ~1;
+    int y = std::max(rect.offset_y, 0) & ~1;
+    int right = std::min((rect.offset_x + rect.width + 1) & ~1, frame_width);
+    int bottom = std::min((rect.offset_y + rect.height + 1) & ~1, frame_height);
+    if (right <= x || bottom <= y) {
+        return false;
+    }
+
+    region->x = x;
+    region->y = y;
+    region->width = right - x;
+    region->height = bottom - y;
+    region->chroma_x = x / 2;
+    region->chroma_y = y / 2;
+    region->chroma_width = (right + 1) / 2 - region->chroma_x;
+    region->chroma_height = (bottom + 1) / 2 - region->chroma_y;
+    return true;
+}
+
+void CopyI420Region(const webrtc::I420BufferInterface* src, const YuvUploadRegion& region,
+    uint8_t* dst_y, int dst_stride_y,
+    uint8_t* dst_u, int dst_stride_u,
+    uint8_t* dst_v, int dst_stride_v)
+{
+    libyuv::CopyPlane(src->DataY() + region.y * src->StrideY() + region.x, src->StrideY(),
+        dst_y, dst_stride_y,
+        region.width, region.height);
+    libyuv::CopyPlane(src->DataU() + region.chroma_y * src->StrideU() + region.chroma_x, src->StrideU(),
+        dst_u, dst_stride_u,
+        region.chroma_width, region.chroma_height);
+    libyuv::CopyPlane(src->DataV() + region.chroma_y * src->StrideV() + region.chroma_x, src->StrideV(),
+        dst_v, dst_stride_v,
+        region.chroma_width, region.chroma_height);
+}
+
+YuvColorMatrix GetYuvColorMatrix(const webrtc::VideoFrame& frame) {
+    if (frame.color_space() && frame.color_space()->matrix() == webrtc::ColorSpace::MatrixID::kBT709) {
+        return YuvColorMatrix::kBT709;
+    }
+    return YuvColorMatrix::kBT601;
+}
+
+bool PendingVideoFrame::Push(const webrtc::VideoFrame& frame) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    bool post = !frame_;
+    if (frame_ && (frame_->width() != frame.width() || frame_->height() != frame.height())) {
+        rect_ = { 0, 0, frame.width(), frame.height() };
+    }
+    // 没有update_rect时返回整帧
+    rect_.Union(frame.update_rect());
+    frame_ = frame;
+    return post;
+}
+
+absl::optional<webrtc::VideoFrame> PendingVideoFrame::Pop(webrtc::VideoFrame::UpdateRect* rect) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    absl::optional<webrtc::VideoFrame> frame = std::move(frame_);
+    frame_.reset();
+    *rect = rect_;
+    rect_ = { 0, 0, 0, 0 };
+    return frame;
+}
+
+void UploadStatsCounter::AddUpload(int64_t upload_us) {
+    upload_us_total_.fetch_add(upload_us, std::memory_order_relaxed);
+    if (static_cast<uint64_t>(upload_us) > upload_us_max_.load(std::memory_order_relaxed)) {
+        upload_us_max_.store(upload_us, std::memory_order_relaxed);
+    }
+}
+
+VideoRenderer::RenderStats UploadStatsCounter::Get() const {
+    VideoRenderer::RenderStats stats;
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.upload_us_total = upload_us_total_.load(std::memory_order_relaxed);
+    stats.upload_us_max = upload_us_max_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace krtc
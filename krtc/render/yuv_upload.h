@@ -0,0 +1,73 @@
+#ifndef KRTCSDK_KRTC_RENDER_YUV_UPLOAD_H_
+#define KRTCSDK_KRTC_RENDER_YUV_UPLOAD_H_
+
+#include <atomic>
+#include <mutex>
+
+#include <absl/types/optional.h>
+#include <api/video/video_frame.h>
+
+#include "krtc/render/video_renderer.h"
+
+namespace krtc {
+
+// 平台渲染器(GlRenderer/D3dRenderer)共用的YUV上传逻辑：
+// 只取最新帧、按update_rect算要上传的区域、按平面拷贝和统计上传耗时。
+
+// 要更新的区域，色度是2x2采样，亮度区域对齐到偶数
+struct YuvUploadRegion {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int chroma_x = 0;
+    int chroma_y = 0;
+    int chroma_width = 0;
+    int chroma_height = 0;
+
+    // rect为空或者在帧外时返回false
+    static bool FromUpdateRect(const webrtc::VideoFrame::UpdateRect& rect, int frame_width, int frame_height,
+        YuvUploadRegion* region);
+};
+
+// 把I420的区域拷贝到目标平面，dst指向各平面里区域的左上角，用libyuv带SIMD的CopyPlane
+void CopyI420Region(const webrtc::I420BufferInterface* src, const YuvUploadRegion& region,
+    uint8_t* dst_y, int dst_stride_y,
+    uint8_t* dst_u, int dst_stride_u,
+    uint8_t* dst_v, int dst_stride_v);
+
+// 渲染时用的YUV转RGB矩阵，GPU的shader和CPU的libyuv转换选的一致
+enum class YuvColorMatrix {
+    kBT601,
+    kBT709,
+};
+YuvColorMatrix GetYuvColorMatrix(const webrtc::VideoFrame& frame);
+
+// OnFrame和渲染线程之间只保留最新一帧，被覆盖的帧的update_rect合并进来
+class PendingVideoFrame {
+public:
+    // 返回true时需要向渲染线程投递一次任务
+    bool Push(const webrtc::VideoFrame& frame);
+    absl::optional<webrtc::VideoFrame> Pop(webrtc::VideoFrame::UpdateRect* rect);
+
+private:
+    std::mutex mutex_;
+    absl::optional<webrtc::VideoFrame> frame_;
+    webrtc::VideoFrame::UpdateRect rect_ = { 0, 0, 0, 0 };
+};
+
+class UploadStatsCounter {
+public:
+    void AddUpload(int64_t upload_us);
+    void AddFrame() { frames_.fetch_add(1, std::memory_order_relaxed); }
+    VideoRenderer::RenderStats Get() const;
+
+private:
+    std::atomic<uint64_t> frames_{ 0 };
+    std::atomic<uint64_t> upload_us_total_{ 0 };
+    std::atomic<uint64_t> upload_us_max_{ 0 };
+};
+
+}  // namespace krtc
+
+#endif  // KRTCSDK_KRTC_RENDER_YUV_UPLOAD_H_
@@ -0,0 +1,131 @@
+// 拉流混音每10ms一次的开销随路数的变化：按PullAudioMixer::Mix的步骤，
+// 每路算音量包络，选最活跃的3路渐变叠加，再饱和回int16。
+// simd=1用SDK的混音kernel，simd=0用等价的标量实现做对照；per_stream为每路摊到的时间。
+//   krtc_benchmarks --benchmark_filter=AudioMix
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "krtc/media/audio_mix_kernels.h"
+
+namespace krtc {
+namespace {
+
+const size_t kFrameSize = 480 * 2;  // 48kHz双声道10ms
+const size_t kMaxActive = 3;
+const float kLevelDecay = 0.9f;
+
+float ScalarMeanSquare(const int16_t* src, size_t count)
+{
+	float sum = 0.0f;
+	for (size_t i = 0; i < count; i++) {
+		sum += static_cast<float>(src[i]) * src[i];
+	}
+	return count ? sum / count : 0.0f;
+}
+
+void ScalarMixWithRamp(const int16_t* src, size_t count, float gain_begin, float gain_end, float* acc)
+{
+	float step = count ? (gain_end - gain_begin) / count : 0.0f;
+	for (size_t i = 0; i < count; i++) {
+		acc[i] += src[i] * (gain_begin + step * i);
+	}
+}
+
+void ScalarFloatToS16(const float* src, size_t count, int16_t* dst)
+{
+	for (size_t i = 0; i < count; i++) {
+		float value = std::min(std::max(src[i], -32768.0f), 32767.0f);
+		dst[i] = static_cast<int16_t>(std::lrintf(value));
+	}
+}
+
+struct MixStream {
+	std::vector<int16_t> samples;
+	float level = 0.0f;
+	float applied_gain = 0.0f;
+	float target_gain = 0.0f;
+};
+
+void BM_AudioMix(benchmark::State& state)
+{
+	const size_t stream_count = static_cast<size_t>(state.range(0));
+	const bool simd = state.range(1) != 0;
+
+	// 各路音量不同，最响的几路被选中
+	std::mt19937 random(1);
+	std::vector<MixStream> streams(stream_count);
+	for (size_t i = 0; i < stream_count; i++) {
+		std::uniform_int_distribution<int> sample(-1000 - 500 * static_cast<int>(i), 1000 + 500 * static_cast<int>(i));
+		streams[i].samples.resize(kFrameSize);
+		for (auto& value : streams[i].samples) {
+			value = static_cast<int16_t>(sample(random));
+		}
+	}
+	std::vector<size_t> candidates;
+	candidates.reserve(stream_count);
+	std::vector<float> accumulator(kFrameSize);
+	std::vector<int16_t> output(kFrameSize);
+
+	size_t tick = 0;
+	for (auto _ : state) {
+		candidates.clear();
+		for (size_t i = 0; i < stream_count; i++) {
+			MixStream& stream = streams[i];
+			float mean_square = simd ? AudioMeanSquare(stream.samples.data(), kFrameSize)
+				: ScalarMeanSquare(stream.samples.data(), kFrameSize);
+			stream.level = std::max(mean_square, stream.level * kLevelDecay);
+			stream.target_gain = 0.0f;
+			candidates.push_back(i);
+		}
+
+		size_t active = std::min(candidates.size(), kMaxActive);
+		std::partial_sort(candidates.begin(), candidates.begin() + active, candidates.end(),
+			[&streams](size_t a, size_t b) { return streams[a].level > streams[b].level; });
+		for (size_t i = 0; i < active; i++) {
+			// 增益每帧都变一点，走渐变路径
+			streams[candidates[i]].target_gain = (tick & 1) ? 0.8f : 1.0f;
+		}
+
+		std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+		for (auto& stream : streams) {
+			if (stream.applied_gain == 0.0f && stream.target_gain == 0.0f) {
+				continue;
+			}
+			if (simd) {
+				AudioMixWithRamp(stream.samples.data(), kFrameSize, stream.applied_gain, stream.target_gain,
+					accumulator.data());
+			}
+			else {
+				ScalarMixWithRamp(stream.samples.data(), kFrameSize, stream.applied_gain, stream.target_gain,
+					accumulator.data());
+			}
+			stream.applied_gain = stream.target_gain;
+		}
+
+		if (simd) {
+			AudioFloatToS16(accumulator.data(), kFrameSize, output.data());
+		}
+		else {
+			ScalarFloatToS16(accumulator.data(), kFrameSize, output.data());
+		}
+		benchmark::DoNotOptimize(output.data());
+		benchmark::ClobberMemory();
+		tick++;
+	}
+
+	state.counters["per_stream"] = benchmark::Counter(static_cast<double>(stream_count),
+		benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK(BM_AudioMix)
+	->ArgNames({ "streams", "simd" })
+	->ArgsProduct({ { 1, 4, 8, 16 }, { 0, 1 } })
+	->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace krtc
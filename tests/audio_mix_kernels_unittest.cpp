@@ -0,0 +1,76 @@
+#include "krtc/media/audio_mix_kernels.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+// 长度覆盖SIMD主循环和标量尾部，以及10ms 48kHz双声道的一帧
+const size_t kCounts[] = { 0, 1, 7, 8, 9, 15, 16, 17, 960 };
+
+std::vector<int16_t> RandomSamples(size_t count, int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> sample(-32768, 32767);
+	std::vector<int16_t> samples(count);
+	for (auto& value : samples) {
+		value = static_cast<int16_t>(sample(random));
+	}
+	return samples;
+}
+
+TEST(AudioMixKernelsTest, MeanSquareMatchesScalar)
+{
+	for (size_t count : kCounts) {
+		std::vector<int16_t> samples = RandomSamples(count, static_cast<int>(count));
+		double expected = 0.0;
+		for (int16_t value : samples) {
+			expected += static_cast<double>(value) * value;
+		}
+		expected = count ? expected / count : 0.0;
+		EXPECT_NEAR(expected, AudioMeanSquare(samples.data(), count), expected * 1e-5 + 1e-3) << count;
+	}
+
+	// 满幅度的-32768平方后仍然是正数
+	std::vector<int16_t> full_scale(16, -32768);
+	EXPECT_FLOAT_EQ(32768.0f * 32768.0f, AudioMeanSquare(full_scale.data(), full_scale.size()));
+}
+
+TEST(AudioMixKernelsTest, MixWithRampInterpolatesGainPerSample)
+{
+	for (size_t count : kCounts) {
+		std::vector<int16_t> samples = RandomSamples(count, 100 + static_cast<int>(count));
+		std::vector<float> acc(count, 10.0f);
+		AudioMixWithRamp(samples.data(), count, 0.25f, 1.0f, acc.data());
+
+		float step = count ? 0.75f / count : 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			float expected = 10.0f + samples[i] * (0.25f + step * i);
+			EXPECT_NEAR(expected, acc[i], std::fabs(expected) * 1e-5f + 1e-2f) << count << "/" << i;
+		}
+	}
+}
+
+TEST(AudioMixKernelsTest, FloatToS16RoundsAndSaturates)
+{
+	const std::vector<float> input = { 0.4f, 0.6f, -0.6f, 1.5f, 2.5f, 32767.4f, 40000.0f, -32768.6f, -50000.0f };
+	const std::vector<int16_t> expected = { 0, 1, -1, 2, 2, 32767, 32767, -32768, -32768 };
+	// 重复到超过一次SIMD循环，尾部也覆盖到
+	std::vector<float> src;
+	std::vector<int16_t> want;
+	for (int i = 0; i < 3; i++) {
+		src.insert(src.end(), input.begin(), input.end());
+		want.insert(want.end(), expected.begin(), expected.end());
+	}
+
+	std::vector<int16_t> dst(src.size());
+	AudioFloatToS16(src.data(), src.size(), dst.data());
+	EXPECT_EQ(want, dst);
+}
+
+}  // namespace
+}  // namespace krtc
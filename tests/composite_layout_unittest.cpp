@@ -0,0 +1,115 @@
+#include "krtc/device/composite_layout.h"
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+KRTCCompositeConfig MakeConfig(COMPOSITE_LAYOUT layout)
+{
+	KRTCCompositeConfig config;
+	config.width = 1280;
+	config.height = 720;
+	config.layout = layout;
+	return config;
+}
+
+void ExpectInside(const KRTCCompositeConfig& config, const CompositeRect& rect)
+{
+	EXPECT_GE(rect.x, 0);
+	EXPECT_GE(rect.y, 0);
+	EXPECT_GE(rect.width, 0);
+	EXPECT_GE(rect.height, 0);
+	EXPECT_LE(rect.x + rect.width, static_cast<int>(config.width));
+	EXPECT_LE(rect.y + rect.height, static_cast<int>(config.height));
+	EXPECT_EQ(0, rect.x % 2);
+	EXPECT_EQ(0, rect.y % 2);
+	EXPECT_EQ(0, rect.width % 2);
+	EXPECT_EQ(0, rect.height % 2);
+}
+
+TEST(CompositeLayoutTest, GridKeepsAspectInsideCells)
+{
+	KRTCCompositeConfig config = MakeConfig(COMPOSITE_LAYOUT::GRID);
+	for (size_t count = 1; count <= KRTCCompositeConfig::kMaxInputs; count++) {
+		for (size_t i = 0; i < count; i++) {
+			ExpectInside(config, CompositeRegionFor(config, i, count, 1920, 1080));
+		}
+	}
+
+	// 2x2网格，16:9输入正好铺满一格
+	CompositeRect rect = CompositeRegionFor(config, 3, 4, 1920, 1080);
+	EXPECT_EQ(640, rect.x);
+	EXPECT_EQ(360, rect.y);
+	EXPECT_EQ(640, rect.width);
+	EXPECT_EQ(360, rect.height);
+}
+
+TEST(CompositeLayoutTest, PipWindowsAboveTopAreClipped)
+{
+	KRTCCompositeConfig config = MakeConfig(COMPOSITE_LAYOUT::PIP);
+	config.pip_scale = 0.4f;
+
+	CompositeRect background = CompositeRegionFor(config, 0, 4, 1280, 720);
+	EXPECT_EQ(0, background.x);
+	EXPECT_EQ(0, background.y);
+	EXPECT_EQ(1280, background.width);
+	EXPECT_EQ(720, background.height);
+
+	// 小窗口高288，第3个从y=-220开始，只剩下面68行
+	CompositeRect third = CompositeRegionFor(config, 3, 4, 1280, 720);
+	ExpectInside(config, third);
+	EXPECT_EQ(0, third.y);
+	EXPECT_EQ(68, third.height);
+	EXPECT_EQ(512, third.width);
+	CompositeRect second = CompositeRegionFor(config, 2, 4, 1280, 720);
+	EXPECT_LE(third.y + third.height, second.y);
+}
+
+TEST(CompositeLayoutTest, CustomRegionsAreClampedToOutput)
+{
+	KRTCCompositeConfig config = MakeConfig(COMPOSITE_LAYOUT::CUSTOM);
+	config.regions[0] = { -0.25f, -0.5f, 0.5f, 1.0f, 255 };
+	config.regions[1] = { 0.75f, 0.75f, 0.5f, 0.5f, 128 };
+	config.regions[2] = { 1.5f, 0.0f, 0.5f, 0.5f, 255 };
+
+	// 左上角移进画面，宽高减去移出去的部分
+	CompositeRect left = CompositeRegionFor(config, 0, 3, 1280, 720);
+	EXPECT_EQ(0, left.x);
+	EXPECT_EQ(0, left.y);
+	EXPECT_EQ(320, left.width);
+	EXPECT_EQ(360, left.height);
+
+	CompositeRect corner = CompositeRegionFor(config, 1, 3, 1280, 720);
+	EXPECT_EQ(960, corner.x);
+	EXPECT_EQ(540, corner.y);
+	EXPECT_EQ(320, corner.width);
+	EXPECT_EQ(180, corner.height);
+
+	CompositeRect outside = CompositeRegionFor(config, 2, 3, 1280, 720);
+	EXPECT_EQ(0, outside.width);
+	EXPECT_EQ(0, outside.height);
+}
+
+TEST(CompositeLayoutTest, StaleInputsDoNotHoldBackReference)
+{
+	const int64_t now = 10000000;
+	const int64_t stale = 500000;
+	int64_t reference = 0;
+
+	EXPECT_FALSE(CompositeReferenceTimestamp({}, now, stale, &reference));
+
+	ASSERT_TRUE(CompositeReferenceTimestamp({ now - 40000, now - 10000 }, now, stale, &reference));
+	EXPECT_EQ(now - 40000, reference);
+
+	// 第一路停了3秒，对齐到还在出帧的输入
+	ASSERT_TRUE(CompositeReferenceTimestamp({ now - 3000000, now - 40000, now - 10000 }, now, stale, &reference));
+	EXPECT_EQ(now - 40000, reference);
+
+	// 都停了时取最新的一帧
+	ASSERT_TRUE(CompositeReferenceTimestamp({ now - 3000000, now - 2000000 }, now, stale, &reference));
+	EXPECT_EQ(now - 2000000, reference);
+}
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,62 @@
+// 多路合成每输出一帧的开销：1080p输出，输入都是1080p，按VideoCompositor::Render的步骤
+// 清底色、每路缩放到自己的区域。layout: 0=GRID，1=PIP，2=CUSTOM(半透明叠加，走I420Blend)。
+// 合成线程按输出帧率运行，结果超过1000/fps毫秒时合成跟不上帧率。
+//   krtc_benchmarks --benchmark_filter=Compositor
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "api/video/i420_buffer.h"
+
+#include "krtc/device/video_compositor.h"
+#include "tests/render_benchmark_util.h"
+
+namespace krtc {
+namespace {
+
+KRTCCompositeConfig MakeConfig(COMPOSITE_LAYOUT layout, int inputs)
+{
+	KRTCCompositeConfig config;
+	config.width = 1920;
+	config.height = 1080;
+	config.layout = layout;
+	// CUSTOM: 每路40%大小，从左上往右下错开，互相重叠
+	for (int i = 0; i < inputs; i++) {
+		config.regions[i].x = 0.075f * i;
+		config.regions[i].y = 0.075f * i;
+		config.regions[i].width = 0.4f;
+		config.regions[i].height = 0.4f;
+		config.regions[i].alpha = 192;
+	}
+	return config;
+}
+
+void BM_CompositorRender(benchmark::State& state)
+{
+	const int inputs = static_cast<int>(state.range(0));
+	const COMPOSITE_LAYOUT layout = static_cast<COMPOSITE_LAYOUT>(state.range(1));
+	const KRTCCompositeConfig config = MakeConfig(layout, inputs);
+
+	std::vector<rtc::scoped_refptr<webrtc::I420BufferInterface>> frames;
+	for (int i = 0; i < inputs; i++) {
+		frames.push_back(test::CreateGradientFrame(1920, 1080, i * 7));
+	}
+	rtc::scoped_refptr<webrtc::I420Buffer> output = webrtc::I420Buffer::Create(config.width, config.height);
+
+	// 没有输入id，不Start，只用到合成本身
+	VideoCompositor compositor({}, config);
+	for (auto _ : state) {
+		compositor.Render(frames, output.get());
+		benchmark::DoNotOptimize(output->DataY());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CompositorRender)
+	->ArgNames({ "inputs", "layout" })
+	->ArgsProduct({ { 2, 4, 9 }, { 0, 1, 2 } })
+	->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,51 @@
+#include "krtc/base/field_trials.h"
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+TEST(FieldTrialsTest, PushProbingOnlyWhenAggressive)
+{
+	KRTCBitrateConfig config;
+	EXPECT_EQ("", PushFieldTrials(config));
+
+	config.aggressive_initial_probe = true;
+	EXPECT_EQ("WebRTC-Bwe-ProbingConfiguration/p1:4,p2:8/", PushFieldTrials(config));
+}
+
+TEST(FieldTrialsTest, PullPlayoutDelay)
+{
+	KRTCPullLatencyConfig config;
+	EXPECT_EQ("", PullFieldTrials(config));
+
+	config.min_playout_delay_ms = 50;
+	config.max_playout_delay_ms = 20;
+	EXPECT_EQ("WebRTC-ForcePlayoutDelay/min_ms:50,max_ms:50/", PullFieldTrials(config));
+
+	config.render_asap = true;
+	EXPECT_EQ("WebRTC-ForcePlayoutDelay/min_ms:0,max_ms:0/", PullFieldTrials(config));
+}
+
+TEST(FieldTrialsTest, FindMatchesWholeKey)
+{
+	const std::string trials = "WebRTC-A/Enabled/WebRTC-AB/x:1,y:2/";
+	EXPECT_EQ("Enabled", KRTCFieldTrials::Find(trials, "WebRTC-A"));
+	EXPECT_EQ("x:1,y:2", KRTCFieldTrials::Find(trials, "WebRTC-AB"));
+	EXPECT_EQ("", KRTCFieldTrials::Find(trials, "WebRTC"));
+	EXPECT_EQ("", KRTCFieldTrials::Find("", "WebRTC-A"));
+}
+
+TEST(FieldTrialsTest, LookupReadsCurrentConfig)
+{
+	// 推流factory的trials每次查询都重新读配置，改了以后新建的Call能看到
+	KRTCBitrateConfig config;
+	KRTCFieldTrials trials([&config]() { return PushFieldTrials(config); });
+	EXPECT_EQ("", trials.Lookup("WebRTC-Bwe-ProbingConfiguration"));
+
+	config.aggressive_initial_probe = true;
+	EXPECT_EQ("p1:4,p2:8", trials.Lookup("WebRTC-Bwe-ProbingConfiguration"));
+}
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,92 @@
+#include "krtc/media/frame_mailbox.h"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+std::shared_ptr<MediaFrame> MakeFrame(uint32_t ts)
+{
+	auto frame = std::make_shared<MediaFrame>(0);
+	frame->ts = ts;
+	return frame;
+}
+
+TEST(FrameMailboxTest, AcquireReturnsLatestFrameOnce)
+{
+	FrameMailbox mailbox;
+	EXPECT_EQ(nullptr, mailbox.Acquire());
+
+	mailbox.Publish(MakeFrame(1));
+	mailbox.Publish(MakeFrame(2));
+	mailbox.Publish(MakeFrame(3));
+	std::shared_ptr<MediaFrame> frame = mailbox.Acquire();
+	ASSERT_TRUE(frame);
+	EXPECT_EQ(3u, frame->ts);
+	EXPECT_EQ(nullptr, mailbox.Acquire());
+
+	mailbox.Publish(MakeFrame(4));
+	frame = mailbox.Acquire();
+	ASSERT_TRUE(frame);
+	EXPECT_EQ(4u, frame->ts);
+
+	KRTCFrameMailboxStats stats = mailbox.stats();
+	EXPECT_EQ(4u, stats.frames_published);
+	EXPECT_EQ(2u, stats.frames_acquired);
+	EXPECT_EQ(2u, stats.frames_dropped_before_render);
+}
+
+TEST(FrameMailboxTest, OverwrittenFramesAreReleased)
+{
+	FrameMailbox mailbox;
+	std::shared_ptr<MediaFrame> first = MakeFrame(1);
+	std::weak_ptr<MediaFrame> first_ref = first;
+	mailbox.Publish(std::move(first));
+	EXPECT_FALSE(first_ref.expired());
+
+	// 解码器的缓冲池有上限，被覆盖的帧不能留在信箱里
+	mailbox.Publish(MakeFrame(2));
+	EXPECT_TRUE(first_ref.expired());
+
+	std::weak_ptr<MediaFrame> second_ref = mailbox.Acquire();
+	EXPECT_TRUE(second_ref.expired());
+}
+
+TEST(FrameMailboxTest, ConsumerSeesFramesInOrder)
+{
+	const uint32_t kFrames = 100000;
+	FrameMailbox mailbox;
+
+	std::thread producer([&mailbox, kFrames] {
+		for (uint32_t ts = 1; ts <= kFrames; ts++) {
+			mailbox.Publish(MakeFrame(ts));
+			if (ts % 64 == 0) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	uint32_t last_ts = 0;
+	while (last_ts < kFrames) {
+		std::shared_ptr<MediaFrame> frame = mailbox.Acquire();
+		if (!frame) {
+			std::this_thread::yield();
+			continue;
+		}
+		if (frame->ts <= last_ts) {
+			ADD_FAILURE() << "frame " << frame->ts << " after " << last_ts;
+			break;
+		}
+		last_ts = frame->ts;
+	}
+	producer.join();
+
+	KRTCFrameMailboxStats stats = mailbox.stats();
+	EXPECT_EQ(kFrames, stats.frames_published);
+	EXPECT_EQ(stats.frames_published, stats.frames_acquired + stats.frames_dropped_before_render);
+}
+
+}  // namespace
+}  // namespace krtc
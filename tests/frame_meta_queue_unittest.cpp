@@ -0,0 +1,54 @@
+#include "krtc/codec/frame_meta_queue.h"
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+struct Meta {
+	int stream = -1;
+	int64_t timestamp = 0;
+};
+
+TEST(FrameMetaQueueTest, TakeReturnsMetaAndDropsSkippedTags)
+{
+	FrameMetaQueue<Meta> queue;
+	int64_t t0 = queue.Push({ 0, 100 });
+	int64_t t1 = queue.Push({ 0, 200 });
+	int64_t t2 = queue.Push({ 0, 300 });
+	EXPECT_EQ(3u, queue.size());
+
+	// 编码器跳过了t0、t1，直接输出t2
+	Meta meta;
+	ASSERT_TRUE(queue.Take(t2, &meta));
+	EXPECT_EQ(300, meta.timestamp);
+	EXPECT_EQ(0u, queue.size());
+	EXPECT_FALSE(queue.Take(t0, &meta));
+	EXPECT_FALSE(queue.Take(t1, &meta));
+}
+
+TEST(FrameMetaQueueTest, EraseRevokesFailedSubmit)
+{
+	FrameMetaQueue<Meta> queue;
+	int64_t t0 = queue.Push({ 0, 100 });
+	int64_t t1 = queue.Push({ 0, 200 });
+	queue.Erase(t1);
+
+	Meta meta;
+	EXPECT_FALSE(queue.Take(t1, &meta));
+	ASSERT_TRUE(queue.Take(t0, &meta));
+	EXPECT_EQ(100, meta.timestamp);
+}
+
+TEST(FrameMetaQueueTest, ClearRestartsTags)
+{
+	FrameMetaQueue<Meta> queue;
+	queue.Push({ 0, 100 });
+	queue.Push({ 0, 200 });
+	queue.Clear();
+	EXPECT_EQ(0u, queue.size());
+	EXPECT_EQ(0, queue.Push({ 0, 300 }));
+}
+
+}  // namespace
+}  // namespace krtc
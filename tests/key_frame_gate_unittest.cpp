@@ -0,0 +1,87 @@
+#include "krtc/codec/key_frame_gate.h"
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+using Action = KeyFrameGate::Action;
+
+KRTCKeyFrameConfig MakeConfig(bool intra_refresh)
+{
+	KRTCKeyFrameConfig config;
+	config.intra_refresh = intra_refresh;
+	config.intra_refresh_frames = 30;
+	config.coalesce_window_ms = 300;
+	config.min_interval_ms = 1000;
+	return config;
+}
+
+KeyFrameGate MakeGate(bool intra_refresh)
+{
+	KeyFrameGate gate;
+	gate.Configure(MakeConfig(intra_refresh), 30.0f);
+	return gate;
+}
+
+TEST(KeyFrameGateTest, ForcedKeyFrameIsNotLimited)
+{
+	KeyFrameGate gate = MakeGate(false);
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(0, true, false));
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(10, true, true));
+	EXPECT_EQ(0u, gate.requests());
+}
+
+TEST(KeyFrameGateTest, RequestsRightAfterKeyFrameAreCoalesced)
+{
+	KeyFrameGate gate = MakeGate(false);
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(0, true, false));
+
+	// 同一次丢包引起的PLI/FIR由刚发出的关键帧满足，之后也不补发
+	EXPECT_EQ(Action::kNone, gate.OnFrame(100, false, true));
+	EXPECT_EQ(Action::kNone, gate.OnFrame(200, false, true));
+	EXPECT_EQ(Action::kNone, gate.OnFrame(2000, false, false));
+	EXPECT_EQ(2u, gate.requests());
+	EXPECT_EQ(2u, gate.coalesced());
+}
+
+TEST(KeyFrameGateTest, RequestsAreDeferredToMinInterval)
+{
+	KeyFrameGate gate = MakeGate(false);
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(0, true, false));
+
+	EXPECT_EQ(Action::kNone, gate.OnFrame(500, false, true));
+	EXPECT_EQ(Action::kNone, gate.OnFrame(900, false, true));
+	// 间隔到了，两个请求合并成一个关键帧
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(1000, false, false));
+	EXPECT_EQ(Action::kNone, gate.OnFrame(1033, false, false));
+	EXPECT_EQ(2u, gate.requests());
+	EXPECT_EQ(1u, gate.coalesced());
+}
+
+TEST(KeyFrameGateTest, IntraRefreshEscalatesToIdrWhenReceiverKeepsAsking)
+{
+	KeyFrameGate gate = MakeGate(true);
+
+	EXPECT_EQ(Action::kIntraRefresh, gate.OnFrame(0, false, true));
+	// 30帧的刷新要1秒，结束后1秒内还在请求，改发IDR
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(1500, false, true));
+	// IDR之后的下一次请求又先用刷新
+	EXPECT_EQ(Action::kIntraRefresh, gate.OnFrame(5000, false, true));
+	EXPECT_EQ(2u, gate.intra_refreshes());
+}
+
+TEST(KeyFrameGateTest, ConfigureResetsState)
+{
+	KeyFrameGate gate = MakeGate(false);
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(0, true, false));
+	EXPECT_EQ(Action::kNone, gate.OnFrame(500, false, true));
+
+	// 重新配置(比如重新协商)后之前挂起的请求和限频都清掉
+	gate.Configure(MakeConfig(false), 30.0f);
+	EXPECT_EQ(0u, gate.requests());
+	EXPECT_EQ(Action::kIdr, gate.OnFrame(600, false, true));
+}
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,346 @@
+// 受限链路上不同降级策略的分辨率/帧率取舍：同进程两个PeerConnection，
+// 媒体经UdpLinkShaper限速(上行kbps，单向20ms)，发送1280x720@30的合成屏幕画面(滚动的文字)，
+// 预热后每秒读一次发送端outbound-rtp，统计平均分辨率、编码帧率和接收端解码帧率。
+// 采集端用SDK的VideoCapturer，和推流一样按偏好过滤VideoAdapter的降级请求。
+//   krtc_benchmarks --benchmark_filter=DegradationOnShapedLink
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <api/audio_codecs/builtin_audio_decoder_factory.h>
+#include <api/audio_codecs/builtin_audio_encoder_factory.h>
+#include <api/create_peerconnection_factory.h>
+#include <api/jsep.h>
+#include <api/peer_connection_interface.h>
+#include <api/stats/rtc_stats_collector_callback.h>
+#include <api/video/i420_buffer.h>
+#include <api/video_codecs/builtin_video_decoder_factory.h>
+#include <api/video_codecs/builtin_video_encoder_factory.h>
+#include <benchmark/benchmark.h>
+#include <json/json.h>
+#include <rtc_base/thread.h>
+#include <rtc_base/time_utils.h>
+
+#include "krtc/device/headless_audio_device.h"
+#include "krtc/device/video_capturer.h"
+#include "udp_link_shaper.h"
+
+namespace krtc {
+namespace {
+
+const int kWidth = 1280;
+const int kHeight = 720;
+const int kFps = 30;
+const auto kWarmUp = std::chrono::seconds(8);
+const int kSamples = 10;
+
+// 白底黑字的合成屏幕，文字区域每帧向上滚动2行像素，编码器始终有残差要编
+class ScrollingTextCapturer : public VideoCapturer {
+public:
+	~ScrollingTextCapturer() override { Stop(); }
+
+	void Start() override
+	{
+		running_ = true;
+		thread_ = std::thread([this]() {
+			auto next = std::chrono::steady_clock::now();
+			for (int index = 0; running_; index++) {
+				OnFrame(webrtc::VideoFrame::Builder()
+					.set_video_frame_buffer(Render(index))
+					.set_timestamp_us(rtc::TimeMicros())
+					.build());
+				next += std::chrono::microseconds(1000000 / kFps);
+				std::this_thread::sleep_until(next);
+			}
+		});
+	}
+
+	void Stop() override
+	{
+		running_ = false;
+		if (thread_.joinable()) {
+			thread_.join();
+		}
+	}
+
+private:
+	static rtc::scoped_refptr<webrtc::I420Buffer> Render(int index)
+	{
+		rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(kWidth, kHeight);
+		webrtc::I420Buffer::SetBlack(buffer.get());
+		for (int y = 0; y < kHeight; y++) {
+			uint8_t* row = buffer->MutableDataY() + y * buffer->StrideY();
+			// 每20行一行字，字高10，字宽6，字间距2
+			int line = (y + index * 2) / 20;
+			int glyph_y = (y + index * 2) % 20;
+			for (int x = 0; x < kWidth; x++) {
+				int glyph = x / 8;
+				int glyph_x = x % 8;
+				uint32_t hash = (line * 131 + glyph) * 2654435761u;
+				bool ink = glyph_y < 10 && glyph_x < 6 && ((hash >> (glyph_y * 3 + glyph_x % 3)) & 1);
+				row[x] = ink ? 16 : 235;
+			}
+		}
+		return buffer;
+	}
+
+	std::atomic<bool> running_{ false };
+	std::thread thread_;
+};
+
+class ScrollingTextSource : public CapturerTrackSource {
+public:
+	ScrollingTextSource() : CapturerTrackSource(std::make_unique<ScrollingTextCapturer>()) {}
+};
+
+class Peer : public webrtc::PeerConnectionObserver {
+public:
+	using CandidateSink = std::function<void(const std::string& mid, int mline, const std::string& candidate)>;
+
+	void Create(webrtc::PeerConnectionFactoryInterface* factory, CandidateSink sink)
+	{
+		sink_ = std::move(sink);
+		webrtc::PeerConnectionInterface::RTCConfiguration config;
+		config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
+		config.tcp_candidate_policy = webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+		pc_ = factory->CreatePeerConnection(config, nullptr, nullptr, this);
+	}
+
+	webrtc::PeerConnectionInterface* pc() { return pc_.get(); }
+
+	void WaitForGathering() { gathered_.get_future().wait(); }
+
+	// outbound-rtp或inbound-rtp里video那一项
+	Json::Value VideoRtpStats(const std::string& type)
+	{
+		auto callback = rtc::make_ref_counted<StatsCallback>();
+		pc_->GetStats(callback.get());
+		rtc::scoped_refptr<const webrtc::RTCStatsReport> report = callback->done.get_future().get();
+		Json::Reader reader;
+		for (auto it = report->begin(); it != report->end(); ++it) {
+			Json::Value stats;
+			if (reader.parse(it->ToJson(), stats) && stats["type"].asString() == type &&
+				stats["kind"].asString() == "video") {
+				return stats;
+			}
+		}
+		return Json::Value();
+	}
+
+	void Close()
+	{
+		pc_->Close();
+		pc_ = nullptr;
+	}
+
+	// webrtc::PeerConnectionObserver
+	void OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState) override {}
+	void OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface>) override {}
+	void OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState state) override
+	{
+		if (state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+			gathered_.set_value();
+		}
+	}
+	void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override
+	{
+		std::string sdp;
+		candidate->ToString(&sdp);
+		sink_(candidate->sdp_mid(), candidate->sdp_mline_index(), sdp);
+	}
+
+private:
+	class StatsCallback : public webrtc::RTCStatsCollectorCallback {
+	public:
+		void OnStatsDelivered(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override
+		{
+			done.set_value(report);
+		}
+
+		std::promise<rtc::scoped_refptr<const webrtc::RTCStatsReport>> done;
+	};
+
+	CandidateSink sink_;
+	std::promise<void> gathered_;
+	rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc_;
+};
+
+class CreateObserver : public webrtc::CreateSessionDescriptionObserver {
+public:
+	void OnSuccess(webrtc::SessionDescriptionInterface* desc) override
+	{
+		done.set_value(std::unique_ptr<webrtc::SessionDescriptionInterface>(desc));
+	}
+	void OnFailure(webrtc::RTCError) override { done.set_value(nullptr); }
+
+	std::promise<std::unique_ptr<webrtc::SessionDescriptionInterface>> done;
+};
+
+class SetLocalObserver : public webrtc::SetLocalDescriptionObserverInterface {
+public:
+	void OnSetLocalDescriptionComplete(webrtc::RTCError) override { done.set_value(); }
+
+	std::promise<void> done;
+};
+
+class SetRemoteObserver : public webrtc::SetRemoteDescriptionObserverInterface {
+public:
+	void OnSetRemoteDescriptionComplete(webrtc::RTCError) override { done.set_value(); }
+
+	std::promise<void> done;
+};
+
+std::string CreateAndSetLocal(webrtc::PeerConnectionInterface* pc, bool offer)
+{
+	auto create = rtc::make_ref_counted<CreateObserver>();
+	if (offer) {
+		pc->CreateOffer(create.get(), webrtc::PeerConnectionInterface::RTCOfferAnswerOptions());
+	}
+	else {
+		pc->CreateAnswer(create.get(), webrtc::PeerConnectionInterface::RTCOfferAnswerOptions());
+	}
+	std::unique_ptr<webrtc::SessionDescriptionInterface> desc = create->done.get_future().get();
+	std::string sdp;
+	desc->ToString(&sdp);
+
+	auto set = rtc::make_ref_counted<SetLocalObserver>();
+	pc->SetLocalDescription(std::move(desc), set);
+	set->done.get_future().wait();
+	return sdp;
+}
+
+void SetRemote(webrtc::PeerConnectionInterface* pc, webrtc::SdpType type, const std::string& sdp)
+{
+	auto set = rtc::make_ref_counted<SetRemoteObserver>();
+	pc->SetRemoteDescription(webrtc::CreateSessionDescription(type, sdp), set);
+	set->done.get_future().wait();
+}
+
+struct PendingCandidate {
+	std::string mid;
+	int mline;
+	std::string sdp;
+};
+
+void BM_DegradationOnShapedLink(benchmark::State& state)
+{
+	const DEGRADATION_PREFERENCE preference = static_cast<DEGRADATION_PREFERENCE>(state.range(0));
+	test::LinkProfile uplink;
+	uplink.kbps = static_cast<int>(state.range(1));
+	uplink.delay = std::chrono::milliseconds(20);
+	test::LinkProfile downlink;
+	downlink.delay = std::chrono::milliseconds(20);
+
+	std::unique_ptr<rtc::Thread> signaling_thread = rtc::Thread::Create();
+	signaling_thread->Start();
+	rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory(
+		nullptr /* network_thread */, nullptr /* worker_thread */, signaling_thread.get(),
+		rtc::make_ref_counted<HeadlessAudioDevice>(""),
+		webrtc::CreateBuiltinAudioEncoderFactory(), webrtc::CreateBuiltinAudioDecoderFactory(),
+		webrtc::CreateBuiltinVideoEncoderFactory(), webrtc::CreateBuiltinVideoDecoderFactory(),
+		nullptr /* audio_mixer */, nullptr /* audio_processing */);
+
+	double width = 0;
+	double height = 0;
+	double fps = 0;
+	double received_fps = 0;
+	int bandwidth_limited = 0;
+	for (auto _ : state) {
+		test::UdpLinkShaper shaper(uplink, downlink);
+		Peer sender;
+		Peer receiver;
+		std::vector<PendingCandidate> to_sender;
+		std::vector<PendingCandidate> to_receiver;
+		std::mutex candidates_mutex;
+		sender.Create(factory.get(), [&](const std::string& mid, int mline, const std::string& sdp) {
+			std::string rewritten = shaper.RewriteCandidateOfA(sdp);
+			if (!rewritten.empty()) {
+				std::lock_guard<std::mutex> locker(candidates_mutex);
+				to_receiver.push_back({ mid, mline, rewritten });
+			}
+		});
+		receiver.Create(factory.get(), [&](const std::string& mid, int mline, const std::string& sdp) {
+			std::string rewritten = shaper.RewriteCandidateOfB(sdp);
+			if (!rewritten.empty()) {
+				std::lock_guard<std::mutex> locker(candidates_mutex);
+				to_sender.push_back({ mid, mline, rewritten });
+			}
+		});
+
+		auto source = rtc::make_ref_counted<ScrollingTextSource>();
+		source->SetDegradationPreference(preference);
+		rtc::scoped_refptr<webrtc::VideoTrackInterface> track = factory->CreateVideoTrack("video", source.get());
+		track->set_content_hint(webrtc::VideoTrackInterface::ContentHint::kDetailed);
+		auto video_sender = sender.pc()->AddTrack(track, { "stream" }).MoveValue();
+		webrtc::RtpParameters parameters = video_sender->GetParameters();
+		parameters.degradation_preference =
+			preference == DEGRADATION_PREFERENCE::MAINTAIN_FRAMERATE ? webrtc::DegradationPreference::MAINTAIN_FRAMERATE :
+			preference == DEGRADATION_PREFERENCE::MAINTAIN_RESOLUTION ? webrtc::DegradationPreference::MAINTAIN_RESOLUTION :
+			webrtc::DegradationPreference::BALANCED;
+		video_sender->SetParameters(parameters);
+
+		// 候选都收集完再交换，避免对端还没有远端描述时AddIceCandidate失败
+		std::string offer = CreateAndSetLocal(sender.pc(), true);
+		SetRemote(receiver.pc(), webrtc::SdpType::kOffer, offer);
+		std::string answer = CreateAndSetLocal(receiver.pc(), false);
+		SetRemote(sender.pc(), webrtc::SdpType::kAnswer, answer);
+		sender.WaitForGathering();
+		receiver.WaitForGathering();
+		{
+			std::lock_guard<std::mutex> locker(candidates_mutex);
+			for (auto& candidate : to_sender) {
+				sender.pc()->AddIceCandidate(std::unique_ptr<webrtc::IceCandidateInterface>(
+					webrtc::CreateIceCandidate(candidate.mid, candidate.mline, candidate.sdp, nullptr)),
+					[](webrtc::RTCError) {});
+			}
+			for (auto& candidate : to_receiver) {
+				receiver.pc()->AddIceCandidate(std::unique_ptr<webrtc::IceCandidateInterface>(
+					webrtc::CreateIceCandidate(candidate.mid, candidate.mline, candidate.sdp, nullptr)),
+					[](webrtc::RTCError) {});
+			}
+		}
+		source->Start();
+
+		std::this_thread::sleep_for(kWarmUp);
+		for (int i = 0; i < kSamples; i++) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			Json::Value outbound = sender.VideoRtpStats("outbound-rtp");
+			Json::Value inbound = receiver.VideoRtpStats("inbound-rtp");
+			width += outbound["frameWidth"].asDouble();
+			height += outbound["frameHeight"].asDouble();
+			fps += outbound["framesPerSecond"].asDouble();
+			received_fps += inbound["framesPerSecond"].asDouble();
+			bandwidth_limited += outbound["qualityLimitationReason"].asString() == "bandwidth" ? 1 : 0;
+		}
+
+		source->Stop();
+		sender.Close();
+		receiver.Close();
+	}
+
+	double samples = static_cast<double>(state.iterations() * kSamples);
+	state.counters["width"] = width / samples;
+	state.counters["height"] = height / samples;
+	state.counters["fps"] = fps / samples;
+	state.counters["recv_fps"] = received_fps / samples;
+	state.counters["bw_limited"] = bandwidth_limited / samples;
+}
+
+BENCHMARK(BM_DegradationOnShapedLink)
+	->ArgNames({ "preference", "kbps" })
+	->ArgsProduct({
+		{ static_cast<int>(DEGRADATION_PREFERENCE::BALANCED),
+		  static_cast<int>(DEGRADATION_PREFERENCE::MAINTAIN_FRAMERATE),
+		  static_cast<int>(DEGRADATION_PREFERENCE::MAINTAIN_RESOLUTION) },
+		{ 300, 1000 } })
+	->Iterations(1)->UseRealTime()->Unit(benchmark::kSecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,79 @@
+// GlRenderer离屏渲染(hwnd为0，渲染到FBO)每帧的耗时：OnFrame到渲染线程画完这一帧。
+// dirty=0每帧整帧更新，dirty=1每帧只更新1/16的区域(屏幕共享里常见)。
+// upload_us为渲染线程上传纹理的平均耗时，和render_cpu_benchmark.cpp的BM_RenderCpuArgb对照。
+// llvmpipe上光栅化也在CPU上做，整帧耗时主要是绘制，这时只比upload_us；
+// 无GPU时用Mesa llvmpipe：
+//   LIBGL_ALWAYS_SOFTWARE=1 krtc_benchmarks --benchmark_filter=Render
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+#include "api/video/video_frame.h"
+
+#include "krtc/render/video_renderer.h"
+#include "tests/render_benchmark_util.h"
+
+namespace krtc {
+namespace {
+
+void BM_RenderGl(benchmark::State& state)
+{
+	const int height = static_cast<int>(state.range(0));
+	const int width = height * 16 / 9;
+	const bool dirty_only = state.range(1) != 0;
+
+	std::unique_ptr<VideoRenderer> renderer = VideoRenderer::CreatePlatformRenderer(0, width, height);
+	if (!renderer) {
+		state.SkipWithError("no platform renderer");
+		return;
+	}
+
+	// 两帧内容不同，轮流送，保证每次都有像素要上传
+	webrtc::VideoFrame::UpdateRect update_rect = { 0, 0, width, height };
+	if (dirty_only) {
+		update_rect = { width / 4, height / 4, width / 4, height / 4 };
+	}
+	webrtc::VideoFrame frames[2] = {
+		webrtc::VideoFrame::Builder()
+			.set_video_frame_buffer(test::CreateGradientFrame(width, height, 0))
+			.set_update_rect(update_rect)
+			.build(),
+		webrtc::VideoFrame::Builder()
+			.set_video_frame_buffer(test::CreateGradientFrame(width, height, 64))
+			.set_update_rect(update_rect)
+			.build(),
+	};
+
+	// 第一帧创建EGL上下文和纹理，不计入
+	renderer->OnFrame(frames[1]);
+	if (!test::WaitRendered(*renderer, 1, std::chrono::seconds(5))) {
+		state.SkipWithError("EGL/GLES init failed");
+		return;
+	}
+	VideoRenderer::RenderStats begin = renderer->render_stats();
+
+	uint64_t rendered = begin.frames;
+	for (auto _ : state) {
+		renderer->OnFrame(frames[rendered & 1]);
+		rendered++;
+		if (!test::WaitRendered(*renderer, rendered, std::chrono::seconds(5))) {
+			state.SkipWithError("render timed out");
+			return;
+		}
+	}
+
+	VideoRenderer::RenderStats end = renderer->render_stats();
+	if (end.frames > begin.frames) {
+		state.counters["upload_us"] = benchmark::Counter(
+			static_cast<double>(end.upload_us_total - begin.upload_us_total) / (end.frames - begin.frames));
+	}
+}
+
+BENCHMARK(BM_RenderGl)
+	->ArgNames({ "height", "dirty" })
+	->ArgsProduct({ { 720, 1080 }, { 0, 1 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace krtc
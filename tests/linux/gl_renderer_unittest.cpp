@@ -0,0 +1,127 @@
+// GlRenderer离屏渲染(hwnd为0)画到FBO后读回像素检查。没有GPU时用Mesa llvmpipe：
+//   LIBGL_ALWAYS_SOFTWARE=1 krtc_unittests --gtest_filter=GlRendererTest.*
+// 没有可用的EGL/GLES3时跳过。
+
+#include "krtc/render/linux/gl_renderer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "api/video/i420_buffer.h"
+
+#include "tests/render_benchmark_util.h"
+
+namespace krtc {
+namespace {
+
+const int kWidth = 128;
+const int kHeight = 72;
+// shader里是mediump，允许几个级别的误差
+const int kTolerance = 4;
+
+rtc::scoped_refptr<webrtc::I420Buffer> CreateSolidFrame(uint8_t y, uint8_t u, uint8_t v)
+{
+	rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(kWidth, kHeight);
+	memset(buffer->MutableDataY(), y, buffer->StrideY() * kHeight);
+	memset(buffer->MutableDataU(), u, buffer->StrideU() * buffer->ChromaHeight());
+	memset(buffer->MutableDataV(), v, buffer->StrideV() * buffer->ChromaHeight());
+	return buffer;
+}
+
+class GlRendererTest : public testing::Test {
+protected:
+	void SetUp() override
+	{
+		renderer_ = GlRenderer::Create(0, kWidth, kHeight);
+	}
+
+	// 送一帧并等它画完，EGL/GLES3不可用时返回false
+	bool Render(const webrtc::VideoFrame& frame)
+	{
+		renderer_->OnFrame(frame);
+		return test::WaitRendered(*renderer_, ++rendered_, std::chrono::seconds(5));
+	}
+
+	void ReadBack()
+	{
+		int width = 0;
+		int height = 0;
+		ASSERT_TRUE(static_cast<GlRenderer*>(renderer_.get())->ReadOffscreenPixels(&pixels_, &width, &height));
+		ASSERT_EQ(kWidth, width);
+		ASSERT_EQ(kHeight, height);
+	}
+
+	void ExpectPixel(int x, int y, int r, int g, int b)
+	{
+		const uint8_t* pixel = pixels_.data() + (y * kWidth + x) * 4;
+		EXPECT_NEAR(r, pixel[0], kTolerance) << "at " << x << "," << y;
+		EXPECT_NEAR(g, pixel[1], kTolerance) << "at " << x << "," << y;
+		EXPECT_NEAR(b, pixel[2], kTolerance) << "at " << x << "," << y;
+	}
+
+	std::unique_ptr<VideoRenderer> renderer_;
+	uint64_t rendered_ = 0;
+	std::vector<uint8_t> pixels_;
+};
+
+TEST_F(GlRendererTest, DrawsBt601ByDefault)
+{
+	// 有限范围BT.601下是纯红
+	webrtc::VideoFrame frame = webrtc::VideoFrame::Builder()
+		.set_video_frame_buffer(CreateSolidFrame(81, 90, 240))
+		.build();
+	if (!Render(frame)) {
+		GTEST_SKIP() << "EGL/GLES3 not available";
+	}
+	ReadBack();
+	ExpectPixel(0, 0, 255, 0, 0);
+	ExpectPixel(kWidth / 2, kHeight / 2, 255, 0, 0);
+	ExpectPixel(kWidth - 1, kHeight - 1, 255, 0, 0);
+}
+
+TEST_F(GlRendererTest, UsesBt709MatrixFromColorSpace)
+{
+	webrtc::VideoFrame frame = webrtc::VideoFrame::Builder()
+		.set_video_frame_buffer(CreateSolidFrame(81, 90, 240))
+		.set_color_space(webrtc::ColorSpace(webrtc::ColorSpace::PrimaryID::kBT709,
+			webrtc::ColorSpace::TransferID::kBT709,
+			webrtc::ColorSpace::MatrixID::kBT709,
+			webrtc::ColorSpace::RangeID::kLimited))
+		.build();
+	if (!Render(frame)) {
+		GTEST_SKIP() << "EGL/GLES3 not available";
+	}
+	ReadBack();
+	// 同样的YUV按BT.709转换，绿色分量明显不为0
+	ExpectPixel(kWidth / 2, kHeight / 2, 255, 24, 2);
+}
+
+// 第二帧整帧都变了，但update_rect只有左半边，右半边应该还是上一帧的内容
+TEST_F(GlRendererTest, UploadsOnlyUpdateRect)
+{
+	webrtc::VideoFrame dark = webrtc::VideoFrame::Builder()
+		.set_video_frame_buffer(CreateSolidFrame(60, 128, 128))
+		.build();
+	webrtc::VideoFrame bright = webrtc::VideoFrame::Builder()
+		.set_video_frame_buffer(CreateSolidFrame(200, 128, 128))
+		.set_update_rect({ 0, 0, kWidth / 2, kHeight })
+		.build();
+	if (!Render(dark)) {
+		GTEST_SKIP() << "EGL/GLES3 not available";
+	}
+	ASSERT_TRUE(Render(bright));
+	ReadBack();
+
+	// Y=200 -> 214，Y=60 -> 51，离分界线远一点避开纹理过滤
+	ExpectPixel(4, kHeight / 2, 214, 214, 214);
+	ExpectPixel(kWidth / 2 - 4, kHeight / 2, 214, 214, 214);
+	ExpectPixel(kWidth / 2 + 4, kHeight / 2, 51, 51, 51);
+	ExpectPixel(kWidth - 4, kHeight / 2, 51, 51, 51);
+}
+
+}  // namespace
+}  // namespace krtc
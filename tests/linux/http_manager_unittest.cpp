@@ -0,0 +1,85 @@
+#include "krtc/base/krtc_http.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "local_http_server.h"
+
+namespace krtc {
+namespace {
+
+// 多个线程同时发请求，http_thread同时在驱动multi handle。
+// easy handle之前在调用线程上直接加入multi handle，和curl_multi_perform并发，
+// 这里会出现丢请求、卡死或崩溃。
+TEST(HttpManagerTest, StressConcurrentRequestsFromManyThreads)
+{
+	const int kThreads = 8;
+	const int kRequests = 10000;
+
+	test::LocalHttpServer server([](const test::LocalHttpRequest&) {
+		test::LocalHttpResponse response;
+		response.body = "ok";
+		return response;
+	});
+	const std::string url = server.origin() + "/ping";
+	HttpManager manager;
+	manager.Start();
+	HttpObjectHandle obj = manager.AddObject();
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	int done = 0;
+	std::atomic<int> ok{ 0 };
+	std::atomic<int> reused{ 0 };
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> callers;
+	for (int t = 0; t < kThreads; ++t) {
+		callers.emplace_back([&]() {
+			for (int i = 0; i < kRequests / kThreads; ++i) {
+				manager.Get(HttpRequest(url), [&](HttpReply reply) {
+					if (reply.get_errno() == 0 && reply.get_status_code() == 200 && reply.get_resp() == "ok") {
+						ok++;
+					}
+					if (reply.get_reused_connection()) {
+						reused++;
+					}
+					std::lock_guard<std::mutex> locker(mutex);
+					done++;
+					cond.notify_all();
+				}, obj);
+			}
+		});
+	}
+	for (auto& caller : callers) {
+		caller.join();
+	}
+
+	{
+		std::unique_lock<std::mutex> locker(mutex);
+		EXPECT_TRUE(cond.wait_for(locker, std::chrono::seconds(60), [&]() { return done == kRequests; }))
+			<< "completed " << done << " of " << kRequests;
+	}
+	auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start).count();
+
+	manager.RemoveObject(obj);
+	manager.Stop();
+
+	EXPECT_EQ(kRequests, ok.load());
+	EXPECT_EQ(kRequests, server.requests());
+	// 连接池生效：每个源最多4条连接
+	EXPECT_LE(server.connections(), 4);
+	std::cout << kRequests << " requests in " << elapsed_ms << " ms, "
+			  << server.connections() << " connections, " << reused.load() << " reused" << std::endl;
+}
+
+}  // namespace
+}  // namespace krtc
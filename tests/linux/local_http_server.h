@@ -0,0 +1,256 @@
+#ifndef KRTCSDK_TESTS_LINUX_LOCAL_HTTP_SERVER_H_
+#define KRTCSDK_TESTS_LINUX_LOCAL_HTTP_SERVER_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+namespace krtc {
+namespace test {
+
+struct LocalHttpRequest {
+	std::string method;
+	std::string path;
+	// 头部名字转成小写
+	std::map<std::string, std::string> headers;
+	std::string body;
+};
+
+struct LocalHttpResponse {
+	int status = 200;
+	std::vector<std::string> headers;
+	std::string body;
+};
+
+using LocalHttpHandler = std::function<LocalHttpResponse(const LocalHttpRequest&)>;
+
+// 测试用的本地HTTP/1.1 keep-alive服务，监听127.0.0.1的随机端口，每条连接一个线程。
+// use_tls时用运行时生成的自签名证书(P-256)，只协商http/1.1。
+// 代码只用OpenSSL和BoringSSL都有的接口，SDK里链接的是WebRTC自带的BoringSSL。
+class LocalHttpServer {
+public:
+	explicit LocalHttpServer(LocalHttpHandler handler, bool use_tls = false)
+		: handler_(std::move(handler))
+	{
+		if (use_tls) {
+			CreateTlsContext();
+		}
+
+		listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+		int reuse = 1;
+		setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		bind(listen_fd_, (sockaddr*)&addr, sizeof(addr));
+		listen(listen_fd_, 128);
+		socklen_t len = sizeof(addr);
+		getsockname(listen_fd_, (sockaddr*)&addr, &len);
+		port_ = ntohs(addr.sin_port);
+
+		accept_thread_ = std::thread([this]() {
+			for (;;) {
+				int fd = accept(listen_fd_, nullptr, nullptr);
+				if (fd < 0) {
+					return;
+				}
+				int nodelay = 1;
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+				std::lock_guard<std::mutex> locker(mutex_);
+				conn_fds_.push_back(fd);
+				conn_threads_.emplace_back([this, fd]() { Serve(fd); });
+			}
+		});
+	}
+
+	~LocalHttpServer()
+	{
+		shutdown(listen_fd_, SHUT_RDWR);
+		close(listen_fd_);
+		accept_thread_.join();
+		{
+			std::lock_guard<std::mutex> locker(mutex_);
+			for (int fd : conn_fds_) {
+				shutdown(fd, SHUT_RDWR);
+			}
+		}
+		for (auto& thread : conn_threads_) {
+			thread.join();
+		}
+		for (int fd : conn_fds_) {
+			close(fd);
+		}
+		if (ssl_ctx_) {
+			SSL_CTX_free(ssl_ctx_);
+		}
+	}
+
+	int port() const { return port_; }
+	std::string origin() const
+	{
+		return std::string(ssl_ctx_ ? "https" : "http") + "://127.0.0.1:" + std::to_string(port_);
+	}
+	int requests() const { return requests_; }
+	int connections()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return static_cast<int>(conn_fds_.size());
+	}
+
+private:
+	void CreateTlsContext()
+	{
+		ssl_ctx_ = SSL_CTX_new(TLS_server_method());
+
+		EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+		EC_KEY_generate_key(ec_key);
+		EVP_PKEY* pkey = EVP_PKEY_new();
+		EVP_PKEY_assign_EC_KEY(pkey, ec_key);
+
+		X509* cert = X509_new();
+		X509_set_version(cert, 2);
+		ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+		X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+		X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+		X509_set_pubkey(cert, pkey);
+		X509_NAME* name = X509_get_subject_name(cert);
+		X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"127.0.0.1", -1, -1, 0);
+		X509_set_issuer_name(cert, name);
+		X509_sign(cert, pkey, EVP_sha256());
+
+		SSL_CTX_use_certificate(ssl_ctx_, cert);
+		SSL_CTX_use_PrivateKey(ssl_ctx_, pkey);
+		X509_free(cert);
+		EVP_PKEY_free(pkey);
+	}
+
+	void Serve(int fd)
+	{
+		SSL* ssl = nullptr;
+		if (ssl_ctx_) {
+			ssl = SSL_new(ssl_ctx_);
+			SSL_set_fd(ssl, fd);
+			if (SSL_accept(ssl) != 1) {
+				SSL_free(ssl);
+				return;
+			}
+		}
+
+		auto recv_some = [&](char* data, int size) -> int {
+			return ssl ? SSL_read(ssl, data, size) : static_cast<int>(recv(fd, data, size, 0));
+		};
+		auto send_all = [&](const std::string& data) -> bool {
+			return ssl ? SSL_write(ssl, data.data(), static_cast<int>(data.size())) == static_cast<int>(data.size())
+					   : send(fd, data.data(), data.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(data.size());
+		};
+
+		std::string buffer;
+		char data[4096];
+		for (;;) {
+			LocalHttpRequest request;
+			size_t header_end = std::string::npos;
+			size_t content_length = 0;
+			for (;;) {
+				header_end = buffer.find("\r\n\r\n");
+				if (header_end != std::string::npos) {
+					content_length = ParseHeaders(buffer.substr(0, header_end), &request);
+					if (buffer.size() >= header_end + 4 + content_length) {
+						break;
+					}
+				}
+				int n = recv_some(data, sizeof(data));
+				if (n <= 0) {
+					if (ssl) {
+						SSL_free(ssl);
+					}
+					return;
+				}
+				buffer.append(data, n);
+			}
+			request.body = buffer.substr(header_end + 4, content_length);
+			buffer.erase(0, header_end + 4 + content_length);
+			requests_++;
+
+			LocalHttpResponse response = handler_(request);
+			std::string out = "HTTP/1.1 " + std::to_string(response.status) + " X\r\n";
+			for (auto& header : response.headers) {
+				out += header + "\r\n";
+			}
+			out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n\r\n";
+			if (request.method != "HEAD") {
+				out += response.body;
+			}
+			if (!send_all(out)) {
+				if (ssl) {
+					SSL_free(ssl);
+				}
+				return;
+			}
+		}
+	}
+
+	static size_t ParseHeaders(const std::string& head, LocalHttpRequest* request)
+	{
+		size_t line_end = head.find("\r\n");
+		std::string request_line = head.substr(0, line_end);
+		size_t sp1 = request_line.find(' ');
+		size_t sp2 = request_line.find(' ', sp1 + 1);
+		request->method = request_line.substr(0, sp1);
+		request->path = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+		request->headers.clear();
+		size_t pos = (line_end == std::string::npos) ? head.size() : line_end + 2;
+		while (pos < head.size()) {
+			size_t end = head.find("\r\n", pos);
+			if (end == std::string::npos) {
+				end = head.size();
+			}
+			std::string line = head.substr(pos, end - pos);
+			size_t colon = line.find(':');
+			if (colon != std::string::npos) {
+				std::string key = line.substr(0, colon);
+				std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+				size_t value_begin = line.find_first_not_of(' ', colon + 1);
+				request->headers[key] = value_begin == std::string::npos ? "" : line.substr(value_begin);
+			}
+			pos = end + 2;
+		}
+
+		auto iter = request->headers.find("content-length");
+		return iter == request->headers.end() ? 0 : std::strtoul(iter->second.c_str(), nullptr, 10);
+	}
+
+	LocalHttpHandler handler_;
+	SSL_CTX* ssl_ctx_ = nullptr;
+	int listen_fd_ = -1;
+	int port_ = 0;
+	std::atomic<int> requests_{ 0 };
+	std::thread accept_thread_;
+	std::mutex mutex_;
+	std::vector<int> conn_fds_;
+	std::vector<std::thread> conn_threads_;
+};
+
+}  // namespace test
+}  // namespace krtc
+
+#endif  // KRTCSDK_TESTS_LINUX_LOCAL_HTTP_SERVER_H_
@@ -0,0 +1,422 @@
+// 推流断线重连：SDK推流到本地的SRS替身，替身每次publish都新建一个接收端PeerConnection，
+// 媒体经UdpLinkShaper中继。推流连上后把链路整个丢包(blackhole)，等SDK开始重连，
+// 再恢复链路，检查OnPushReconnecting/OnPushReconnected的回调和重连统计。
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <api/audio_codecs/builtin_audio_decoder_factory.h>
+#include <api/audio_codecs/builtin_audio_encoder_factory.h>
+#include <api/create_peerconnection_factory.h>
+#include <api/jsep.h>
+#include <api/peer_connection_interface.h>
+#include <api/video_codecs/builtin_video_decoder_factory.h>
+#include <api/video_codecs/builtin_video_encoder_factory.h>
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <rtc_base/thread.h>
+
+#include "krtc/krtc.h"
+#include "krtc/base/krtc_global.h"
+#include "krtc/device/headless_audio_device.h"
+#include "local_http_server.h"
+#include "udp_link_shaper.h"
+
+namespace krtc {
+namespace {
+
+const auto kConnectTimeout = std::chrono::seconds(10);
+// ICE要连续几秒收不到回应才进入disconnected，再加上disconnected_timeout_ms
+const auto kReconnectingTimeout = std::chrono::seconds(20);
+const auto kReconnectedTimeout = std::chrono::seconds(30);
+
+// 沙箱里没有声卡，SDK用无声卡的音频设备，推流只有空的音频轨，不影响建连
+class HeadlessAudioEnvironment : public testing::Environment {
+public:
+	void SetUp() override
+	{
+		KRTCAudioDeviceConfig config;
+		config.type = AUDIO_DEVICE_TYPE::HEADLESS;
+		KRTCEngine::SetAudioDeviceConfig(config);
+	}
+};
+
+const testing::Environment* const kHeadlessAudioEnvironment =
+	testing::AddGlobalTestEnvironment(new HeadlessAudioEnvironment());
+
+class ReceiverPeer : public webrtc::PeerConnectionObserver {
+public:
+	void Create(webrtc::PeerConnectionFactoryInterface* factory)
+	{
+		webrtc::PeerConnectionInterface::RTCConfiguration config;
+		config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
+		config.tcp_candidate_policy = webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+		pc_ = factory->CreatePeerConnection(config, nullptr, nullptr, this);
+	}
+
+	webrtc::PeerConnectionInterface* pc() { return pc_.get(); }
+
+	bool WaitForGathering()
+	{
+		return gathered_future_.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+	}
+
+	void Close()
+	{
+		pc_->Close();
+		pc_ = nullptr;
+	}
+
+	// webrtc::PeerConnectionObserver
+	void OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState) override {}
+	void OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface>) override {}
+	void OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState state) override
+	{
+		if (state == webrtc::PeerConnectionInterface::kIceGatheringComplete && !gathered_set_) {
+			gathered_set_ = true;
+			gathered_.set_value();
+		}
+	}
+	void OnIceCandidate(const webrtc::IceCandidateInterface*) override {}
+
+private:
+	std::promise<void> gathered_;
+	std::future<void> gathered_future_ = gathered_.get_future();
+	bool gathered_set_ = false;
+	rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc_;
+};
+
+class CreateObserver : public webrtc::CreateSessionDescriptionObserver {
+public:
+	void OnSuccess(webrtc::SessionDescriptionInterface* desc) override
+	{
+		done.set_value(std::unique_ptr<webrtc::SessionDescriptionInterface>(desc));
+	}
+	void OnFailure(webrtc::RTCError) override { done.set_value(nullptr); }
+
+	std::promise<std::unique_ptr<webrtc::SessionDescriptionInterface>> done;
+};
+
+class SetLocalObserver : public webrtc::SetLocalDescriptionObserverInterface {
+public:
+	void OnSetLocalDescriptionComplete(webrtc::RTCError) override { done.set_value(); }
+
+	std::promise<void> done;
+};
+
+class SetRemoteObserver : public webrtc::SetRemoteDescriptionObserverInterface {
+public:
+	void OnSetRemoteDescriptionComplete(webrtc::RTCError error) override { done.set_value(error.ok()); }
+
+	std::promise<bool> done;
+};
+
+// 本地的SRS替身：POST /rtc/v1/publish/ 时新建接收端PeerConnection应答，
+// 和SRS一样不理会offer里的候选(ICE-lite，只靠连通性检查学到对端)，
+// answer里的候选改写成经过shaper的地址
+class SrsAnswerer {
+public:
+	explicit SrsAnswerer(test::UdpLinkShaper* shaper)
+		: shaper_(shaper),
+		  signaling_thread_(rtc::Thread::Create())
+	{
+		signaling_thread_->Start();
+		factory_ = webrtc::CreatePeerConnectionFactory(
+			nullptr /* network_thread */, nullptr /* worker_thread */, signaling_thread_.get(),
+			rtc::make_ref_counted<HeadlessAudioDevice>(""),
+			webrtc::CreateBuiltinAudioEncoderFactory(), webrtc::CreateBuiltinAudioDecoderFactory(),
+			webrtc::CreateBuiltinVideoEncoderFactory(), webrtc::CreateBuiltinVideoDecoderFactory(),
+			nullptr /* audio_mixer */, nullptr /* audio_processing */);
+		server_ = std::make_unique<test::LocalHttpServer>(
+			[this](const test::LocalHttpRequest& request) { return Handle(request); });
+	}
+
+	~SrsAnswerer()
+	{
+		// 先停服务线程，不再有新的会话
+		server_.reset();
+		for (auto& peer : peers_) {
+			peer->Close();
+		}
+		peers_.clear();
+		factory_ = nullptr;
+	}
+
+	std::string origin() const { return server_->origin(); }
+
+	int publishes()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return static_cast<int>(peers_.size());
+	}
+
+private:
+	test::LocalHttpResponse Handle(const test::LocalHttpRequest& request)
+	{
+		test::LocalHttpResponse response;
+		Json::Value body;
+		Json::Reader reader;
+		if (request.method != "POST" || request.path != "/rtc/v1/publish/" ||
+			!reader.parse(request.body, body)) {
+			response.status = 404;
+			return response;
+		}
+
+		std::string offer;
+		ForEachLine(body["sdp"].asString(), [&](const std::string& line) {
+			if (line.find("a=candidate:") != 0) {
+				offer += line + "\r\n";
+			}
+		});
+
+		auto peer = std::make_unique<ReceiverPeer>();
+		peer->Create(factory_.get());
+		std::string answer;
+		if (SetRemote(peer->pc(), offer) && SetLocalAnswer(peer->pc()) && peer->WaitForGathering()) {
+			std::string local;
+			peer->pc()->local_description()->ToString(&local);
+			// 重连时推流端和这边都是新的PeerConnection
+			shaper_->ResetEndpoints();
+			ForEachLine(local, [&](const std::string& line) {
+				if (line.find("a=candidate:") != 0) {
+					answer += line + "\r\n";
+					return;
+				}
+				std::string rewritten = shaper_->RewriteCandidateOfB(line.substr(2));
+				if (!rewritten.empty()) {
+					answer += "a=" + rewritten + "\r\n";
+				}
+			});
+		}
+
+		Json::Value reply;
+		reply["code"] = answer.empty() ? 400 : 0;
+		reply["server"] = "reconnect-test";
+		reply["sdp"] = answer;
+		response.headers.push_back("Content-Type: application/json");
+		Json::StreamWriterBuilder writer;
+		writer.settings_["indentation"] = "";
+		response.body = Json::writeString(writer, reply);
+
+		std::lock_guard<std::mutex> locker(mutex_);
+		peers_.push_back(std::move(peer));
+		return response;
+	}
+
+	static void ForEachLine(const std::string& sdp, const std::function<void(const std::string&)>& callback)
+	{
+		std::istringstream in(sdp);
+		std::string line;
+		while (std::getline(in, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (!line.empty()) {
+				callback(line);
+			}
+		}
+	}
+
+	static bool SetRemote(webrtc::PeerConnectionInterface* pc, const std::string& sdp)
+	{
+		std::unique_ptr<webrtc::SessionDescriptionInterface> desc =
+			webrtc::CreateSessionDescription(webrtc::SdpType::kOffer, sdp);
+		if (!desc) {
+			return false;
+		}
+		auto set = rtc::make_ref_counted<SetRemoteObserver>();
+		pc->SetRemoteDescription(std::move(desc), set);
+		return set->done.get_future().get();
+	}
+
+	static bool SetLocalAnswer(webrtc::PeerConnectionInterface* pc)
+	{
+		auto create = rtc::make_ref_counted<CreateObserver>();
+		pc->CreateAnswer(create.get(), webrtc::PeerConnectionInterface::RTCOfferAnswerOptions());
+		std::unique_ptr<webrtc::SessionDescriptionInterface> desc = create->done.get_future().get();
+		if (!desc) {
+			return false;
+		}
+		auto set = rtc::make_ref_counted<SetLocalObserver>();
+		pc->SetLocalDescription(std::move(desc), set);
+		set->done.get_future().wait();
+		return true;
+	}
+
+	test::UdpLinkShaper* shaper_;
+	std::unique_ptr<rtc::Thread> signaling_thread_;
+	rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory_;
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<ReceiverPeer>> peers_;
+	std::unique_ptr<test::LocalHttpServer> server_;
+};
+
+// 记录推流相关的回调，回调来自SDK的线程
+class PushObserver : public KRTCEngineObserver {
+public:
+	void OnPushFailed(KRTCError err) override
+	{
+		Update([&]() { failed_ = err; });
+	}
+
+	// 推流PeerConnection第一次connected
+	void OnPushSetupTimings(const KRTCSetupTimings&) override
+	{
+		Update([&]() { connected_ = true; });
+	}
+
+	void OnPushReconnecting(uint32_t attempt, bool ice_restart) override
+	{
+		Update([&]() { reconnecting_.push_back({ attempt, ice_restart }); });
+	}
+
+	void OnPushReconnected(const KRTCReconnectInfo& info) override
+	{
+		Update([&]() { reconnected_.push_back(info); });
+	}
+
+	bool WaitForConnected()
+	{
+		return WaitFor(kConnectTimeout, [this]() { return connected_; });
+	}
+
+	bool WaitForReconnecting()
+	{
+		return WaitFor(kReconnectingTimeout, [this]() { return !reconnecting_.empty(); });
+	}
+
+	bool WaitForReconnected()
+	{
+		return WaitFor(kReconnectedTimeout, [this]() { return !reconnected_.empty(); });
+	}
+
+	struct Attempt {
+		uint32_t attempt;
+		bool ice_restart;
+	};
+
+	std::vector<Attempt> reconnecting()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return reconnecting_;
+	}
+
+	std::vector<KRTCReconnectInfo> reconnected()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return reconnected_;
+	}
+
+	KRTCError failed()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return failed_;
+	}
+
+private:
+	void Update(const std::function<void()>& update)
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		update();
+		cond_.notify_all();
+	}
+
+	bool WaitFor(std::chrono::seconds timeout, const std::function<bool()>& done)
+	{
+		std::unique_lock<std::mutex> locker(mutex_);
+		cond_.wait_for(locker, timeout, [&]() { return done() || failed_ != KRTCError::kNoErr; });
+		return done();
+	}
+
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool connected_ = false;
+	std::vector<Attempt> reconnecting_;
+	std::vector<KRTCReconnectInfo> reconnected_;
+	KRTCError failed_ = KRTCError::kNoErr;
+};
+
+class PushReconnectTest : public testing::Test {
+protected:
+	void SetUp() override
+	{
+		KRTCGlobal::Instance()->RegisterEngineObserver(&observer_);
+		KRTCEngine::SetSignalingProtocol(SIGNALING_PROTOCOL::SRS);
+
+		KRTCReconnectConfig config;
+		config.disconnected_timeout_ms = 1000;
+		config.max_attempts = 20;
+		config.initial_backoff_ms = 200;
+		config.max_backoff_ms = 1000;
+		config.attempt_timeout_ms = 4000;
+		KRTCEngine::SetReconnectConfig(config);
+	}
+
+	void TearDown() override
+	{
+		if (pusher_) {
+			OnApiThread([this]() { pusher_->Stop(); });
+			pusher_->Destroy();
+			pusher_ = nullptr;
+		}
+		KRTCEngine::SetReconnectConfig(KRTCReconnectConfig());
+		KRTCGlobal::Instance()->RegisterEngineObserver(nullptr);
+	}
+
+	void OnApiThread(std::function<void()> task)
+	{
+		KRTCGlobal::Instance()->api_thread()->BlockingCall(task);
+	}
+
+	void StartPush(const std::string& server_addr)
+	{
+		// 没有采集源时只推音频
+		pusher_ = KRTCEngine::CreatePusher(server_addr.c_str(), "reconnect", nullptr, nullptr);
+		OnApiThread([this]() { pusher_->Start(); });
+	}
+
+	test::UdpLinkShaper shaper_{ test::LinkProfile(), test::LinkProfile() };
+	PushObserver observer_;
+	IMediaHandler* pusher_ = nullptr;
+};
+
+TEST_F(PushReconnectTest, RecoversAfterLinkBlackhole)
+{
+	SrsAnswerer answerer(&shaper_);
+	StartPush(answerer.origin());
+	ASSERT_TRUE(observer_.WaitForConnected());
+	EXPECT_EQ(1, answerer.publishes());
+
+	shaper_.SetBlackhole(true);
+	ASSERT_TRUE(observer_.WaitForReconnecting());
+	std::vector<PushObserver::Attempt> attempts = observer_.reconnecting();
+	EXPECT_EQ(1u, attempts[0].attempt);
+	// SRS不支持ICE restart，直接重建PeerConnection
+	EXPECT_FALSE(attempts[0].ice_restart);
+	EXPECT_TRUE(observer_.reconnected().empty());
+
+	shaper_.SetBlackhole(false);
+	ASSERT_TRUE(observer_.WaitForReconnected());
+	EXPECT_EQ(KRTCError::kNoErr, observer_.failed());
+
+	std::vector<KRTCReconnectInfo> reconnected = observer_.reconnected();
+	ASSERT_EQ(1u, reconnected.size());
+	const KRTCReconnectInfo& info = reconnected[0];
+	EXPECT_GE(info.attempts, 1u);
+	EXPECT_EQ(info.attempts, info.renegotiations);
+	EXPECT_FALSE(info.ice_restart);
+	EXPECT_GT(info.downtime_ms, 0);
+	// 每次尝试都重新publish
+	EXPECT_EQ(observer_.reconnecting().size(), reconnected[0].attempts);
+	EXPECT_EQ(1 + static_cast<int>(info.attempts), answerer.publishes());
+}
+
+}  // namespace
+}  // namespace krtc
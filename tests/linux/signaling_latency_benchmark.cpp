@@ -0,0 +1,103 @@
+// SRS JSON接口和WHIP/WHEP的信令耗时对比：从SendOffer到拿到answer。
+// 本地信令服务(signaling_stand_in.h)前面挂TCP时延代理模拟往返时间。
+//   cold    每次换一个代理端口，连接池里没有可复用的连接
+//   pooled  同一个源连续发，复用连接
+// WHIP的候选在answer之后PATCH，不占建连的关键路径，这里只统计到answer。
+//   krtc_benchmarks --benchmark_filter=SignalingLatency
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/media/signaling.h"
+#include "signaling_stand_in.h"
+#include "tcp_delay_proxy.h"
+
+namespace krtc {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char kOffer[] =
+	"v=0\r\n"
+	"o=- 1 2 IN IP4 127.0.0.1\r\n"
+	"s=-\r\n"
+	"t=0 0\r\n"
+	"a=group:BUNDLE 0\r\n"
+	"m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
+	"c=IN IP4 0.0.0.0\r\n"
+	"a=ice-ufrag:cli1\r\n"
+	"a=ice-pwd:clientclientclientcli01\r\n"
+	"a=mid:0\r\n";
+
+// 发一次offer，返回拿到answer的耗时(秒)，失败返回负数
+double TimedOffer(SIGNALING_PROTOCOL protocol, const std::string& origin)
+{
+	std::string server_addr = protocol == SIGNALING_PROTOCOL::WHIP ? origin + "/whip/endpoint" : origin;
+	HttpObjectHandle owner = KRTCGlobal::Instance()->http_manager()->AddObject();
+	std::unique_ptr<Signaling> signaling;
+	std::promise<bool> done;
+	Clock::time_point start;
+
+	KRTCGlobal::Instance()->api_thread()->BlockingCall([&]() {
+		signaling = Signaling::Create(protocol, CONTROL_TYPE::PUSH, server_addr, "livestream", owner);
+		start = Clock::now();
+		signaling->SendOffer(kOffer, [&](KRTCError err, const std::string& answer) {
+			done.set_value(err == KRTCError::kNoErr && !answer.empty());
+		});
+	});
+	bool ok = done.get_future().get();
+	double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	KRTCGlobal::Instance()->api_thread()->BlockingCall([&]() {
+		KRTCGlobal::Instance()->http_manager()->RemoveObject(owner);
+		signaling->Stop();
+		signaling.reset();
+	});
+	return ok ? elapsed : -1;
+}
+
+void BM_SignalingLatency(benchmark::State& state)
+{
+	const SIGNALING_PROTOCOL protocol = static_cast<SIGNALING_PROTOCOL>(state.range(0));
+	const bool pooled = state.range(1) != 0;
+	const std::chrono::milliseconds rtt(state.range(2));
+
+	test::SignalingStandIn stand_in(true);
+	std::unique_ptr<test::TcpDelayProxy> proxy(new test::TcpDelayProxy(stand_in.port(), rtt));
+	auto origin = [&]() { return "https://127.0.0.1:" + std::to_string(proxy->port()); };
+	if (pooled) {
+		TimedOffer(protocol, origin());
+		std::this_thread::sleep_for(rtt * 2 + std::chrono::milliseconds(10));
+	}
+
+	for (auto _ : state) {
+		if (!pooled) {
+			proxy.reset(new test::TcpDelayProxy(stand_in.port(), rtt));
+		}
+		double elapsed = TimedOffer(protocol, origin());
+		if (elapsed < 0) {
+			state.SkipWithError("offer failed");
+			return;
+		}
+		state.SetIterationTime(elapsed);
+		// 等WHIP的DELETE完成，不和下一次的POST抢连接
+		std::this_thread::sleep_for(rtt * 2 + std::chrono::milliseconds(10));
+	}
+	state.counters["connections"] = stand_in.connections();
+	state.counters["requests"] = benchmark::Counter(
+		static_cast<double>(stand_in.requests().size()), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_SignalingLatency)
+	->ArgNames({ "whip", "pooled", "rtt_ms" })
+	->ArgsProduct({ { static_cast<int>(SIGNALING_PROTOCOL::SRS), static_cast<int>(SIGNALING_PROTOCOL::WHIP) },
+					{ 0, 1 }, { 0, 40 } })
+	->Iterations(20)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace krtc
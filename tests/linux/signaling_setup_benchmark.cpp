@@ -0,0 +1,116 @@
+// 信令建连耗时：本地TLS服务(自签名证书)前面挂一个TCP时延代理模拟往返时间，
+// 比较三种情况下一次publish POST从发出到收到应答的时间：
+//   cold       每次新建HttpManager，DNS/TCP/TLS全部重新来
+//   prewarmed  先PrewarmSignaling(HEAD)，再发POST
+//   pooled     同一个HttpManager连续发，复用连接池里的连接
+//   krtc_benchmarks --benchmark_filter=SignalingSetup
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "krtc/base/krtc_http.h"
+#include "local_http_server.h"
+#include "tcp_delay_proxy.h"
+
+namespace krtc {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum SetupMode {
+	kCold = 0,
+	kPrewarmed,
+	kPooled,
+};
+
+test::LocalHttpResponse OnPublish(const test::LocalHttpRequest&)
+{
+	test::LocalHttpResponse response;
+	response.headers.push_back("Content-Type: application/json");
+	response.body = "{\"code\":0,\"sdp\":\"v=0\"}";
+	return response;
+}
+
+// 发一次publish POST，返回耗时(秒)
+double TimedPost(HttpManager* manager, const std::string& url, HttpObjectHandle obj, bool* reused)
+{
+	std::promise<HttpReply> done;
+	Clock::time_point start = Clock::now();
+	manager->Post(HttpRequest(url, "{\"api\":\"publish\",\"sdp\":\"v=0\"}"), [&](HttpReply reply) {
+		done.set_value(reply);
+	}, obj);
+	HttpReply reply = done.get_future().get();
+	*reused = reply.get_reused_connection();
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void BM_SignalingSetup(benchmark::State& state)
+{
+	const SetupMode mode = static_cast<SetupMode>(state.range(0));
+	const std::chrono::milliseconds rtt(state.range(1));
+
+	test::LocalHttpServer server(OnPublish, true);
+	test::TcpDelayProxy proxy(server.port(), rtt);
+	const std::string origin = "https://127.0.0.1:" + std::to_string(proxy.port());
+	const std::string url = origin + "/rtc/v1/publish/";
+
+	std::unique_ptr<HttpManager> manager;
+	HttpObjectHandle obj = kInvalidHttpObjectHandle;
+	auto start_manager = [&]() {
+		manager.reset(new HttpManager());
+		manager->Start();
+		obj = manager->AddObject();
+	};
+	auto stop_manager = [&]() {
+		manager->RemoveObject(obj);
+		manager->Stop();
+		manager.reset();
+	};
+
+	bool reused = false;
+	int reused_count = 0;
+	if (mode == kPooled) {
+		start_manager();
+		TimedPost(manager.get(), url, obj, &reused);
+	}
+
+	for (auto _ : state) {
+		if (mode != kPooled) {
+			start_manager();
+		}
+		if (mode == kPrewarmed) {
+			int requests = server.requests();
+			manager->Prewarm(origin);
+			while (server.requests() == requests) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			// HEAD的应答回到客户端，连接放回连接池
+			std::this_thread::sleep_for(rtt / 2 + std::chrono::milliseconds(5));
+		}
+
+		state.SetIterationTime(TimedPost(manager.get(), url, obj, &reused));
+		reused_count += reused ? 1 : 0;
+
+		if (mode != kPooled) {
+			stop_manager();
+		}
+	}
+
+	if (mode == kPooled) {
+		stop_manager();
+	}
+	state.counters["reused"] = benchmark::Counter(reused_count, benchmark::Counter::kAvgIterations);
+	state.counters["connections"] = server.connections();
+}
+
+BENCHMARK(BM_SignalingSetup)
+	->ArgNames({ "mode", "rtt_ms" })
+	->ArgsProduct({ { kCold, kPrewarmed, kPooled }, { 0, 40 } })
+	->Iterations(20)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,143 @@
+#ifndef KRTCSDK_TESTS_LINUX_SIGNALING_STAND_IN_H_
+#define KRTCSDK_TESTS_LINUX_SIGNALING_STAND_IN_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "local_http_server.h"
+
+namespace krtc {
+namespace test {
+
+// 本地信令服务，同时提供SRS的JSON接口和WHIP/WHEP：
+//   POST   /rtc/v1/publish/ /rtc/v1/play/  应答{"code":0,"sdp":answer}
+//   POST   /whip/endpoint                   201，Location: resource/<n>，body为answer
+//   PATCH  /whip/resource/<n>               trickle返回204，ICE restart(If-Match: *)返回200和新凭据的sdpfrag，
+//                                           set_trickle_supported(false)时返回405
+//   DELETE /whip/resource/<n>               200
+// 只回固定的answer，不建立媒体，用于信令流程和建连耗时测试。
+class SignalingStandIn {
+public:
+	static constexpr const char* kAnswer =
+		"v=0\r\n"
+		"o=- 1 2 IN IP4 127.0.0.1\r\n"
+		"s=-\r\n"
+		"t=0 0\r\n"
+		"a=group:BUNDLE 0\r\n"
+		"m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
+		"c=IN IP4 0.0.0.0\r\n"
+		"a=ice-ufrag:srv1\r\n"
+		"a=ice-pwd:standinstandinstandin01\r\n"
+		"a=mid:0\r\n"
+		"a=candidate:1 1 udp 2130706431 127.0.0.1 8000 typ host\r\n"
+		"a=end-of-candidates\r\n";
+
+	explicit SignalingStandIn(bool use_tls = false)
+		: server_([this](const LocalHttpRequest& request) { return Handle(request); }, use_tls)
+	{
+	}
+
+	int port() const { return server_.port(); }
+	std::string origin() const { return server_.origin(); }
+	int connections() { return server_.connections(); }
+
+	void set_trickle_supported(bool supported)
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		trickle_supported_ = supported;
+	}
+
+	std::vector<LocalHttpRequest> requests()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return requests_;
+	}
+
+	// 还没有DELETE的WHIP会话数
+	int live_sessions()
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		return live_sessions_;
+	}
+
+private:
+	LocalHttpResponse Handle(const LocalHttpRequest& request)
+	{
+		std::lock_guard<std::mutex> locker(mutex_);
+		requests_.push_back(request);
+
+		LocalHttpResponse response;
+		if (request.method == "POST" && request.path.find("/rtc/v1/") == 0) {
+			response.headers.push_back("Content-Type: application/json");
+			response.body = "{\"code\":0,\"server\":\"stand-in\",\"sdp\":\"" + JsonEscape(kAnswer) + "\"}";
+		}
+		else if (request.method == "POST" && request.path == "/whip/endpoint") {
+			live_sessions_++;
+			response.status = 201;
+			response.headers.push_back("Content-Type: application/sdp");
+			response.headers.push_back("Location: resource/" + std::to_string(++next_session_));
+			response.body = kAnswer;
+		}
+		else if (request.method == "PATCH" && request.path.find("/whip/resource/") == 0) {
+			auto iter = request.headers.find("if-match");
+			if (!trickle_supported_) {
+				response.status = 405;
+			}
+			else if (iter != request.headers.end() && iter->second == "*") {
+				response.status = 200;
+				response.headers.push_back("Content-Type: application/trickle-ice-sdpfrag");
+				response.body =
+					"a=ice-ufrag:srv2\r\n"
+					"a=ice-pwd:standinstandinstandin02\r\n"
+					"m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
+					"a=mid:0\r\n"
+					"a=candidate:2 1 udp 2130706431 127.0.0.1 8002 typ host\r\n";
+			}
+			else {
+				response.status = 204;
+			}
+		}
+		else if (request.method == "DELETE" && request.path.find("/whip/resource/") == 0) {
+			live_sessions_--;
+		}
+		else {
+			response.status = 404;
+		}
+		return response;
+	}
+
+	static std::string JsonEscape(const std::string& value)
+	{
+		std::string out;
+		for (char c : value) {
+			if (c == '\r') {
+				out += "\\r";
+			}
+			else if (c == '\n') {
+				out += "\\n";
+			}
+			else if (c == '"' || c == '\\') {
+				out += '\\';
+				out += c;
+			}
+			else {
+				out += c;
+			}
+		}
+		return out;
+	}
+
+	std::mutex mutex_;
+	std::vector<LocalHttpRequest> requests_;
+	bool trickle_supported_ = true;
+	int next_session_ = 0;
+	int live_sessions_ = 0;
+	// 放在最后：析构时先停服务线程，再释放上面的状态
+	LocalHttpServer server_;
+};
+
+}  // namespace test
+}  // namespace krtc
+
+#endif  // KRTCSDK_TESTS_LINUX_SIGNALING_STAND_IN_H_
@@ -0,0 +1,185 @@
+#ifndef KRTCSDK_TESTS_LINUX_TCP_DELAY_PROXY_H_
+#define KRTCSDK_TESTS_LINUX_TCP_DELAY_PROXY_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace krtc {
+namespace test {
+
+// 本地TCP转发，两个方向各加rtt/2的单向时延，模拟到信令服务器的往返时间。
+// 沙箱里没有netem，用它代替tc的时延整形。
+class TcpDelayProxy {
+public:
+	TcpDelayProxy(int upstream_port, std::chrono::milliseconds rtt)
+		: upstream_port_(upstream_port), one_way_(rtt / 2)
+	{
+		listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+		int reuse = 1;
+		setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		bind(listen_fd_, (sockaddr*)&addr, sizeof(addr));
+		listen(listen_fd_, 128);
+		socklen_t len = sizeof(addr);
+		getsockname(listen_fd_, (sockaddr*)&addr, &len);
+		port_ = ntohs(addr.sin_port);
+
+		accept_thread_ = std::thread([this]() {
+			for (;;) {
+				int client_fd = accept(listen_fd_, nullptr, nullptr);
+				if (client_fd < 0) {
+					return;
+				}
+				int nodelay = 1;
+				setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+				int server_fd = ConnectUpstream();
+				if (server_fd < 0) {
+					close(client_fd);
+					continue;
+				}
+				std::lock_guard<std::mutex> locker(mutex_);
+				fds_.push_back(client_fd);
+				fds_.push_back(server_fd);
+				pipes_.emplace_back(new Pipe(client_fd, server_fd, one_way_));
+				pipes_.emplace_back(new Pipe(server_fd, client_fd, one_way_));
+			}
+		});
+	}
+
+	~TcpDelayProxy()
+	{
+		shutdown(listen_fd_, SHUT_RDWR);
+		close(listen_fd_);
+		accept_thread_.join();
+		std::lock_guard<std::mutex> locker(mutex_);
+		for (int fd : fds_) {
+			shutdown(fd, SHUT_RDWR);
+		}
+		pipes_.clear();
+		for (int fd : fds_) {
+			close(fd);
+		}
+	}
+
+	int port() const { return port_; }
+
+private:
+	// 单向转发：读线程收数据打上到期时间，写线程到期后发出，时延不随排队累加
+	class Pipe {
+	public:
+		Pipe(int from_fd, int to_fd, std::chrono::milliseconds delay)
+			: from_fd_(from_fd), to_fd_(to_fd), delay_(delay)
+		{
+			reader_ = std::thread([this]() { ReadLoop(); });
+			writer_ = std::thread([this]() { WriteLoop(); });
+		}
+
+		~Pipe()
+		{
+			reader_.join();
+			writer_.join();
+		}
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		void ReadLoop()
+		{
+			char data[16 * 1024];
+			for (;;) {
+				ssize_t n = recv(from_fd_, data, sizeof(data), 0);
+				std::lock_guard<std::mutex> locker(mutex_);
+				if (n <= 0) {
+					closed_ = true;
+					cond_.notify_all();
+					return;
+				}
+				chunks_.push_back({ Clock::now() + delay_, std::string(data, n) });
+				cond_.notify_all();
+			}
+		}
+
+		void WriteLoop()
+		{
+			for (;;) {
+				std::unique_lock<std::mutex> locker(mutex_);
+				cond_.wait(locker, [this]() { return closed_ || !chunks_.empty(); });
+				if (chunks_.empty()) {
+					shutdown(to_fd_, SHUT_WR);
+					return;
+				}
+				Clock::time_point due = chunks_.front().due;
+				std::string data = std::move(chunks_.front().data);
+				chunks_.pop_front();
+				locker.unlock();
+
+				std::this_thread::sleep_until(due);
+				if (send(to_fd_, data.data(), data.size(), MSG_NOSIGNAL) < 0) {
+					return;
+				}
+			}
+		}
+
+		struct Chunk {
+			Clock::time_point due;
+			std::string data;
+		};
+
+		int from_fd_;
+		int to_fd_;
+		std::chrono::milliseconds delay_;
+		std::mutex mutex_;
+		std::condition_variable cond_;
+		std::deque<Chunk> chunks_;
+		bool closed_ = false;
+		std::thread reader_;
+		std::thread writer_;
+	};
+
+	int ConnectUpstream()
+	{
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		int nodelay = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = htons(upstream_port_);
+		// TCP握手也要算一个往返
+		std::this_thread::sleep_for(one_way_ * 2);
+		if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	int upstream_port_;
+	std::chrono::milliseconds one_way_;
+	int listen_fd_ = -1;
+	int port_ = 0;
+	std::thread accept_thread_;
+	std::mutex mutex_;
+	std::vector<int> fds_;
+	std::vector<std::unique_ptr<Pipe>> pipes_;
+};
+
+}  // namespace test
+}  // namespace krtc
+
+#endif  // KRTCSDK_TESTS_LINUX_TCP_DELAY_PROXY_H_
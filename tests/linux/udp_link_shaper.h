@@ -0,0 +1,283 @@
+#ifndef KRTCSDK_TESTS_LINUX_UDP_LINK_SHAPER_H_
+#define KRTCSDK_TESTS_LINUX_UDP_LINK_SHAPER_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace krtc {
+namespace test {
+
+// 单向链路参数，kbps为0时不限速
+struct LinkProfile {
+	int kbps = 0;
+	std::chrono::milliseconds delay{ 0 };
+	double loss = 0.0;
+	// 瓶颈队列最多排这么久，超过后尾部丢包
+	std::chrono::milliseconds queue{ 200 };
+};
+
+// 用户态UDP中继，把两个PeerConnection之间的媒体流量绕过它做带宽/时延/丢包整形。
+// 沙箱里没有netem，用它代替tc：
+//   A的候选改写成 A的IP:b_side_port() 交给B，B的候选改写成 B的IP:a_side_port() 交给A，
+//   A发到a_side的包从b_side转给B，B发到b_side的包从a_side转给A。
+// 只转发每边第一个UDP IPv4 host候选，其余候选丢弃。
+class UdpLinkShaper {
+public:
+	UdpLinkShaper(const LinkProfile& a_to_b, const LinkProfile& b_to_a)
+		: a_to_b_(a_to_b), b_to_a_(b_to_a)
+	{
+		a_side_fd_ = BindAny(&a_side_port_);
+		b_side_fd_ = BindAny(&b_side_port_);
+		a_to_b_.thread = std::thread([this]() { DeliverLoop(&a_to_b_, b_side_fd_, &b_addr_); });
+		b_to_a_.thread = std::thread([this]() { DeliverLoop(&b_to_a_, a_side_fd_, &a_addr_); });
+		recv_thread_ = std::thread([this]() { RecvLoop(); });
+	}
+
+	~UdpLinkShaper()
+	{
+		stopped_ = true;
+		recv_thread_.join();
+		for (Direction* direction : { &a_to_b_, &b_to_a_ }) {
+			{
+				std::lock_guard<std::mutex> locker(direction->mutex);
+				direction->cond.notify_all();
+			}
+			direction->thread.join();
+		}
+		close(a_side_fd_);
+		close(b_side_fd_);
+	}
+
+	int a_side_port() const { return a_side_port_; }
+	int b_side_port() const { return b_side_port_; }
+
+	// 改写A的候选交给B，不转发的候选返回空串
+	std::string RewriteCandidateOfA(const std::string& candidate)
+	{
+		return Rewrite(candidate, &a_addr_, b_side_port_);
+	}
+
+	// 改写B的候选交给A
+	std::string RewriteCandidateOfB(const std::string& candidate)
+	{
+		return Rewrite(candidate, &b_addr_, a_side_port_);
+	}
+
+	// 瓶颈队列丢掉的和随机丢掉的包数
+	int dropped_a_to_b() const { return a_to_b_.dropped; }
+
+	// 打开后两个方向的包全部丢弃，模拟断网
+	void SetBlackhole(bool blackhole) { blackhole_ = blackhole; }
+
+	// 一端重新协商换了新的PeerConnection，之后的候选重新改写，地址以新候选和新收到的包为准
+	void ResetEndpoints()
+	{
+		for (Endpoint* endpoint : { &a_addr_, &b_addr_ }) {
+			std::lock_guard<std::mutex> locker(endpoint->mutex);
+			endpoint->has_candidate = false;
+			endpoint->known = false;
+		}
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Packet {
+		Clock::time_point due;
+		std::string data;
+	};
+
+	struct Direction {
+		explicit Direction(const LinkProfile& profile) : profile(profile) {}
+
+		LinkProfile profile;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::deque<Packet> packets;
+		// 瓶颈链路发完已排队数据的时间
+		Clock::time_point link_free;
+		std::atomic<int> dropped{ 0 };
+		std::thread thread;
+	};
+
+	struct Endpoint {
+		std::mutex mutex;
+		bool has_candidate = false;
+		bool known = false;
+		sockaddr_in addr = {};
+	};
+
+	static int BindAny(int* port)
+	{
+		int fd = socket(AF_INET, SOCK_DGRAM, 0);
+		int buffer = 4 * 1024 * 1024;
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+		setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_ANY);
+		addr.sin_port = 0;
+		bind(fd, (sockaddr*)&addr, sizeof(addr));
+		socklen_t len = sizeof(addr);
+		getsockname(fd, (sockaddr*)&addr, &len);
+		*port = ntohs(addr.sin_port);
+		return fd;
+	}
+
+	// candidate:<foundation> <component> <protocol> <priority> <ip> <port> typ <type> ...
+	static std::string Rewrite(const std::string& candidate, Endpoint* endpoint, int port)
+	{
+		std::istringstream in(candidate);
+		std::vector<std::string> fields;
+		std::string field;
+		while (in >> field) {
+			fields.push_back(field);
+		}
+		if (fields.size() < 8 || fields[2] != "udp" || fields[7] != "host") {
+			return "";
+		}
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		if (inet_pton(AF_INET, fields[4].c_str(), &addr.sin_addr) != 1) {
+			return "";
+		}
+		addr.sin_port = htons(static_cast<uint16_t>(std::stoi(fields[5])));
+		{
+			std::lock_guard<std::mutex> locker(endpoint->mutex);
+			if (endpoint->has_candidate) {
+				return "";
+			}
+			endpoint->has_candidate = true;
+			if (!endpoint->known) {
+				endpoint->known = true;
+				endpoint->addr = addr;
+			}
+		}
+
+		fields[5] = std::to_string(port);
+		std::string out;
+		for (auto& item : fields) {
+			out += (out.empty() ? "" : " ") + item;
+		}
+		return out;
+	}
+
+	void RecvLoop()
+	{
+		pollfd fds[2] = { { a_side_fd_, POLLIN, 0 }, { b_side_fd_, POLLIN, 0 } };
+		char data[65536];
+		while (!stopped_) {
+			if (poll(fds, 2, 50) <= 0) {
+				continue;
+			}
+			for (int i = 0; i < 2; i++) {
+				if (!(fds[i].revents & POLLIN)) {
+					continue;
+				}
+				sockaddr_in from = {};
+				socklen_t len = sizeof(from);
+				ssize_t n = recvfrom(fds[i].fd, data, sizeof(data), 0, (sockaddr*)&from, &len);
+				if (n <= 0) {
+					continue;
+				}
+				// 以实际的源地址为准，回包发到这里
+				Endpoint* sender = (i == 0) ? &a_addr_ : &b_addr_;
+				{
+					std::lock_guard<std::mutex> locker(sender->mutex);
+					sender->known = true;
+					sender->addr = from;
+				}
+				Enqueue(i == 0 ? &a_to_b_ : &b_to_a_, std::string(data, n));
+			}
+		}
+	}
+
+	void Enqueue(Direction* direction, std::string data)
+	{
+		const LinkProfile& profile = direction->profile;
+		if (blackhole_) {
+			direction->dropped++;
+			return;
+		}
+		if (profile.loss > 0 && std::uniform_real_distribution<double>(0, 1)(random_) < profile.loss) {
+			direction->dropped++;
+			return;
+		}
+
+		Clock::time_point now = Clock::now();
+		std::lock_guard<std::mutex> locker(direction->mutex);
+		Clock::time_point sent = now;
+		if (profile.kbps > 0) {
+			// 瓶颈链路串行发送，包在队列里等前面的发完
+			Clock::time_point start = std::max(now, direction->link_free);
+			if (start - now > profile.queue) {
+				direction->dropped++;
+				return;
+			}
+			auto transmit = std::chrono::microseconds(data.size() * 8 * 1000 / profile.kbps);
+			direction->link_free = start + transmit;
+			sent = direction->link_free;
+		}
+		direction->packets.push_back({ sent + profile.delay, std::move(data) });
+		direction->cond.notify_all();
+	}
+
+	void DeliverLoop(Direction* direction, int fd, Endpoint* to)
+	{
+		for (;;) {
+			std::unique_lock<std::mutex> locker(direction->mutex);
+			direction->cond.wait(locker, [&]() { return stopped_ || !direction->packets.empty(); });
+			if (stopped_) {
+				return;
+			}
+			// 同一方向时延固定，到期时间是单调的
+			Packet packet = std::move(direction->packets.front());
+			direction->packets.pop_front();
+			locker.unlock();
+
+			std::this_thread::sleep_until(packet.due);
+			sockaddr_in addr;
+			{
+				std::lock_guard<std::mutex> endpoint_locker(to->mutex);
+				if (!to->known) {
+					continue;
+				}
+				addr = to->addr;
+			}
+			sendto(fd, packet.data.data(), packet.data.size(), 0, (sockaddr*)&addr, sizeof(addr));
+		}
+	}
+
+	Direction a_to_b_;
+	Direction b_to_a_;
+	Endpoint a_addr_;
+	Endpoint b_addr_;
+	int a_side_fd_ = -1;
+	int b_side_fd_ = -1;
+	int a_side_port_ = 0;
+	int b_side_port_ = 0;
+	std::mt19937 random_{ 1 };
+	std::atomic<bool> blackhole_{ false };
+	std::atomic<bool> stopped_{ false };
+	std::thread recv_thread_;
+};
+
+}  // namespace test
+}  // namespace krtc
+
+#endif  // KRTCSDK_TESTS_LINUX_UDP_LINK_SHAPER_H_
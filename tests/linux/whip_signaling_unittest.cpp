@@ -0,0 +1,184 @@
+#include "krtc/media/whip_signaling.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <api/jsep.h>
+#include <gtest/gtest.h>
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/media/signaling.h"
+#include "signaling_stand_in.h"
+
+namespace krtc {
+namespace {
+
+const char kOffer[] =
+	"v=0\r\n"
+	"o=- 1 2 IN IP4 127.0.0.1\r\n"
+	"s=-\r\n"
+	"t=0 0\r\n"
+	"a=group:BUNDLE 0\r\n"
+	"m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
+	"c=IN IP4 0.0.0.0\r\n"
+	"a=ice-ufrag:cli1\r\n"
+	"a=ice-pwd:clientclientclientcli01\r\n"
+	"a=mid:0\r\n";
+const char kCandidate[] = "candidate:1 1 udp 2130706431 192.168.1.2 50000 typ host";
+
+// WhipSignaling只在api线程上使用，测试里的调用都切到api线程
+class WhipSignalingTest : public testing::Test {
+protected:
+	void SetUp() override
+	{
+		owner_ = KRTCGlobal::Instance()->http_manager()->AddObject();
+		signaling_ = std::make_unique<WhipSignaling>(stand_in_.origin() + "/whip/endpoint", owner_);
+	}
+
+	void TearDown() override
+	{
+		// 先让句柄失效，已经在路上的应答就不会再回调到销毁的对象
+		OnApiThread([this]() {
+			KRTCGlobal::Instance()->http_manager()->RemoveObject(owner_);
+			signaling_.reset();
+		});
+	}
+
+	void OnApiThread(std::function<void()> task)
+	{
+		KRTCGlobal::Instance()->api_thread()->BlockingCall(task);
+	}
+
+	std::string SendOffer()
+	{
+		std::promise<std::string> answer;
+		OnApiThread([&]() {
+			signaling_->SendOffer(kOffer, [&](KRTCError err, const std::string& sdp) {
+				answer.set_value(err == KRTCError::kNoErr ? sdp : "");
+			});
+		});
+		return answer.get_future().get();
+	}
+
+	void SendCandidateAndComplete()
+	{
+		OnApiThread([this]() {
+			std::unique_ptr<webrtc::IceCandidateInterface> candidate(
+				webrtc::CreateIceCandidate("0", 0, kCandidate, nullptr));
+			signaling_->SendCandidate(candidate.get());
+			signaling_->OnGatheringComplete();
+		});
+	}
+
+	// 等服务端收到method请求的个数达到count
+	std::vector<test::LocalHttpRequest> WaitForRequests(const std::string& method, size_t count)
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		std::vector<test::LocalHttpRequest> matched;
+		while (std::chrono::steady_clock::now() < deadline) {
+			matched.clear();
+			for (auto& request : stand_in_.requests()) {
+				if (request.method == method) {
+					matched.push_back(request);
+				}
+			}
+			if (matched.size() >= count) {
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		return matched;
+	}
+
+	test::SignalingStandIn stand_in_;
+	HttpObjectHandle owner_ = kInvalidHttpObjectHandle;
+	std::unique_ptr<WhipSignaling> signaling_;
+};
+
+TEST_F(WhipSignalingTest, OfferTrickleAndTeardown)
+{
+	EXPECT_EQ(test::SignalingStandIn::kAnswer, SendOffer());
+
+	auto posts = WaitForRequests("POST", 1);
+	ASSERT_EQ(1u, posts.size());
+	EXPECT_EQ("/whip/endpoint", posts[0].path);
+	EXPECT_EQ("application/sdp", posts[0].headers["content-type"]);
+	EXPECT_EQ(kOffer, posts[0].body);
+
+	// 候选先PATCH出去，收集完成时第一个PATCH还没应答，end-of-candidates跟在后面再PATCH一次，
+	// 都发到Location给出的资源地址
+	SendCandidateAndComplete();
+	auto patches = WaitForRequests("PATCH", 2);
+	ASSERT_EQ(2u, patches.size());
+	EXPECT_EQ(patches[0].path, patches[1].path);
+	EXPECT_EQ("/whip/resource/1", patches[0].path);
+	EXPECT_EQ("application/trickle-ice-sdpfrag", patches[0].headers["content-type"]);
+	std::string fragment;
+	for (auto& patch : patches) {
+		fragment += patch.body;
+	}
+	EXPECT_NE(std::string::npos, fragment.find("a=ice-ufrag:cli1\r\n"));
+	EXPECT_NE(std::string::npos, fragment.find("a=mid:0\r\n"));
+	EXPECT_NE(std::string::npos, fragment.find(std::string("a=") + kCandidate));
+	EXPECT_NE(std::string::npos, fragment.find("a=end-of-candidates\r\n"));
+
+	OnApiThread([this]() { signaling_->Stop(); });
+	auto deletes = WaitForRequests("DELETE", 1);
+	ASSERT_EQ(1u, deletes.size());
+	EXPECT_EQ("/whip/resource/1", deletes[0].path);
+	EXPECT_EQ(0, stand_in_.live_sessions());
+}
+
+TEST_F(WhipSignalingTest, StopsTricklingWhenServerRejectsPatch)
+{
+	stand_in_.set_trickle_supported(false);
+	EXPECT_FALSE(SendOffer().empty());
+
+	SendCandidateAndComplete();
+	WaitForRequests("PATCH", 1);
+	OnApiThread([this]() {
+		std::unique_ptr<webrtc::IceCandidateInterface> candidate(
+			webrtc::CreateIceCandidate("0", 0, kCandidate, nullptr));
+		signaling_->SendCandidate(candidate.get());
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	EXPECT_EQ(1u, WaitForRequests("PATCH", 1).size());
+}
+
+TEST_F(WhipSignalingTest, IceRestartPatchesTheExistingSession)
+{
+	EXPECT_FALSE(SendOffer().empty());
+
+	std::string restart_offer = kOffer;
+	restart_offer.replace(restart_offer.find("cli1"), 4, "cli2");
+	std::promise<std::string> answer;
+	OnApiThread([&]() {
+		signaling_->RestartIce(restart_offer, [&](KRTCError err, const std::string& sdp) {
+			answer.set_value(err == KRTCError::kNoErr ? sdp : "");
+		});
+	});
+	std::string merged = answer.get_future().get();
+
+	// 同一个会话上换凭据，不新建会话
+	EXPECT_NE(std::string::npos, merged.find("a=ice-ufrag:srv2\r\n"));
+	EXPECT_NE(std::string::npos, merged.find("127.0.0.1 8002"));
+	EXPECT_EQ(std::string::npos, merged.find("127.0.0.1 8000"));
+	EXPECT_EQ(1u, WaitForRequests("POST", 1).size());
+	EXPECT_EQ(1, stand_in_.live_sessions());
+}
+
+// SRS的/rtc/v1接口没有结束会话的请求，重连时不能走ICE restart
+TEST(SignalingTest, OnlyWhipSupportsIceRestart)
+{
+	auto srs = Signaling::Create(SIGNALING_PROTOCOL::SRS, CONTROL_TYPE::PUSH,
+		"https://127.0.0.1:1990", "livestream", kInvalidHttpObjectHandle);
+	auto whip = Signaling::Create(SIGNALING_PROTOCOL::WHIP, CONTROL_TYPE::PUSH,
+		"https://127.0.0.1:1990/whip/endpoint", "", kInvalidHttpObjectHandle);
+	EXPECT_FALSE(srs->SupportsIceRestart());
+	EXPECT_TRUE(whip->SupportsIceRestart());
+}
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,84 @@
+// 摄像头MJPEG解码吞吐：用录制的MJPEG码流(录制方法见mjpeg_dump.h)循环送给MjpegDecoder，
+// 解码线程都忙时等一会再送，不丢帧，测满负荷下每帧的间隔。
+// decode_us为单帧解码耗时(墙上时间)，线程数超过空闲核数时包含等CPU的时间，这时吞吐不再提升。
+//   KRTC_MJPEG_DUMP=camera_4k.mjpeg krtc_benchmarks --benchmark_filter=MjpegDecode
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "krtc/device/mjpeg_decoder.h"
+#include "tests/mjpeg_dump.h"
+
+namespace krtc {
+namespace {
+
+void BM_MjpegDecode(benchmark::State& state)
+{
+	const int threads = static_cast<int>(state.range(0));
+	const bool nv12 = state.range(1) != 0;
+
+	const char* path = getenv("KRTC_MJPEG_DUMP");
+	if (!path) {
+		state.SkipWithError("KRTC_MJPEG_DUMP not set");
+		return;
+	}
+	std::vector<std::vector<uint8_t>> frames = test::LoadMjpegDump(path);
+	if (frames.empty()) {
+		state.SkipWithError("no mjpeg frame in dump");
+		return;
+	}
+
+	std::atomic<int64_t> delivered{ 0 };
+	std::atomic<int64_t> failed{ 0 };
+	std::atomic<int64_t> decode_us_total{ 0 };
+	std::atomic<int> width{ 0 };
+	std::atomic<int> height{ 0 };
+	MjpegDecoder decoder(nv12, threads,
+		[&](rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer, int64_t, int64_t decode_us) {
+			if (buffer) {
+				width = buffer->width();
+				height = buffer->height();
+				decode_us_total += decode_us;
+			}
+			else {
+				failed++;
+			}
+			delivered++;
+		});
+
+	int64_t submitted = 0;
+	for (auto _ : state) {
+		const std::vector<uint8_t>& frame = frames[submitted % frames.size()];
+		while (!decoder.Decode(frame.data(), frame.size(), submitted)) {
+			if (decoder.threads() <= 1) {
+				state.SkipWithError("decode failed");
+				return;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		submitted++;
+	}
+	while (delivered < submitted) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	state.SetItemsProcessed(submitted);
+	state.counters["width"] = width.load();
+	state.counters["height"] = height.load();
+	state.counters["failed"] = static_cast<double>(failed.load());
+	if (delivered > failed) {
+		state.counters["decode_us"] = static_cast<double>(decode_us_total.load()) / (delivered - failed);
+	}
+}
+
+BENCHMARK(BM_MjpegDecode)
+	->ArgNames({ "threads", "nv12" })
+	->ArgsProduct({ { 1, 2, 4 }, { 0, 1 } })
+	->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,152 @@
+#include "krtc/device/mjpeg_decoder.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tests/mjpeg_dump.h"
+
+namespace krtc {
+namespace {
+
+// 32x16的4:2:0 JPEG(libjpeg，quality 50，优化哈夫曼表)
+const uint8_t kTestJpeg[] = {
+	0xff, 0xd8, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x10, 0x0b, 0x0c, 0x0e, 0x0c,
+	0x0a, 0x10, 0x0e, 0x0d, 0x0e, 0x12, 0x11, 0x10, 0x13, 0x18, 0x28, 0x1a,
+	0x18, 0x16, 0x16, 0x18, 0x31, 0x23, 0x25, 0x1d, 0x28, 0x3a, 0x33, 0x3d,
+	0x3c, 0x39, 0x33, 0x38, 0x37, 0x40, 0x48, 0x5c, 0x4e, 0x40, 0x44, 0x57,
+	0x45, 0x37, 0x38, 0x50, 0x6d, 0x51, 0x57, 0x5f, 0x62, 0x67, 0x68, 0x67,
+	0x3e, 0x4d, 0x71, 0x79, 0x70, 0x64, 0x78, 0x5c, 0x65, 0x67, 0x63, 0xff,
+	0xdb, 0x00, 0x43, 0x01, 0x11, 0x12, 0x12, 0x18, 0x15, 0x18, 0x2f, 0x1a,
+	0x1a, 0x2f, 0x63, 0x42, 0x38, 0x42, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63,
+	0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0xff, 0xc0, 0x00, 0x11,
+	0x08, 0x00, 0x10, 0x00, 0x20, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01,
+	0x03, 0x11, 0x01, 0xff, 0xc4, 0x00, 0x16, 0x00, 0x01, 0x01, 0x01, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x04, 0x05, 0x06, 0xff, 0xc4, 0x00, 0x17, 0x10, 0x00, 0x03, 0x01, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x03, 0x04, 0x61, 0xff, 0xc4, 0x00, 0x16, 0x01, 0x01, 0x01, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x04, 0x03, 0x05, 0xff, 0xc4, 0x00, 0x17, 0x11, 0x01, 0x01, 0x01,
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x04, 0x00, 0x02, 0x61, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00,
+	0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xcd, 0xae, 0x1c, 0x12, 0xb8,
+	0x70, 0xb8, 0xb8, 0x70, 0x52, 0xe1, 0xc2, 0xfb, 0x5c, 0x13, 0xbb, 0xb4,
+	0x35, 0xc3, 0x82, 0x97, 0x0e, 0x17, 0x17, 0x0e, 0x09, 0x5c, 0x38, 0x13,
+	0x6b, 0xb7, 0x8e, 0xee, 0xdf, 0xff, 0xd9
+};
+const int kTestJpegWidth = 32;
+const int kTestJpegHeight = 16;
+
+std::vector<uint8_t> TestJpeg()
+{
+	return std::vector<uint8_t>(kTestJpeg, kTestJpeg + sizeof(kTestJpeg));
+}
+
+TEST(MjpegDecoderTest, DecodesIntoI420OrNv12)
+{
+	for (bool nv12 : { false, true }) {
+		rtc::scoped_refptr<webrtc::VideoFrameBuffer> decoded;
+		int64_t decoded_timestamp_us = -1;
+		MjpegDecoder decoder(nv12, 1,
+			[&](rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer, int64_t timestamp_us, int64_t decode_us) {
+				decoded = buffer;
+				decoded_timestamp_us = timestamp_us;
+				EXPECT_GE(decode_us, 0);
+			});
+
+		ASSERT_TRUE(decoder.Decode(kTestJpeg, sizeof(kTestJpeg), 1234));
+		ASSERT_TRUE(decoded);
+		EXPECT_EQ(nv12 ? webrtc::VideoFrameBuffer::Type::kNV12 : webrtc::VideoFrameBuffer::Type::kI420,
+			decoded->type());
+		EXPECT_EQ(kTestJpegWidth, decoded->width());
+		EXPECT_EQ(kTestJpegHeight, decoded->height());
+		EXPECT_EQ(1234, decoded_timestamp_us);
+	}
+}
+
+TEST(MjpegDecoderTest, SyncDecodeDropsInvalidFrame)
+{
+	int callbacks = 0;
+	MjpegDecoder decoder(false, 1,
+		[&callbacks](rtc::scoped_refptr<webrtc::VideoFrameBuffer>, int64_t, int64_t) { callbacks++; });
+
+	std::vector<uint8_t> truncated = TestJpeg();
+	truncated.resize(20);
+	EXPECT_FALSE(decoder.Decode(truncated.data(), truncated.size(), 0));
+	EXPECT_EQ(0, callbacks);
+}
+
+TEST(MjpegDecoderTest, ThreadedDecodeKeepsInputOrder)
+{
+	const int kFrames = 400;
+	// 每7帧一个坏帧，异步解码失败时按顺序回调nullptr
+	std::vector<uint8_t> broken = TestJpeg();
+	broken.resize(20);
+
+	std::mutex mutex;
+	std::vector<int64_t> timestamps;
+	std::vector<bool> decoded;
+	std::atomic<int> delivered{ 0 };
+	int accepted = 0;
+	std::vector<bool> expect_decoded;
+	{
+		MjpegDecoder decoder(false, 4,
+			[&](rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer, int64_t timestamp_us, int64_t) {
+				std::lock_guard<std::mutex> locker(mutex);
+				timestamps.push_back(timestamp_us);
+				decoded.push_back(buffer != nullptr);
+				delivered++;
+			});
+		ASSERT_EQ(4, decoder.threads());
+
+		for (int i = 0; i < kFrames; i++) {
+			const std::vector<uint8_t> frame = (i % 7 == 3) ? broken : TestJpeg();
+			// 解码线程都忙时返回false，这一帧不会回调
+			if (decoder.Decode(frame.data(), frame.size(), i)) {
+				accepted++;
+				expect_decoded.push_back(i % 7 != 3);
+			}
+			if (i % 16 == 0) {
+				std::this_thread::yield();
+			}
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (delivered < accepted && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	ASSERT_GT(accepted, 0);
+	ASSERT_EQ(static_cast<size_t>(accepted), timestamps.size());
+	for (size_t i = 1; i < timestamps.size(); i++) {
+		EXPECT_LT(timestamps[i - 1], timestamps[i]);
+	}
+	EXPECT_EQ(expect_decoded, decoded);
+}
+
+TEST(MjpegDumpTest, SplitsConcatenatedFrames)
+{
+	std::vector<uint8_t> stream = { 0x00, 0x12 };
+	for (int i = 0; i < 3; i++) {
+		stream.insert(stream.end(), kTestJpeg, kTestJpeg + sizeof(kTestJpeg));
+	}
+
+	std::vector<std::vector<uint8_t>> frames = test::SplitMjpegStream(stream);
+	ASSERT_EQ(3u, frames.size());
+	for (const auto& frame : frames) {
+		EXPECT_EQ(TestJpeg(), frame);
+	}
+	EXPECT_TRUE(test::SplitMjpegStream({}).empty());
+}
+
+}  // namespace
+}  // namespace krtc
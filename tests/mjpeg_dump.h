@@ -0,0 +1,54 @@
+#ifndef KRTCSDK_TESTS_MJPEG_DUMP_H_
+#define KRTCSDK_TESTS_MJPEG_DUMP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace krtc {
+namespace test {
+
+// 录制的摄像头MJPEG码流是一帧帧JPEG首尾相接，例如：
+//   ffmpeg -f v4l2 -input_format mjpeg -video_size 3840x2160 -i /dev/video0 \
+//          -c:v copy -frames:v 300 -f mjpeg camera_4k.mjpeg
+// 按SOI(FF D8)和后面紧跟下一个SOI或文件结尾的EOI(FF D9)切成帧，开头不是SOI的数据跳过
+inline std::vector<std::vector<uint8_t>> SplitMjpegStream(const std::vector<uint8_t>& stream)
+{
+	std::vector<std::vector<uint8_t>> frames;
+	const size_t size = stream.size();
+	size_t begin = 0;
+	while (begin + 1 < size && !(stream[begin] == 0xFF && stream[begin + 1] == 0xD8)) {
+		begin++;
+	}
+	for (size_t i = begin + 2; i + 1 < size; i++) {
+		if (stream[i] != 0xFF || stream[i + 1] != 0xD9) {
+			continue;
+		}
+		size_t end = i + 2;
+		if (end == size || (end + 1 < size && stream[end] == 0xFF && stream[end + 1] == 0xD8)) {
+			frames.emplace_back(stream.begin() + begin, stream.begin() + end);
+			begin = end;
+			i = begin + 1;
+		}
+	}
+	return frames;
+}
+
+inline std::vector<std::vector<uint8_t>> LoadMjpegDump(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return {};
+	}
+	std::vector<uint8_t> stream((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return SplitMjpegStream(stream);
+}
+
+}  // namespace test
+}  // namespace krtc
+
+#endif  // KRTCSDK_TESTS_MJPEG_DUMP_H_
@@ -0,0 +1,108 @@
+// 推流Opus编码的CPU开销：按KRTCAudioSendConfig设置ptime和complexity，由CreateTunedAudioEncoderFactory
+// 创建编码器(和推流用的是同一个工厂)，离线编码48kHz的合成语音，每次迭代编1秒音频。
+// realtime_x为编码速度相对实时的倍数，单核占用约为1/realtime_x；kbps为实际输出码率。
+//   krtc_benchmarks --benchmark_filter=OpusEncode
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "api/audio_codecs/audio_encoder.h"
+#include "api/audio_codecs/audio_format.h"
+#include "rtc_base/buffer.h"
+
+#include "krtc/base/krtc_global.h"
+#include "krtc/media/audio_send_config.h"
+
+namespace krtc {
+namespace {
+
+const int kSampleRate = 48000;
+const int kPayloadType = 111;
+const size_t kFramesPerIteration = 100;  // 1秒，10ms一帧
+
+// 基频缓慢变化的谐波加噪声，每隔一段静音，接近语音的频谱和起伏
+std::vector<int16_t> SynthesizeSpeech(size_t channels, size_t samples_per_channel)
+{
+	std::mt19937 random(7);
+	std::normal_distribution<float> noise(0.0f, 300.0f);
+	std::vector<int16_t> pcm(samples_per_channel * channels);
+	const float kPi = 3.14159265f;
+	float phase = 0.0f;
+	for (size_t i = 0; i < samples_per_channel; i++) {
+		float t = static_cast<float>(i) / kSampleRate;
+		float pitch = 140.0f + 40.0f * std::sin(2 * kPi * 0.7f * t);
+		phase += 2 * kPi * pitch / kSampleRate;
+		float voiced = 0.0f;
+		for (int harmonic = 1; harmonic <= 8; harmonic++) {
+			voiced += std::sin(phase * harmonic) / harmonic;
+		}
+		// 每秒里最后0.3秒是停顿
+		float envelope = std::fmod(t, 1.0f) < 0.7f ? 6000.0f : 0.0f;
+		float value = voiced * envelope + noise(random);
+		for (size_t ch = 0; ch < channels; ch++) {
+			pcm[i * channels + ch] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, value)));
+		}
+	}
+	return pcm;
+}
+
+void BM_OpusEncode(benchmark::State& state)
+{
+	KRTCAudioSendConfig config;
+	config.ptime_ms = static_cast<uint32_t>(state.range(0));
+	config.complexity = static_cast<int32_t>(state.range(1));
+	config.stereo = state.range(2) != 0;
+	KRTCGlobal::Instance()->SetAudioSendConfig(config);
+
+	// 和MungeOpusAnswer写进fmtp的参数一致
+	const size_t channels = config.stereo ? 2 : 1;
+	webrtc::SdpAudioFormat format("opus", kSampleRate, 2, {
+		{ "minptime", std::to_string(std::min<uint32_t>(config.ptime_ms, 10)) },
+		{ "ptime", std::to_string(config.ptime_ms) },
+		{ "stereo", config.stereo ? "1" : "0" },
+		{ "sprop-stereo", config.stereo ? "1" : "0" },
+		{ "useinbandfec", config.fec ? "1" : "0" },
+		{ "usedtx", config.dtx ? "1" : "0" },
+	});
+	std::unique_ptr<webrtc::AudioEncoder> encoder =
+		CreateTunedAudioEncoderFactory()->MakeAudioEncoder(kPayloadType, format, absl::nullopt);
+	if (!encoder || encoder->NumChannels() != channels) {
+		state.SkipWithError("create opus encoder failed");
+		return;
+	}
+
+	const size_t frame_samples = kSampleRate / 100;
+	std::vector<int16_t> pcm = SynthesizeSpeech(channels, frame_samples * kFramesPerIteration);
+	rtc::Buffer encoded;
+	uint32_t rtp_timestamp = 0;
+	int64_t encoded_bytes = 0;
+
+	for (auto _ : state) {
+		for (size_t frame = 0; frame < kFramesPerIteration; frame++) {
+			encoded.Clear();
+			encoder->Encode(rtp_timestamp,
+				rtc::ArrayView<const int16_t>(pcm.data() + frame * frame_samples * channels,
+					frame_samples * channels),
+				&encoded);
+			encoded_bytes += encoded.size();
+			rtp_timestamp += static_cast<uint32_t>(frame_samples);
+		}
+	}
+
+	state.counters["realtime_x"] = benchmark::Counter(1.0, benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["kbps"] = static_cast<double>(encoded_bytes) * 8 / 1000 / state.iterations();
+}
+
+BENCHMARK(BM_OpusEncode)
+	->ArgNames({ "ptime", "complexity", "stereo" })
+	->ArgsProduct({ { 10, 20, 40, 60 }, { 0, 5, 10 }, { 0, 1 } })
+	->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,46 @@
+#ifndef KRTCSDK_TESTS_RENDER_BENCHMARK_UTIL_H_
+#define KRTCSDK_TESTS_RENDER_BENCHMARK_UTIL_H_
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "api/video/i420_buffer.h"
+
+#include "krtc/render/video_renderer.h"
+
+namespace krtc {
+namespace test {
+
+// 渲染benchmark共用的测试帧：亮度是斜向渐变，phase不同内容不同
+inline rtc::scoped_refptr<webrtc::I420Buffer> CreateGradientFrame(int width, int height, int phase)
+{
+	rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(width, height);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			buffer->MutableDataY()[y * buffer->StrideY() + x] = static_cast<uint8_t>(16 + (x + y + phase) % 220);
+		}
+	}
+	memset(buffer->MutableDataU(), 100, buffer->StrideU() * buffer->ChromaHeight());
+	memset(buffer->MutableDataV(), 160, buffer->StrideV() * buffer->ChromaHeight());
+	return buffer;
+}
+
+// 等平台渲染器画完第frames帧，超时返回false。
+// 渲染在另一个线程上，单核机器上忙等会抢它的时间，这里短暂sleep
+inline bool WaitRendered(const VideoRenderer& renderer, uint64_t frames, std::chrono::milliseconds timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (renderer.render_stats().frames < frames) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+	return true;
+}
+
+}  // namespace test
+}  // namespace krtc
+
+#endif  // KRTCSDK_TESTS_RENDER_BENCHMARK_UTIL_H_
@@ -0,0 +1,132 @@
+// 平台渲染器每帧在CPU上的工作，和linux/gl_render_benchmark.cpp、win/d3d_render_benchmark.cpp
+// 用同样的分辨率比较：
+//   CpuArgb: 原来D3dRenderer的做法，I420整帧转成ARGB放到中间缓冲，再按行拷贝到表面
+//   CpuArgbDirect: 不支持YV12表面时的回退，只转换变化的区域，直接写到表面
+//   Yv12Copy: YV12表面，只拷贝变化区域的Y/U/V平面，颜色转换交给GPU
+// dirty=1时每帧只更新1/16的区域。
+//   krtc_benchmarks --benchmark_filter=Render
+
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "api/video/i420_buffer.h"
+#include "libyuv/convert_argb.h"
+
+#include "krtc/render/yuv_upload.h"
+#include "tests/render_benchmark_util.h"
+
+namespace krtc {
+namespace {
+
+// D3D表面的行宽按64字节对齐
+const int kSurfacePitchAlign = 64;
+
+int SurfacePitch(int row_bytes)
+{
+	return (row_bytes + kSurfacePitchAlign - 1) / kSurfacePitchAlign * kSurfacePitchAlign;
+}
+
+YuvUploadRegion DirtyRegion(int width, int height, bool dirty_only)
+{
+	webrtc::VideoFrame::UpdateRect rect = { 0, 0, width, height };
+	if (dirty_only) {
+		rect = { width / 4, height / 4, width / 4, height / 4 };
+	}
+	YuvUploadRegion region;
+	YuvUploadRegion::FromUpdateRect(rect, width, height, &region);
+	return region;
+}
+
+void BM_RenderCpuArgb(benchmark::State& state)
+{
+	const int height = static_cast<int>(state.range(0));
+	const int width = height * 16 / 9;
+	rtc::scoped_refptr<webrtc::I420Buffer> buffer = test::CreateGradientFrame(width, height, 0);
+
+	const int rgb_stride = width * 4;
+	const int surface_pitch = SurfacePitch(rgb_stride);
+	std::vector<uint8_t> rgb_buffer(static_cast<size_t>(rgb_stride) * height);
+	std::vector<uint8_t> surface(static_cast<size_t>(surface_pitch) * height);
+
+	for (auto _ : state) {
+		// 1. 整帧转换到中间缓冲
+		libyuv::I420ToARGB(buffer->DataY(), buffer->StrideY(),
+			buffer->DataU(), buffer->StrideU(),
+			buffer->DataV(), buffer->StrideV(),
+			rgb_buffer.data(), rgb_stride, width, height);
+		// 2. 按行拷贝到锁定的表面
+		const uint8_t* src = rgb_buffer.data();
+		uint8_t* dst = surface.data();
+		for (int i = 0; i < height; i++) {
+			memcpy(dst, src, rgb_stride);
+			dst += surface_pitch;
+			src += rgb_stride;
+		}
+		benchmark::DoNotOptimize(surface.data());
+		benchmark::ClobberMemory();
+	}
+}
+
+void BM_RenderCpuArgbDirect(benchmark::State& state)
+{
+	const int height = static_cast<int>(state.range(0));
+	const int width = height * 16 / 9;
+	rtc::scoped_refptr<webrtc::I420Buffer> buffer = test::CreateGradientFrame(width, height, 0);
+	const YuvUploadRegion region = DirtyRegion(width, height, state.range(1) != 0);
+
+	const int surface_pitch = SurfacePitch(width * 4);
+	std::vector<uint8_t> surface(static_cast<size_t>(surface_pitch) * height);
+
+	for (auto _ : state) {
+		libyuv::I420ToARGBMatrix(
+			buffer->DataY() + region.y * buffer->StrideY() + region.x, buffer->StrideY(),
+			buffer->DataU() + region.chroma_y * buffer->StrideU() + region.chroma_x, buffer->StrideU(),
+			buffer->DataV() + region.chroma_y * buffer->StrideV() + region.chroma_x, buffer->StrideV(),
+			surface.data() + region.y * surface_pitch + region.x * 4, surface_pitch,
+			&libyuv::kYuvI601Constants, region.width, region.height);
+		benchmark::DoNotOptimize(surface.data());
+		benchmark::ClobberMemory();
+	}
+}
+
+void BM_RenderYv12Copy(benchmark::State& state)
+{
+	const int height = static_cast<int>(state.range(0));
+	const int width = height * 16 / 9;
+	rtc::scoped_refptr<webrtc::I420Buffer> buffer = test::CreateGradientFrame(width, height, 0);
+	const YuvUploadRegion region = DirtyRegion(width, height, state.range(1) != 0);
+
+	// 和D3dRenderer::Upload一样，Y后面依次是V、U平面，色度行宽是一半
+	const int surface_pitch = SurfacePitch(width);
+	const int chroma_pitch = surface_pitch / 2;
+	std::vector<uint8_t> surface(static_cast<size_t>(surface_pitch) * height * 3 / 2);
+	uint8_t* dst_y = surface.data();
+	uint8_t* dst_v = dst_y + surface_pitch * height;
+	uint8_t* dst_u = dst_v + chroma_pitch * (height / 2);
+
+	for (auto _ : state) {
+		CopyI420Region(buffer.get(), region,
+			dst_y + region.y * surface_pitch + region.x, surface_pitch,
+			dst_u + region.chroma_y * chroma_pitch + region.chroma_x, chroma_pitch,
+			dst_v + region.chroma_y * chroma_pitch + region.chroma_x, chroma_pitch);
+		benchmark::DoNotOptimize(surface.data());
+		benchmark::ClobberMemory();
+	}
+}
+
+BENCHMARK(BM_RenderCpuArgb)
+	->ArgName("height")->Arg(720)->Arg(1080)
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RenderCpuArgbDirect)
+	->ArgNames({ "height", "dirty" })
+	->ArgsProduct({ { 720, 1080 }, { 0, 1 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RenderYv12Copy)
+	->ArgNames({ "height", "dirty" })
+	->ArgsProduct({ { 720, 1080 }, { 0, 1 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,99 @@
+// 这个目录的用例打开KRTC_CHECK_RT_ALLOCATION编译，全局operator new被替换，
+// ScopedNoAllocation范围内的堆分配会让进程崩溃
+#include "krtc/base/allocation_guard.h"
+
+#include <stdint.h>
+
+#include <new>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <modules/audio_device/include/audio_device_data_observer.h>
+
+#include "krtc/base/spsc_ring_buffer.h"
+#include "krtc/device/audio_capture_tap.h"
+#include "krtc/device/audio_device_data_observer.h"
+#include "krtc/device/audio_processing_profiler.h"
+
+#if !defined(KRTC_CHECK_RT_ALLOCATION)
+#error "rt_allocation tests must be built with KRTC_CHECK_RT_ALLOCATION"
+#endif
+
+namespace krtc {
+namespace {
+
+TEST(AllocationGuardDeathTest, AllocationInsideScopeAborts)
+{
+	EXPECT_DEATH({
+		ScopedNoAllocation no_allocation;
+		// 直接调用operator new，编译器不能把分配优化掉
+		void* ptr = ::operator new(16);
+		::operator delete(ptr);
+	}, "heap allocation of 16 bytes");
+}
+
+TEST(AllocationGuardTest, ScopesNestAndAllocationResumesAfterScope)
+{
+	{
+		ScopedNoAllocation outer;
+		{
+			ScopedNoAllocation inner;
+		}
+		EXPECT_TRUE(ScopedNoAllocation::IsActive());
+	}
+	EXPECT_FALSE(ScopedNoAllocation::IsActive());
+	std::vector<int> allowed(64);
+	EXPECT_EQ(64u, allowed.size());
+}
+
+TEST(AllocationGuardTest, RingBufferDoesNotAllocate)
+{
+	SpscRingBuffer<int16_t> ring(1024);
+	std::vector<int16_t> input(480, 1);
+	std::vector<int16_t> output(480);
+	size_t written = 0;
+	size_t read = 0;
+	{
+		ScopedNoAllocation no_allocation;
+		for (int i = 0; i < 100; i++) {
+			written += ring.Write(input.data(), input.size());
+			read += ring.Read(output.data(), output.size());
+		}
+	}
+	EXPECT_EQ(48000u, written);
+	EXPECT_EQ(48000u, read);
+}
+
+// ADM采集回调的完整路径：旁路缓冲区和APM profiler都只写环形缓冲区
+TEST(AllocationGuardTest, CaptureCallbackDoesNotAllocate)
+{
+	AudioCaptureTap tap;
+	// 不启动投递线程，数据留在缓冲区里由下面读出
+	tap.SetDelivery(false);
+	AudioProcessingProfiler profiler;
+	ADMDataObserver observer(&tap, &profiler);
+	webrtc::AudioDeviceDataObserver* adm_observer = &observer;
+
+	std::vector<int16_t> stereo(480 * 2, 100);
+	std::vector<int16_t> mono(480, 200);
+	// 先按单声道写，再切到双声道，最后写满缓冲区触发overrun
+	for (int i = 0; i < 10; i++) {
+		adm_observer->OnCaptureData(mono.data(), 480, sizeof(int16_t), 1, 48000);
+		adm_observer->OnRenderData(mono.data(), 480, sizeof(int16_t), 1, 48000);
+	}
+	for (int i = 0; i < 200; i++) {
+		adm_observer->OnCaptureData(stereo.data(), 480, 2 * sizeof(int16_t), 2, 48000);
+	}
+
+	KRTCCapturedAudioStats stats = tap.stats();
+	EXPECT_EQ(2u, stats.channels);
+	EXPECT_EQ(48000u, stats.sample_rate);
+	EXPECT_GT(stats.overrun_frames, 0u);
+
+	std::vector<int16_t> buffer(480 * 2);
+	ASSERT_EQ(480, tap.Read(buffer.data(), 480));
+	EXPECT_EQ(100, buffer[0]);
+}
+
+}  // namespace
+}  // namespace krtc
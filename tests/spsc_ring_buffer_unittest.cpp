@@ -0,0 +1,108 @@
+#include "krtc/base/spsc_ring_buffer.h"
+
+#include <stdint.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace krtc {
+namespace {
+
+TEST(SpscRingBufferTest, CapacityRoundsUpToPowerOfTwo)
+{
+	EXPECT_EQ(1u, SpscRingBuffer<int>(1).capacity());
+	EXPECT_EQ(8u, SpscRingBuffer<int>(5).capacity());
+	EXPECT_EQ(131072u, SpscRingBuffer<int16_t>(96000).capacity());
+}
+
+TEST(SpscRingBufferTest, WritesOnlyWhatFits)
+{
+	SpscRingBuffer<int> ring(4);
+	const int data[] = { 1, 2, 3, 4, 5, 6 };
+	EXPECT_EQ(4u, ring.Write(data, 6));
+	EXPECT_EQ(0u, ring.WritableSize());
+	EXPECT_EQ(0u, ring.Write(data, 1));
+
+	int out[6] = {};
+	EXPECT_EQ(4u, ring.Read(out, 6));
+	EXPECT_EQ(1, out[0]);
+	EXPECT_EQ(4, out[3]);
+	EXPECT_EQ(0u, ring.Read(out, 1));
+}
+
+TEST(SpscRingBufferTest, WrapsAround)
+{
+	SpscRingBuffer<int> ring(8);
+	int out[8] = {};
+	int next_write = 0;
+	int next_read = 0;
+	// 每次写5个读5个，读写位置不断跨过缓冲区末尾
+	for (int round = 0; round < 20; round++) {
+		int data[5];
+		for (int& value : data) {
+			value = next_write++;
+		}
+		ASSERT_EQ(5u, ring.Write(data, 5));
+		ASSERT_EQ(5u, ring.ReadableSize());
+		ASSERT_EQ(5u, ring.Read(out, 5));
+		for (int i = 0; i < 5; i++) {
+			ASSERT_EQ(next_read++, out[i]);
+		}
+	}
+}
+
+TEST(SpscRingBufferTest, DiscardDropsOldestData)
+{
+	SpscRingBuffer<int> ring(8);
+	const int data[] = { 1, 2, 3, 4, 5 };
+	ring.Write(data, 5);
+	EXPECT_EQ(3u, ring.Discard(3));
+	EXPECT_EQ(2u, ring.Discard(10));
+	EXPECT_EQ(0u, ring.ReadableSize());
+	EXPECT_EQ(8u, ring.WritableSize());
+}
+
+TEST(SpscRingBufferTest, ProducerAndConsumerThreadsKeepOrder)
+{
+	const int kTotal = 200000;
+	SpscRingBuffer<int> ring(1024);
+
+	std::thread producer([&ring]() {
+		int chunk[37];
+		int next = 0;
+		while (next < kTotal) {
+			int count = std::min<int>(37, kTotal - next);
+			for (int i = 0; i < count; i++) {
+				chunk[i] = next + i;
+			}
+			size_t written = ring.Write(chunk, count);
+			if (written == 0) {
+				std::this_thread::yield();
+			}
+			next += static_cast<int>(written);
+		}
+	});
+
+	std::vector<int> out(53);
+	int expected = 0;
+	bool in_order = true;
+	while (expected < kTotal) {
+		size_t read = ring.Read(out.data(), out.size());
+		if (read == 0) {
+			std::this_thread::yield();
+		}
+		for (size_t i = 0; i < read; i++) {
+			in_order = in_order && out[i] == expected;
+			expected++;
+		}
+	}
+	producer.join();
+
+	EXPECT_TRUE(in_order);
+	EXPECT_EQ(0u, ring.ReadableSize());
+}
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,90 @@
+// D3dRenderer每帧的耗时：OnFrame到worker_thread画完这一帧(Present之后)。
+// 渲染到一个不显示的窗口，显卡支持时走YV12表面，否则走CPU转换ARGB的回退，
+// 实际走的路径看日志里的"d3d9 render with yv12 surface"。upload_us为锁定表面写入数据的平均耗时，
+// 和render_cpu_benchmark.cpp里原来整帧转换ARGB的BM_RenderCpuArgb对照。
+//   krtc_benchmarks.exe --benchmark_filter=Render
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+#include "api/video/video_frame.h"
+
+#include "krtc/render/win/d3d_renderer.h"
+#include "tests/render_benchmark_util.h"
+
+namespace krtc {
+namespace {
+
+void BM_RenderD3d(benchmark::State& state)
+{
+	const int height = static_cast<int>(state.range(0));
+	const int width = height * 16 / 9;
+	const bool dirty_only = state.range(1) != 0;
+
+	// 窗口不显示，客户区和帧一样大，StretchRect不缩放
+	HWND hwnd = CreateWindowExW(0, L"STATIC", L"krtc_d3d_render_benchmark", WS_OVERLAPPEDWINDOW,
+		0, 0, width, height, NULL, NULL, GetModuleHandleW(NULL), NULL);
+	if (!hwnd) {
+		state.SkipWithError("create window failed");
+		return;
+	}
+	RECT client = { 0, 0, width, height };
+	AdjustWindowRect(&client, WS_OVERLAPPEDWINDOW, FALSE);
+	SetWindowPos(hwnd, NULL, 0, 0, client.right - client.left, client.bottom - client.top,
+		SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+
+	std::unique_ptr<VideoRenderer> renderer = D3dRenderer::Create(hwnd, width, height);
+
+	webrtc::VideoFrame::UpdateRect update_rect = { 0, 0, width, height };
+	if (dirty_only) {
+		update_rect = { width / 4, height / 4, width / 4, height / 4 };
+	}
+	webrtc::VideoFrame frames[2] = {
+		webrtc::VideoFrame::Builder()
+			.set_video_frame_buffer(test::CreateGradientFrame(width, height, 0))
+			.set_update_rect(update_rect)
+			.build(),
+		webrtc::VideoFrame::Builder()
+			.set_video_frame_buffer(test::CreateGradientFrame(width, height, 64))
+			.set_update_rect(update_rect)
+			.build(),
+	};
+
+	// 第一帧创建设备和表面，不计入
+	renderer->OnFrame(frames[1]);
+	if (!test::WaitRendered(*renderer, 1, std::chrono::seconds(5))) {
+		state.SkipWithError("d3d9 init failed");
+		renderer.reset();
+		DestroyWindow(hwnd);
+		return;
+	}
+	VideoRenderer::RenderStats begin = renderer->render_stats();
+
+	uint64_t rendered = begin.frames;
+	for (auto _ : state) {
+		renderer->OnFrame(frames[rendered & 1]);
+		rendered++;
+		if (!test::WaitRendered(*renderer, rendered, std::chrono::seconds(5))) {
+			state.SkipWithError("render timed out");
+			break;
+		}
+	}
+
+	VideoRenderer::RenderStats end = renderer->render_stats();
+	if (end.frames > begin.frames) {
+		state.counters["upload_us"] = benchmark::Counter(
+			static_cast<double>(end.upload_us_total - begin.upload_us_total) / (end.frames - begin.frames));
+	}
+
+	renderer.reset();
+	DestroyWindow(hwnd);
+}
+
+BENCHMARK(BM_RenderD3d)
+	->ArgNames({ "height", "dirty" })
+	->ArgsProduct({ { 720, 1080 }, { 0, 1 } })
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace krtc
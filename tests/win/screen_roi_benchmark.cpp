@@ -0,0 +1,136 @@
+// 屏幕共享ROI的码率收益：同一段合成的桌面序列(静止的文字窗口 + 一小块在打字的区域)
+// 分别关/开ROI送QSV编码，比较每帧输出字节数。需要Intel核显。
+//   krtc_benchmarks.exe --benchmark_filter=ScreenRoi
+
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "libyuv/convert_from.h"
+
+#include "krtc/codec/screen_roi_builder.h"
+#include "krtc/codec/encoder/intel_d3d_encoder.h"
+
+namespace krtc {
+namespace {
+
+const int kWidth = 1920;
+const int kHeight = 1080;
+const int kFrameRate = 30;
+const int kFrames = 300;
+// 打字区域，每帧多出一个字符
+const int kTypingX = 200;
+const int kTypingY = 600;
+const int kGlyphWidth = 10;
+const int kGlyphHeight = 18;
+const int kLineChars = 120;
+
+// 浅色背景上一行行深色“字”：每个字由几条竖线和横线组成，边缘密集
+void DrawGlyph(webrtc::I420Buffer* buffer, int x, int y, int seed)
+{
+	uint8_t* dst_y = buffer->MutableDataY();
+	int stride = buffer->StrideY();
+	for (int row = 0; row < kGlyphHeight - 4; ++row) {
+		for (int col = 0; col < kGlyphWidth - 2; ++col) {
+			bool stroke = ((col + seed) % 3 == 0) || ((row + seed) % 5 == 0);
+			if (stroke && x + col < kWidth && y + row < kHeight) {
+				dst_y[(y + row) * stride + x + col] = 30;
+			}
+		}
+	}
+}
+
+rtc::scoped_refptr<webrtc::I420Buffer> CreateDesktop()
+{
+	rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(kWidth, kHeight);
+	memset(buffer->MutableDataY(), 235, buffer->StrideY() * kHeight);
+	memset(buffer->MutableDataU(), 128, buffer->StrideU() * buffer->ChromaHeight());
+	memset(buffer->MutableDataV(), 128, buffer->StrideV() * buffer->ChromaHeight());
+	for (int y = 100; y + kGlyphHeight < 500; y += kGlyphHeight) {
+		for (int x = 100; x + kGlyphWidth < kWidth - 100; x += kGlyphWidth) {
+			DrawGlyph(buffer.get(), x, y, x * 7 + y);
+		}
+	}
+	return buffer;
+}
+
+void BM_QsvScreenRoi(benchmark::State& state)
+{
+	const bool use_roi = state.range(0) != 0;
+	if (!xop::IntelD3DEncoder::IsSupported()) {
+		state.SkipWithError("QSV not supported");
+		return;
+	}
+
+	int64_t total_bytes = 0;
+	int64_t total_frames = 0;
+	for (auto _ : state) {
+		xop::IntelD3DEncoder encoder;
+		encoder.SetOption(xop::VE_OPT_WIDTH, kWidth);
+		encoder.SetOption(xop::VE_OPT_HEIGHT, kHeight);
+		encoder.SetOption(xop::VE_OPT_FRAME_RATE, kFrameRate);
+		encoder.SetOption(xop::VE_OPT_GOP, kFrames * 10);
+		encoder.SetOption(xop::VE_OPT_CODEC, xop::VE_OPT_CODEC_H264);
+		encoder.SetOption(xop::VE_OPT_BITRATE_KBPS, 2500);
+		encoder.SetOption(xop::VE_OPT_TEXTURE_FORMAT, xop::VE_OPT_FORMAT_NV12);
+		encoder.SetOption(xop::VE_OPT_QP_MAP, use_roi ? 1 : 0);
+		if (!encoder.Init()) {
+			state.SkipWithError("QSV init failed");
+			return;
+		}
+
+		ScreenRoiBuilder roi_builder(true);
+		rtc::scoped_refptr<webrtc::I420Buffer> desktop = CreateDesktop();
+		std::vector<uint8_t> nv12(kWidth * kHeight * 3 / 2);
+		std::vector<uint8_t> out_frame;
+
+		for (int i = 0; i < kFrames; ++i) {
+			webrtc::VideoFrame::UpdateRect update_rect = { 0, 0, kWidth, kHeight };
+			if (i > 0) {
+				int x = kTypingX + (i % kLineChars) * kGlyphWidth;
+				int y = kTypingY + (i / kLineChars) * kGlyphHeight;
+				DrawGlyph(desktop.get(), x, y, i);
+				update_rect = { x, y, kGlyphWidth, kGlyphHeight };
+			}
+
+			webrtc::VideoFrame frame = webrtc::VideoFrame::Builder()
+				.set_video_frame_buffer(desktop)
+				.set_timestamp_us(i * 1000000LL / kFrameRate)
+				.set_update_rect(update_rect)
+				.build();
+			if (use_roi) {
+				encoder.SetRegionsOfInterest(roi_builder.Build(frame, *desktop, i == 0));
+			}
+
+			uint8_t* dst_uv = nv12.data() + kWidth * kHeight;
+			libyuv::I420ToNV12(desktop->DataY(), desktop->StrideY(),
+							   desktop->DataU(), desktop->StrideU(),
+							   desktop->DataV(), desktop->StrideV(),
+							   nv12.data(), kWidth, dst_uv, kWidth, kWidth, kHeight);
+			out_frame.clear();
+			if (encoder.Encode(nv12, out_frame) < 0) {
+				state.SkipWithError("QSV encode failed");
+				encoder.Destroy();
+				return;
+			}
+			total_bytes += out_frame.size();
+			total_frames++;
+		}
+		encoder.Destroy();
+	}
+
+	state.counters["bytes_per_frame"] = benchmark::Counter(
+		static_cast<double>(total_bytes) / total_frames);
+	state.counters["kbps"] = benchmark::Counter(
+		static_cast<double>(total_bytes) * 8 * kFrameRate / total_frames / 1000);
+}
+
+BENCHMARK(BM_QsvScreenRoi)
+	->ArgName("roi")->Arg(0)->Arg(1)
+	->Iterations(1)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace krtc
@@ -0,0 +1,149 @@
+#include "krtc/render/yuv_upload.h"
+
+#include <gtest/gtest.h>
+
+#include "api/video/i420_buffer.h"
+
+namespace krtc {
+namespace {
+
+void ExpectRect(const webrtc::VideoFrame::UpdateRect& rect, int x, int y, int width, int height)
+{
+	EXPECT_EQ(x, rect.offset_x);
+	EXPECT_EQ(y, rect.offset_y);
+	EXPECT_EQ(width, rect.width);
+	EXPECT_EQ(height, rect.height);
+}
+
+webrtc::VideoFrame MakeFrame(int width, int height, const webrtc::VideoFrame::UpdateRect* rect = nullptr)
+{
+	webrtc::VideoFrame::Builder builder;
+	builder.set_video_frame_buffer(webrtc::I420Buffer::Create(width, height));
+	if (rect) {
+		builder.set_update_rect(*rect);
+	}
+	return builder.build();
+}
+
+TEST(YuvUploadRegionTest, EmptyRectHasNothingToUpload)
+{
+	YuvUploadRegion region;
+	EXPECT_FALSE(YuvUploadRegion::FromUpdateRect({ 0, 0, 0, 0 }, 64, 48, &region));
+}
+
+TEST(YuvUploadRegionTest, EvenRectMapsDirectly)
+{
+	YuvUploadRegion region;
+	ASSERT_TRUE(YuvUploadRegion::FromUpdateRect({ 16, 8, 32, 16 }, 64, 48, &region));
+	EXPECT_EQ(16, region.x);
+	EXPECT_EQ(8, region.y);
+	EXPECT_EQ(32, region.width);
+	EXPECT_EQ(16, region.height);
+	EXPECT_EQ(8, region.chroma_x);
+	EXPECT_EQ(4, region.chroma_y);
+	EXPECT_EQ(16, region.chroma_width);
+	EXPECT_EQ(8, region.chroma_height);
+}
+
+// 奇数边界向外扩到偶数，保证覆盖到的色度样本完整
+TEST(YuvUploadRegionTest, OddRectGrowsToEvenBounds)
+{
+	YuvUploadRegion region;
+	ASSERT_TRUE(YuvUploadRegion::FromUpdateRect({ 3, 5, 4, 4 }, 64, 48, &region));
+	EXPECT_EQ(2, region.x);
+	EXPECT_EQ(4, region.y);
+	EXPECT_EQ(6, region.width);
+	EXPECT_EQ(6, region.height);
+	EXPECT_EQ(1, region.chroma_x);
+	EXPECT_EQ(2, region.chroma_y);
+	EXPECT_EQ(3, region.chroma_width);
+	EXPECT_EQ(3, region.chroma_height);
+}
+
+TEST(YuvUploadRegionTest, ClipsToFrame)
+{
+	YuvUploadRegion region;
+	ASSERT_TRUE(YuvUploadRegion::FromUpdateRect({ 60, 40, 20, 20 }, 64, 48, &region));
+	EXPECT_EQ(60, region.x);
+	EXPECT_EQ(40, region.y);
+	EXPECT_EQ(4, region.width);
+	EXPECT_EQ(8, region.height);
+	EXPECT_EQ(2, region.chroma_width);
+	EXPECT_EQ(4, region.chroma_height);
+
+	ASSERT_TRUE(YuvUploadRegion::FromUpdateRect({ -4, -4, 8, 8 }, 64, 48, &region));
+	EXPECT_EQ(0, region.x);
+	EXPECT_EQ(0, region.y);
+	EXPECT_EQ(4, region.width);
+	EXPECT_EQ(4, region.height);
+
+	EXPECT_FALSE(YuvUploadRegion::FromUpdateRect({ 64, 0, 8, 8 }, 64, 48, &region));
+	EXPECT_FALSE(YuvUploadRegion::FromUpdateRect({ 0, 48, 8, 8 }, 64, 48, &region));
+}
+
+// 奇数尺寸的帧，最后一列/行的色度也要上传
+TEST(YuvUploadRegionTest, OddFrameSizeCoversLastChromaSample)
+{
+	YuvUploadRegion region;
+	ASSERT_TRUE(YuvUploadRegion::FromUpdateRect({ 0, 0, 63, 47 }, 63, 47, &region));
+	EXPECT_EQ(63, region.width);
+	EXPECT_EQ(47, region.height);
+	EXPECT_EQ(32, region.chroma_width);
+	EXPECT_EQ(24, region.chroma_height);
+}
+
+TEST(PendingVideoFrameTest, KeepsLatestFrameAndMergesRects)
+{
+	PendingVideoFrame pending;
+	webrtc::VideoFrame::UpdateRect first = { 0, 0, 8, 8 };
+	webrtc::VideoFrame::UpdateRect second = { 32, 16, 8, 8 };
+	webrtc::VideoFrame latest = MakeFrame(64, 48, &second);
+
+	// 只有第一帧需要投递渲染任务
+	EXPECT_TRUE(pending.Push(MakeFrame(64, 48, &first)));
+	EXPECT_FALSE(pending.Push(latest));
+
+	webrtc::VideoFrame::UpdateRect rect;
+	absl::optional<webrtc::VideoFrame> frame = pending.Pop(&rect);
+	ASSERT_TRUE(frame);
+	EXPECT_EQ(latest.video_frame_buffer(), frame->video_frame_buffer());
+	ExpectRect(rect, 0, 0, 40, 24);
+
+	// 取走后重新累计
+	EXPECT_FALSE(pending.Pop(&rect));
+	ExpectRect(rect, 0, 0, 0, 0);
+	EXPECT_TRUE(pending.Push(MakeFrame(64, 48, &second)));
+	ASSERT_TRUE(pending.Pop(&rect));
+	ExpectRect(rect, 32, 16, 8, 8);
+}
+
+TEST(PendingVideoFrameTest, FrameWithoutUpdateRectIsFullFrame)
+{
+	PendingVideoFrame pending;
+	webrtc::VideoFrame::UpdateRect small = { 4, 4, 2, 2 };
+	pending.Push(MakeFrame(64, 48, &small));
+	pending.Push(MakeFrame(64, 48));
+
+	webrtc::VideoFrame::UpdateRect rect;
+	ASSERT_TRUE(pending.Pop(&rect));
+	ExpectRect(rect, 0, 0, 64, 48);
+}
+
+// 被覆盖的帧尺寸不同，之前合并的区域不再有意义，整帧更新
+TEST(PendingVideoFrameTest, SizeChangeResetsToFullFrame)
+{
+	PendingVideoFrame pending;
+	webrtc::VideoFrame::UpdateRect old_rect = { 48, 32, 16, 16 };
+	webrtc::VideoFrame::UpdateRect new_rect = { 4, 4, 4, 4 };
+	pending.Push(MakeFrame(64, 48, &old_rect));
+	pending.Push(MakeFrame(32, 24, &new_rect));
+
+	webrtc::VideoFrame::UpdateRect rect;
+	absl::optional<webrtc::VideoFrame> frame = pending.Pop(&rect);
+	ASSERT_TRUE(frame);
+	EXPECT_EQ(32, frame->width());
+	ExpectRect(rect, 0, 0, 32, 24);
+}
+
+}  // namespace
+}  // namespace krtc